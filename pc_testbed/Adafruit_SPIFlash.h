@@ -0,0 +1,2 @@
+// Host stand-in.  File comes from the Arduino.h shim next to this.
+#include "Arduino.h"
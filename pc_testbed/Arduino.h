@@ -0,0 +1,46 @@
+// Host stand-in for the bits of Arduino.h and the SdFat File class the sources in ../src use.
+// Lets the testbed build the real ogg_stripper.cpp instead of keeping a copy in sync.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#ifndef ARDUINO_HOST_SHIM_H
+#define ARDUINO_HOST_SHIM_H
+
+#define FILE_READ "rb"
+
+// Wraps a FILE* with the File calls ogg_stripper uses.
+// Reads is bumped on every read call so tests can count storage accesses.
+class File {
+public:
+    FILE * Handle;
+    uint32_t Reads;
+
+    File (FILE * handle = NULL) : Handle(handle), Reads(0) {}
+
+    int read (void * buffer, size_t length) {
+        Reads++;
+        return (int)fread(buffer, 1, length, Handle);
+    }
+    size_t readBytes (void * buffer, size_t length) {
+        Reads++;
+        return fread(buffer, 1, length, Handle);
+    }
+    size_t write (const uint8_t * buffer, size_t length) {
+        return fwrite(buffer, 1, length, Handle);
+    }
+    bool seek (uint32_t position) { return fseek(Handle, position, SEEK_SET) == 0; }
+    bool seekCur (int32_t offset) { return fseek(Handle, offset, SEEK_CUR) == 0; }
+    uint32_t position (void) { return (uint32_t)ftell(Handle); }
+    uint32_t size (void) {
+        long here = ftell(Handle);
+        fseek(Handle, 0, SEEK_END);
+        long end = ftell(Handle);
+        fseek(Handle, here, SEEK_SET);
+        return (uint32_t)end;
+    }
+    int available (void) { return (int)(size() - position()); }
+};
+
+#endif
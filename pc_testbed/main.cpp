@@ -0,0 +1,3485 @@
+// Testbed for ogg_stripper.cpp
+// Builds the real ../src/ogg_stripper.cpp and friends, and ../src/libopus, against the host
+// shims in this folder.
+//   testbed [in.ogg] [out.opk]  Pack an Ogg Opus file (default sample.ogg) into an .opk.
+//   testbed crc     Check sample.ogg's page CRCs and benchmark the CRC kernel.
+//   testbed seek    Compare page reads per seek for bisection against a linear walk, and
+//                   check index seeks and the index sidecar round trip.
+//   testbed mmap [files]  Demux with the mmap reader and report packets per second, and
+//                   check both readers drop a packet cut by a damaged page the same way.
+//   testbed readahead     Play against a simulated slow flash, with and without read-ahead.
+//   testbed chain [in.ogg]  Demux chained and multiplexed copies of a file.
+//   testbed i2s [decode us [spike us [jitter us [wall]]]]  Play through the simulated I2S,
+//                   from the PCM FIFO and from the interrupt, and report the headroom.
+//   testbed spsc    Hammer the PCM FIFO from two threads, and time both ends.
+//   testbed reframe Pack packets of every Opus duration into the PCM FIFO's frames.
+//   testbed noalloc [in.opk]  Decode from static decoder storage and check nothing is allocated.
+//   testbed scratch [in.opk]  Decode with and without a scratch arena, and report the arena's
+//                   peak and the stack each way.
+//   testbed gain    Check the output gain applied as the output is written against a pass
+//                   of its own, on streams switching between SILK, hybrid and CELT.
+//   testbed pack    Check mono output packed into stereo pairs against the plain decode
+//                   spread out by hand, and time SILK decoding both ways.
+//   testbed cores [in.opk]  Report the decoder's size for the cores it was built with, and
+//                   check how packets needing a missing one are refused or concealed, in
+//                   in.opk and in SILK, hybrid and CELT streams from the in-tree encoder.
+//   testbed decimate [in.opk]  Time decimated CELT synthesis against the exact path at each
+//                   rate below 48 kHz, and score both against the 48 kHz decode.  Needs a
+//                   libopus built with -DDECIMATED_SYNTHESIS.
+//   testbed dtables [out.h]  Regenerate libopus/celt/static_decimate_fixed.h.
+//   testbed imdct   Check the fused IMDCT against the separate passes, and time both per LM.
+//   testbed deemph  Check CELT's output stage against CRCs of what the separate passes it
+//                   replaced wrote, at every rate, packing, gain and skip.
+//   testbed simd    Check each x86 kernel the CPU can run against the C one, and time them.
+//   testbed dsp     Check the C stand-ins for the Cortex-M4 DSP instructions, and the M4
+//                   kernels built on them, against the generic arithmetic.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sched.h>
+#include <stdint.h>
+#include "Arduino.h"
+#include "ogg_stripper.h"
+#include "opk_reader.h"
+#include "ogg_mmap.h"
+#include "read_ahead.h"
+#include "pcm_fifo.h"
+#include "nrfx_i2s.h"
+#include "libopus/opus.h"
+extern "C" {
+#include "libopus/config.h" // For the decoder internals imdctTest calls directly.
+#include "libopus/celt/modes.h"
+#include "libopus/celt/pitch.h" // For simdTest.
+#include "libopus/celt/vq.h"
+#include "libopus/silk/main.h"
+#include "libopus/celt/celt_lpc.h" // For dspTest.
+#include "libopus/opus_private.h" // For the encoder's forced modes, and OPUS_SET_GAIN_PASS.
+#if defined(OPUS_ARM_INLINE_EDSP) && defined(OPUS_ARM_INLINE_MEDIA)
+#include "libopus/celt/arm/cm4_dsp.h"
+#endif
+}
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define CRC_BENCH_LEN   (1 << 20)
+#define CRC_BENCH_PASSES 64
+#define SEEK_TRIALS      50
+#define SEEK_INDEX_MAX   1024
+#define SIM_BLOCK        4096
+#define SIM_BLOCKS       2
+#define SIM_PERIOD_US    5000 // One packet per period: 20 ms frames, run 4x faster than real time.
+#define CHAIN_BUFFER_LEN 0x20000 // Room for the biggest legal page, twice.
+#define MUX_SERIAL       0x4D555821 // Serial of the made-up stream muxed in by chainTest.
+#define I2S_FRAME        PCM_FIFO_FRAME_LENGTH // Samples per I2S buffer, as on the device.
+#define I2S_DECODE_US    10000 // Typical decode, a quarter of a 40 ms frame...
+#define I2S_SPIKE_US     60000 // ...but every tenth frame takes one and a half.
+#define I2S_STREAM       500 // Frames to play.
+#define I2S_WALL_STREAM  100 // The same, in real time.
+#define SPSC_FRAMES      200000
+#define REFRAME_SAMPLES  (16000 * 600) // Ten minutes at 16 kHz.
+#define SCRATCH_STACK    (256 * 1024) // For the decode thread: far more than it needs.
+#define SCRATCH_ARENA_MAX (64 * 1024)
+#define SCRATCH_GUARD    64 // Bytes checked either side of an arena that's too small.
+#define ENCODE_SECONDS   12 // Made-up signal encoded for the gain test.
+#define GAIN_LOSS        9  // Every ninth packet lost.
+#define PACK_PASSES      20 // Decodes of the SILK stream timed each way.
+
+// Convert an Ogg Opus file into an .opk (see opk_reader.h), then read the .opk back with
+// the device reader and check every packet against the Ogg source.
+// Anything but a clean end of stream from either reader is a failure.
+static int packFile (const char * inName, const char * outName) {
+    static uint8_t oggBuffer[8192];
+    static uint8_t opkBuffer[8192];
+    oggStream_t stream;
+    opkHeader_t header;
+    opkReader_t reader;
+    const uint8_t * packet;
+    const uint8_t * check;
+    uint8_t prefix[OPK_MAX_VARINT_LEN];
+    uint8_t * data = NULL;
+    uint32_t * offsets = NULL;
+    size_t dataLen = 0, capacity = 0;
+    uint32_t count = 0, maxPackets = 0, entry, opkLen;
+    int bytesPulled, checkLen, err = 0;
+    FILE * outFile;
+
+    FILE * oggFile = fopen(inName, "rb");
+    if (!oggFile) {
+        printf("ERR! Couldn't open %s.\r\n", inName);
+        return 1;
+    }
+    File file(oggFile);
+    OggStreamInit(&stream, &file, oggBuffer, sizeof(oggBuffer));
+    if ( !OggStreamPrepare(&stream) || stream.IDHeader.Signature != OPUSHEAD_MAGIC ) {
+        printf("ERR! Couldn't parse Ogg header.\r\n");
+        return 1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.Signature = OPK_MAGIC;
+    header.Version = OPK_VERSION;
+    header.ChannelCount = stream.IDHeader.ChannelCount;
+    header.PreSkip = stream.IDHeader.PreSkip;
+    header.OutputGain = (int16_t)stream.IDHeader.OutputGain;
+    header.InputSampleRate = stream.IDHeader.InputSampleRate;
+    header.IndexStride = OPK_INDEX_STRIDE;
+
+    while ( (bytesPulled = OggStreamGetNextPacketView(&stream, &packet)) >= 0 ) {
+        if (count == maxPackets) {
+            maxPackets = maxPackets ? maxPackets * 2 : 256;
+            offsets = (uint32_t *)realloc(offsets, maxPackets * sizeof(uint32_t));
+        }
+        if (dataLen + OPK_MAX_VARINT_LEN + bytesPulled > capacity) {
+            capacity = capacity ? capacity * 2 : 65536;
+            capacity += bytesPulled;
+            data = (uint8_t *)realloc(data, capacity);
+        }
+        offsets[count++] = dataLen;
+        dataLen += OpkWriteVarint(data + dataLen, bytesPulled);
+        memcpy(data + dataLen, packet, bytesPulled);
+        dataLen += bytesPulled;
+        header.SampleCount = OggStreamGetLastPageHeader(&stream)->GranulePosition;
+    }
+    if (bytesPulled != OGG_STRIP_EOF) {
+        printf("ERR! Ogg read failed after %u packets: %d\r\n", (unsigned)count, bytesPulled);
+        return 1;
+    }
+    header.PacketCount = count;
+
+    outFile = fopen(outName, "wb");
+    if (!outFile) {
+        printf("ERR! Couldn't open %s.\r\n", outName);
+        return 1;
+    }
+    fwrite(&header, sizeof(header), 1, outFile);
+    opkLen = sizeof(header);
+    for (entry = 0; entry < count; entry += OPK_INDEX_STRIDE) {
+        fwrite(&offsets[entry], sizeof(uint32_t), 1, outFile);
+        opkLen += sizeof(uint32_t);
+    }
+    fwrite(data, 1, dataLen, outFile);
+    fclose(outFile);
+    opkLen += dataLen;
+    printf("Packed %u packets: %u bytes of Ogg into %u bytes of .opk\r\n", (unsigned)count,
+           (unsigned)file.size(), (unsigned)opkLen);
+
+    // Read it back, in order and then by random access.
+    File opkFile(fopen(outName, "rb"));
+    OggStreamPrepare(&stream);
+    if ( OpkOpen(&reader, &opkFile, opkBuffer, sizeof(opkBuffer), NULL) != OPK_OK ) {
+        printf("ERR! Couldn't read back %s.\r\n", outName);
+        return 1;
+    }
+    while ( (bytesPulled = OggStreamGetNextPacketView(&stream, &packet)) >= 0 ) {
+        checkLen = OpkGetNextPacket(&reader, &check);
+        if (checkLen != bytesPulled || memcmp(check, packet, bytesPulled))
+            err++;
+    }
+    if (bytesPulled != OGG_STRIP_EOF || OpkGetNextPacket(&reader, &check) != OPK_EOF)
+        err++;
+    for (count = 0; count < header.PacketCount; count += 7) {
+        if (OpkSeekToPacket(&reader, count) != OPK_OK) {
+            err++;
+            continue;
+        }
+        checkLen = OpkGetNextPacket(&reader, &check);
+        if (checkLen < 0 ||
+            memcmp(check, data + offsets[count] + OpkWriteVarint(prefix, checkLen), checkLen))
+            err++;
+    }
+    printf("Read back: %d mismatches\r\n", err);
+
+    fclose(opkFile.Handle);
+    fclose(oggFile);
+    free(offsets);
+    free(data);
+    return err ? 1 : 0;
+}
+
+// Plain one-bit-at-a-time CRC to check the table kernel against.
+static uint32_t referenceCrc (uint32_t crc, const uint8_t * data, size_t length) {
+    int bit;
+    while (length--) {
+        crc ^= (uint32_t)*data++ << 24;
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+    }
+    return crc;
+}
+
+static double secondsSince (clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+// The packets a reader has to give up when the page at offset in data is lost: those that end
+// on it, and the one running on out of it into the next page, if any.
+static int packetsLostWithPage (const uint8_t * data, size_t length, size_t offset) {
+    size_t page = 0, size;
+    int segments, lost, i;
+
+    while (page + 27 <= length) {
+        segments = data[page + 26];
+        size = 27 + segments;
+        for (i = 0; i < segments; i++)
+            size += data[page + 27 + i];
+        if (offset < page + size) {
+            lost = 0;
+            for (i = 0; i < segments; i++)
+                lost += data[page + 27 + i] < 255;
+            return lost + (segments && data[page + 27 + segments - 1] == 255);
+        }
+        page += size;
+    }
+    return -1;
+}
+
+static int crcBench (void) {
+    static uint8_t buffer[8192];
+    uint8_t * data;
+    const uint8_t * packet;
+    oggStream_t stream;
+    uint32_t crc, expected;
+    clock_t start;
+    double seconds;
+    size_t i, length;
+    int packets = 0, cleanPackets, lost;
+    int bytesPulled;
+    FILE * oggFile;
+
+    // Every page in the sample should check out.
+    oggFile = fopen("sample.ogg", "rb");
+    if (!oggFile) {
+        printf("ERR! Couldn't open file.\r\n");
+        return 1;
+    }
+    File file(oggFile);
+    OggStreamInit(&stream, &file, buffer, sizeof(buffer));
+    OggStreamSetCrcCheck(&stream, true);
+    if ( OggStreamPrepare(&stream) ) {
+        while ( (bytesPulled = OggStreamGetNextPacketView(&stream, &packet)) >= 0 )
+            packets++;
+    }
+    printf("sample.ogg: %d packets, %u bad pages\r\n", packets, stream.Reader.BadPages);
+    if (stream.Reader.BadPages) {
+        printf("ERR! The sample has pages that fail their CRC.\r\n");
+        return 1;
+    }
+    cleanPackets = packets;
+
+    // Flip a byte in the middle of the file; that page should be dropped and the rest kept.
+    length = file.size();
+    data = (uint8_t *)malloc(length);
+    fseek(oggFile, 0, SEEK_SET);
+    fread(data, 1, length, oggFile);
+    fclose(oggFile);
+    lost = packetsLostWithPage(data, length, length / 2);
+    data[length / 2] ^= 0x40;
+    oggFile = fmemopen(data, length, "rb");
+    File damaged(oggFile);
+    OggStreamInit(&stream, &damaged, buffer, sizeof(buffer));
+    OggStreamSetCrcCheck(&stream, true);
+    packets = 0;
+    if ( OggStreamPrepare(&stream) ) {
+        while ( (bytesPulled = OggStreamGetNextPacketView(&stream, &packet)) >= 0 )
+            packets++;
+    }
+    printf("damaged copy: %d packets, %u bad pages; the page held %d\r\n", packets, stream.Reader.BadPages, lost);
+    fclose(oggFile);
+    free(data);
+    if (stream.Reader.BadPages != 1 || lost < 0 || packets != cleanPackets - lost) {
+        printf("ERR! The damaged copy should lose its one bad page, and only the packets on it.\r\n");
+        return 1;
+    }
+
+    // Throughput, on odd lengths and offsets so the byte tail gets exercised too.
+    data = (uint8_t *)malloc(CRC_BENCH_LEN + 8);
+    for (i = 0; i < CRC_BENCH_LEN + 8; i++)
+        data[i] = (uint8_t)(rand() >> 7);
+
+    for (i = 0; i < 64; i++) {
+        if (OggCrcUpdate(0, data + i % 8, 1000 + i) != referenceCrc(0, data + i % 8, 1000 + i)) {
+            printf("ERR! Slice-by-8 CRC disagrees with the reference at length %u.\r\n", (unsigned)(1000 + i));
+            return 1;
+        }
+    }
+
+    crc = 0;
+    start = clock();
+    for (i = 0; i < CRC_BENCH_PASSES; i++)
+        crc = OggCrcUpdate(crc, data + 1, CRC_BENCH_LEN);
+    seconds = secondsSince(start);
+    printf("slice-by-8: %.1f MB/s\r\n", CRC_BENCH_PASSES * (CRC_BENCH_LEN / 1e6) / seconds);
+
+    expected = 0;
+    start = clock();
+    for (i = 0; i < CRC_BENCH_PASSES / 16; i++)
+        expected = referenceCrc(expected, data + 1, CRC_BENCH_LEN);
+    seconds = secondsSince(start);
+    printf("bitwise:    %.1f MB/s\r\n", CRC_BENCH_PASSES / 16 * (CRC_BENCH_LEN / 1e6) / seconds);
+
+    crc = 0;
+    for (i = 0; i < CRC_BENCH_PASSES / 16; i++)
+        crc = OggCrcUpdate(crc, data + 1, CRC_BENCH_LEN);
+    if (crc != expected) {
+        printf("ERR! Slice-by-8 CRC disagrees with the reference.\r\n");
+        return 1;
+    }
+
+    free(data);
+    return 0;
+}
+
+// Read sample.ogg and loop its audio pages until the result runs at least `minutes`,
+// renumbering granules and sequence numbers and redoing the CRCs as we go.
+// Returns a malloc'd image of the file.
+static uint8_t * makeLongFile (int minutes, size_t * length) {
+    FILE * oggFile = fopen("sample.ogg", "rb");
+    uint8_t * sample, * image, * page;
+    size_t sampleLen, audioStart, pos, out;
+    uint64_t granule = 0, loopGranule = 0, lastGranule = 0;
+    uint32_t sequence = 2, crc;
+    int copies, i;
+
+    if (!oggFile)
+        return NULL;
+    fseek(oggFile, 0, SEEK_END);
+    sampleLen = ftell(oggFile);
+    fseek(oggFile, 0, SEEK_SET);
+    sample = (uint8_t *)malloc(sampleLen);
+    fread(sample, 1, sampleLen, oggFile);
+    fclose(oggFile);
+
+    // Skip the two header pages.
+    audioStart = 0;
+    for (i = 0; i < 2; i++) {
+        pos = audioStart + OGG_PAGE_HEADER_LEN + sample[audioStart + 26];
+        for (int s = 0; s < sample[audioStart + 26]; s++)
+            pos += sample[audioStart + OGG_PAGE_HEADER_LEN + s];
+        audioStart = pos;
+    }
+
+    // Work out the length of one pass from the last page's granule.
+    for (pos = audioStart; pos < sampleLen; ) {
+        memcpy(&loopGranule, sample + pos + 6, 8);
+        out = OGG_PAGE_HEADER_LEN + sample[pos + 26];
+        for (int s = 0; s < sample[pos + 26]; s++)
+            out += sample[pos + OGG_PAGE_HEADER_LEN + s];
+        pos += out;
+    }
+    copies = (int)((uint64_t)minutes * 60 * 48000 / loopGranule) + 1;
+
+    image = (uint8_t *)malloc(audioStart + (sampleLen - audioStart) * copies);
+    memcpy(image, sample, audioStart);
+    out = audioStart;
+    for (i = 0; i < copies; i++) {
+        for (pos = audioStart; pos < sampleLen; ) {
+            size_t pageLen = OGG_PAGE_HEADER_LEN + sample[pos + 26];
+            for (int s = 0; s < sample[pos + 26]; s++)
+                pageLen += sample[pos + OGG_PAGE_HEADER_LEN + s];
+
+            page = image + out;
+            memcpy(page, sample + pos, pageLen);
+            memcpy(&lastGranule, page + 6, 8);
+            granule = lastGranule + (uint64_t)i * loopGranule;
+            memcpy(page + 6, &granule, 8);
+            memcpy(page + 18, &sequence, 4);
+            page[5] &= ~0x04; // Only the last page keeps EOS.
+            if (i == copies - 1 && pos + pageLen == sampleLen)
+                page[5] |= 0x04;
+            memset(page + 22, 0, 4);
+            crc = OggCrcUpdate(0, page, pageLen);
+            memcpy(page + 22, &crc, 4);
+
+            sequence++;
+            out += pageLen;
+            pos += pageLen;
+        }
+    }
+
+    free(sample);
+    *length = out;
+    return image;
+}
+
+// The no-index, no-bisection way: walk page headers from the top until we pass the
+// start point.  Returns the samples to discard, and leaves the page offset in *offset.
+static int32_t linearSeek (oggStream_t * stream, uint64_t sample, uint32_t * offset) {
+    oggPageHeader_t header;
+    uint64_t target = sample + stream->IDHeader.PreSkip;
+    uint64_t start = target > OGG_OPUS_PREROLL ? target - OGG_OPUS_PREROLL : 0;
+    uint64_t bestGranule = 0;
+    uint32_t pos = stream->DataStart;
+    int dataLen;
+
+    *offset = pos;
+    stream->Source->seek(pos);
+    while ( (dataLen = OggReadPageHeader(stream->Source, &header)) > 0 ) {
+        if (header.GranulePosition > start)
+            break;
+        pos += OGG_PAGE_HEADER_LEN + header.Segments + dataLen;
+        stream->Source->seekCur(dataLen);
+        *offset = pos;
+        bestGranule = header.GranulePosition;
+    }
+    return (int32_t)(target - bestGranule);
+}
+
+// Build an index of the given capacity, and check every OggSeekToSample against the last
+// point at or before the run-in start, and that it's never later than the linear walk's
+// page.  Then round-trip the index through a sidecar and check the copy seeks the same,
+// and that a stale sidecar is refused.  Returns the number of failures.
+static int indexSeekCheck (oggStream_t * stream, uint32_t fileSize, uint64_t total, uint16_t capacity) {
+    static oggSeekPoint_t points[SEEK_INDEX_MAX], loadedPoints[SEEK_INDEX_MAX];
+    oggSeekIndex_t index, loaded;
+    uint64_t sample, target, start;
+    uint32_t offset;
+    int32_t discard, linearDiscard;
+    int trial, failures = 0;
+    uint16_t p, low;
+
+    OggSeekIndexInit(&index, points, capacity, 0);
+    index.FileSize = fileSize;
+    if (OggSeekIndexBuild(stream, &index) != OGG_STRIP_OK ||
+        index.Points[0].Granule != 0 || index.Points[0].Offset != stream->DataStart) {
+        printf("ERR! Capacity %u: no index, or it doesn't start at the first audio page.\r\n", capacity);
+        return 1;
+    }
+
+    for (trial = 0; trial < SEEK_TRIALS; trial++) {
+        sample = (uint64_t)rand() * total / RAND_MAX;
+        target = sample + stream->IDHeader.PreSkip;
+        start = target > OGG_OPUS_PREROLL ? target - OGG_OPUS_PREROLL : 0;
+        for (low = 0, p = 1; p < index.Count; p++)
+            if (index.Points[p].Granule <= start)
+                low = p;
+
+        linearDiscard = linearSeek(stream, sample, &offset);
+        discard = OggSeekToSample(stream, &index, sample);
+        if (discard != (int32_t)(target - index.Points[low].Granule) ||
+            stream->Reader.FileOffset != index.Points[low].Offset || discard < linearDiscard)
+            failures++;
+    }
+
+    // Sidecar round trip.  Its points are 12 bytes each, with no padding, on any ABI.
+    File sidecar(tmpfile());
+    if (OggSeekIndexSave(&sidecar, &index) != OGG_STRIP_OK || sidecar.size() != 16u + 12u * index.Count)
+        failures++;
+    sidecar.seek(0);
+    OggSeekIndexInit(&loaded, loadedPoints, capacity, 0);
+    if (OggSeekIndexLoad(&sidecar, &loaded, fileSize) != OGG_STRIP_OK ||
+        loaded.Count != index.Count || loaded.Spacing != index.Spacing ||
+        memcmp(loadedPoints, points, index.Count * sizeof(oggSeekPoint_t)))
+        failures++;
+    for (trial = 0; trial < SEEK_TRIALS; trial++) {
+        sample = (uint64_t)rand() * total / RAND_MAX;
+        discard = OggSeekToSample(stream, &index, sample);
+        offset = stream->Reader.FileOffset;
+        if (OggSeekToSample(stream, &loaded, sample) != discard || stream->Reader.FileOffset != offset)
+            failures++;
+    }
+    sidecar.seek(0);
+    if (OggSeekIndexLoad(&sidecar, &loaded, fileSize + 1) != OGG_STRIP_NO_INDEX)
+        failures++;
+    fclose(sidecar.Handle);
+
+    printf("        capacity %3u: %3u points, %9u spacing, %d failures\r\n",
+           capacity, index.Count, (unsigned)index.Spacing, failures);
+    return failures;
+}
+
+static int seekTest (void) {
+    static uint8_t buffer[8192];
+    static const int lengths[] = { 1, 10, 60 };
+    static const uint16_t capacities[] = { 2, 3, 64, SEEK_INDEX_MAX };
+    static oggSeekPoint_t points[1];
+    oggSeekIndex_t index;
+    oggStream_t stream;
+    uint8_t * image;
+    size_t length;
+    uint64_t total, sample;
+    uint32_t offset, reads, linearReads, bisectReads;
+    int32_t linearDiscard, bisectDiscard;
+    int i, c, trial, mismatches;
+
+    for (i = 0; i < 3; i++) {
+        image = makeLongFile(lengths[i], &length);
+        if (!image) {
+            printf("ERR! Couldn't open file.\r\n");
+            return 1;
+        }
+        File file(fmemopen(image, length, "rb"));
+        OggStreamInit(&stream, &file, buffer, sizeof(buffer));
+        OggStreamPrepare(&stream);
+        total = (uint64_t)lengths[i] * 60 * 48000;
+
+        linearReads = bisectReads = 0;
+        mismatches = 0;
+        srand(i);
+        for (trial = 0; trial < SEEK_TRIALS; trial++) {
+            sample = (uint64_t)rand() * total / RAND_MAX;
+
+            reads = file.Reads;
+            linearDiscard = linearSeek(&stream, sample, &offset);
+            linearReads += file.Reads - reads;
+
+            reads = file.Reads;
+            bisectDiscard = OggBisectToSample(&stream, sample);
+            bisectReads += file.Reads - reads;
+
+            // Both should land on the same page.
+            if (bisectDiscard != linearDiscard || stream.Reader.FileOffset != offset)
+                mismatches++;
+        }
+
+        printf("%2d min, %7u KB: linear %7.1f reads/seek, bisection %5.1f reads/seek, %d mismatches\r\n",
+               lengths[i], (unsigned)(length / 1024), (double)linearReads / SEEK_TRIALS,
+               (double)bisectReads / SEEK_TRIALS, mismatches);
+
+        // Index seeks, down to the smallest index that can keep granule 0.
+        OggSeekIndexInit(&index, points, 1, 0);
+        if (OggSeekIndexBuild(&stream, &index) != OGG_STRIP_NO_INDEX) {
+            printf("ERR! A one-point index was accepted.\r\n");
+            mismatches++;
+        }
+        for (c = 0; c < (int)(sizeof(capacities) / sizeof(capacities[0])); c++)
+            mismatches += indexSeekCheck(&stream, length, total, capacities[c]);
+
+        fclose(file.Handle);
+        free(image);
+        if (mismatches)
+            return 1;
+    }
+    return 0;
+}
+
+// Demux one file both ways, check they agree, and report throughput.
+// Packets are folded into a running CRC so both readers really have to touch the data.
+static int demuxFile (const char * name) {
+    static uint8_t buffer[65536];
+    oggMap_t map;
+    oggMapPacket_t packet;
+    oggStream_t stream;
+    const uint8_t * view;
+    uint32_t mapCrc = 0, streamCrc = 0;
+    uint32_t mapPackets = 0, streamPackets = 0;
+    double mapSeconds, streamSeconds;
+    clock_t start;
+    int length, i;
+
+    start = clock();
+    if (OggMapOpen(&map, name, true) != OGG_STRIP_OK) {
+        printf("ERR! Couldn't map %s.\r\n", name);
+        return 1;
+    }
+    while ( (length = OggMapNextPacket(&map, &packet)) >= 0 ) {
+        for (i = 0; i < packet.Count; i++)
+            mapCrc = OggCrcUpdate(mapCrc, packet.Parts[i], packet.PartLengths[i]);
+        mapPackets++;
+    }
+    mapSeconds = secondsSince(start);
+
+    start = clock();
+    File file(fopen(name, "rb"));
+    OggStreamInit(&stream, &file, buffer, sizeof(buffer));
+    OggStreamSetCrcCheck(&stream, true);
+    if ( OggStreamPrepare(&stream) ) {
+        // The mmap reader hands out the two header packets as well; match that.
+        streamPackets = 2;
+        while ( (length = OggStreamGetNextPacketView(&stream, &view)) >= 0 ) {
+            streamCrc = OggCrcUpdate(streamCrc, view, length);
+            streamPackets++;
+        }
+    }
+    streamSeconds = secondsSince(start);
+    fclose(file.Handle);
+
+    // Header packets went into mapCrc but not streamCrc, so compare counts, then the
+    // audio on its own.
+    OggMapClose(&map);
+    OggMapOpen(&map, name, true);
+    OggMapNextPacket(&map, &packet);
+    OggMapNextPacket(&map, &packet);
+    mapCrc = 0;
+    while (OggMapNextPacket(&map, &packet) >= 0) {
+        for (i = 0; i < packet.Count; i++)
+            mapCrc = OggCrcUpdate(mapCrc, packet.Parts[i], packet.PartLengths[i]);
+    }
+
+    printf("%s: %u packets, %u MB\r\n", name, mapPackets, (unsigned)(map.Size >> 20));
+    printf("  mmap:     %10.0f packets/s, %u bad pages\r\n", mapPackets / mapSeconds, map.BadPages);
+    printf("  buffered: %10.0f packets/s, %u bad pages\r\n", streamPackets / streamSeconds, stream.Reader.BadPages);
+    OggMapClose(&map);
+
+    if (mapPackets != streamPackets || mapCrc != streamCrc || map.BadPages != stream.Reader.BadPages) {
+        printf("ERR! Readers disagree.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+static uint8_t * loadFile (const char * name, size_t * length) {
+    FILE * inFile = fopen(name, "rb");
+    uint8_t * image;
+
+    if (!inFile)
+        return NULL;
+    fseek(inFile, 0, SEEK_END);
+    *length = ftell(inFile);
+    fseek(inFile, 0, SEEK_SET);
+    image = (uint8_t *)malloc(*length);
+    fread(image, 1, *length, inFile);
+    fclose(inFile);
+    return image;
+}
+
+static size_t pageLength (const uint8_t * page) {
+    size_t length = OGG_PAGE_HEADER_LEN + page[26];
+    for (int s = 0; s < page[26]; s++)
+        length += page[OGG_PAGE_HEADER_LEN + s];
+    return length;
+}
+
+// Write a page with the given serial and flags and a fresh CRC.  Returns its length.
+static size_t putPage (uint8_t * out, const uint8_t * segments, uint8_t segmentCount,
+                       const uint8_t * data, uint32_t serial, uint32_t sequence, uint8_t flags) {
+    size_t dataLen = 0;
+    uint64_t granule = 0;
+    uint32_t crc;
+
+    memcpy(out, "OggS", 4);
+    out[4] = 0;
+    out[5] = flags;
+    memcpy(out + 6, &granule, 8);
+    memcpy(out + 14, &serial, 4);
+    memcpy(out + 18, &sequence, 4);
+    memset(out + 22, 0, 4);
+    out[26] = segmentCount;
+    memcpy(out + OGG_PAGE_HEADER_LEN, segments, segmentCount);
+    for (int s = 0; s < segmentCount; s++)
+        dataLen += segments[s];
+    memcpy(out + OGG_PAGE_HEADER_LEN + segmentCount, data, dataLen);
+    crc = OggCrcUpdate(0, out, OGG_PAGE_HEADER_LEN + segmentCount + dataLen);
+    memcpy(out + 22, &crc, 4);
+    return OGG_PAGE_HEADER_LEN + segmentCount + dataLen;
+}
+
+// A packet spanning three pages, with the middle or the last of them damaged.  Both readers
+// must drop it, not join its head to the tail of the page after the damage.
+static int damagedSpanCheck (void) {
+    static const uint8_t headSegs[3] = { 100, 255, 255 };   // Packet a, then the start of x...
+    static const uint8_t middleSegs[2] = { 255, 255 };      // ...more of x...
+    static const uint8_t tailSegs[4] = { 255, 255, 40, 60 }; // ...the end of x, and packet b.
+    static const uint8_t lastSegs[1] = { 70 };               // Packet c.
+    const char * name = "damaged_sample.ogg";
+    uint8_t data[1200], * sample, * image;
+    size_t sampleLen, headersLen, pages[4], out;
+    uint32_t serial, sequence = 2;
+    FILE * outFile;
+    int err = 0, damaged, i;
+
+    sample = loadFile("sample.ogg", &sampleLen);
+    if (!sample) {
+        printf("ERR! Couldn't open sample.ogg.\r\n");
+        return 1;
+    }
+    memcpy(&serial, sample + 14, 4);
+    headersLen = pageLength(sample);
+    headersLen += pageLength(sample + headersLen);
+    for (i = 0; i < (int)sizeof(data); i++)
+        data[i] = (uint8_t)(i * 7 + i / 255);
+
+    image = (uint8_t *)malloc(headersLen + 4 * (OGG_PAGE_HEADER_LEN + 255 + sizeof(data)));
+    for (damaged = 1; damaged <= 2; damaged++) {
+        memcpy(image, sample, headersLen);
+        out = headersLen;
+        pages[0] = out;
+        out += putPage(image + out, headSegs, 3, data, serial, sequence, 0);
+        pages[1] = out;
+        out += putPage(image + out, middleSegs, 2, data + 300, serial, sequence + 1, OGG_FLAG_CONTINUED);
+        pages[2] = out;
+        out += putPage(image + out, tailSegs, 4, data + 500, serial, sequence + 2, OGG_FLAG_CONTINUED);
+        pages[3] = out;
+        out += putPage(image + out, lastSegs, 1, data + 1000, serial, sequence + 3, OGG_FLAG_EOS);
+        image[pages[damaged] + OGG_PAGE_HEADER_LEN + image[pages[damaged] + 26] + 10] ^= 0x55;
+
+        outFile = fopen(name, "wb");
+        if (!outFile) {
+            printf("ERR! Couldn't write %s.\r\n", name);
+            err = 1;
+            break;
+        }
+        fwrite(image, 1, out, outFile);
+        fclose(outFile);
+        printf("Page %d of a three page packet damaged:\r\n", damaged + 1);
+        err |= demuxFile(name);
+        remove(name);
+    }
+
+    free(image);
+    free(sample);
+    return err;
+}
+
+static int mmapBench (int fileCount, char ** files) {
+    const char * longName = "long_sample.ogg";
+    uint8_t * image;
+    size_t length;
+    FILE * outFile;
+    int err = 0, i;
+
+    if (fileCount) {
+        for (i = 0; i < fileCount; i++)
+            err |= demuxFile(files[i]);
+        return err | damagedSpanCheck();
+    }
+
+    // No files given; make an hour of audio out of the sample and use that.
+    image = makeLongFile(60, &length);
+    outFile = image ? fopen(longName, "wb") : NULL;
+    if (!outFile) {
+        printf("ERR! Couldn't write %s.\r\n", longName);
+        return 1;
+    }
+    fwrite(image, 1, length, outFile);
+    fclose(outFile);
+    free(image);
+
+    err = demuxFile(longName);
+    remove(longName);
+    return err | damagedSpanCheck();
+}
+
+// Simulated flash: serves blocks out of memory, but takes 1 ms per block and now and
+// then stalls for 4 packet periods, the way FAT lookups and QSPI busy waits do.
+typedef struct {
+    const uint8_t * Image;
+    size_t Length;
+    unsigned Seed;
+} slowDevice_t;
+
+static int slowBlockRead (void * context, uint32_t offset, uint8_t * destination, size_t length) {
+    slowDevice_t * device = (slowDevice_t *)context;
+    size_t available = offset < device->Length ? device->Length - offset : 0;
+
+    usleep(1000);
+    if (rand_r(&device->Seed) % 8 == 0)
+        usleep(4 * SIM_PERIOD_US);
+
+    if (length > available)
+        length = available;
+    memcpy(destination, device->Image + offset, length);
+    return (int)length;
+}
+
+static uint64_t microseconds (void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+typedef struct {
+    readAhead_t * ReadAhead;
+    volatile bool Stop;
+} serviceThread_t;
+
+// Stands in for the device's readAheadTask: keep the read-ahead full.
+static void * serviceLoop (void * context) {
+    serviceThread_t * service = (serviceThread_t *)context;
+    while (!service->Stop) {
+        if (!ReadAheadService(service->ReadAhead))
+            usleep(200);
+    }
+    return NULL;
+}
+
+// Pull one packet per period the way data_handler does, and time each pull.
+// A pull that takes longer than a period, or finds nothing ready, is a missed deadline.
+// With threaded set, storage reads happen on their own thread as on the device;
+// otherwise they happen inline in the "callback", like the old code.
+static void simulatePlayback (const uint8_t * image, size_t length, bool threaded) {
+    static uint8_t buffer[8192];
+    static uint8_t blocks[SIM_BLOCK * SIM_BLOCKS];
+    slowDevice_t device = { image, length, 1 };
+    serviceThread_t service;
+    readAhead_t readAhead;
+    oggStream_t stream;
+    pthread_t thread;
+    const uint8_t * packet;
+    uint64_t start, took, worst = 0, deadline;
+    int bytesPulled, packets = 0, missed = 0;
+
+    File file(fmemopen((void *)image, length, "rb"));
+    ReadAheadInit(&readAhead, slowBlockRead, &device, blocks, SIM_BLOCK, SIM_BLOCKS);
+    OggStreamInit(&stream, &file, buffer, sizeof(buffer));
+    OggStreamSetPrefetch(&stream, &readAhead);
+    OggStreamPrepare(&stream);
+    ReadAheadService(&readAhead);
+
+    service.ReadAhead = &readAhead;
+    service.Stop = false;
+    if (threaded)
+        pthread_create(&thread, NULL, serviceLoop, &service);
+
+    deadline = microseconds();
+    for (;;) {
+        deadline += SIM_PERIOD_US;
+        start = microseconds();
+        if (!threaded)
+            ReadAheadService(&readAhead);
+        bytesPulled = OggStreamGetNextPacketView(&stream, &packet);
+        took = microseconds() - start;
+
+        if (bytesPulled == OGG_STRIP_NOT_READY || took > SIM_PERIOD_US)
+            missed++;
+        else if (bytesPulled < 0)
+            break;
+        if (took > worst)
+            worst = took;
+        packets++;
+
+        if (microseconds() < deadline)
+            usleep(deadline - microseconds());
+    }
+
+    service.Stop = true;
+    if (threaded)
+        pthread_join(thread, NULL);
+    fclose(file.Handle);
+
+    printf("  %-22s %3d periods, %3d missed, worst pull %5.2f ms, %u underruns\r\n",
+           threaded ? "read-ahead thread:" : "reads in callback:", packets, missed,
+           worst / 1000.0, readAhead.Underruns);
+}
+
+static int readAheadTest (void) {
+    uint8_t * image;
+    size_t length;
+
+    image = loadFile("sample.ogg", &length);
+    if (!image) {
+        printf("ERR! Couldn't open file.\r\n");
+        return 1;
+    }
+
+    printf("%d x %d byte blocks, %d us period:\r\n", SIM_BLOCKS, SIM_BLOCK, SIM_PERIOD_US);
+    simulatePlayback(image, length, false);
+    simulatePlayback(image, length, true);
+    free(image);
+    return 0;
+}
+
+// The playback path from main.cpp (decode task, PCM FIFO and data_handler) run against the
+// simulated I2S in nrfx_i2s_sim.cpp, with a made-up decoder that takes as long as it's told
+// to.  Every decoded sample is its frame's number, so the monitor can check each frame
+// comes out whole and in order as the peripheral starts on it, and again when it's done.
+// Frame size is PCM_FIFO_FRAME_LENGTH (build with -D to try others); decode time stands in
+// for bitrate and complexity.
+typedef struct {
+    pcmFifo_t Fifo;
+    bool InHandler;             // Decoding from the handler, the old way.
+    bool Notified;              // decodeTask's notification.
+    int16_t * Spare;            // The old way: the buffer that isn't playing.
+    uint32_t DecodeUs, SpikeUs;
+    int Stream;                 // Frames to decode.
+    int Decoded;
+    int64_t ReadyAt[I2S_STREAM + 1]; // When each frame was decoded.
+    const int16_t * Playing;
+    int16_t Expect;             // Frame number the next real frame should carry.
+    int64_t NeededAt;           // When it should have started, if silence played instead.
+    uint32_t Frames, Silent, Torn, OutOfOrder;
+    int64_t MinHeadroomUs;      // Least time between a frame being decoded and it being needed.
+} i2sTest_t;
+
+static i2sTest_t m_i2s;
+
+static bool i2sTestWhole (const int16_t * frame) {
+    int i;
+
+    for (i = 1; i < I2S_FRAME; i++)
+        if (frame[i] != frame[0])
+            return false;
+    return true;
+}
+
+// The peripheral has latched frame: check the one it just finished and the one it's starting.
+static void i2sTestMonitor (void * context, const uint32_t * buffer, uint16_t words) {
+    const int16_t * frame = (const int16_t *)buffer;
+    int64_t headroom;
+
+    (void)context;
+    (void)words;
+    if (m_i2s.Playing && !i2sTestWhole(m_i2s.Playing))
+        m_i2s.Torn++; // Written to while it played.
+    if (frame == m_i2s.Playing) {
+        m_i2s.Playing = frame;
+        return; // Replayed: the simulator counts those.
+    }
+    m_i2s.Playing = frame;
+    if (!i2sTestWhole(frame)) {
+        m_i2s.Torn++; // Still being written to.
+    } else if (frame[0] == 0) {
+        if (m_i2s.Expect <= m_i2s.Stream) {
+            m_i2s.Silent++; // Not counting the tail while the last frame plays out.
+            if (!m_i2s.NeededAt)
+                m_i2s.NeededAt = (int64_t)I2sSimNow();
+        }
+    } else {
+        if (frame[0] != m_i2s.Expect) {
+            m_i2s.OutOfOrder++;
+        } else {
+            headroom = (m_i2s.NeededAt ? m_i2s.NeededAt : (int64_t)I2sSimNow()) - m_i2s.ReadyAt[frame[0]];
+            if (headroom < m_i2s.MinHeadroomUs)
+                m_i2s.MinHeadroomUs = headroom;
+        }
+        m_i2s.NeededAt = 0;
+        m_i2s.Expect = frame[0] + 1;
+        m_i2s.Frames++;
+    }
+}
+
+static int i2sTestFill (void * context, int16_t * destination, size_t samples) {
+    i2sTest_t * test = (i2sTest_t *)context;
+    uint64_t cost;
+    size_t i;
+
+    if (test->Decoded == test->Stream)
+        return -1;
+    test->Decoded++;
+    cost = test->Decoded % 10 ? test->DecodeUs : test->SpikeUs;
+
+    // Half now and half later, so a frame being written while it plays shows up torn.
+    for (i = 0; i < samples; i++) {
+        if (i == samples / 2)
+            I2sSimSpend(cost);
+        destination[i] = (int16_t)test->Decoded;
+    }
+    test->ReadyAt[test->Decoded] = (int64_t)I2sSimNow();
+    return (int)samples;
+}
+
+// data_handler, both ways.
+static void i2sTestHandler (nrfx_i2s_buffers_t const * p_released, uint32_t status) {
+    const int16_t * released = p_released ? (const int16_t *)p_released->p_tx_buffer : NULL;
+    nrfx_i2s_buffers_t newBuf;
+    int16_t * next;
+
+    if (status != NRFX_I2S_STATUS_NEXT_BUFFERS_NEEDED)
+        return;
+
+    if (!m_i2s.InHandler) {
+        next = PcmFifoNext(&m_i2s.Fifo, released);
+        __atomic_store_n(&m_i2s.Notified, true, __ATOMIC_RELEASE);
+    } else {
+        // The old way: decode into the buffer just released (or the spare, if none was)
+        // and hope it's done before the one playing runs out.
+        next = released ? (int16_t *)released : m_i2s.Spare;
+        m_i2s.Spare = next;
+        if (i2sTestFill(&m_i2s, next, I2S_FRAME) < 0)
+            next = NULL;
+    }
+
+    newBuf.p_rx_buffer = NULL;
+    newBuf.p_tx_buffer = (uint32_t *)next;
+    if (next)
+        nrfx_i2s_next_buffers_set(&newBuf);
+    else
+        nrfx_i2s_stop();
+}
+
+static bool i2sTestRun (bool inHandler, bool wallClock, uint32_t jitterUs) {
+    nrfx_i2s_buffers_t firstBuf;
+    const i2sSimStats_t * stats;
+    uint32_t decodeUs = m_i2s.DecodeUs, spikeUs = m_i2s.SpikeUs;
+
+    memset(&m_i2s, 0, sizeof(m_i2s));
+    m_i2s.DecodeUs = decodeUs;
+    m_i2s.SpikeUs = spikeUs;
+    m_i2s.InHandler = inHandler;
+    m_i2s.Stream = wallClock ? I2S_WALL_STREAM : I2S_STREAM;
+    m_i2s.Expect = 1;
+    m_i2s.MinHeadroomUs = INT64_MAX;
+    PcmFifoInit(&m_i2s.Fifo, i2sTestFill, &m_i2s);
+
+    // playFile().
+    I2sSimConfigure(wallClock, jitterUs, 1);
+    I2sSimSetMonitor(i2sTestMonitor, NULL);
+    if (inHandler) {
+        i2sTestFill(&m_i2s, m_i2s.Fifo.Frames[0], I2S_FRAME);
+        m_i2s.Spare = m_i2s.Fifo.Frames[1];
+        firstBuf.p_tx_buffer = (uint32_t *)m_i2s.Fifo.Frames[0];
+    } else {
+        PcmFifoService(&m_i2s.Fifo);
+        firstBuf.p_tx_buffer = (uint32_t *)PcmFifoNext(&m_i2s.Fifo, NULL);
+    }
+    firstBuf.p_rx_buffer = NULL;
+    nrfx_i2s_start(&firstBuf, I2S_FRAME / 2, 0);
+
+    // decodeTask.
+    while (I2sSimRunning()) {
+        if (__atomic_exchange_n(&m_i2s.Notified, false, __ATOMIC_ACQ_REL))
+            PcmFifoService(&m_i2s.Fifo);
+        else
+            I2sSimIdle();
+    }
+
+    stats = I2sSimStats();
+    printf("  %-18s %3u frames, %u silent, %u replayed, %u late swaps, %u torn, %u out of order\r\n",
+           inHandler ? "decode in handler:" : "decode task:", m_i2s.Frames, m_i2s.Silent,
+           stats->Replays, stats->LateSwaps, m_i2s.Torn, m_i2s.OutOfOrder);
+    printf("  %-18s headroom %lld us decoded ahead, %lld us at the swap; handler %llu us at worst\r\n",
+           "", (long long)m_i2s.MinHeadroomUs, (long long)stats->MinHeadroomUs,
+           (unsigned long long)stats->WorstHandlerUs);
+    return m_i2s.Frames == (uint32_t)m_i2s.Stream && !m_i2s.Torn && !m_i2s.OutOfOrder && !stats->StateErrors;
+}
+
+// testbed i2s [decode us [spike us [jitter us [wall]]]]
+static int i2sTest (int argc, char ** argv) {
+    uint32_t jitterUs = argc > 2 ? atoi(argv[2]) : 0;
+    bool wallClock = argc > 3 && !strcmp(argv[3], "wall");
+    nrfx_i2s_config_t config = NRFX_I2S_DEFAULT_CONFIG(0, 0, NRFX_I2S_PIN_NOT_USED, 0, NRFX_I2S_PIN_NOT_USED);
+    bool ok;
+
+    // As in setup().
+    config.ratio = NRF_I2S_RATIO_64X;
+    config.mck_setup = NRF_I2S_MCK_32MDIV31;
+    nrfx_i2s_init(&config, i2sTestHandler);
+
+    m_i2s.DecodeUs = argc > 0 ? atoi(argv[0]) : I2S_DECODE_US;
+    m_i2s.SpikeUs = argc > 1 ? atoi(argv[1]) : I2S_SPIKE_US;
+    printf("%d frames of %d samples, %u us period, decode %u us with %u us every 10th, %u us jitter%s:\r\n",
+           wallClock ? I2S_WALL_STREAM : I2S_STREAM, I2S_FRAME, I2sSimPeriodUs(I2S_FRAME / 2),
+           m_i2s.DecodeUs, m_i2s.SpikeUs, jitterUs, wallClock ? ", wall clock" : "");
+    i2sTestRun(true, wallClock, jitterUs); // Only for comparison.
+    ok = i2sTestRun(false, wallClock, jitterUs);
+    nrfx_i2s_uninit();
+    if (!ok) {
+        printf("ERR! Frames lost or corrupted from the decode task.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+// PCM FIFO stress test: a decoder thread and an I2S thread, both flat out, with random
+// yields to shake out the interleavings.  Each frame carries its commit time in its first
+// four samples and its number in the rest.  The I2S side checks every frame when it's
+// queued and again when it's released: anything the decoder wrote into a frame in between
+// shows up as a mismatch.
+typedef struct {
+    pcmFifo_t Fifo;
+    uint32_t Yields;             // The producer's, which keeps the FIFO nearly full.
+} spscTest_t;
+
+static uint64_t nanoseconds (void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void * spscProducer (void * context) {
+    spscTest_t * test = (spscTest_t *)context;
+    unsigned seed = 2;
+    int16_t * frame;
+    uint64_t stamp;
+    uint32_t n;
+    int i;
+
+    for (n = 1; n <= SPSC_FRAMES; n++) {
+        while ((frame = PcmFifoWriteSlot(&test->Fifo)) == NULL)
+            sched_yield();
+        for (i = 4; i < PCM_FIFO_FRAME_LENGTH; i++)
+            frame[i] = (int16_t)n;
+        if (rand_r(&seed) % 16 == 0) {
+            test->Yields++;
+            sched_yield();
+        }
+        stamp = nanoseconds();
+        memcpy(frame, &stamp, sizeof(stamp));
+        PcmFifoCommit(&test->Fifo);
+    }
+    PcmFifoEnd(&test->Fifo);
+    return NULL;
+}
+
+static bool spscFrameOk (const int16_t * frame, int16_t n) {
+    int i;
+    for (i = 4; i < PCM_FIFO_FRAME_LENGTH; i++) {
+        if (frame[i] != n)
+            return false;
+    }
+    return true;
+}
+
+static int compareU64 (const void * a, const void * b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int spscTest (void) {
+    static spscTest_t test;
+    static uint64_t handoff[SPSC_FRAMES];
+    static uint64_t nextCost[SPSC_FRAMES];
+    const int16_t * playing = NULL;
+    const int16_t * queued;
+    const int16_t * released;
+    uint32_t frames = 0, timed = 0, errors = 0, silent = 0;
+    int16_t playingN = 0;
+    uint64_t start, took, seconds, stamp;
+    unsigned seed = 3;
+    pthread_t thread;
+
+    PcmFifoInit(&test.Fifo, NULL, NULL);
+    start = nanoseconds();
+    pthread_create(&thread, NULL, spscProducer, &test);
+
+    // The I2S side: one frame playing, one queued, as in nrfx.
+    queued = PcmFifoNext(&test.Fifo, NULL);
+    while (queued) {
+        released = playing;
+        if (released && released != test.Fifo.Silence && !spscFrameOk(released, playingN))
+            errors++; // Overwritten while the "DMA" had it.
+
+        playing = queued;
+        if (playing == test.Fifo.Silence) {
+            silent++;
+        } else {
+            memcpy(&stamp, playing, sizeof(stamp));
+            if (frames < SPSC_FRAMES)
+                handoff[frames] = nanoseconds() - stamp;
+            playingN = (int16_t)(frames + 1);
+            if (!spscFrameOk(playing, playingN))
+                errors++; // Torn, or out of order.
+            frames++;
+        }
+
+        took = nanoseconds();
+        queued = PcmFifoNext(&test.Fifo, released);
+        took = nanoseconds() - took;
+        if (queued && queued != test.Fifo.Silence && timed < SPSC_FRAMES)
+            nextCost[timed++] = took; // Only the calls that hand out a frame.
+
+        if (rand_r(&seed) % 64 == 0)
+            sched_yield();
+    }
+    pthread_join(thread, NULL);
+    seconds = nanoseconds() - start;
+
+    qsort(handoff, frames, sizeof(handoff[0]), compareU64);
+    qsort(nextCost, timed, sizeof(nextCost[0]), compareU64);
+    printf("%u frames of %d samples through %d slots, %.0f frames/s, %u errors\r\n",
+           frames, PCM_FIFO_FRAME_LENGTH, PCM_FIFO_FRAMES, frames * 1e9 / seconds, errors);
+    printf("  %u silence frames handed out, %u producer yields\r\n", silent, test.Yields);
+    printf("  PcmFifoNext:        median %6.0f ns, 99%% %6.0f ns, worst %8.0f ns\r\n",
+           (double)nextCost[timed / 2], (double)nextCost[timed * 99 / 100], (double)nextCost[timed - 1]);
+    printf("  commit to dequeue:  median %6.0f ns, 99%% %6.0f ns, worst %8.0f ns\r\n",
+           (double)handoff[frames / 2], (double)handoff[frames * 99 / 100], (double)handoff[frames - 1]);
+    if (frames != SPSC_FRAMES || errors) {
+        printf("ERR! Frames lost or corrupted.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Reframing check: a fake decoder hands out packets of random Opus durations (2.5 to
+// 120 ms at 16 kHz), each sample numbered, and the frames that come out of the FIFO must
+// carry every number in order with nothing dropped, doubled or padded, bar the tail.
+typedef struct {
+    pcmFifo_t * Fifo;
+    unsigned Seed;
+    bool Mixed;                 // Random durations, or 20 ms throughout.
+    int Held;                   // Length of a packet that didn't fit, or 0.
+    uint32_t Next;              // Number of the next sample to hand out.
+    uint32_t Packets, Spilled, Direct;
+} reframeSource_t;
+
+static int reframeFill (void * context, int16_t * destination, size_t samples) {
+    static const int durations[] = { 40, 80, 160, 320, 640, 960, 1280, 1600, 1920 };
+    reframeSource_t * source = (reframeSource_t *)context;
+    int length, i;
+
+    if (source->Next >= REFRAME_SAMPLES)
+        return -1;
+    if (source->Held)
+        length = source->Held;
+    else
+        length = source->Mixed ? durations[rand_r(&source->Seed) % 9] : 320;
+    if ((uint32_t)length > REFRAME_SAMPLES - source->Next)
+        length = REFRAME_SAMPLES - source->Next;
+    source->Held = 0;
+    if ((size_t)length > samples) {
+        source->Held = length;
+        return PCM_FIFO_NO_ROOM;
+    }
+
+    for (i = 0; i < length; i++)
+        destination[i] = (int16_t)((source->Next + i) % 30000 + 1);
+    source->Next += length;
+    source->Packets++;
+    if (destination == source->Fifo->Spill)
+        source->Spilled += length;
+    else
+        source->Direct += length;
+    return length;
+}
+
+static bool reframeRun (bool mixed) {
+    static pcmFifo_t fifo;
+    reframeSource_t source;
+    const int16_t * frame;
+    const int16_t * released = NULL;
+    uint32_t expect = 0, frames = 0, errors = 0, padding = 0;
+    int i;
+
+    memset(&source, 0, sizeof(source));
+    source.Fifo = &fifo;
+    source.Seed = 4;
+    source.Mixed = mixed;
+    PcmFifoInit(&fifo, reframeFill, &source);
+
+    for (;;) {
+        PcmFifoService(&fifo);
+        frame = PcmFifoNext(&fifo, released);
+        if (!frame)
+            break;
+        if (frame == fifo.Silence) {
+            errors++; // Nothing runs concurrently here, so this can't happen.
+            break;
+        }
+        for (i = 0; i < PCM_FIFO_FRAME_LENGTH; i++) {
+            if (expect < REFRAME_SAMPLES) {
+                if (frame[i] != (int16_t)(expect % 30000 + 1))
+                    errors++;
+                expect++;
+            } else if (frame[i] == 0) {
+                padding++;
+            } else {
+                errors++;
+            }
+        }
+        frames++;
+        released = frame;
+    }
+
+    printf("  %-13s %6u packets -> %6u frames, %u samples short, %u padding, %u errors, %.1f%% copied\r\n",
+           mixed ? "2.5-120 ms:" : "20 ms:", source.Packets, frames, REFRAME_SAMPLES - expect, padding,
+           errors, 100.0 * source.Spilled / (source.Spilled + source.Direct));
+    return expect == REFRAME_SAMPLES && !errors;
+}
+
+static int reframeTest (void) {
+    printf("%d sample frames: %.1f ms each, %.1f interrupts/s at 16 kHz:\r\n", PCM_FIFO_FRAME_LENGTH,
+           PCM_FIFO_FRAME_LENGTH / 16.0, 16000.0 / PCM_FIFO_FRAME_LENGTH);
+    if (!reframeRun(false) || !reframeRun(true)) {
+        printf("ERR! Samples lost or out of order.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Copy a page, changing its serial and redoing the CRC.
+static size_t copyPage (uint8_t * out, const uint8_t * page, uint32_t serial) {
+    size_t length = pageLength(page);
+    uint32_t crc;
+
+    memcpy(out, page, length);
+    memcpy(out + 14, &serial, 4);
+    memset(out + 22, 0, 4);
+    crc = OggCrcUpdate(0, out, length);
+    memcpy(out + 22, &crc, 4);
+    return length;
+}
+
+// Demux image with both packet calls and check what comes out against the reference
+// packets, expected `links` times over with a track change in between.
+static int checkDemux (const char * label, uint8_t * image, size_t length,
+                       const uint8_t * reference, int referenceCount, int links) {
+    static uint8_t buffer[CHAIN_BUFFER_LEN];
+    static uint8_t copy[CHAIN_BUFFER_LEN];
+    oggStream_t stream;
+    const uint8_t * packet;
+    const uint8_t * expect = reference;
+    uint32_t expectLen;
+    int bytesPulled, packets = 0, viewPackets, changes = 0, err = 0;
+
+    File file(fmemopen(image, length, "rb"));
+    OggStreamInit(&stream, &file, buffer, sizeof(buffer));
+    OggStreamSetCrcCheck(&stream, true);
+    if ( !OggStreamPrepare(&stream) || stream.IDHeader.Signature != OPUSHEAD_MAGIC )
+        err++;
+
+    for (;;) {
+        bytesPulled = OggStreamGetNextPacketView(&stream, &packet);
+        if (bytesPulled == OGG_STRIP_NEW_STREAM) {
+            if (packets % referenceCount || stream.IDHeader.Signature != OPUSHEAD_MAGIC)
+                err++;
+            expect = reference;
+            changes++;
+            continue;
+        }
+        if (bytesPulled < 0)
+            break;
+        memcpy(&expectLen, expect, 4);
+        if (expectLen != (uint32_t)bytesPulled || memcmp(expect + 4, packet, bytesPulled))
+            err++;
+        expect += 4 + expectLen;
+        packets++;
+    }
+    if (packets != referenceCount * links || changes != links - 1 || stream.Reader.BadPages)
+        err++;
+    viewPackets = packets;
+
+    // The copying call sticks to the first track.
+    OggStreamPrepare(&stream);
+    expect = reference;
+    packets = 0;
+    while ( (bytesPulled = OggStreamGetNextPacket(&stream, copy, sizeof(copy))) >= 0 ) {
+        memcpy(&expectLen, expect, 4);
+        if (expectLen != (uint32_t)bytesPulled || memcmp(expect + 4, copy, bytesPulled))
+            err++;
+        expect += 4 + expectLen;
+        packets++;
+    }
+    if (packets != referenceCount)
+        err++;
+    printf("  %-12s view: %5d packets, %d track changes, copy: %5d packets, %d errors\r\n",
+           label, viewPackets, changes, packets, err);
+
+    fclose(file.Handle);
+    return err;
+}
+
+static int chainTest (const char * name) {
+    static uint8_t buffer[CHAIN_BUFFER_LEN];
+    static const uint8_t muxHeadSegs[1] = { 64 };
+    static const uint8_t muxDataSegs[3] = { 255, 255, 90 };
+    uint8_t muxData[600];
+    oggStream_t stream;
+    const uint8_t * packet;
+    uint8_t * sample, * chained, * muxed, * reference;
+    size_t sampleLen, referenceLen = 0, pos, out;
+    uint32_t serial, sequence = 0, length;
+    int bytesPulled, count = 0, err = 0;
+
+    sample = loadFile(name, &sampleLen);
+    if (!sample) {
+        printf("ERR! Couldn't open %s.\r\n", name);
+        return 1;
+    }
+    memcpy(&serial, sample + 14, 4);
+
+    // Reference packets, each with a length in front.
+    reference = (uint8_t *)malloc(sampleLen * 2);
+    File file(fmemopen(sample, sampleLen, "rb"));
+    OggStreamInit(&stream, &file, buffer, sizeof(buffer));
+    OggStreamPrepare(&stream);
+    while ( (bytesPulled = OggStreamGetNextPacketView(&stream, &packet)) >= 0 ) {
+        length = bytesPulled;
+        memcpy(reference + referenceLen, &length, 4);
+        memcpy(reference + referenceLen + 4, packet, length);
+        referenceLen += 4 + length;
+        count++;
+    }
+    fclose(file.Handle);
+
+    // Chained: the file twice over, the second copy under a new serial.
+    chained = (uint8_t *)malloc(sampleLen * 2);
+    memcpy(chained, sample, sampleLen);
+    for (pos = 0, out = sampleLen; pos < sampleLen; pos += pageLength(sample + pos))
+        out += copyPage(chained + out, sample + pos, serial + 1);
+
+    // Multiplexed: a second, non-Opus stream whose BOS page comes first, then one of its
+    // pages after every one of ours.
+    muxed = (uint8_t *)malloc(sampleLen * 2 + (sampleLen / OGG_PAGE_HEADER_LEN + 2) * sizeof(muxData));
+    memset(muxData, 0xA5, sizeof(muxData));
+    memcpy(muxData, "fishead", 8);
+    out = putPage(muxed, muxHeadSegs, 1, muxData, MUX_SERIAL, sequence++, OGG_FLAG_BOS);
+    for (pos = 0; pos < sampleLen; pos += pageLength(sample + pos)) {
+        out += copyPage(muxed + out, sample + pos, serial);
+        out += putPage(muxed + out, muxDataSegs, 3, muxData, MUX_SERIAL, sequence++,
+                       pos + pageLength(sample + pos) == sampleLen ? OGG_FLAG_EOS : 0);
+    }
+
+    printf("%s: %d packets\r\n", name, count);
+    err |= checkDemux("chained x2", chained, sampleLen * 2, reference, count, 2);
+    err |= checkDemux("multiplexed", muxed, out, reference, count, 1);
+
+    free(muxed);
+    free(chained);
+    free(reference);
+    free(sample);
+    return err ? 1 : 0;
+}
+
+// Every packet of an .opk, read into memory up front so decoding them touches nothing else.
+typedef struct {
+    opkHeader_t Header;
+    uint8_t * Data;
+    uint32_t * Offsets;         // Count + 1 of them: packet n runs from Offsets[n] to Offsets[n + 1].
+    uint32_t Count;
+} packetList_t;
+
+static bool loadPackets (const char * name, packetList_t * list) {
+    static uint8_t buffer[8192];
+    opkReader_t reader;
+    const uint8_t * packet;
+    uint32_t used = 0;
+    int length;
+
+    FILE * handle = fopen(name, "rb");
+    if (!handle)
+        return false;
+    File file(handle);
+    if (OpkOpen(&reader, &file, buffer, sizeof(buffer), NULL) != OPK_OK) {
+        fclose(handle);
+        return false;
+    }
+    list->Header = reader.Header;
+    list->Offsets = (uint32_t *)malloc((reader.Header.PacketCount + 1) * sizeof(uint32_t));
+    list->Data = (uint8_t *)malloc(file.size());
+    for (list->Count = 0; list->Count < reader.Header.PacketCount; list->Count++) {
+        length = OpkGetNextPacket(&reader, &packet);
+        if (length < 0)
+            break;
+        list->Offsets[list->Count] = used;
+        memcpy(list->Data + used, packet, length);
+        used += length;
+    }
+    list->Offsets[list->Count] = used;
+    fclose(handle);
+    return true;
+}
+
+// Heap calls, counted while m_countAllocs is set, and otherwise passed straight to glibc.
+extern "C" void * __libc_malloc (size_t size);
+extern "C" void * __libc_calloc (size_t count, size_t size);
+extern "C" void * __libc_realloc (void * pointer, size_t size);
+static bool m_countAllocs;
+static uint32_t m_allocs;
+
+extern "C" void * malloc (size_t size) noexcept {
+    if (m_countAllocs)
+        m_allocs++;
+    return __libc_malloc(size);
+}
+extern "C" void * calloc (size_t count, size_t size) noexcept {
+    if (m_countAllocs)
+        m_allocs++;
+    return __libc_calloc(count, size);
+}
+extern "C" void * realloc (void * pointer, size_t size) noexcept {
+    if (m_countAllocs)
+        m_allocs++;
+    return __libc_realloc(pointer, size);
+}
+
+// Decoders in static storage, the way main.cpp keeps its one.  Build this and libopus with
+// -DOPUS_DECODER_MAX_CHANNELS=1 to try the mono-only decoder (which leaves stereo out).
+static union { void * align; uint8_t bytes[OPUS_DECODER_SIZE(1)]; } m_monoDecoder;
+static union { void * align; uint8_t bytes[OPUS_DECODER_SIZE(OPUS_DECODER_MAX_CHANNELS)]; } m_stereoDecoder;
+
+// Set a decoder up for a track, as startTrack does.  Packets needing a core left out of this
+// build (see coresTest) are concealed, so the tests still run through the whole file.
+static bool noAllocStart (OpusDecoder * decoder, opus_int32 rate, int channels, const opkHeader_t * header) {
+    bool ok = opus_decoder_init(decoder, rate, channels) == OPUS_OK;
+
+    ok &= opus_decoder_ctl(decoder, OPUS_SET_CONCEAL_UNSUPPORTED(1)) == OPUS_OK;
+    ok &= opus_decoder_ctl(decoder, OPUS_SET_SKIP_SAMPLES(header->PreSkip * rate / 48000)) == OPUS_OK;
+    ok &= opus_decoder_ctl(decoder, OPUS_SET_GAIN(header->OutputGain)) == OPUS_OK;
+    if (channels == 1)
+        ok &= opus_decoder_ctl(decoder, OPUS_SET_OUTPUT_PACKING(OPUS_PACKING_BOTH)) == OPUS_OK;
+    return ok;
+}
+
+// OPUS_DECODER_SIZE must agree with opus_decoder_get_size(), and a decoder placed in static
+// storage must never touch the heap.  Plays name mono and stereo at high and low rates,
+// through concealment and a re-init halfway (a chained track), counting every malloc, calloc
+// and realloc on the way.
+static int noAllocTest (const char * name) {
+    static const opus_int32 rates[] = { 48000, 16000, 8000 };
+    static opus_int16 pcm[5760 * 2];
+    packetList_t list;
+    OpusDecoder * decoder;
+    const uint8_t * packet;
+    opus_int32 length;
+    uint32_t n;
+    size_t r;
+    int channels, samples, err = 0, errors;
+
+    for (channels = 1; channels <= OPUS_DECODER_MAX_CHANNELS; channels++) {
+        printf("%s: OPUS_DECODER_SIZE %u bytes, opus_decoder_get_size %d\r\n",
+               channels == 1 ? "mono" : "stereo", (unsigned)OPUS_DECODER_SIZE(channels),
+               opus_decoder_get_size(channels));
+        if ((int)OPUS_DECODER_SIZE(channels) != opus_decoder_get_size(channels))
+            err++;
+    }
+    if (OPUS_DECODER_MAX_CHANNELS == 1) {
+        errors = opus_decoder_init((OpusDecoder *)&m_stereoDecoder, 48000, 2);
+        printf("stereo: left out of this build; opus_decoder_init returns %d\r\n", errors);
+        if (errors != OPUS_BAD_ARG)
+            err++;
+    }
+    if (!loadPackets(name, &list)) {
+        printf("ERR! Couldn't read %s.\r\n", name);
+        return 1;
+    }
+
+    for (channels = 1; channels <= OPUS_DECODER_MAX_CHANNELS; channels++) {
+        decoder = channels == 1 ? (OpusDecoder *)&m_monoDecoder : (OpusDecoder *)&m_stereoDecoder;
+        for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+            errors = 0;
+            m_allocs = 0;
+            m_countAllocs = true;
+            errors += !noAllocStart(decoder, rates[r], channels, &list.Header);
+            for (n = 0; n < list.Count; n++) {
+                if (n == list.Count / 2)
+                    errors += !noAllocStart(decoder, rates[r], channels, &list.Header);
+                packet = list.Data + list.Offsets[n];
+                length = list.Offsets[n + 1] - list.Offsets[n];
+                if (n % 37 == 36) {
+                    samples = opus_decode(decoder, NULL, 0, pcm, rates[r] / 50, 0);
+                } else {
+                    samples = opus_decoder_get_nb_samples(decoder, packet, length);
+                    if (samples >= 0)
+                        samples = opus_decode(decoder, packet, length, pcm, 5760, 0);
+                }
+                errors += samples < 0;
+            }
+            m_countAllocs = false;
+            printf("  %-6s %5d Hz: %u packets, %d errors, %u allocations\r\n", channels == 1 ? "mono" : "stereo",
+                   (int)rates[r], (unsigned)list.Count, errors, (unsigned)m_allocs);
+            err += errors + m_allocs;
+        }
+    }
+
+    // Make sure the counting works: opus_decoder_create has to show up.
+    m_allocs = 0;
+    m_countAllocs = true;
+    decoder = opus_decoder_create(16000, 1, &errors);
+    m_countAllocs = false;
+    opus_decoder_destroy(decoder);
+    if (!m_allocs) {
+        printf("ERR! opus_decoder_create wasn't seen allocating; the counting is broken.\r\n");
+        err++;
+    }
+
+    free(list.Data);
+    free(list.Offsets);
+    if (err) {
+        printf("ERR! Size mismatch, decode errors or allocations.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+// One pass over a packet list for scratchTest, on a thread of its own so its stack can be
+// measured.
+typedef struct {
+    OpusDecoder * Decoder;
+    const packetList_t * List;
+    opus_int32 Rate;
+    int Channels;
+    OpusScratchArena * Arena;   // NULL to leave the temporaries on the stack.
+    OpusScratchArena * Later;   // Swapped in halfway through, if not NULL.
+    uint32_t Hash;              // Of everything decoded.
+    int Errors;                 // Failed calls.
+    int AllocFails;             // Calls that ran out of arena.
+    size_t StackUsed;
+} scratchRun_t;
+
+static void * scratchDecode (void * context) {
+    static opus_int16 pcm[5760 * 2];
+    scratchRun_t * run = (scratchRun_t *)context;
+    const packetList_t * list = run->List;
+    OpusScratchArena * arena = run->Arena;
+    const uint8_t * packet;
+    uint32_t n;
+    opus_int32 peak;
+    int samples, i, words = run->Channels == 1 ? 2 : run->Channels; // Mono comes out in pairs.
+
+    run->Hash = 2166136261u;
+    run->Errors = !noAllocStart(run->Decoder, run->Rate, run->Channels, &list->Header);
+    run->Errors += opus_decoder_ctl(run->Decoder, OPUS_SET_SCRATCH_ARENA(run->Arena)) != OPUS_OK;
+    run->AllocFails = 0;
+    for (n = 0; n < list->Count; n++) {
+        if (n == list->Count / 2 && run->Later) {
+            arena = run->Later;
+            run->Errors += opus_decoder_ctl(run->Decoder, OPUS_SET_SCRATCH_ARENA(arena)) != OPUS_OK;
+        }
+        // Running out only shows in the peak, so take this call's on its own.
+        peak = arena ? arena->peak : 0;
+        if (arena)
+            arena->peak = 0;
+        packet = list->Data + list->Offsets[n];
+        if (n % 37 == 36)
+            samples = opus_decode(run->Decoder, NULL, 0, pcm, run->Rate / 50, 0);
+        else
+            samples = opus_decode(run->Decoder, packet, list->Offsets[n + 1] - list->Offsets[n], pcm, 5760, 0);
+        if (arena) {
+            run->AllocFails += arena->peak > arena->size;
+            if (arena->peak < peak)
+                arena->peak = peak;
+        }
+        if (samples < 0) {
+            run->Errors++;
+        } else {
+            for (i = 0; i < samples * words; i++)
+                run->Hash = (run->Hash ^ (uint16_t)pcm[i]) * 16777619u;
+        }
+    }
+    return NULL;
+}
+
+// Run a pass on a painted stack, and see how much of the paint is gone afterwards.
+static void scratchMeasure (scratchRun_t * run) {
+    uint8_t * stack = (uint8_t *)malloc(SCRATCH_STACK);
+    pthread_attr_t attributes;
+    pthread_t thread;
+    size_t untouched = 0;
+
+    memset(stack, 0xA5, SCRATCH_STACK);
+    pthread_attr_init(&attributes);
+    pthread_attr_setstack(&attributes, stack, SCRATCH_STACK);
+    pthread_create(&thread, &attributes, scratchDecode, run);
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attributes);
+    while (untouched < SCRATCH_STACK && stack[untouched] == 0xA5)
+        untouched++;
+    run->StackUsed = SCRATCH_STACK - untouched;
+    free(stack);
+}
+
+// With OPUS_SET_SCRATCH_ARENA, the decoder's temporaries should move off the stack and into
+// the arena, and come out the same.  Decodes name at each rate both ways, and reports the
+// stack used each way and the arena's peak, which is what the arena on the device has to
+// be.  Then decodes again with an arena half that size, swapping the full-size one back in
+// halfway: the calls that need more should put the rest on the stack, write nothing outside
+// the arena, return their samples as usual and leave the arena's peak above its size, and
+// everything should come out the same.
+static int scratchTest (const char * name) {
+    static const opus_int32 rates[] = { 48000, 16000, 8000 };
+    static union { uint64_t align; uint8_t bytes[SCRATCH_ARENA_MAX + 2 * SCRATCH_GUARD]; } memory;
+    packetList_t list;
+    OpusScratchArena arena, full;
+    scratchRun_t plain, arenaRun;
+    size_t r, i;
+    int channels, err = 0, guards;
+
+    if (!loadPackets(name, &list)) {
+        printf("ERR! Couldn't read %s.\r\n", name);
+        return 1;
+    }
+    for (channels = 1; channels <= OPUS_DECODER_MAX_CHANNELS; channels++) {
+        for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+            memset(&plain, 0, sizeof(plain));
+            plain.Decoder = channels == 1 ? (OpusDecoder *)&m_monoDecoder : (OpusDecoder *)&m_stereoDecoder;
+            plain.List = &list;
+            plain.Rate = rates[r];
+            plain.Channels = channels;
+            scratchMeasure(&plain);
+
+            arenaRun = plain;
+            arena.base = memory.bytes + SCRATCH_GUARD;
+            arena.size = SCRATCH_ARENA_MAX;
+            arena.peak = 0;
+            arenaRun.Arena = &arena;
+            scratchMeasure(&arenaRun);
+            printf("%-6s %5d Hz: stack %6u bytes without an arena, %6u with one; arena peak %6d bytes; %s\r\n",
+                   channels == 1 ? "mono" : "stereo", (int)rates[r], (unsigned)plain.StackUsed,
+                   (unsigned)arenaRun.StackUsed, (int)arena.peak,
+                   plain.Hash == arenaRun.Hash ? "same output" : "OUTPUT DIFFERS");
+            err += plain.Errors + arenaRun.Errors + arenaRun.AllocFails + (plain.Hash != arenaRun.Hash);
+
+            // The small arena sits at the bottom, with the full one above its guard.
+            memset(memory.bytes, 0x5A, sizeof(memory.bytes));
+            arena.size = arena.peak / 2;
+            arena.peak = 0;
+            full.base = memory.bytes + SCRATCH_ARENA_MAX / 2 + 2 * SCRATCH_GUARD;
+            full.size = SCRATCH_ARENA_MAX / 2;
+            full.peak = 0;
+            arenaRun.Later = &full;
+            scratchMeasure(&arenaRun);
+            guards = 0;
+            for (i = 0; i < SCRATCH_GUARD; i++)
+                guards += memory.bytes[i] != 0x5A;
+            for (i = SCRATCH_GUARD + arena.size; i < (size_t)(full.base - memory.bytes); i++)
+                guards += memory.bytes[i] != 0x5A;
+            printf("               %6d byte arena: %u of %u calls ran out, %d bytes written outside it, stack %6u bytes; %s\r\n",
+                   (int)arena.size, (unsigned)arenaRun.AllocFails, (unsigned)list.Count / 2, guards,
+                   (unsigned)arenaRun.StackUsed, plain.Hash == arenaRun.Hash ? "same output" : "OUTPUT DIFFERS");
+            // (Unless nothing needed the arena: every packet concealed by a decoder lacking its core.)
+            err += arenaRun.Errors + (arena.size && !arenaRun.AllocFails) + guards + (plain.Hash != arenaRun.Hash);
+        }
+    }
+
+    free(list.Data);
+    free(list.Offsets);
+    if (err) {
+        printf("ERR! Decode errors, differing output, or an arena that overflowed the wrong way.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+// One run of an encodeStream stream: Frames frames of FrameSize (at 48 kHz) in Mode.
+typedef struct {
+    int Mode;                   // MODE_SILK_ONLY, MODE_HYBRID or MODE_CELT_ONLY.
+    int Bandwidth;
+    opus_int32 Bitrate;
+    int FrameSize;
+    int Frames;
+} encodeRun_t;
+
+// ENCODE_SECONDS of stereo that the encoder has something to do with: a voice-like buzz
+// gliding between 100 and 300 Hz, its loudness swelling four times a second, over a
+// little noise.  Loud enough that +11.7 dB clips it.
+static opus_int16 * makeSignal (void) {
+    opus_int16 * pcm = (opus_int16 *)malloc(ENCODE_SECONDS * 48000 * 2 * sizeof(opus_int16));
+    double phase = 0, f0, level, x;
+    int i, h;
+
+    srand(7);
+    for (i = 0; i < ENCODE_SECONDS * 48000; i++) {
+        f0 = 200 + 100 * sin(2 * M_PI * 0.3 * i / 48000);
+        phase += 2 * M_PI * f0 / 48000;
+        level = 6000 * (1.2 + sin(2 * M_PI * 4 * i / 48000));
+        for (x = 0, h = 1; h <= 12; h++)
+            x += sin(h * phase) / h;
+        x = level * x + 400.0 * rand() / RAND_MAX - 200;
+        pcm[2 * i]     = (opus_int16)fmax(-32768, fmin(32767, x));
+        pcm[2 * i + 1] = (opus_int16)fmax(-32768, fmin(32767, 0.8 * x + 300 * sin(2 * M_PI * 1000.0 * i / 48000)));
+    }
+    return pcm;
+}
+
+// Encode makeSignal() with the in-tree encoder, in runs taken from runs[] in turn until the
+// signal runs out.  shared uses one encoder for all of them, so it smooths each switch with
+// a redundant CELT frame; otherwise each run has an encoder of its own, and the stream is
+// spliced from theirs, switching with no redundancy at all (as after a lost packet).
+static bool encodeStream (packetList_t * list, const encodeRun_t * runs, int count, bool shared) {
+    OpusEncoder * encoders[8];
+    opus_int16 * pcm = makeSignal();
+    uint32_t used = 0, capacity = 0;
+    int sample = 0, run = 0, frame, length, i, err = 0;
+
+    memset(list, 0, sizeof(*list));
+    for (i = 0; i < count && i < 8; i++) {
+        encoders[i] = shared && i ? encoders[0] : opus_encoder_create(48000, 2, OPUS_APPLICATION_AUDIO, &err);
+        if (err != OPUS_OK)
+            return false;
+    }
+    for (;;) {
+        const encodeRun_t * r = &runs[run % count];
+        OpusEncoder * encoder = encoders[run % count];
+        opus_encoder_ctl(encoder, OPUS_SET_FORCE_MODE(r->Mode));
+        opus_encoder_ctl(encoder, OPUS_SET_BANDWIDTH(r->Bandwidth));
+        opus_encoder_ctl(encoder, OPUS_SET_BITRATE(r->Bitrate));
+        for (frame = 0; frame < r->Frames; frame++) {
+            if (sample + r->FrameSize > ENCODE_SECONDS * 48000)
+                goto done;
+            if (used + 1500 > capacity) {
+                capacity = capacity ? capacity * 2 : 65536;
+                list->Data = (uint8_t *)realloc(list->Data, capacity);
+            }
+            if (!(list->Count & 255))
+                list->Offsets = (uint32_t *)realloc(list->Offsets, (list->Count + 257) * sizeof(uint32_t));
+            length = opus_encode(encoder, pcm + 2 * sample, r->FrameSize, list->Data + used, 1500);
+            if (length < 0)
+                return false;
+            list->Offsets[list->Count++] = used;
+            used += length;
+            sample += r->FrameSize;
+        }
+        run++;
+    }
+done:
+    list->Offsets[list->Count] = used;
+    for (i = 0; i < count && i < 8; i++)
+        if (!shared || !i)
+            opus_encoder_destroy(encoders[i]);
+    free(pcm);
+    return true;
+}
+
+// Streams for encodeStream that switch between SILK, hybrid and CELT every few frames, at
+// frame sizes of 2.5 to 60 ms: through one encoder (with redundant frames), and spliced.
+static const encodeRun_t m_switchedRuns[] = {
+    { MODE_SILK_ONLY, OPUS_BANDWIDTH_WIDEBAND,  24000, 960, 7 },
+    { MODE_HYBRID,    OPUS_BANDWIDTH_FULLBAND,  48000, 960, 5 },
+    { MODE_CELT_ONLY, OPUS_BANDWIDTH_FULLBAND,  64000, 960, 6 },
+    { MODE_HYBRID,    OPUS_BANDWIDTH_SUPERWIDEBAND, 40000, 480, 9 },
+    { MODE_SILK_ONLY, OPUS_BANDWIDTH_NARROWBAND, 12000, 1920, 3 },
+    { MODE_CELT_ONLY, OPUS_BANDWIDTH_FULLBAND,  64000, 480, 8 },
+};
+static const encodeRun_t m_splicedRuns[] = {
+    { MODE_SILK_ONLY, OPUS_BANDWIDTH_WIDEBAND,  24000, 960, 4 },
+    { MODE_CELT_ONLY, OPUS_BANDWIDTH_FULLBAND,  64000, 960, 3 },
+    { MODE_HYBRID,    OPUS_BANDWIDTH_FULLBAND,  48000, 480, 5 },
+    { MODE_SILK_ONLY, OPUS_BANDWIDTH_MEDIUMBAND, 16000, 2880, 2 },
+    { MODE_CELT_ONLY, OPUS_BANDWIDTH_FULLBAND,  64000, 240, 9 },
+    { MODE_HYBRID,    OPUS_BANDWIDTH_SUPERWIDEBAND, 40000, 960, 3 },
+    { MODE_CELT_ONLY, OPUS_BANDWIDTH_WIDEBAND,  48000, 120, 12 },
+};
+#define RUNS(runs) runs, (int)(sizeof(runs) / sizeof(runs[0]))
+
+// OPUS_SET_GAIN used to be a pass over each decoded frame, and is now applied as the output
+// is written, wherever that comes out the same.  Decode both switching streams both ways,
+// and check they agree to the bit: at each rate and gain, with concealment, and packed as
+// well as plain.
+static int gainTest (void) {
+    static const opus_int32 rates[] = { 8000, 16000, 48000 };
+    static const int gains[] = { -1500, 1000, 3000 };
+    static opus_int16 pcm[2][5760 * 2];
+    packetList_t list;
+    OpusDecoder * decoders[2];
+    const uint8_t * packet;
+    opus_int32 length;
+    uint32_t n, modes[3], decodes, differ;
+    int stream, channels, packing, r, g, samples[2], d, i, created, err = 0;
+
+    for (stream = 0; stream < 2; stream++) {
+        if (!(stream ? encodeStream(&list, RUNS(m_splicedRuns), false)
+                     : encodeStream(&list, RUNS(m_switchedRuns), true))) {
+            printf("ERR! Couldn't encode.\r\n");
+            return 1;
+        }
+        memset(modes, 0, sizeof(modes));
+        for (n = 0; n < list.Count; n++) {
+            packet = list.Data + list.Offsets[n];
+            modes[packet[0] & 0x80 ? 2 : (packet[0] & 0x60) == 0x60 ? 1 : 0]++;
+        }
+
+        decodes = differ = 0;
+        for (channels = 1; channels <= OPUS_DECODER_MAX_CHANNELS; channels++)
+        for (packing = 0; packing <= (channels == 1); packing++)
+        for (r = 0; r < 3; r++)
+        for (g = 0; g < 3; g++) {
+            for (d = 0; d < 2; d++) {
+                decoders[d] = opus_decoder_create(rates[r], channels, &created);
+                if (created != OPUS_OK)
+                    return 1;
+                opus_decoder_ctl(decoders[d], OPUS_SET_GAIN(gains[g]));
+                opus_decoder_ctl(decoders[d], OPUS_SET_GAIN_PASS(d));
+                opus_decoder_ctl(decoders[d], OPUS_SET_OUTPUT_PACKING(packing));
+                opus_decoder_ctl(decoders[d], OPUS_SET_CONCEAL_UNSUPPORTED(1));
+            }
+            for (n = 0; n < list.Count; n++) {
+                packet = list.Data + list.Offsets[n];
+                length = list.Offsets[n + 1] - list.Offsets[n];
+                for (d = 0; d < 2; d++) {
+                    if (n % GAIN_LOSS == GAIN_LOSS - 1)
+                        samples[d] = opus_decode(decoders[d], NULL, 0, pcm[d],
+                                                 opus_packet_get_nb_samples(packet, length, rates[r]), 0);
+                    else
+                        samples[d] = opus_decode(decoders[d], packet, length, pcm[d], 5760, 0);
+                }
+                if (samples[0] < 0 || samples[0] != samples[1]) {
+                    err++;
+                    continue;
+                }
+                for (i = 0; i < samples[0] * (packing ? 2 : channels); i++)
+                    differ += pcm[0][i] != pcm[1][i];
+            }
+            for (d = 0; d < 2; d++)
+                opus_decoder_destroy(decoders[d]);
+            decodes++;
+        }
+
+        printf("%s: %u packets (%u SILK, %u hybrid, %u CELT), %u decodes, %u samples differ\r\n",
+               stream ? "Spliced, no redundancy  " : "Switched, with redundancy",
+               (unsigned)list.Count, (unsigned)modes[0], (unsigned)modes[1], (unsigned)modes[2],
+               (unsigned)decodes, (unsigned)differ);
+        err += differ != 0;
+        free(list.Data);
+        free(list.Offsets);
+    }
+    if (err) {
+        printf("ERR! Decode errors, or the gain applied on the way out differs from the pass.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Decode mono into every OPUS_SET_OUTPUT_PACKING, which CELT's deemphasis and SILK's
+// resampler now write as they go, and check each against the plain mono decode spread into
+// pairs by hand: on both switching streams, at each rate, with and without gain, and with
+// concealment.  Then time a SILK-only stream plain and packed at 16 and 48 kHz.
+static int packTest (void) {
+    static const encodeRun_t silkOnly[] = {
+        { MODE_SILK_ONLY, OPUS_BANDWIDTH_WIDEBAND, 24000, 960, 1 },
+    };
+    static const opus_int32 rates[] = { 8000, 12000, 16000, 24000, 48000 };
+    static const int gains[] = { 0, 1000 };
+    static const opus_int16 masks[4][2] = { { 0, 0 }, { -1, -1 }, { -1, 0 }, { 0, -1 } };
+    static opus_int16 plain[5760], packed[5760 * 2];
+    packetList_t list;
+    OpusDecoder * decoders[2];
+    const uint8_t * packet;
+    opus_int32 length;
+    uint32_t n, pass, decodes, differ;
+    clock_t start;
+    double seconds[2];
+    int stream, packing, r, g, samples[2], d, i, created, err = 0;
+
+    for (stream = 0; stream < 2; stream++) {
+        if (!(stream ? encodeStream(&list, RUNS(m_splicedRuns), false)
+                     : encodeStream(&list, RUNS(m_switchedRuns), true))) {
+            printf("ERR! Couldn't encode.\r\n");
+            return 1;
+        }
+        decodes = differ = 0;
+        for (packing = OPUS_PACKING_BOTH; packing <= OPUS_PACKING_RIGHT; packing++)
+        for (r = 0; r < 5; r++)
+        for (g = 0; g < 2; g++) {
+            for (d = 0; d < 2; d++) {
+                decoders[d] = opus_decoder_create(rates[r], 1, &created);
+                if (created != OPUS_OK)
+                    return 1;
+                opus_decoder_ctl(decoders[d], OPUS_SET_GAIN(gains[g]));
+                opus_decoder_ctl(decoders[d], OPUS_SET_CONCEAL_UNSUPPORTED(1));
+            }
+            opus_decoder_ctl(decoders[1], OPUS_SET_OUTPUT_PACKING(packing));
+            for (n = 0; n < list.Count; n++) {
+                packet = list.Data + list.Offsets[n];
+                length = list.Offsets[n + 1] - list.Offsets[n];
+                if (n % GAIN_LOSS == GAIN_LOSS - 1) {
+                    length = opus_packet_get_nb_samples(packet, length, rates[r]);
+                    samples[0] = opus_decode(decoders[0], NULL, 0, plain, length, 0);
+                    samples[1] = opus_decode(decoders[1], NULL, 0, packed, length, 0);
+                } else {
+                    samples[0] = opus_decode(decoders[0], packet, length, plain, 5760, 0);
+                    samples[1] = opus_decode(decoders[1], packet, length, packed, 5760, 0);
+                }
+                if (samples[0] < 0 || samples[0] != samples[1]) {
+                    err++;
+                    continue;
+                }
+                for (i = 0; i < samples[0]; i++)
+                    differ += packed[2 * i]     != (plain[i] & masks[packing][0])
+                            || packed[2 * i + 1] != (plain[i] & masks[packing][1]);
+            }
+            for (d = 0; d < 2; d++)
+                opus_decoder_destroy(decoders[d]);
+            decodes++;
+        }
+        printf("%s: %u packets, %u decodes, %u samples differ\r\n",
+               stream ? "Spliced, no redundancy  " : "Switched, with redundancy",
+               (unsigned)list.Count, (unsigned)decodes, (unsigned)differ);
+        err += differ != 0;
+        free(list.Data);
+        free(list.Offsets);
+    }
+
+    // Timed only where there's a SILK decoder to time.
+    if (OPUS_DECODER_CORES & OPUS_DECODER_SILK) {
+        if (!encodeStream(&list, RUNS(silkOnly), true)) {
+            printf("ERR! Couldn't encode.\r\n");
+            return 1;
+        }
+        for (r = 2; r < 5; r += 2) {
+            for (d = 0; d < 2; d++) {
+                decoders[0] = opus_decoder_create(rates[r], 1, &created);
+                if (created != OPUS_OK)
+                    return 1;
+                opus_decoder_ctl(decoders[0], OPUS_SET_OUTPUT_PACKING(d ? OPUS_PACKING_BOTH : OPUS_PACKING_NONE));
+                start = clock();
+                for (pass = 0; pass < PACK_PASSES; pass++)
+                    for (n = 0; n < list.Count; n++)
+                        if (opus_decode(decoders[0], list.Data + list.Offsets[n],
+                                        list.Offsets[n + 1] - list.Offsets[n], d ? packed : plain, 5760, 0) < 0)
+                            err++;
+                seconds[d] = secondsSince(start);
+                opus_decoder_destroy(decoders[0]);
+            }
+            printf("SILK at %2d kHz: %.2f us per 20 ms plain, %.2f us packed (%.2fx)\r\n",
+                   (int)(rates[r] / 1000), seconds[0] * 1e6 / (PACK_PASSES * list.Count),
+                   seconds[1] * 1e6 / (PACK_PASSES * list.Count), seconds[0] / seconds[1]);
+        }
+        free(list.Data);
+        free(list.Offsets);
+    }
+
+    if (err) {
+        printf("ERR! Decode errors, or packed output that isn't the plain output spread out.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Build this and libopus with -DOPUS_DECODER_CORES=1 (SILK alone) or 2 (CELT alone) for a
+// decoder that leaves the other core out.  Its size has to shrink to match, packets needing
+// the missing core have to fail with OPUS_UNIMPLEMENTED, and once asked to conceal them, each
+// has to come back as its own length of concealment; the rest decode as usual.  Checked on
+// name, and on both of encodeStream's switching streams, so SILK and hybrid packets are
+// covered whatever name holds.
+static int coresTest (const char * name) {
+    static opus_int16 pcm[5760 * 2];
+    static const char * const modeNames[3] = { "SILK", "hybrid", "CELT" };
+    packetList_t list;
+    OpusDecoder * decoder = (OpusDecoder *)&m_monoDecoder;
+    const uint8_t * packet;
+    opus_int32 length, conceal, readBack;
+    uint32_t n, packets[3], failed[3];
+    bool have[3];
+    int source, mode, samples, expected, err = 0;
+
+    have[0] = (OPUS_DECODER_CORES & OPUS_DECODER_SILK) != 0;
+    have[2] = (OPUS_DECODER_CORES & OPUS_DECODER_CELT) != 0;
+    have[1] = have[0] && have[2];
+    printf("Cores: %s%s%s; OPUS_DECODER_SIZE(1) %u bytes, opus_decoder_get_size(1) %d\r\n",
+           have[0] ? "SILK" : "", have[1] ? " and " : "", have[2] ? "CELT" : "",
+           (unsigned)OPUS_DECODER_SIZE(1), opus_decoder_get_size(1));
+    if ((int)OPUS_DECODER_SIZE(1) != opus_decoder_get_size(1))
+        err++;
+
+    for (source = 0; source < 3; source++) {
+        if (source == 0 && !loadPackets(name, &list)) {
+            printf("ERR! Couldn't read %s.\r\n", name);
+            return 1;
+        }
+        if ((source == 1 && !encodeStream(&list, RUNS(m_switchedRuns), true))
+         || (source == 2 && !encodeStream(&list, RUNS(m_splicedRuns), false))) {
+            printf("ERR! Couldn't encode.\r\n");
+            return 1;
+        }
+        printf("%s:\r\n", source == 0 ? name : source == 1 ? "Switched, with redundancy" : "Spliced, no redundancy");
+
+        for (conceal = 0; conceal <= 1; conceal++) {
+            err += !noAllocStart(decoder, 16000, 1, &list.Header);
+            err += opus_decoder_ctl(decoder, OPUS_SET_SKIP_SAMPLES(0)) != OPUS_OK; // Whole packets only.
+            err += opus_decoder_ctl(decoder, OPUS_SET_CONCEAL_UNSUPPORTED(conceal)) != OPUS_OK;
+            err += opus_decoder_ctl(decoder, OPUS_GET_CONCEAL_UNSUPPORTED(&readBack)) != OPUS_OK || readBack != conceal;
+            memset(packets, 0, sizeof(packets));
+            memset(failed, 0, sizeof(failed));
+            for (n = 0; n < list.Count; n++) {
+                packet = list.Data + list.Offsets[n];
+                length = list.Offsets[n + 1] - list.Offsets[n];
+                mode = packet[0] & 0x80 ? 2 : (packet[0] & 0x60) == 0x60 ? 1 : 0;
+                expected = opus_packet_get_nb_samples(packet, length, 16000);
+                samples = opus_decode(decoder, packet, length, pcm, 5760, 0);
+                packets[mode]++;
+                if (samples != (have[mode] || conceal ? expected : OPUS_UNIMPLEMENTED))
+                    failed[mode]++;
+            }
+            printf("  %s: ", conceal ? "concealing" : "refusing  ");
+            for (mode = 0; mode < 3; mode++) {
+                printf("%s%u %s packets %s", mode ? ", " : "", (unsigned)packets[mode], modeNames[mode],
+                       have[mode] ? "decoded" : conceal ? "concealed" : "refused");
+                if (failed[mode])
+                    printf(" (%u WRONG)", (unsigned)failed[mode]);
+                err += failed[mode];
+            }
+            printf("\r\n");
+        }
+
+        free(list.Data);
+        free(list.Offsets);
+    }
+    if (err) {
+        printf("ERR! Size mismatch, or packets decoded, refused or concealed wrongly.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Tables for decimated CELT synthesis (CELTDecimation, in libopus/celt/modes.h): for each
+// downsampling factor, an IMDCT sized to the output rate, and the filters that stand in for
+// the 48 kHz postfilter and deemphasis there.  The FFT and MDCT tables are worked out as
+// kiss_fft.c, mdct.c and modes.c work them out for custom modes, which aren't built here;
+// FFT sizes the 48 kHz mode already has come from it rather than being repeated.
+#define DECIMATE_FITS    512  // Frequencies each filter is fitted at...
+#define DECIMATE_FIT_TOP 0.95 // ...spread evenly up to this fraction of the output Nyquist.
+#define DECIMATE_TAPS    4    // Postfilter taps, at pitch lag - 1 to lag + 2 at the output rate.
+
+static const int m_decimateFactors[] = { 2, 3, 4, 6 };
+
+// The postfilter's three tapsets (gains[] in celt.c), Q15: centre tap, then the pair either
+// side of it, then the pair two away.
+static const int m_combTapsets[3][3] = { { 10048, 7112, 4248 }, { 15200, 8784, 0 }, { 26208, 3280, 0 } };
+
+// kf_factor(): fours first, then a two (moved in behind the first four), then threes and
+// fives, and the whole list reversed.  Returns the number of stages.
+static int fftFactor (int n, int16_t * factors) {
+    int p = 4, stages = 0, length = n, i;
+
+    do {
+        while (n % p) {
+            p = p == 4 ? 2 : p == 2 ? 3 : p + 2;
+            if (p * p > n)
+                p = n;
+        }
+        n /= p;
+        factors[2 * stages] = p;
+        if (p == 2 && stages > 1) {
+            factors[2 * stages] = 4;
+            factors[2] = 2;
+        }
+        stages++;
+    } while (n > 1);
+    for (i = 0; i < stages / 2; i++) {
+        int16_t radix = factors[2 * i];
+        factors[2 * i] = factors[2 * (stages - i - 1)];
+        factors[2 * (stages - i - 1)] = radix;
+    }
+    for (i = 0; i < stages; i++) {
+        length /= factors[2 * i];
+        factors[2 * i + 1] = length;
+    }
+    return stages;
+}
+
+// compute_bitrev_table().
+static void fftBitrev (int out, int16_t * f, int stride, const int16_t * factors) {
+    int p = factors[0], m = factors[1], j;
+
+    for (j = 0; j < p; j++, f += stride) {
+        if (m == 1) {
+            *f = out + j;
+        } else {
+            fftBitrev(out, f, stride * p, factors + 2);
+            out += m;
+        }
+    }
+}
+
+// celt_cos_norm() from mathops.c, which the fixed-point FFT twiddles are made with: the cosine
+// of x * pi/2, x in Q16.
+static int16_t productP15 (int a, int b) {
+    return (int16_t)(((int32_t)(int16_t)a * (int16_t)b + 16384) >> 15);
+}
+static int16_t cosPi2 (int16_t x) {
+    int16_t x2 = productP15(x, x);
+    int32_t sum = (32767 - x2) + productP15(x2, -7651 + productP15(x2, 8277 + productP15(-626, x2)));
+    return (int16_t)(1 + (sum < 32766 ? sum : 32766));
+}
+static int16_t cosNorm (int32_t x) {
+    x &= 0x1FFFF;
+    if (x > 65536)
+        x = 131072 - x;
+    if (x & 0x7FFF)
+        return x < 32768 ? cosPi2((int16_t)x) : -cosPi2((int16_t)(65536 - x));
+    if (x & 0xFFFF)
+        return 0;
+    return x ? -32767 : 32767;
+}
+
+// Least squares: solve the n by n system a x = b in place (a is row major), by Gaussian
+// elimination with partial pivoting.
+static void solveLinear (double * a, double * b, int n) {
+    int i, j, k, pivot;
+
+    for (i = 0; i < n; i++) {
+        pivot = i;
+        for (j = i + 1; j < n; j++)
+            if (fabs(a[j * n + i]) > fabs(a[pivot * n + i]))
+                pivot = j;
+        for (k = 0; k < n; k++) {
+            double t = a[i * n + k];
+            a[i * n + k] = a[pivot * n + k];
+            a[pivot * n + k] = t;
+        }
+        double t = b[i];
+        b[i] = b[pivot];
+        b[pivot] = t;
+        for (j = i + 1; j < n; j++) {
+            double f = a[j * n + i] / a[i * n + i];
+            for (k = i; k < n; k++)
+                a[j * n + k] -= f * a[i * n + k];
+            b[j] -= f * b[i];
+        }
+    }
+    for (i = n - 1; i >= 0; i--) {
+        for (k = i + 1; k < n; k++)
+            b[i] -= a[i * n + k] * b[k];
+        b[i] /= a[i * n + i];
+    }
+}
+
+static int roundQ (double value, int shift) {
+    double scaled = floor(0.5 + value * (1 << shift));
+    return scaled > 32767 ? 32767 : scaled < -32767 ? -32767 : (int)scaled;
+}
+
+// The postfilter at a 48 kHz lag of T = q * factor + phase, as taps at q - 1 to q + 2 of the
+// output rate: fitted to the 48 kHz filter's response there, which is its tapset's smoothing
+// kernel, delayed by T / factor samples.
+static void fitCombTaps (int factor, int tapset, int phase, int * taps) {
+    double a[DECIMATE_TAPS * DECIMATE_TAPS] = { 0 }, b[DECIMATE_TAPS] = { 0 };
+    const int * gains = m_combTapsets[tapset];
+    int i, j, k;
+
+    for (i = 0; i < DECIMATE_FITS; i++) {
+        double w = DECIMATE_FIT_TOP * M_PI * (i + 0.5) / DECIMATE_FITS;
+        double kernel = (gains[0] + 2 * gains[1] * cos(w / factor) + 2 * gains[2] * cos(2 * w / factor)) / 32768.;
+        for (j = 0; j < DECIMATE_TAPS; j++) {
+            for (k = 0; k < DECIMATE_TAPS; k++)
+                a[j * DECIMATE_TAPS + k] += cos(w * (j - k));
+            b[j] += kernel * cos(w * (j - 1 - (double)phase / factor));
+        }
+    }
+    solveLinear(a, b, DECIMATE_TAPS);
+    for (j = 0; j < DECIMATE_TAPS; j++)
+        taps[j] = roundQ(b[j], 15);
+}
+
+// Deemphasis at the output rate, (b0 + b1 z^-1) / (1 - p z^-1), fitted to the magnitude of
+// the 48 kHz filter's response there (its phase can't be matched at this order, and doesn't
+// matter after the postfilter).  For each pole on a grid, |b0 + b1 e^-jw|^2 = B0 + B1 cos w
+// is fitted by least squares on the relative error; the pole with the smallest worst-case
+// error in dB wins, and b0 and b1 come from factoring its B0 and B1.
+static void fitDeemphasis (int factor, int * coefs) {
+    const double coef = 27853 / 32768.;
+    double best = 1e9, bestP = 0, bestB[2] = { 1, 0 };
+    int i, grid;
+
+    for (grid = 0; grid < 950; grid++) {
+        double p = grid / 1000., a[4] = { 0 }, b[2] = { 0 }, worst = 0;
+        for (i = 0; i < DECIMATE_FITS; i++) {
+            double w = DECIMATE_FIT_TOP * M_PI * (i + 0.5) / DECIMATE_FITS;
+            double target = (1 + p * p - 2 * p * cos(w)) / (1 + coef * coef - 2 * coef * cos(w / factor));
+            a[0] += 1 / (target * target);
+            a[1] += cos(w) / (target * target);
+            a[3] += cos(w) * cos(w) / (target * target);
+            b[0] += 1 / target;
+            b[1] += cos(w) / target;
+        }
+        a[2] = a[1];
+        solveLinear(a, b, 2);
+        if (b[0] < fabs(b[1]))
+            continue;
+        for (i = 0; i < DECIMATE_FITS; i++) {
+            double w = DECIMATE_FIT_TOP * M_PI * (i + 0.5) / DECIMATE_FITS;
+            double target = (1 + p * p - 2 * p * cos(w)) / (1 + coef * coef - 2 * coef * cos(w / factor));
+            worst = fmax(worst, fabs(10 * log10((b[0] + b[1] * cos(w)) / target)));
+        }
+        if (worst < best) {
+            best = worst;
+            bestP = p;
+            bestB[0] = b[0];
+            bestB[1] = b[1];
+        }
+    }
+    coefs[0] = roundQ(bestP, 15);
+    coefs[1] = roundQ((sqrt(bestB[0] + bestB[1]) + sqrt(bestB[0] - bestB[1])) / 2, 13);
+    coefs[2] = roundQ((sqrt(bestB[0] + bestB[1]) - sqrt(bestB[0] - bestB[1])) / 2, 13);
+}
+
+static void writeTable (FILE * out, const char * declaration, const int * values, int count, int perLine) {
+    int i;
+
+    fprintf(out, "%s = {\n", declaration);
+    for (i = 0; i < count; i++)
+        fprintf(out, "%d,%s", values[i], (i + 1) % perLine && i + 1 < count ? " " : "\n");
+    fprintf(out, "};\n\n");
+}
+
+// Name of the kiss_fft_state for an FFT of size, from the 48 kHz mode if it has one.
+static void fftStateName (int size, char * name) {
+    if (480 % size == 0 && !((480 / size) & (480 / size - 1)) && size >= 60)
+        sprintf(name, "fft_state48000_960_%d", __builtin_ctz(480 / size));
+    else
+        sprintf(name, "fft_state%d", size);
+}
+
+static int writeDecimateTables (const char * name) {
+    static const int newFfts[] = { 160, 80, 40, 20, 10, 30, 15 };
+    int values[960];
+    int16_t factors[32], bitrev[160];
+    char declaration[80], states[4][32];
+    size_t f;
+    int i, n, level, factor, size, base, shift;
+
+    FILE * out = fopen(name, "w");
+    if (!out) {
+        printf("ERR! Couldn't write %s.\r\n", name);
+        return 1;
+    }
+    fprintf(out, "/* Decimated synthesis tables for the 48 kHz, 960 sample mode (CELTDecimation in\n"
+                 "   modes.h). Generated by \"testbed dtables\" in pc_testbed; don't edit. */\n\n"
+                 "#ifndef STATIC_DECIMATE_FIXED_H\n#define STATIC_DECIMATE_FIXED_H\n\n");
+
+    for (f = 0; f < sizeof(m_decimateFactors) / sizeof(m_decimateFactors[0]); f++) {
+        n = 120 / m_decimateFactors[f];
+        for (i = 0; i < n; i++) {
+            double s = sin(.5 * M_PI * (i + .5) / n);
+            values[i] = (int)fmin(32767, floor(.5 + 32768. * sin(.5 * M_PI * s * s)));
+        }
+        sprintf(declaration, "static const opus_val16 window%d[%d]", n, n);
+        writeTable(out, declaration, values, n, 5);
+    }
+
+    fprintf(out, "static const kiss_twiddle_cpx fft_twiddles160[160] = {\n");
+    for (i = 0; i < 160; i++) {
+        int32_t phase = -(i << 17) / 160;
+        fprintf(out, "{%d, %d},%s", cosNorm(phase), cosNorm(phase - 32768), i & 1 ? "\n" : " ");
+    }
+    fprintf(out, "};\n\n");
+
+    for (f = 0; f < sizeof(newFfts) / sizeof(newFfts[0]); f++) {
+        size = newFfts[f];
+        fftFactor(size, factors);
+        fftBitrev(0, bitrev, 1, factors);
+        for (i = 0; i < size; i++)
+            values[i] = bitrev[i];
+        sprintf(declaration, "static const opus_int16 fft_bitrev%d[%d]", size, size);
+        writeTable(out, declaration, values, size, 15);
+    }
+    for (f = 0; f < sizeof(newFfts) / sizeof(newFfts[0]); f++) {
+        size = newFfts[f];
+        memset(factors, 0, sizeof(factors));
+        fftFactor(size, factors);
+        base = 160 % size == 0 ? 160 : 480;
+        for (shift = 0; size << shift != base; shift++)
+            ;
+        i = 31 - __builtin_clz(size);
+        fprintf(out, "static const kiss_fft_state fft_state%d = {\n%d,    /* nfft */\n%d,    /* scale */\n"
+                     "%d,      /* scale_shift */\n%d,      /* shift */\n{", size, size,
+                size == 1 << i ? 32767 : (1073741824 + size / 2) / size >> (15 - i), i, shift ? shift : -1);
+        for (i = 0; i < 16; i++)
+            fprintf(out, "%d, ", factors[i]);
+        fprintf(out, "},    /* factors */\nfft_bitrev%d,  /* bitrev */\n%s,  /* twiddles */\n"
+                     "NULL,\n};\n\n", size, base == 160 ? "fft_twiddles160" : "fft_twiddles48000_960");
+    }
+
+    // One run of MDCT twiddles for the factors that halve the frame, and one for those that
+    // divide it by three; each goes a level further than the IMDCT at 2x and 3x need, so the
+    // one at 4x and 6x can start a level in.
+    for (base = 480; base >= 320; base -= 160) {
+        size = 2 * base;
+        n = 0;
+        for (level = 0; level < 5; level++, size >>= 1)
+            for (i = 0; i < size / 2; i++)
+                values[n++] = (int)fmax(-32767, fmin(32767, floor(.5 + 32768 * cos(2 * M_PI * (i + .125) / size))));
+        sprintf(declaration, "static const opus_val16 mdct_twiddles%d[%d]", base, n);
+        writeTable(out, declaration, values, n, 5);
+    }
+
+    for (f = 0; f < sizeof(m_decimateFactors) / sizeof(m_decimateFactors[0]); f++) {
+        factor = m_decimateFactors[f];
+        n = 0;
+        for (i = 0; i < 3; i++)
+            for (shift = 0; shift < factor; shift++, n += DECIMATE_TAPS)
+                fitCombTaps(factor, i, shift, values + n);
+        sprintf(declaration, "static const opus_val16 comb_taps%d[%d]", factor, n);
+        writeTable(out, declaration, values, n, DECIMATE_TAPS);
+    }
+
+    fprintf(out, "static const CELTDecimation decimation48000_960[%d] = {\n",
+            (int)(sizeof(m_decimateFactors) / sizeof(m_decimateFactors[0])));
+    for (f = 0; f < sizeof(m_decimateFactors) / sizeof(m_decimateFactors[0]); f++) {
+        factor = m_decimateFactors[f];
+        for (level = 0; level < 4; level++)
+            fftStateName(480 / factor >> level, states[level]);
+        fitDeemphasis(factor, values);
+        fprintf(out, "{%d, %d, %d, window%d,\n {%d, 3, {&%s, &%s, &%s, &%s}, mdct_twiddles%d%s},\n"
+                     " {%d, %d, %d}, comb_taps%d},\n", factor, 120 / factor, 120 / factor, 120 / factor,
+                1920 / factor, states[0], states[1], states[2], states[3], factor % 3 ? 480 : 320,
+                factor == 4 ? "+480" : factor == 6 ? "+320" : "", values[0], values[1], values[2], factor);
+    }
+    fprintf(out, "};\n\n#endif\n");
+    fclose(out);
+    printf("Wrote %s.\r\n", name);
+    return 0;
+}
+
+// Scores a decode at rate against a reference decode of the same stream (at 48 kHz, or at
+// rate), the way opus_compare scores the conformance vectors: per-bin power spectra in 100 Hz bins, masked by their
+// neighbours in frequency and time (the masking added to both), then the ratio of the two
+// spectra over the bands rate can carry.  Q of 0 or more passes; 100 is identical.
+#define COMPARE_BANDS  21
+#define COMPARE_BINS   240
+#define COMPARE_WINDOW 480 // At 48 kHz, a bin every 100 Hz.
+#define COMPARE_STEP   120
+
+static const int m_compareBands[COMPARE_BANDS + 1] = {
+    0, 2, 4, 6, 8, 10, 12, 14, 16, 20, 24, 28, 32, 40, 48, 56, 68, 80, 96, 120, 156, 200
+};
+
+static void comparePowers (const opus_int16 * x, int frames, int factor, float * power) {
+    int window = COMPARE_WINDOW / factor, step = COMPARE_STEP / factor, bins = window / 2;
+    static double shape[COMPARE_WINDOW], cosines[COMPARE_WINDOW], sines[COMPARE_WINDOW];
+    double windowed[COMPARE_WINDOW];
+    int frame, k, j;
+
+    for (j = 0; j < window; j++) {
+        shape[j] = .5 - .5 * cos(2 * M_PI * j / (window - 1));
+        cosines[j] = cos(2 * M_PI * j / window);
+        sines[j] = sin(2 * M_PI * j / window);
+    }
+    for (frame = 0; frame < frames; frame++) {
+        for (j = 0; j < window; j++)
+            windowed[j] = shape[j] * x[frame * step + j];
+        for (k = 0; k < COMPARE_BINS; k++) {
+            double re = 0, im = 0;
+            if (k < bins) {
+                for (j = 0; j < window; j++) {
+                    re += windowed[j] * cosines[k * j % window];
+                    im -= windowed[j] * sines[k * j % window];
+                }
+            }
+            // The same tone has 1/factor the amplitude over a window 1/factor as long.  Every
+            // bin has a floor, so near-silence doesn't count.
+            power[frame * COMPARE_BINS + k] = (float)((re * re + im * im) * factor * factor + 100000);
+        }
+    }
+}
+
+static double compareQuality (const opus_int16 * reference, opus_int32 referenceRate,
+                              const opus_int16 * test, int length, opus_int32 rate) {
+    int factor = 48000 / rate, frames = (length * factor - COMPARE_WINDOW + COMPARE_STEP) / COMPARE_STEP;
+    int bands = rate == 8000 ? 13 : rate == 12000 ? 15 : rate == 16000 ? 17 : rate == 24000 ? 19 : COMPARE_BANDS;
+    // Below 48 kHz, the top 300 Hz is left out to allow for different transition bands.
+    int top = rate == 48000 || rate == 12000 ? m_compareBands[bands] : m_compareBands[bands] - 3;
+    float * X = (float *)malloc(frames * COMPARE_BINS * sizeof(float));
+    float * Y = (float *)malloc(frames * COMPARE_BINS * sizeof(float));
+    float * masks = (float *)malloc(frames * COMPARE_BANDS * sizeof(float));
+    double err = 0;
+    int frame, b, k;
+
+    comparePowers(reference, frames, 48000 / referenceRate, X);
+    comparePowers(test, frames, factor, Y);
+    for (frame = 0; frame < frames; frame++) {
+        float * mask = masks + frame * COMPARE_BANDS;
+        for (b = 0; b < COMPARE_BANDS; b++) {
+            mask[b] = 0;
+            for (k = m_compareBands[b]; k < m_compareBands[b + 1]; k++)
+                mask[b] += X[frame * COMPARE_BINS + k];
+            mask[b] /= m_compareBands[b + 1] - m_compareBands[b];
+        }
+        for (b = 1; b < COMPARE_BANDS; b++)
+            mask[b] += .1f * mask[b - 1];
+        for (b = COMPARE_BANDS - 2; b >= 0; b--)
+            mask[b] += .03f * mask[b + 1];
+        if (frame > 0) {
+            for (b = 0; b < COMPARE_BANDS; b++)
+                mask[b] += .5f * mask[b - COMPARE_BANDS];
+        }
+        for (b = 0; b < COMPARE_BANDS; b++) {
+            for (k = m_compareBands[b]; k < m_compareBands[b + 1]; k++) {
+                X[frame * COMPARE_BINS + k] += .1f * mask[b];
+                Y[frame * COMPARE_BINS + k] += .1f * mask[b];
+            }
+        }
+    }
+    // Each frame summed with the one before it, to be a little less touchy.
+    for (k = 0; k < m_compareBands[bands]; k++) {
+        float xLast = X[k], yLast = Y[k];
+        for (frame = 1; frame < frames; frame++) {
+            float xThis = X[frame * COMPARE_BINS + k], yThis = Y[frame * COMPARE_BINS + k];
+            X[frame * COMPARE_BINS + k] += xLast;
+            Y[frame * COMPARE_BINS + k] += yLast;
+            xLast = xThis;
+            yLast = yThis;
+        }
+    }
+    for (frame = 0; frame < frames; frame++) {
+        double frameErr = 0;
+        for (b = 0; b < bands; b++) {
+            double bandErr = 0;
+            for (k = m_compareBands[b]; k < m_compareBands[b + 1] && k < top; k++) {
+                double ratio = Y[frame * COMPARE_BINS + k] / X[frame * COMPARE_BINS + k];
+                double e = ratio - log(ratio) - 1;
+                // Leave room around the SILK/CELT cross-over at 8 kHz.
+                if (k >= 79 && k <= 81)
+                    e *= .1;
+                if (k == 80)
+                    e *= .1;
+                bandErr += e;
+            }
+            bandErr /= m_compareBands[b + 1] - m_compareBands[b];
+            frameErr += bandErr * bandErr;
+        }
+        frameErr /= COMPARE_BANDS;
+        frameErr *= frameErr;
+        err += frameErr * frameErr;
+    }
+    free(X);
+    free(Y);
+    free(masks);
+    err = pow(err / frames, 1.0 / 16);
+    return 100 * (1 - .5 * log(1 + err) / log(1.13));
+}
+
+// Decode every packet of list at rate into out, dropping every lossEvery'th (0 for none),
+// and return the samples, or -1 on an error.
+static int decimateDecode (const packetList_t * list, opus_int32 rate, int decimated, uint32_t lossEvery,
+                           opus_int16 * out) {
+    OpusDecoder * decoder = (OpusDecoder *)&m_monoDecoder;
+    opus_int32 readBack;
+    uint32_t n;
+    int samples, total = 0;
+
+    if (opus_decoder_init(decoder, rate, 1) != OPUS_OK
+        || opus_decoder_ctl(decoder, OPUS_SET_DECIMATED_SYNTHESIS(decimated)) != OPUS_OK
+        || opus_decoder_ctl(decoder, OPUS_GET_DECIMATED_SYNTHESIS(&readBack)) != OPUS_OK
+        || readBack != (decimated && rate != 48000))
+        return -1;
+    for (n = 0; n < list->Count; n++) {
+        const uint8_t * packet = list->Data + list->Offsets[n];
+        opus_int32 length = list->Offsets[n + 1] - list->Offsets[n];
+        if (lossEvery && n % lossEvery == lossEvery - 1)
+            samples = opus_decode(decoder, NULL, 0, out + total, opus_packet_get_nb_samples(packet, length, rate), 0);
+        else
+            samples = opus_decode(decoder, packet, length, out + total, 5760, 0);
+        if (samples < 0)
+            return -1;
+        total += samples;
+    }
+    return total;
+}
+
+// OPUS_SET_DECIMATED_SYNTHESIS trades bit-exactness for a cheaper CELT synthesis below
+// 48 kHz.  Decodes name (mono) at each lower rate both ways, timing them, and scores both
+// against the 48 kHz decode as opus_compare would; then again with every tenth packet lost,
+// to take concealment through the decimated path too.
+#define DECIMATE_PASSES 10
+#define DECIMATE_LOSS   10
+
+static int decimateTest (const char * name) {
+    static const opus_int32 rates[] = { 24000, 16000, 12000, 8000 };
+    packetList_t list;
+    opus_int16 * full, * exact, * decimated;
+    int fullLength, length[2], pass, block, blocks, n, i, within[2], err = 0;
+    double seconds[2], quality[2], worst;
+    size_t r;
+
+#ifndef HAVE_DECIMATED_SYNTHESIS
+    printf("ERR! This build has no decimated synthesis; build libopus with -DDECIMATED_SYNTHESIS.\r\n");
+    return 1;
+#endif
+    if (!loadPackets(name, &list)) {
+        printf("ERR! Couldn't read %s.\r\n", name);
+        return 1;
+    }
+    full = (opus_int16 *)malloc(list.Count * 5760 * sizeof(opus_int16));
+    fullLength = decimateDecode(&list, 48000, 0, 0, full);
+    err += fullLength < 0;
+    exact = (opus_int16 *)malloc(list.Count * 5760 * sizeof(opus_int16));
+    decimated = (opus_int16 *)malloc(list.Count * 5760 * sizeof(opus_int16));
+    printf("%u packets, %.1f s of audio\r\n", (unsigned)list.Count, fullLength / 48000.0);
+
+    for (r = 0; r < sizeof(rates) / sizeof(rates[0]) && !err; r++) {
+        // The fastest of several passes, as the least disturbed by everything else running.
+        for (int way = 0; way < 2; way++) {
+            seconds[way] = 1e9;
+            for (pass = 0; pass < DECIMATE_PASSES; pass++) {
+                uint64_t start = nanoseconds();
+                length[way] = decimateDecode(&list, rates[r], way, 0, way ? decimated : exact);
+                seconds[way] = fmin(seconds[way], (nanoseconds() - start) / 1e9);
+            }
+        }
+        if (length[0] < 0 || length[1] != length[0] || length[0] * (48000 / rates[r]) != fullLength) {
+            err++;
+            break;
+        }
+        quality[0] = compareQuality(full, 48000, exact, length[0], rates[r]);
+        quality[1] = compareQuality(full, 48000, decimated, length[1], rates[r]);
+        printf("%5d Hz: %6.2f ms exact, %6.2f ms decimated, %.2fx as fast; Q %6.2f exact, %6.2f decimated\r\n",
+               (int)rates[r], seconds[0] * 1e3, seconds[1] * 1e3, seconds[0] / seconds[1], quality[0], quality[1]);
+        err += quality[1] < 0;
+
+        // Concealment is guesswork, not covered by conformance, and the exact path's isn't
+        // band-limited before it's decimated; so with losses, the levels are only compared
+        // with the exact path's, 20 ms at a time, to see that they track it.
+        length[0] = decimateDecode(&list, rates[r], 0, DECIMATE_LOSS, exact);
+        length[1] = decimateDecode(&list, rates[r], 1, DECIMATE_LOSS, decimated);
+        if (length[0] < 0 || length[1] != length[0]) {
+            err++;
+            break;
+        }
+        block = rates[r] / 50;
+        blocks = length[0] / block;
+        within[0] = within[1] = 0;
+        worst = 0;
+        for (n = 0; n < blocks; n++) {
+            double energy[2] = { 0, 0 }, db;
+            for (i = n * block; i < (n + 1) * block; i++) {
+                energy[0] += (double)exact[i] * exact[i];
+                energy[1] += (double)decimated[i] * decimated[i];
+            }
+            // (A floor of 30 dB below full scale, so silence against near-silence doesn't count.)
+            db = 10 * log10((energy[1] / block + 1e6) / (energy[0] / block + 1e6));
+            within[0] += fabs(db) <= 1;
+            within[1] += fabs(db) <= 6;
+            worst = fmax(worst, fabs(db));
+        }
+        printf("          1 in %d lost: level within 1 dB of exact in %.1f%% of 20 ms blocks, 6 dB in %.1f%%, worst %.1f dB\r\n",
+               DECIMATE_LOSS, 100. * within[0] / blocks, 100. * within[1] / blocks, worst);
+    }
+
+    free(full);
+    free(exact);
+    free(decimated);
+    free(list.Data);
+    free(list.Offsets);
+    if (err) {
+        printf("ERR! Decode errors, or decimated synthesis outside the conformance tolerance.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+// The fused IMDCT, clt_mdct_backward_sat_c, against clt_mdct_backward_c followed by the
+// separate saturation celt_synthesis used to do.  Random coefficients and history, some loud
+// enough to saturate, go through every LM in long and short blocks, at 48 kHz and at every
+// rate decimated synthesis has tables for; everything either way writes, the tail left for
+// the next frame included, has to match.  Then the cycles a frame's IMDCT takes each way.
+// Where the overlap doesn't suit the fused kernel (12 kHz), celt_synthesis keeps the separate
+// passes, and so does the fused way here: those rows time the same code twice.
+#define IMDCT_TRIALS 200
+#define IMDCT_FRAMES 25
+#define IMDCT_ROUNDS 400 // Many short runs: the best of them rides out the host's interruptions.
+
+typedef struct {
+    char Name[16];
+    const mdct_lookup * Mdct;
+    const opus_val16 * Window;
+    int Overlap;
+    int ShortMdctSize;
+} imdctSetup_t;
+
+static uint64_t cycleCount (void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return nanoseconds();
+#endif
+}
+
+// One frame's IMDCT, as celt_synthesis does it for a channel.
+static void imdctFrame (const imdctSetup_t * setup, int maxLM, int LM, bool transient, bool fused,
+                        celt_sig * freq, celt_sig * out) {
+    int B = transient ? 1 << LM : 1, N = setup->ShortMdctSize << LM;
+    int NB = transient ? setup->ShortMdctSize : N, shift = transient ? maxLM : maxLM - LM;
+    int b, i;
+
+    fused = fused && CLT_MDCT_BACKWARD_SAT_FUSES(setup->Overlap, NB);
+    for (b = 0; b < B; b++) {
+        if (fused)
+            clt_mdct_backward_sat_c(setup->Mdct, freq + b, out + NB * b, setup->Window, setup->Overlap, shift, B, 0);
+        else
+            clt_mdct_backward_c(setup->Mdct, freq + b, out + NB * b, setup->Window, setup->Overlap, shift, B, 0);
+    }
+    if (!fused) {
+        for (i = 0; i < N; i++)
+            out[i] = SATURATE(out[i], SIG_SAT);
+    }
+}
+
+static int imdctTest (void) {
+    static const int scales[] = { 1 << 14, 1 << 20, 1 << 26, 1 << 29 };
+    const CELTMode * mode = opus_custom_mode_create(48000, 960, NULL);
+    imdctSetup_t setups[5];
+    int setupCount = 1, s, LM, transient, trial, i, err = 0;
+
+    snprintf(setups[0].Name, sizeof(setups[0].Name), "48000 Hz");
+    setups[0].Mdct = &mode->mdct;
+    setups[0].Window = mode->window;
+    setups[0].Overlap = mode->overlap;
+    setups[0].ShortMdctSize = mode->shortMdctSize;
+#ifdef HAVE_DECIMATED_SYNTHESIS
+    for (int factor = 2; factor <= 6; factor++) {
+        const CELTDecimation * decimate = celt_mode_decimation(mode, factor);
+        if (!decimate)
+            continue;
+        snprintf(setups[setupCount].Name, sizeof(setups[0].Name), "%5d Hz dec.", 48000 / factor);
+        setups[setupCount].Mdct = &decimate->mdct;
+        setups[setupCount].Window = decimate->window;
+        setups[setupCount].Overlap = decimate->overlap;
+        setups[setupCount].ShortMdctSize = decimate->shortMdctSize;
+        setupCount++;
+    }
+#endif
+
+    celt_sig * freq = (celt_sig *)malloc(1920 * sizeof(celt_sig));
+    celt_sig * reference = (celt_sig *)malloc((960 + 120) * sizeof(celt_sig));
+    celt_sig * fused = (celt_sig *)malloc((960 + 120) * sizeof(celt_sig));
+    srand(21);
+    for (s = 0; s < setupCount; s++) {
+        const imdctSetup_t * setup = &setups[s];
+        int mismatches = 0, saturated = 0;
+        for (LM = 0; LM <= mode->maxLM; LM++) {
+            int N = setup->ShortMdctSize << LM, length = N + setup->Overlap / 2;
+            for (transient = 0; transient <= (LM > 0); transient++) {
+                for (trial = 0; trial < IMDCT_TRIALS; trial++) {
+                    int scale = scales[trial % 4];
+                    for (i = 0; i < N; i++)
+                        freq[i] = (celt_sig)(((int64_t)rand() * 2 - RAND_MAX) * scale / RAND_MAX);
+                    for (i = 0; i < length; i++)
+                        reference[i] = fused[i] = (celt_sig)(((int64_t)rand() * 2 - RAND_MAX) * scale / RAND_MAX);
+                    imdctFrame(setup, mode->maxLM, LM, transient, false, freq, reference);
+                    imdctFrame(setup, mode->maxLM, LM, transient, true, freq, fused);
+                    mismatches += memcmp(reference, fused, length * sizeof(celt_sig)) != 0;
+                    for (i = 0; i < N; i++)
+                        saturated += reference[i] == SIG_SAT || reference[i] == -SIG_SAT;
+                }
+            }
+        }
+        printf("%s: %d frames, %d samples saturated, %s\r\n", setup->Name,
+               IMDCT_TRIALS * (2 * mode->maxLM + 1), saturated, mismatches ? "MISMATCHED" : "bit-exact");
+        err += mismatches + !saturated;
+    }
+
+    printf("Cycles per frame (%s), current and fused:\r\n",
+#if defined(__x86_64__) || defined(__i386__)
+           "TSC"
+#else
+           "ns"
+#endif
+           );
+    for (s = 0; s < setupCount; s++) {
+        const imdctSetup_t * setup = &setups[s];
+        for (LM = 0; LM <= mode->maxLM; LM++) {
+            int N = setup->ShortMdctSize << LM;
+            printf("%s LM %d (%4d):", setup->Name, LM, N);
+            for (i = 0; i < N; i++)
+                freq[i] = (celt_sig)(((int64_t)rand() * 2 - RAND_MAX) * (1 << 24) / RAND_MAX);
+            for (transient = 0; transient <= (LM > 0); transient++) {
+                // Best of IMDCT_ROUNDS, alternating, so neither way gets the quieter moments.
+                uint64_t cycles[2] = { UINT64_MAX, UINT64_MAX };
+                for (int round = 0; round < IMDCT_ROUNDS; round++) {
+                    for (int way = 0; way < 2; way++) {
+                        uint64_t start = cycleCount();
+                        for (trial = 0; trial < IMDCT_FRAMES; trial++)
+                            imdctFrame(setup, mode->maxLM, LM, transient, way, freq, way ? fused : reference);
+                        uint64_t elapsed = (cycleCount() - start) / IMDCT_FRAMES;
+                        if (elapsed < cycles[way])
+                            cycles[way] = elapsed;
+                    }
+                }
+                printf("  %s %6u %6u (%.2fx)", transient ? "short" : "long ", (unsigned)cycles[0],
+                       (unsigned)cycles[1], (double)cycles[0] / cycles[1]);
+            }
+            printf("\r\n");
+        }
+    }
+
+    free(freq);
+    free(reference);
+    free(fused);
+    if (err) {
+        printf("ERR! The fused IMDCT doesn't match, or nothing was loud enough to saturate.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+// CELT's output stage, deemphasis_fused in celt_decoder.c, against the separate passes it
+// replaced, through CRCs of what the decoder wrote before the fusion (with the later fix to
+// where the output gain goes, which changed what both wrote).  The switching stream,
+// every ninth packet lost, is decoded at each rate (exact, and decimated below 48 kHz),
+// mono in each packing and stereo; each row's CRC covers it with and without gain (enough to
+// saturate) and skip.  The packets' own CRC comes first, so a change in the encoder shows up
+// as that and not as the output stage.
+#define DEEMPH_GAIN     3000 // Q8 dB.
+#define DEEMPH_SKIP_MS  13
+
+static const uint32_t m_deemphPacketsCrc = 0xA2AC228D;
+static const uint32_t m_deemphCrcs[] = {
+    0x55D940A1, 0x295B14C3, 0x63BCC76D, 0x4AE7D3AE, 0x731203E3,
+    0x1B8844A1, 0x38FA8B6B, 0xE050EC4D, 0xD8AA6726, 0x520714A6,
+    0x9CF09837, 0x76B659A3, 0x15664E50, 0x63D017F3, 0xE75C7364,
+    0xCD160043, 0xBC1B00AE, 0x82B82116, 0x3EA321B8, 0xC992AB17,
+    0x05CCD54C, 0x2693A7D8, 0xF34C39E6, 0xD5DF9E3E, 0x5C14E198,
+    0x6C34D4B2, 0x1D90B150, 0x604F940A, 0x7DDF255A, 0x1CAAD860,
+    0x63D27155, 0xF4E40F52, 0x482F4CAE, 0xBCCB43FC, 0x89677909,
+    0xC68F4C6E, 0xE2D0201F, 0xE04B6EF0, 0x029B4EEF, 0x13F42F3B,
+    0x6AC1D1FE, 0xADF52CA8, 0x15D49DA8, 0xB821B100, 0x08F70411,
+};
+
+// Decode list with the given output settings and fold everything written into crc.
+static bool deemphDecode (const packetList_t * list, opus_int32 rate, int decimated, int channels,
+                          int packing, int gain, int skip, uint32_t * crc) {
+    static opus_int16 pcm[5760 * 2];
+    OpusDecoder * decoder;
+    const uint8_t * packet;
+    opus_int32 length;
+    uint32_t n;
+    int samples, created;
+
+    decoder = opus_decoder_create(rate, channels, &created);
+    if (created != OPUS_OK)
+        return false;
+    opus_decoder_ctl(decoder, OPUS_SET_GAIN(gain));
+    opus_decoder_ctl(decoder, OPUS_SET_OUTPUT_PACKING(packing));
+    opus_decoder_ctl(decoder, OPUS_SET_SKIP_SAMPLES(skip));
+    if (opus_decoder_ctl(decoder, OPUS_SET_DECIMATED_SYNTHESIS(decimated)) != OPUS_OK) {
+        opus_decoder_destroy(decoder);
+        return false;
+    }
+    for (n = 0; n < list->Count; n++) {
+        packet = list->Data + list->Offsets[n];
+        length = list->Offsets[n + 1] - list->Offsets[n];
+        if (n % GAIN_LOSS == GAIN_LOSS - 1)
+            samples = opus_decode(decoder, NULL, 0, pcm, opus_packet_get_nb_samples(packet, length, rate), 0);
+        else
+            samples = opus_decode(decoder, packet, length, pcm, 5760, 0);
+        if (samples < 0)
+            break;
+        *crc = OggCrcUpdate(*crc, (const uint8_t *)pcm, samples * (packing ? 2 : channels) * sizeof(opus_int16));
+    }
+    opus_decoder_destroy(decoder);
+    return n == list->Count;
+}
+
+static int deemphTest (void) {
+    static const opus_int32 rates[] = { 48000, 24000, 16000, 12000, 8000 };
+    static const char * const layouts[] = { "mono", "mono both", "mono left", "mono right", "stereo" };
+    packetList_t list;
+    uint32_t crc;
+    int r, decimated, channels, packing, gain, skip, row = 0, rows = 0, err = 0;
+
+    if (!encodeStream(&list, RUNS(m_switchedRuns), true)) {
+        printf("ERR! Couldn't encode.\r\n");
+        return 1;
+    }
+    crc = OggCrcUpdate(0, list.Data, list.Offsets[list.Count]);
+    printf("%u packets, CRC %08X%s\r\n", (unsigned)list.Count, (unsigned)crc,
+           crc == m_deemphPacketsCrc ? "" : ", not the one the CRCs below were taken from");
+    err += crc != m_deemphPacketsCrc;
+
+    for (r = 0; r < (int)(sizeof(rates) / sizeof(rates[0])); r++)
+    for (decimated = 0; decimated <= (rates[r] != 48000); decimated++)
+    for (channels = 1; channels <= 2; channels++)
+    for (packing = 0; packing <= (channels == 1 ? OPUS_PACKING_RIGHT : 0); packing++, row++) {
+#ifndef HAVE_DECIMATED_SYNTHESIS
+        if (decimated)
+            continue;
+#endif
+        if (channels > OPUS_DECODER_MAX_CHANNELS)
+            continue;
+        crc = 0;
+        for (gain = 0; gain <= DEEMPH_GAIN; gain += DEEMPH_GAIN)
+        for (skip = 0; skip <= rates[r] * DEEMPH_SKIP_MS / 1000; skip += rates[r] * DEEMPH_SKIP_MS / 1000) {
+            if (!deemphDecode(&list, rates[r], decimated, channels, packing, gain, skip, &crc)) {
+                printf("ERR! Decode failed.\r\n");
+                return 1;
+            }
+        }
+        printf("%5d Hz%s %-10s %08X %s\r\n", (int)rates[r], decimated ? " dec." : "     ",
+               layouts[channels == 2 ? 4 : packing], (unsigned)crc,
+               crc == m_deemphCrcs[row] ? "same" : "DIFFERENT");
+        err += crc != m_deemphCrcs[row];
+        rows++;
+    }
+    printf("%d of %d configurations checked\r\n", rows, row);
+
+    free(list.Data);
+    free(list.Offsets);
+    if (err) {
+        printf("ERR! The output stage doesn't write what the separate passes did.\r\n");
+        return 1;
+    }
+    return 0;
+}
+
+// Every kernel in the x86 dispatch tables, at each level the CPU has, against the C one
+// (arch 0) on random input, some of it at the extremes; then the cycles each takes.  The
+// encoder kernels run whole frames from a random state, so the state they leave is checked
+// too.
+#define SIMD_TRIALS   500
+#define SIMD_RUNS     50
+#define SIMD_ROUNDS   10
+#define SIMD_ARCHS    5
+#define SIMD_MAX_N    1024
+#define SIMD_MAX_T    1024 // MAX_PERIOD: the longest pitch period comb_filter_const sees.
+#define SIMD_FRAMES   4
+#define SIMD_OUT      (64 * 1024)
+
+#if defined(OPUS_X86_MAY_HAVE_SSE4_1) && !defined(OPUS_X86_PRESUME_SSE4_1)
+static const char * const m_simdArchs[SIMD_ARCHS] = { "C", "SSE", "SSE2", "SSE4.1", "AVX2" };
+
+typedef struct {
+    int N, K, T, Len, MaxPitch;
+    opus_val16 G[3];
+    opus_val16 A[SIMD_MAX_N + SIMD_MAX_N];
+    opus_val16 B[SIMD_MAX_N + SIMD_MAX_N];
+    opus_val32 X32[SIMD_MAX_T + 2 + SIMD_MAX_N];
+    celt_norm X[SIMD_MAX_N];
+    silk_encoder_state Enc;
+    silk_nsq_state Nsq;
+    SideInfoIndices Indices;
+    opus_int16 Pcm[SIMD_FRAMES * MAX_FRAME_LENGTH];
+    opus_int16 PredCoef[2 * MAX_LPC_ORDER];
+    opus_int16 LtpCoef[LTP_ORDER * MAX_NB_SUBFR];
+    opus_int16 ArCoef[MAX_NB_SUBFR * MAX_SHAPE_LPC_ORDER];
+    opus_int HarmShapeGain[MAX_NB_SUBFR], Tilt[MAX_NB_SUBFR], PitchL[MAX_NB_SUBFR];
+    opus_int32 LfShp[MAX_NB_SUBFR], Gains[MAX_NB_SUBFR];
+    opus_int Lambda, LtpScale;
+} simdCase_t;
+
+typedef struct {
+    const char * Name;
+    void (*Fill) (simdCase_t * c, int trial);
+    size_t (*Run) (simdCase_t * c, int arch, uint8_t * out); // Returns the bytes written to out.
+    int Top;    // Highest arch with a kernel of its own; those above reuse it, so aren't timed.
+} simdKernel_t;
+
+static simdCase_t m_simdCase;
+static uint8_t m_simdOut[2][SIMD_OUT];
+
+static int simdRandom (int low, int high) {
+    return low + (int)((int64_t)rand() * (high - low + 1) / ((int64_t)RAND_MAX + 1));
+}
+
+// Random 16-bit values at one of a few levels: every fourth trial full scale, with some
+// runs of -32768 (the one product _mm_madd_epi16 pairs can wrap on).
+static void simdFill16 (opus_val16 * x, int n, int trial, int quiet) {
+    static const int levels[] = { 100, 2047, 8191, 32767 };
+    int level = levels[trial % 4], i;
+    if (quiet && level > quiet)
+        level = quiet;
+    for (i = 0; i < n; i++)
+        x[i] = (opus_val16)simdRandom(-level, level);
+    if (!quiet && trial % 4 == 3) {
+        for (i = 0; i < n; i++) {
+            if (trial % 8 == 3 || rand() % 3 == 0)
+                x[i] = -32768;
+        }
+    }
+}
+
+static void simdFillInnerProd (simdCase_t * c, int trial) {
+    c->N = simdRandom(0, SIMD_MAX_N);
+    // celt_inner_prod's sums are 32 bits: keep them from wrapping (which C leaves undefined).
+    simdFill16(c->A, c->N + 16, trial, 2047);
+    simdFill16(c->B, c->N + 16, trial + 1, 2047);
+}
+
+static size_t simdRunInnerProd (simdCase_t * c, int arch, uint8_t * out) {
+    opus_val32 r = (*CELT_INNER_PROD_IMPL[arch])(c->A, c->B, c->N);
+    memcpy(out, &r, sizeof(r));
+    return sizeof(r);
+}
+
+static size_t simdRunDualInnerProd (simdCase_t * c, int arch, uint8_t * out) {
+    opus_val32 r[2];
+    (*DUAL_INNER_PROD_IMPL[arch])(c->A, c->B, c->B + 7, c->N, &r[0], &r[1]);
+    memcpy(out, r, sizeof(r));
+    return sizeof(r);
+}
+
+static void simdFillXcorr (simdCase_t * c, int trial) {
+    c->Len = simdRandom(3, SIMD_MAX_N / 2);
+    c->MaxPitch = simdRandom(1, SIMD_MAX_N / 2);
+    simdFill16(c->A, c->Len, trial, 2047);
+    simdFill16(c->B, c->Len + c->MaxPitch, trial + 1, 2047);
+}
+
+static size_t simdRunXcorr (simdCase_t * c, int arch, uint8_t * out) {
+    opus_val32 * xcorr = (opus_val32 *)(void *)out;
+    xcorr[c->MaxPitch] = (*CELT_PITCH_XCORR_IMPL[arch])(c->A, c->B, xcorr, c->Len, c->MaxPitch, arch);
+    return (c->MaxPitch + 1) * sizeof(opus_val32);
+}
+
+static void simdFillComb (simdCase_t * c, int trial) {
+    int i;
+    c->T = simdRandom(COMBFILTER_MINPERIOD, SIMD_MAX_T);
+    c->N = simdRandom(1, SIMD_MAX_N);
+    for (i = 0; i < 3; i++)
+        c->G[i] = (opus_val16)simdRandom(-32768, 32767);
+    // Loud enough to saturate now and then, not to wrap the sum of five taps.
+    for (i = 0; i < c->T + 2 + c->N; i++)
+        c->X32[i] = simdRandom(-(1 << 26), 1 << 26);
+    c->K = trial & 1; // In place, as celt_decoder's postfilter runs it, every other trial.
+}
+
+static size_t simdRunComb (simdCase_t * c, int arch, uint8_t * out) {
+    opus_val32 * x = (opus_val32 *)(void *)out + c->T + 2;
+    opus_val32 * y = c->K ? x : (opus_val32 *)(void *)out + c->T + 2 + c->N;
+    memcpy(out, c->X32, (c->T + 2 + c->N) * sizeof(opus_val32));
+    (*COMB_FILTER_CONST_IMPL[arch])(y, x, c->T, c->N, c->G[0], c->G[1], c->G[2]);
+    return (c->T + 2 + c->N * (2 - c->K)) * sizeof(opus_val32);
+}
+
+static void simdFillPvq (simdCase_t * c, int trial) {
+    int64_t energy = 0;
+    int i;
+    c->N = simdRandom(2, 176);
+    c->K = simdRandom(1, trial % 4 == 0 ? 256 : 32);
+    for (i = 0; i < c->N; i++) {
+        c->X[i] = (celt_norm)(rand() % 4 == 0 && trial % 2 ? 0 : simdRandom(-16384, 16384));
+        if (trial % 8 == 5 && i >= 4)
+            c->X[i] = c->X[i % 4]; // Repeats, so positions tie.
+        energy += (int64_t)c->X[i] * c->X[i];
+    }
+    if (!energy)
+        c->X[0] = 16384, energy = 1 << 28;
+    // Unit norm in Q14, as the bands come in.
+    for (i = 0; i < c->N; i++)
+        c->X[i] = (celt_norm)(c->X[i] * 16384.0 / sqrt((double)energy));
+}
+
+static size_t simdRunPvq (simdCase_t * c, int arch, uint8_t * out) {
+    celt_norm * x = (celt_norm *)(void *)out;
+    int * iy = (int *)(void *)(out + c->N * sizeof(celt_norm) + 16);
+    opus_val16 yy;
+    memcpy(x, c->X, c->N * sizeof(celt_norm));
+    memset(iy, 0, (c->N + 1) * sizeof(int));
+    yy = (*OP_PVQ_SEARCH_IMPL[arch])(x, iy, c->K, c->N, arch);
+    memcpy(iy + c->N, &yy, sizeof(yy));
+    return c->N * sizeof(celt_norm) + 16 + (c->N + 1) * sizeof(int);
+}
+
+static void simdFillInnerProd64 (simdCase_t * c, int trial) {
+    c->N = simdRandom(0, SIMD_MAX_N);
+    simdFill16(c->A, c->N, trial, 0);
+    simdFill16(c->B, c->N, trial, 0);
+}
+
+static size_t simdRunInnerProd64 (simdCase_t * c, int arch, uint8_t * out) {
+    opus_int64 r = (*SILK_INNER_PROD16_ALIGNED_64_IMPL[arch])(c->A, c->B, c->N);
+    memcpy(out, &r, sizeof(r));
+    return sizeof(r);
+}
+
+// A 10 or 20 ms frame's worth of SILK encoder state at 8, 12 or 16 kHz.
+static void simdFillEncoder (simdCase_t * c, int trial) {
+    static const int rates[] = { 8, 12, 16 };
+    silk_encoder_state * enc = &c->Enc;
+    int i;
+
+    memset(enc, 0, sizeof(*enc));
+    enc->fs_kHz = rates[trial % 3];
+    enc->nb_subfr = trial & 1 ? MAX_NB_SUBFR : MAX_NB_SUBFR / 2;
+    enc->subfr_length = SUB_FRAME_LENGTH_MS * enc->fs_kHz;
+    enc->frame_length = enc->nb_subfr * enc->subfr_length;
+    enc->ltp_mem_length = LTP_MEM_LENGTH_MS * enc->fs_kHz;
+    enc->arch = 0;
+    silk_VAD_Init(&enc->sVAD);
+    for (i = 0; i < SIMD_FRAMES * enc->frame_length; i++) {
+        double t = i / (enc->fs_kHz * 1000.0);
+        c->Pcm[i] = (opus_int16)(simdRandom(-300, 300) * (trial % 5) +
+                                 (6000 + 5000 * sin(7 * t)) * sin(2 * M_PI * (150 + 90 * sin(3 * t)) * t));
+    }
+}
+
+static void simdFillNsq (simdCase_t * c, int trial) {
+    static const int shapingOrders[] = { 12, 14, 16, 20, 24 };
+    static const int ltpScales[] = { 15565, 11469, 8192 };
+    silk_encoder_state * enc = &c->Enc;
+    int k, i;
+
+    simdFillEncoder(c, trial);
+    enc->predictLPCOrder = trial & 2 ? MAX_LPC_ORDER : MIN_LPC_ORDER;
+    enc->shapingLPCOrder = shapingOrders[trial % 5];
+    memset(&c->Nsq, 0, sizeof(c->Nsq));
+    c->Nsq.prev_gain_Q16 = 65536;
+    c->Nsq.lagPrev = 100;
+    for (i = 0; i < 2 * MAX_LPC_ORDER; i++)
+        c->PredCoef[i] = (opus_int16)simdRandom(-600, 600);
+    for (i = 0; i < LTP_ORDER * MAX_NB_SUBFR; i++)
+        c->LtpCoef[i] = (opus_int16)simdRandom(-1000, 3000);
+    for (i = 0; i < MAX_NB_SUBFR * MAX_SHAPE_LPC_ORDER; i++)
+        c->ArCoef[i] = (opus_int16)simdRandom(-1200, 1200);
+    for (k = 0; k < MAX_NB_SUBFR; k++) {
+        c->HarmShapeGain[k] = simdRandom(0, 8000);
+        c->Tilt[k] = simdRandom(-5000, 5000);
+        c->LfShp[k] = (opus_int32)((uint32_t)simdRandom(0, 16000) << 16 | (uint16_t)simdRandom(-16000, 0));
+        c->Gains[k] = simdRandom(1 << 16, 1 << 22);
+        // Lags stay near each other through a frame, as the pitch contours keep them: the
+        // LTP state is only rewhitened back as far as the first subframe's lag needs.
+        c->PitchL[k] = k ? c->PitchL[0] + simdRandom(-8, 8) : simdRandom(2 * enc->fs_kHz + 8, 18 * enc->fs_kHz - 8);
+    }
+    c->Lambda = simdRandom(300, 3000);
+    c->LtpScale = ltpScales[trial % 3];
+    memset(&c->Indices, 0, sizeof(c->Indices));
+    c->Indices.signalType = (opus_int8)(trial % 3);
+    c->Indices.quantOffsetType = (opus_int8)(trial / 3 % 2);
+    c->Indices.NLSFInterpCoef_Q2 = (opus_int8)(trial % 5);
+}
+
+static size_t simdRunNsq (simdCase_t * c, int arch, uint8_t * out) {
+    silk_nsq_state * nsq = (silk_nsq_state *)(void *)out;
+    opus_int8 * pulses = (opus_int8 *)(out + sizeof(*nsq));
+    int frame, n = c->Enc.frame_length;
+
+    *nsq = c->Nsq;
+    for (frame = 0; frame < SIMD_FRAMES; frame++) {
+        c->Indices.Seed = (opus_int8)(frame & 3);
+        (*SILK_NSQ_IMPL[arch])(&c->Enc, nsq, &c->Indices, c->Pcm + frame * n, pulses + frame * n,
+                               c->PredCoef, c->LtpCoef, c->ArCoef, c->HarmShapeGain, c->Tilt, c->LfShp,
+                               c->Gains, c->PitchL, c->Lambda, c->LtpScale);
+    }
+    return sizeof(*nsq) + SIMD_FRAMES * n;
+}
+
+static const simdKernel_t m_simdKernels[] = {
+    { "celt_inner_prod", simdFillInnerProd, simdRunInnerProd, 4 },
+    { "dual_inner_prod", simdFillInnerProd, simdRunDualInnerProd, 4 },
+    { "celt_pitch_xcorr", simdFillXcorr, simdRunXcorr, 4 },
+    { "comb_filter_const", simdFillComb, simdRunComb, 3 },
+    { "op_pvq_search", simdFillPvq, simdRunPvq, 3 },
+    { "silk_inner_prod16", simdFillInnerProd64, simdRunInnerProd64, 4 },
+    { "silk_NSQ", simdFillNsq, simdRunNsq, 3 },
+};
+#endif
+
+static int simdTest (void) {
+#if defined(OPUS_X86_MAY_HAVE_SSE4_1) && !defined(OPUS_X86_PRESUME_SSE4_1)
+    int cpuArch = opus_select_arch(), err = 0;
+    size_t k;
+
+    printf("CPU runs up to %s.\r\n", m_simdArchs[cpuArch < SIMD_ARCHS ? cpuArch : SIMD_ARCHS - 1]);
+    srand(24);
+    for (k = 0; k < sizeof(m_simdKernels) / sizeof(m_simdKernels[0]); k++) {
+        const simdKernel_t * kernel = &m_simdKernels[k];
+        uint64_t cycles[SIMD_ARCHS];
+        int mismatches[SIMD_ARCHS] = { 0 };
+        int arch, trial;
+
+        for (trial = 0; trial < SIMD_TRIALS; trial++) {
+            kernel->Fill(&m_simdCase, trial);
+            size_t length = kernel->Run(&m_simdCase, 0, m_simdOut[0]);
+            for (arch = 1; arch <= cpuArch && arch < SIMD_ARCHS; arch++) {
+                kernel->Run(&m_simdCase, arch, m_simdOut[1]);
+                mismatches[arch] += memcmp(m_simdOut[0], m_simdOut[1], length) != 0;
+            }
+        }
+
+        // Best of SIMD_ROUNDS on the last trial's input, alternating.
+        for (arch = 0; arch < SIMD_ARCHS; arch++)
+            cycles[arch] = UINT64_MAX;
+        for (int round = 0; round < SIMD_ROUNDS; round++) {
+            for (arch = 0; arch <= cpuArch && arch <= kernel->Top; arch++) {
+                uint64_t start = cycleCount();
+                for (trial = 0; trial < SIMD_RUNS; trial++)
+                    kernel->Run(&m_simdCase, arch, m_simdOut[1]);
+                uint64_t elapsed = (cycleCount() - start) / SIMD_RUNS;
+                if (elapsed < cycles[arch])
+                    cycles[arch] = elapsed;
+            }
+        }
+        printf("%-18s C %7u", kernel->Name, (unsigned)cycles[0]);
+        // SSE and SSE2 have nothing of their own here: only the levels with kernels.
+        for (arch = 3; arch <= cpuArch && arch < SIMD_ARCHS; arch++) {
+            if (arch > kernel->Top)
+                printf(", %s runs the %s one%s", m_simdArchs[arch], m_simdArchs[kernel->Top],
+                       mismatches[arch] ? " MISMATCHED" : "");
+            else
+                printf(", %s %7u (%.2fx)%s", m_simdArchs[arch], (unsigned)cycles[arch],
+                       (double)cycles[0] / cycles[arch], mismatches[arch] ? " MISMATCHED" : "");
+            err += mismatches[arch];
+        }
+        for (arch = 1; arch < 3 && arch <= cpuArch; arch++)
+            err += mismatches[arch];
+        printf(" TSC\r\n");
+    }
+    if (err) {
+        printf("ERR! %d trials of the x86 kernels didn't match C.\r\n", err);
+        return 1;
+    }
+    printf("All %d trials of each kernel bit-exact.\r\n", SIMD_TRIALS);
+    return 0;
+#else
+    printf("This build has no x86 kernels to dispatch to: build it with OPUS_HAVE_RTCD,\r\n"
+           "OPUS_X86_MAY_HAVE_SSE4_1 and OPUS_X86_MAY_HAVE_AVX2.\r\n");
+    return 0;
+#endif
+}
+
+// The Cortex-M4 layer in celt/arm and silk/arm, as a host build with OPUS_ARM_INLINE_EDSP and
+// OPUS_ARM_INLINE_MEDIA gets it: with a C version of each DSP instruction in place of the
+// instruction.  First each of those, and each macro built on them, against the arithmetic it
+// stands for on random words and the edges; then each M4 kernel against the C function it
+// replaces.  The C versions take nothing from the ARM ones, so a match here means the kernels
+// are right, and the instructions only have to do what the architecture manual says.  Host
+// cycles for these mean nothing, so none are printed.
+#define DSP_OP_TRIALS     200000
+#define DSP_KERNEL_TRIALS 2000
+#define DSP_MAX_N         512
+#define DSP_MAX_ORD       32
+
+#if defined(OPUS_ARM_INLINE_EDSP) && defined(OPUS_ARM_INLINE_MEDIA)
+typedef struct {
+    const char * Name;
+    int64_t (*Op) (opus_int32 a, opus_int32 b, opus_int32 c);
+    int64_t (*Ref) (opus_int32 a, opus_int32 b, opus_int32 c);
+} dspOp_t;
+
+static int64_t dspFloor (int64_t x, int shift) { // x / 2^shift, rounded down, without >>.
+    int64_t d = (int64_t)1 << shift, q = x / d;
+    return q - (x % d < 0);
+}
+
+static int64_t dspWrap (int64_t x) {
+    return (opus_int32)(uint32_t)(uint64_t)x;
+}
+
+static int64_t dspClamp (int64_t x, int64_t low, int64_t high) {
+    return x < low ? low : x > high ? high : x;
+}
+
+static int64_t dspLo (opus_int32 x) { return (int16_t)(uint16_t)((uint32_t)x & 0xFFFF); }
+static int64_t dspHi (opus_int32 x) { return (int16_t)(uint16_t)((uint32_t)x >> 16); }
+
+static int64_t dspClz (opus_int32 x) {
+    int64_t n = 0;
+    for (uint32_t bit = 0x80000000u; bit && !((uint32_t)x & bit); bit >>= 1)
+        n++;
+    return n;
+}
+
+// Each op and its reference see the same a, b and c, and each ignores what it doesn't need.
+#define DSP_OP(name, op, ref) \
+    static int64_t dspOp_##name (opus_int32 a, opus_int32 b, opus_int32 c) { \
+        (void)a; (void)b; (void)c; return (op); } \
+    static int64_t dspRef_##name (opus_int32 a, opus_int32 b, opus_int32 c) { \
+        (void)a; (void)b; (void)c; return (ref); }
+#define DSP_ENTRY(name) { #name, dspOp_##name, dspRef_##name }
+
+DSP_OP(cm4_smulbb, cm4_smulbb(a, b), dspLo(a) * dspLo(b))
+DSP_OP(cm4_smlabb, cm4_smlabb(c, a, b), dspWrap(c + dspLo(a) * dspLo(b)))
+DSP_OP(cm4_smulbt, cm4_smulbt(a, b), dspLo(a) * dspHi(b))
+DSP_OP(cm4_smlabt, cm4_smlabt(c, a, b), dspWrap(c + dspLo(a) * dspHi(b)))
+DSP_OP(cm4_smultt, cm4_smultt(a, b), dspHi(a) * dspHi(b))
+DSP_OP(cm4_smlatt, cm4_smlatt(c, a, b), dspWrap(c + dspHi(a) * dspHi(b)))
+DSP_OP(cm4_smulwb, cm4_smulwb(a, b), dspFloor(a * dspLo(b), 16))
+DSP_OP(cm4_smlawb, cm4_smlawb(c, a, b), dspWrap(c + dspFloor(a * dspLo(b), 16)))
+DSP_OP(cm4_smulwt, cm4_smulwt(a, b), dspFloor(a * dspHi(b), 16))
+DSP_OP(cm4_smlawt, cm4_smlawt(c, a, b), dspWrap(c + dspFloor(a * dspHi(b), 16)))
+DSP_OP(cm4_smlad, cm4_smlad(a, b, c), dspWrap(c + dspLo(a) * dspLo(b) + dspHi(a) * dspHi(b)))
+DSP_OP(cm4_smladx, cm4_smladx(a, b, c), dspWrap(c + dspLo(a) * dspHi(b) + dspHi(a) * dspLo(b)))
+DSP_OP(cm4_pkhbt, cm4_pkhbt(a, b), (opus_int32)(((uint32_t)a & 0xFFFF) | ((uint32_t)b & 0xFFFF0000)))
+DSP_OP(cm4_qadd, cm4_qadd(a, b), dspClamp((int64_t)a + b, INT32_MIN, INT32_MAX))
+DSP_OP(cm4_qsub, cm4_qsub(a, b), dspClamp((int64_t)a - b, INT32_MIN, INT32_MAX))
+DSP_OP(cm4_ssat16, cm4_ssat16(a), dspClamp(a, -32768, 32767))
+DSP_OP(cm4_smmul, cm4_smmul(a, b), dspFloor((int64_t)a * b, 32))
+DSP_OP(cm4_clz, cm4_clz(a), dspClz(a))
+DSP_OP(MULT16_16, MULT16_16(a, b), dspLo(a) * dspLo(b))
+DSP_OP(MAC16_16, MAC16_16(c, a, b), dspWrap(c + dspLo(a) * dspLo(b)))
+DSP_OP(MULT16_32_Q15, MULT16_32_Q15(a, b), dspWrap(dspFloor(dspLo(a) * b, 15)))
+DSP_OP(MAC16_32_Q15, MAC16_32_Q15(c, a, b >> 1), dspWrap(c + dspFloor(dspLo(a) * (b >> 1), 15)))
+DSP_OP(MULT16_32_Q16, MULT16_32_Q16(a, b), dspFloor(dspLo(a) * b, 16))
+DSP_OP(MAC16_32_Q16, MAC16_32_Q16(c, a, b), dspWrap(c + dspFloor(dspLo(a) * b, 16)))
+DSP_OP(MULT32_32_Q31, MULT32_32_Q31(a, b), dspWrap(dspFloor((int64_t)a * b, 31)))
+DSP_OP(SATURATE16, SATURATE16(a), dspClamp(a, -32768, 32767))
+DSP_OP(SAT16, SAT16(a), dspClamp(a, -32768, 32767))
+DSP_OP(silk_SMULWB, silk_SMULWB(a, b), dspFloor(a * dspLo(b), 16))
+DSP_OP(silk_SMLAWB, silk_SMLAWB(c, a, b), dspWrap(c + dspFloor(a * dspLo(b), 16)))
+DSP_OP(silk_SMULWT, silk_SMULWT(a, b), dspFloor(a * dspHi(b), 16))
+DSP_OP(silk_SMLAWT, silk_SMLAWT(c, a, b), dspWrap(c + dspFloor(a * dspHi(b), 16)))
+DSP_OP(silk_SMULBB, silk_SMULBB(a, b), dspLo(a) * dspLo(b))
+DSP_OP(silk_SMLABB, silk_SMLABB(c, a, b), dspWrap(c + dspLo(a) * dspLo(b)))
+DSP_OP(silk_SMULBT, silk_SMULBT(a, b), dspLo(a) * dspHi(b))
+DSP_OP(silk_SMLABT, silk_SMLABT(c, a, b), dspWrap(c + dspLo(a) * dspHi(b)))
+DSP_OP(silk_SMULTT, silk_SMULTT(a, b), dspHi(a) * dspHi(b))
+DSP_OP(silk_SMLATT, silk_SMLATT(c, a, b), dspWrap(c + dspHi(a) * dspHi(b)))
+DSP_OP(silk_SMULWW, silk_SMULWW(a, b), dspWrap(dspFloor((int64_t)a * b, 16)))
+DSP_OP(silk_SMLAWW, silk_SMLAWW(c, a, b), dspWrap(c + dspFloor((int64_t)a * b, 16)))
+DSP_OP(silk_ADD_SAT32, silk_ADD_SAT32(a, b), dspClamp((int64_t)a + b, INT32_MIN, INT32_MAX))
+DSP_OP(silk_SUB_SAT32, silk_SUB_SAT32(a, b), dspClamp((int64_t)a - b, INT32_MIN, INT32_MAX))
+DSP_OP(silk_SMMUL, silk_SMMUL(a, b), dspFloor((int64_t)a * b, 32))
+DSP_OP(silk_SAT16, silk_SAT16(a), dspClamp(a, -32768, 32767))
+DSP_OP(silk_CLZ16, silk_CLZ16(a), dspLo(a) ? dspClz((opus_int32)((uint32_t)a << 16)) : 16)
+DSP_OP(silk_CLZ32, silk_CLZ32(a), dspClz(a))
+
+static const dspOp_t m_dspOps[] = {
+    DSP_ENTRY(cm4_smulbb), DSP_ENTRY(cm4_smlabb), DSP_ENTRY(cm4_smulbt), DSP_ENTRY(cm4_smlabt),
+    DSP_ENTRY(cm4_smultt), DSP_ENTRY(cm4_smlatt), DSP_ENTRY(cm4_smulwb), DSP_ENTRY(cm4_smlawb),
+    DSP_ENTRY(cm4_smulwt), DSP_ENTRY(cm4_smlawt), DSP_ENTRY(cm4_smlad), DSP_ENTRY(cm4_smladx),
+    DSP_ENTRY(cm4_pkhbt), DSP_ENTRY(cm4_qadd), DSP_ENTRY(cm4_qsub), DSP_ENTRY(cm4_ssat16),
+    DSP_ENTRY(cm4_smmul), DSP_ENTRY(cm4_clz),
+    DSP_ENTRY(MULT16_16), DSP_ENTRY(MAC16_16), DSP_ENTRY(MULT16_32_Q15), DSP_ENTRY(MAC16_32_Q15),
+    DSP_ENTRY(MULT16_32_Q16), DSP_ENTRY(MAC16_32_Q16), DSP_ENTRY(MULT32_32_Q31),
+    DSP_ENTRY(SATURATE16), DSP_ENTRY(SAT16),
+    DSP_ENTRY(silk_SMULWB), DSP_ENTRY(silk_SMLAWB), DSP_ENTRY(silk_SMULWT), DSP_ENTRY(silk_SMLAWT),
+    DSP_ENTRY(silk_SMULBB), DSP_ENTRY(silk_SMLABB), DSP_ENTRY(silk_SMULBT), DSP_ENTRY(silk_SMLABT),
+    DSP_ENTRY(silk_SMULTT), DSP_ENTRY(silk_SMLATT), DSP_ENTRY(silk_SMULWW), DSP_ENTRY(silk_SMLAWW),
+    DSP_ENTRY(silk_ADD_SAT32), DSP_ENTRY(silk_SUB_SAT32), DSP_ENTRY(silk_SMMUL), DSP_ENTRY(silk_SAT16),
+    DSP_ENTRY(silk_CLZ16), DSP_ENTRY(silk_CLZ32),
+};
+
+// The words that find the corners: each half at 0, +-1 and both extremes.
+static const uint32_t m_dspEdges[] = {
+    0x00000000, 0x00000001, 0xFFFFFFFF, 0x00007FFF, 0x00008000, 0x0000FFFF, 0x00010000,
+    0x7FFFFFFF, 0x80000000, 0x7FFF7FFF, 0x80008000, 0x80007FFF, 0x7FFF8000, 0xFFFF8000,
+    0x8000FFFF, 0x00018001,
+};
+
+// A random word: one time in four an edge, otherwise all 32 bits, or a smaller magnitude
+// so that the results aren't all saturated.
+static opus_int32 dspWord (void) {
+    uint32_t x = ((uint32_t)rand() << 16) ^ (uint32_t)rand() ^ ((uint32_t)rand() << 31);
+    switch (rand() % 4) {
+    case 0:  return (opus_int32)m_dspEdges[rand() % (sizeof(m_dspEdges) / sizeof(m_dspEdges[0]))];
+    case 1:  return (opus_int32)x >> (rand() % 24);
+    default: return (opus_int32)x;
+    }
+}
+
+static int dspRandom (int low, int high) {
+    return low + (int)((int64_t)rand() * (high - low + 1) / ((int64_t)RAND_MAX + 1));
+}
+
+static void dspFill16 (opus_val16 * x, int n, int level) {
+    for (int i = 0; i < n; i++)
+        x[i] = (opus_val16)dspRandom(-level, level);
+}
+
+static opus_val16 m_dspX[DSP_MAX_ORD + DSP_MAX_N + 4], m_dspY[DSP_MAX_ORD + DSP_MAX_N + 4];
+static opus_val16 m_dspCoef[DSP_MAX_ORD], m_dspOut[2][DSP_MAX_ORD + DSP_MAX_N];
+static opus_val16 m_dspMem[2][DSP_MAX_ORD];
+static opus_val32 m_dspX32[DSP_MAX_N], m_dspOut32[2][DSP_MAX_N], m_dspSum[2][4];
+
+// xcorr_kernel: lengths from 3, at levels where len products of x and y can't overflow
+// xcorr_kernel_c's 32-bit sums.
+static bool dspXcorrTrial (int trial) {
+    int len = dspRandom(3, DSP_MAX_N);
+    int level = trial % 2 ? 2047 : 32767 / len;
+
+    dspFill16(m_dspX, len, level);
+    dspFill16(m_dspY, len + 3, level);
+    for (int k = 0; k < 4; k++)
+        m_dspSum[0][k] = m_dspSum[1][k] = dspRandom(-(1 << 20), 1 << 20);
+    xcorr_kernel_c(m_dspX, m_dspY, m_dspSum[0], len);
+    xcorr_kernel_cm4(m_dspX, m_dspY, m_dspSum[1], len);
+    return !memcmp(m_dspSum[0], m_dspSum[1], sizeof(m_dspSum[0]));
+}
+
+// celt_fir_c and celt_iir_c call xcorr_kernel, which in this build is the M4 one too, so the
+// two below check what the M4 filters do around it; the trial above checks the kernel itself.
+
+// celt_fir: any order from 3, any N, with the order's worth of history before x.
+static bool dspFirTrial (int trial) {
+    int ord = dspRandom(3, DSP_MAX_ORD), n = dspRandom(1, DSP_MAX_N);
+
+    (void)trial;
+    dspFill16(m_dspCoef, ord, 8191);
+    dspFill16(m_dspX, ord + n, 2047);
+    celt_fir_c(m_dspX + ord, m_dspCoef, m_dspOut[0], n, ord, 0);
+    celt_fir_cm4(m_dspX + ord, m_dspCoef, m_dspOut[1], n, ord);
+    return !memcmp(m_dspOut[0], m_dspOut[1], n * sizeof(opus_val16));
+}
+
+// celt_iir: orders a multiple of 4, small enough coefficients to stay stable, and any N from
+// the order up (the new memory is the last ord outputs), so the tail past the last four gets
+// its turn.
+static bool dspIirTrial (int trial) {
+    int ord = 4 * dspRandom(1, DSP_MAX_ORD / 4), n = dspRandom(ord, DSP_MAX_N);
+
+    (void)trial;
+    dspFill16(m_dspCoef, ord, 100);
+    dspFill16(m_dspMem[0], ord, 32767);
+    memcpy(m_dspMem[1], m_dspMem[0], ord * sizeof(opus_val16));
+    for (int i = 0; i < n; i++)
+        m_dspX32[i] = dspRandom(-(1 << 24), 1 << 24);
+    celt_iir_c(m_dspX32, m_dspCoef, m_dspOut32[0], n, ord, m_dspMem[0], 0);
+    celt_iir_cm4(m_dspX32, m_dspCoef, m_dspOut32[1], n, ord, m_dspMem[1]);
+    return !memcmp(m_dspOut32[0], m_dspOut32[1], n * sizeof(opus_val32))
+        && !memcmp(m_dspMem[0], m_dspMem[1], ord * sizeof(opus_val16));
+}
+
+// silk_LPC_analysis_filter: even orders from 6, odd and even lengths, all at full scale
+// (its sums are meant to wrap).
+static bool dspLpcTrial (int trial) {
+    int d = 2 * dspRandom(3, SILK_MAX_ORDER_LPC / 2), len = dspRandom(d, d + DSP_MAX_N - DSP_MAX_ORD);
+    int level = trial % 2 ? 32767 : 4095;
+
+    dspFill16(m_dspCoef, d, level);
+    dspFill16(m_dspX, len, 32767);
+    silk_LPC_analysis_filter_c(m_dspOut[0], m_dspX, m_dspCoef, len, d, 0);
+    silk_LPC_analysis_filter_cm4(m_dspOut[1], m_dspX, m_dspCoef, len, d);
+    return !memcmp(m_dspOut[0], m_dspOut[1], len * sizeof(opus_val16));
+}
+
+typedef struct {
+    const char * Name;
+    bool (*Trial) (int trial);
+} dspKernel_t;
+
+static const dspKernel_t m_dspKernels[] = {
+    { "xcorr_kernel", dspXcorrTrial },
+    { "celt_fir", dspFirTrial },
+    { "celt_iir", dspIirTrial },
+    { "silk_LPC_analysis_filter", dspLpcTrial },
+};
+#endif
+
+static int dspTest (void) {
+#if defined(OPUS_ARM_INLINE_EDSP) && defined(OPUS_ARM_INLINE_MEDIA)
+    int err = 0;
+    size_t k;
+
+    srand(25);
+    for (k = 0; k < sizeof(m_dspOps) / sizeof(m_dspOps[0]); k++) {
+        const dspOp_t * op = &m_dspOps[k];
+        int mismatches = 0;
+
+        for (int trial = 0; trial < DSP_OP_TRIALS; trial++) {
+            opus_int32 a = dspWord(), b = dspWord(), c = dspWord();
+            int64_t got = op->Op(a, b, c), want = op->Ref(a, b, c);
+            if (got != want && mismatches++ == 0)
+                printf("%s(0x%08X, 0x%08X, 0x%08X) gave %lld, not %lld\r\n", op->Name, (unsigned)a,
+                       (unsigned)b, (unsigned)c, (long long)got, (long long)want);
+        }
+        err += mismatches;
+    }
+    printf("%d instructions and macros, %d operands each%s.\r\n",
+           (int)(sizeof(m_dspOps) / sizeof(m_dspOps[0])), DSP_OP_TRIALS, err ? "" : ": all exact");
+    for (k = 0; k < sizeof(m_dspKernels) / sizeof(m_dspKernels[0]); k++) {
+        int mismatches = 0;
+
+        for (int trial = 0; trial < DSP_KERNEL_TRIALS; trial++)
+            mismatches += !m_dspKernels[k].Trial(trial);
+        printf("%-26s %d of %d trials bit-exact\r\n", m_dspKernels[k].Name,
+               DSP_KERNEL_TRIALS - mismatches, DSP_KERNEL_TRIALS);
+        err += mismatches;
+    }
+    if (err) {
+        printf("ERR! %d results of the Cortex-M4 layer didn't match.\r\n", err);
+        return 1;
+    }
+    return 0;
+#else
+    printf("This build has the generic C arithmetic: build it with OPUS_ARM_INLINE_EDSP and\r\n"
+           "OPUS_ARM_INLINE_MEDIA for the Cortex-M4 layer, with C in place of each instruction.\r\n");
+    return 0;
+#endif
+}
+
+int main (int argc, char ** argv) {
+    printf("Ogg Stripper Testbed starting up...\r\n");
+    if (argc > 1 && !strcmp(argv[1], "crc"))
+        return crcBench();
+    if (argc > 1 && !strcmp(argv[1], "seek"))
+        return seekTest();
+    if (argc > 1 && !strcmp(argv[1], "mmap"))
+        return mmapBench(argc - 2, argv + 2);
+    if (argc > 1 && !strcmp(argv[1], "readahead"))
+        return readAheadTest();
+    if (argc > 1 && !strcmp(argv[1], "chain"))
+        return chainTest(argc > 2 ? argv[2] : "sample.ogg");
+    if (argc > 1 && !strcmp(argv[1], "i2s"))
+        return i2sTest(argc - 2, argv + 2);
+    if (argc > 1 && !strcmp(argv[1], "spsc"))
+        return spscTest();
+    if (argc > 1 && !strcmp(argv[1], "reframe"))
+        return reframeTest();
+    if (argc > 1 && !strcmp(argv[1], "noalloc"))
+        return noAllocTest(argc > 2 ? argv[2] : "sample.opk");
+    if (argc > 1 && !strcmp(argv[1], "scratch"))
+        return scratchTest(argc > 2 ? argv[2] : "sample.opk");
+    if (argc > 1 && !strcmp(argv[1], "cores"))
+        return coresTest(argc > 2 ? argv[2] : "sample.opk");
+    if (argc > 1 && !strcmp(argv[1], "pack"))
+        return packTest();
+    if (argc > 1 && !strcmp(argv[1], "gain"))
+        return gainTest();
+    if (argc > 1 && !strcmp(argv[1], "dtables"))
+        return writeDecimateTables(argc > 2 ? argv[2] : "../src/libopus/celt/static_decimate_fixed.h");
+    if (argc > 1 && !strcmp(argv[1], "decimate"))
+        return decimateTest(argc > 2 ? argv[2] : "sample.opk");
+    if (argc > 1 && !strcmp(argv[1], "imdct"))
+        return imdctTest();
+    if (argc > 1 && !strcmp(argv[1], "deemph"))
+        return deemphTest();
+    if (argc > 1 && !strcmp(argv[1], "simd"))
+        return simdTest();
+    if (argc > 1 && !strcmp(argv[1], "dsp"))
+        return dspTest();
+    return packFile(argc > 1 ? argv[1] : "sample.ogg", argc > 2 ? argv[2] : "sample.opk");
+}
@@ -0,0 +1,95 @@
+// Host stand-in for nrfx_i2s.h: the same calls as the driver in ../src/nrfx_i2s.c, driven by a
+// simulated peripheral instead of NRF_I2S0, so buffer handoff can be tested off-target.
+// The simulation follows the driver's rules: START latches the first buffer and asks for the
+// next straight away; every buffer_size words after that the peripheral latches whatever
+// TXD.PTR holds, and if nrfx_i2s_next_buffers_set hasn't been called since the last request
+// that's the buffer it just played, which plays again (the handler gets a NULL release).
+//
+// Time is a sample clock.  In virtual mode nothing happens until the program spends time
+// with I2sSimSpend (say, the cost of a decode) or waits for the next event with I2sSimIdle;
+// events that fall due in the meantime fire right there, preempting it, as the interrupt
+// would.  Handlers can spend time too, which holds everything else up.  In wall-clock mode a
+// thread fires the events in real time and the program just runs.
+// Either way the handler can be made late by up to a random jitter (interrupt latency), and
+// the simulator counts replays (underruns), late swaps, and calls made in the wrong state.
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef NRFX_I2S_HOST_SHIM_H
+#define NRFX_I2S_HOST_SHIM_H
+
+typedef int nrfx_err_t;
+#define NRFX_SUCCESS                0
+#define NRFX_ERROR_INVALID_STATE    8
+#define NRFX_ERROR_INVALID_PARAM    7
+#define NRFX_ERROR_INVALID_ADDR     16
+#define NRF_SUCCESS                 NRFX_SUCCESS
+
+#define NRF_GPIO_PIN_MAP(port, pin) (((port) << 5) | ((pin) & 0x1F))
+#define NRFX_I2S_PIN_NOT_USED       0xFF
+
+#define NRFX_I2S_STATUS_NEXT_BUFFERS_NEEDED (1UL << 0)
+#define NRFX_I2S_STATUS_TRANSFER_STOPPED    (1UL << 1)
+
+// Unlike the real register values, these are the dividers themselves, so the simulator can
+// work out the sample rate: LRCK = 32 MHz / mck_setup / ratio.
+typedef enum {
+    NRF_I2S_MCK_32MDIV8 = 8, NRF_I2S_MCK_32MDIV10 = 10, NRF_I2S_MCK_32MDIV11 = 11,
+    NRF_I2S_MCK_32MDIV15 = 15, NRF_I2S_MCK_32MDIV16 = 16, NRF_I2S_MCK_32MDIV21 = 21,
+    NRF_I2S_MCK_32MDIV23 = 23, NRF_I2S_MCK_32MDIV31 = 31, NRF_I2S_MCK_32MDIV32 = 32,
+    NRF_I2S_MCK_32MDIV42 = 42, NRF_I2S_MCK_32MDIV63 = 63, NRF_I2S_MCK_32MDIV125 = 125
+} nrf_i2s_mck_t;
+typedef enum {
+    NRF_I2S_RATIO_32X = 32, NRF_I2S_RATIO_48X = 48, NRF_I2S_RATIO_64X = 64,
+    NRF_I2S_RATIO_96X = 96, NRF_I2S_RATIO_128X = 128, NRF_I2S_RATIO_192X = 192,
+    NRF_I2S_RATIO_256X = 256, NRF_I2S_RATIO_384X = 384, NRF_I2S_RATIO_512X = 512
+} nrf_i2s_ratio_t;
+
+typedef struct {
+    uint8_t sck_pin, lrck_pin, mck_pin, sdout_pin, sdin_pin;
+    uint8_t irq_priority;
+    nrf_i2s_mck_t mck_setup;
+    nrf_i2s_ratio_t ratio;
+} nrfx_i2s_config_t;
+
+#define NRFX_I2S_DEFAULT_CONFIG(_pin_sck, _pin_lrck, _pin_mck, _pin_sdout, _pin_sdin) \
+    nrfx_i2s_config_t { (_pin_sck), (_pin_lrck), (_pin_mck), (_pin_sdout), (_pin_sdin), 7, \
+                        NRF_I2S_MCK_32MDIV8, NRF_I2S_RATIO_256X }
+
+typedef struct {
+    uint32_t * p_rx_buffer;
+    uint32_t const * p_tx_buffer;
+} nrfx_i2s_buffers_t;
+
+typedef void (*nrfx_i2s_data_handler_t)(nrfx_i2s_buffers_t const * p_released, uint32_t status);
+
+nrfx_err_t nrfx_i2s_init (nrfx_i2s_config_t const * p_config, nrfx_i2s_data_handler_t handler);
+void nrfx_i2s_uninit (void);
+nrfx_err_t nrfx_i2s_start (nrfx_i2s_buffers_t const * p_initial_buffers, uint16_t buffer_size, uint8_t flags);
+nrfx_err_t nrfx_i2s_next_buffers_set (nrfx_i2s_buffers_t const * p_buffers);
+void nrfx_i2s_stop (void);
+
+// Simulator controls.
+typedef struct {
+    uint32_t Buffers;             // Buffers latched, replays included.
+    uint32_t Replays;             // No buffer queued in time, so the last one played again.
+    uint32_t LateSwaps;           // nrfx_i2s_next_buffers_set after the deadline it was for.
+    uint32_t StateErrors;         // nrfx_i2s_next_buffers_set with no buffer asked for.
+    uint64_t WorstHandlerUs;      // Longest handler call.
+    int64_t MinHeadroomUs;        // Least time to spare on a next_buffers_set; negative if late.
+} i2sSimStats_t;
+
+// Called each time the peripheral latches a buffer, with what it's about to play.
+typedef void (*i2sSimMonitor_t)(void * context, const uint32_t * buffer, uint16_t words);
+
+void I2sSimConfigure (bool wallClock, uint32_t jitterUs, unsigned seed);
+void I2sSimSetMonitor (i2sSimMonitor_t monitor, void * context);
+uint32_t I2sSimPeriodUs (uint16_t words);
+uint64_t I2sSimNow (void);
+void I2sSimSpend (uint64_t us);
+bool I2sSimIdle (void);
+bool I2sSimRunning (void);
+const i2sSimStats_t * I2sSimStats (void);
+
+#endif
@@ -0,0 +1,399 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "nrfx_i2s.h"
+
+// The peripheral (what TXD.PTR holds and what's playing) and the driver (its m_cb) are kept
+// apart, as on the chip, so a buffer set after the peripheral has latched but before the
+// interrupt is serviced goes wrong the same way it would there.
+typedef struct {
+    nrfx_i2s_data_handler_t Handler;
+    uint32_t MckDivider, Ratio;
+    bool Initialized;
+    bool PoweredOn;               // Between start and the STOPPED event.
+    uint16_t Words;
+    uint64_t PeriodNs;            // One buffer.
+
+    // The peripheral.
+    const uint32_t * TxdPtr;      // TXD.PTR.
+    bool Written;                 // TXD.PTR written since the last latch...
+    uint64_t WrittenAt;           // ...at this time.
+    const uint32_t * Playing;
+    uint64_t NextLatch;
+    bool Stopping;
+    bool TxPending;               // TXPTRUPD raised and not yet serviced...
+    uint64_t TxDue;               // ...which it will be at this time, jitter included.
+
+    // The driver.
+    nrfx_i2s_buffers_t Current, Next;
+    bool BuffersNeeded;
+    uint64_t Deadline;            // The latch the buffers asked for are needed by.
+    bool InHandler;
+
+    // The simulation.
+    bool WallClock;
+    uint32_t JitterUs;
+    unsigned Seed;
+    uint64_t Now;                 // Virtual clock, nanoseconds.
+    struct timespec Start;        // Wall clock's zero.
+    uint32_t HandlerCalls;
+    i2sSimMonitor_t Monitor;
+    void * MonitorContext;
+    i2sSimStats_t Stats;
+    pthread_t Thread;
+    bool ThreadStarted;
+} i2sSim_t;
+
+static i2sSim_t m_sim;
+static pthread_mutex_t m_lock = PTHREAD_MUTEX_INITIALIZER; // Held by whoever is moving the simulation on.
+static pthread_cond_t m_called = PTHREAD_COND_INITIALIZER; // A handler call returned, or the thread quit.
+
+static uint64_t simNow (void) {
+    struct timespec now;
+
+    if (!m_sim.WallClock)
+        return m_sim.Now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - m_sim.Start.tv_sec) * 1000000000 + now.tv_nsec - m_sim.Start.tv_nsec;
+}
+
+static void sleepNs (uint64_t ns) {
+    struct timespec delay = { (time_t)(ns / 1000000000), (long)(ns % 1000000000) };
+
+    nanosleep(&delay, NULL);
+}
+
+// The peripheral reaches the end of a buffer (or is started) and latches TXD.PTR.  If
+// nothing new was written in time, that's the buffer it just played, and it plays again.
+static void simLatch (uint64_t at, bool starting) {
+    if (m_sim.Written && m_sim.WrittenAt <= at) {
+        m_sim.Playing = m_sim.TxdPtr;
+        m_sim.Written = false;
+    } else if (!starting) {
+        m_sim.Stats.Replays++;
+    }
+    m_sim.Stats.Buffers++;
+    if (m_sim.Monitor)
+        m_sim.Monitor(m_sim.MonitorContext, m_sim.Playing, m_sim.Words);
+
+    // Events don't queue: if the last one hasn't been serviced, this one merges with it.
+    if (!m_sim.TxPending) {
+        m_sim.TxPending = true;
+        m_sim.TxDue = at;
+        if (m_sim.JitterUs)
+            m_sim.TxDue += (uint64_t)(rand_r(&m_sim.Seed) % (m_sim.JitterUs + 1)) * 1000;
+    }
+    m_sim.NextLatch = at + m_sim.PeriodNs;
+}
+
+// Call the handler the way nrfx_i2s_irq_handler would.  Called with the lock held, which
+// is let go for the call.
+static void simCallHandler (nrfx_i2s_buffers_t const * released, uint32_t status) {
+    uint64_t start = simNow(), took;
+
+    m_sim.InHandler = true;
+    pthread_mutex_unlock(&m_lock);
+    m_sim.Handler(released, status);
+    pthread_mutex_lock(&m_lock);
+    m_sim.InHandler = false;
+
+    took = (simNow() - start) / 1000;
+    if (took > m_sim.Stats.WorstHandlerUs)
+        m_sim.Stats.WorstHandlerUs = took;
+    m_sim.HandlerCalls++;
+    pthread_cond_broadcast(&m_called);
+}
+
+// The interrupt, for TXPTRUPD.
+static void simServiceTx (void) {
+    nrfx_i2s_buffers_t released;
+
+    m_sim.TxPending = false;
+    m_sim.Deadline = m_sim.NextLatch;
+    if (m_sim.BuffersNeeded) {
+        simCallHandler(NULL, NRFX_I2S_STATUS_NEXT_BUFFERS_NEEDED);
+    } else {
+        released = m_sim.Current;
+        m_sim.Current = m_sim.Next;
+        memset(&m_sim.Next, 0, sizeof(m_sim.Next));
+        m_sim.BuffersNeeded = true;
+        simCallHandler(&released, NRFX_I2S_STATUS_NEXT_BUFFERS_NEEDED);
+    }
+}
+
+// The interrupt, for STOPPED.
+static void simServiceStopped (void) {
+    nrfx_i2s_buffers_t current = m_sim.Current, next = m_sim.Next;
+
+    m_sim.Stopping = false;
+    m_sim.PoweredOn = false;
+    simCallHandler(&current, 0);
+    simCallHandler(&next, NRFX_I2S_STATUS_TRANSFER_STOPPED);
+}
+
+// The next thing due, and whether it's an interrupt (rather than a latch, which is the
+// peripheral's and happens whatever the CPU is doing).  False if nothing is.
+static bool simNextEvent (uint64_t * at, bool * interrupt) {
+    bool found = false;
+
+    if (!m_sim.PoweredOn)
+        return false;
+    if (!m_sim.Stopping) {
+        *at = m_sim.NextLatch;
+        *interrupt = false;
+        found = true;
+    }
+    // An interrupt waits for the handler that's running to return.
+    if (!m_sim.InHandler) {
+        if (m_sim.Stopping && (!found || m_sim.Now <= *at)) {
+            *at = m_sim.Now;
+            *interrupt = true;
+            found = true;
+        } else if (m_sim.TxPending && (!found || m_sim.TxDue <= *at)) {
+            *at = m_sim.TxDue;
+            *interrupt = true;
+            found = true;
+        }
+    }
+    return found;
+}
+
+static void simFire (bool interrupt) {
+    if (!interrupt)
+        simLatch(m_sim.NextLatch, false);
+    else if (m_sim.Stopping)
+        simServiceStopped();
+    else
+        simServiceTx();
+}
+
+// Virtual time: fire everything due up to end, then move the clock there.
+static void simRunUntil (uint64_t end) {
+    uint64_t at;
+    bool interrupt;
+
+    while (simNextEvent(&at, &interrupt) && at <= end) {
+        if (at > m_sim.Now)
+            m_sim.Now = at;
+        simFire(interrupt);
+    }
+    if (end > m_sim.Now)
+        m_sim.Now = end;
+}
+
+// Wall time: the interrupt context, a thread of its own.
+static void * simThread (void * context) {
+    uint64_t at, now;
+    bool interrupt;
+
+    (void)context;
+    pthread_mutex_lock(&m_lock);
+    while (simNextEvent(&at, &interrupt)) {
+        now = simNow();
+        if (at > now) {
+            pthread_mutex_unlock(&m_lock);
+            sleepNs(at - now);
+            pthread_mutex_lock(&m_lock);
+            continue;
+        }
+        simFire(interrupt);
+    }
+    pthread_cond_broadcast(&m_called);
+    pthread_mutex_unlock(&m_lock);
+    return NULL;
+}
+
+static void simJoin (void) {
+    if (m_sim.ThreadStarted) {
+        pthread_join(m_sim.Thread, NULL);
+        m_sim.ThreadStarted = false;
+    }
+}
+
+nrfx_err_t nrfx_i2s_init (nrfx_i2s_config_t const * p_config, nrfx_i2s_data_handler_t handler) {
+    if (m_sim.Initialized)
+        return NRFX_ERROR_INVALID_STATE;
+    if (!handler || !p_config->mck_setup || !p_config->ratio)
+        return NRFX_ERROR_INVALID_PARAM;
+    m_sim.Handler = handler;
+    m_sim.MckDivider = p_config->mck_setup;
+    m_sim.Ratio = p_config->ratio;
+    m_sim.Initialized = true;
+    return NRFX_SUCCESS;
+}
+
+void nrfx_i2s_uninit (void) {
+    if (!m_sim.Initialized)
+        return;
+    nrfx_i2s_stop();
+    if (m_sim.WallClock) {
+        simJoin();
+    } else {
+        pthread_mutex_lock(&m_lock);
+        simRunUntil(m_sim.Now);
+        pthread_mutex_unlock(&m_lock);
+    }
+    m_sim.Initialized = false;
+}
+
+nrfx_err_t nrfx_i2s_start (nrfx_i2s_buffers_t const * p_initial_buffers, uint16_t buffer_size, uint8_t flags) {
+    (void)flags;
+    if (!m_sim.Initialized || m_sim.PoweredOn)
+        return NRFX_ERROR_INVALID_STATE;
+    if (!p_initial_buffers->p_tx_buffer || !buffer_size)
+        return NRFX_ERROR_INVALID_PARAM;
+    if ((uintptr_t)p_initial_buffers->p_tx_buffer & 3)
+        return NRFX_ERROR_INVALID_ADDR;
+    simJoin();
+
+    pthread_mutex_lock(&m_lock);
+    m_sim.Words = buffer_size;
+    m_sim.PeriodNs = I2sSimPeriodUs(buffer_size) * 1000ULL;
+    m_sim.Current.p_rx_buffer = NULL;
+    m_sim.Current.p_tx_buffer = NULL;
+    m_sim.Next = *p_initial_buffers;
+    m_sim.BuffersNeeded = false;
+    m_sim.TxPending = false;
+    m_sim.Stopping = false;
+    m_sim.PoweredOn = true;
+
+    // START latches the initial buffer straight away, and asks for the next.
+    m_sim.TxdPtr = p_initial_buffers->p_tx_buffer;
+    m_sim.Written = true;
+    m_sim.WrittenAt = simNow();
+    simLatch(m_sim.WrittenAt, true);
+
+    if (m_sim.WallClock) {
+        m_sim.ThreadStarted = pthread_create(&m_sim.Thread, NULL, simThread, NULL) == 0;
+    } else if (!m_sim.InHandler) {
+        simRunUntil(m_sim.Now); // The interrupt preempts the caller.
+    }
+    pthread_mutex_unlock(&m_lock);
+    return NRFX_SUCCESS;
+}
+
+nrfx_err_t nrfx_i2s_next_buffers_set (nrfx_i2s_buffers_t const * p_buffers) {
+    int64_t headroom;
+
+    if (!p_buffers->p_tx_buffer)
+        return NRFX_ERROR_INVALID_PARAM;
+    if ((uintptr_t)p_buffers->p_tx_buffer & 3)
+        return NRFX_ERROR_INVALID_ADDR;
+
+    pthread_mutex_lock(&m_lock);
+    if (!m_sim.PoweredOn || !m_sim.BuffersNeeded) {
+        m_sim.Stats.StateErrors++;
+        pthread_mutex_unlock(&m_lock);
+        return NRFX_ERROR_INVALID_STATE;
+    }
+
+    m_sim.TxdPtr = p_buffers->p_tx_buffer;
+    m_sim.Written = true;
+    m_sim.WrittenAt = simNow();
+    m_sim.Next = *p_buffers;
+    m_sim.BuffersNeeded = false;
+
+    headroom = ((int64_t)m_sim.Deadline - (int64_t)m_sim.WrittenAt) / 1000;
+    if (headroom < m_sim.Stats.MinHeadroomUs)
+        m_sim.Stats.MinHeadroomUs = headroom;
+    if (headroom < 0)
+        m_sim.Stats.LateSwaps++;
+    pthread_mutex_unlock(&m_lock);
+    return NRFX_SUCCESS;
+}
+
+void nrfx_i2s_stop (void) {
+    pthread_mutex_lock(&m_lock);
+    if (m_sim.PoweredOn && !m_sim.Stopping) {
+        m_sim.BuffersNeeded = false;
+        m_sim.TxPending = false; // TXPTRUPD is masked before STOP is triggered.
+        m_sim.Stopping = true;
+        if (!m_sim.WallClock && !m_sim.InHandler)
+            simRunUntil(m_sim.Now);
+    }
+    pthread_mutex_unlock(&m_lock);
+}
+
+// Pick the clock and the interrupt latency, and clear the stats.  Call before starting.
+// jitterUs delays each TXPTRUPD interrupt by anything from none to that much, at random.
+void I2sSimConfigure (bool wallClock, uint32_t jitterUs, unsigned seed) {
+    simJoin();
+    pthread_mutex_lock(&m_lock);
+    m_sim.WallClock = wallClock;
+    m_sim.JitterUs = jitterUs;
+    m_sim.Seed = seed;
+    m_sim.Now = 0;
+    clock_gettime(CLOCK_MONOTONIC, &m_sim.Start);
+    memset(&m_sim.Stats, 0, sizeof(m_sim.Stats));
+    m_sim.Stats.MinHeadroomUs = INT64_MAX;
+    pthread_mutex_unlock(&m_lock);
+}
+
+void I2sSimSetMonitor (i2sSimMonitor_t monitor, void * context) {
+    m_sim.Monitor = monitor;
+    m_sim.MonitorContext = context;
+}
+
+// How long a buffer of words stereo pairs plays for: LRCK is 32 MHz / MCK divider / ratio.
+uint32_t I2sSimPeriodUs (uint16_t words) {
+    return (uint32_t)((uint64_t)words * m_sim.MckDivider * m_sim.Ratio / 32);
+}
+
+uint64_t I2sSimNow (void) {
+    return simNow() / 1000;
+}
+
+// Take us microseconds, as a decode would.  In virtual time, whatever falls due meanwhile
+// happens now, interrupts preempting unless this is a handler.
+void I2sSimSpend (uint64_t us) {
+    if (m_sim.WallClock) {
+        sleepNs(us * 1000);
+        return;
+    }
+    pthread_mutex_lock(&m_lock);
+    simRunUntil(m_sim.Now + us * 1000);
+    pthread_mutex_unlock(&m_lock);
+}
+
+// Nothing to do until the next handler call: wait for it (in virtual time, skip to it).
+// In wall-clock time, gives up after a millisecond, so the caller can't sleep through a
+// handler call that happened just before.  Returns false once the I2S has stopped.
+bool I2sSimIdle (void) {
+    uint32_t calls;
+    uint64_t at;
+    bool interrupt;
+    struct timespec until;
+
+    pthread_mutex_lock(&m_lock);
+    calls = m_sim.HandlerCalls;
+    if (m_sim.WallClock) {
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += 1000000;
+        if (until.tv_nsec >= 1000000000) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000;
+        }
+        if (m_sim.PoweredOn && calls == m_sim.HandlerCalls)
+            pthread_cond_timedwait(&m_called, &m_lock, &until);
+    } else {
+        while (calls == m_sim.HandlerCalls && simNextEvent(&at, &interrupt))
+            simRunUntil(at);
+    }
+    pthread_mutex_unlock(&m_lock);
+    return I2sSimRunning();
+}
+
+bool I2sSimRunning (void) {
+    bool running;
+
+    pthread_mutex_lock(&m_lock);
+    running = m_sim.PoweredOn;
+    pthread_mutex_unlock(&m_lock);
+    return running;
+}
+
+const i2sSimStats_t * I2sSimStats (void) {
+    return &m_sim.Stats;
+}
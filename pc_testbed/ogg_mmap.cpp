@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Arduino.h"
+#include "ogg_stripper.h"
+#include "ogg_mmap.h"
+
+// Map path and get ready to walk it from the first page.
+// The first page's serial number is taken as the stream to follow.
+int OggMapOpen (oggMap_t * map, const char * path, bool verifyCrc) {
+    struct stat info;
+    void * base;
+    int fd;
+
+    memset(map, 0, sizeof(*map));
+    map->VerifyCrc = verifyCrc;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return OGG_STRIP_EOF;
+    if (fstat(fd, &info) < 0 || info.st_size < OGG_PAGE_HEADER_LEN) {
+        close(fd);
+        return OGG_STRIP_EOF;
+    }
+
+    // The mapping holds its own reference to the file, so the descriptor can go now.
+    base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return OGG_STRIP_EOF;
+
+    // We only ever walk forwards, so let the kernel read ahead hard and drop pages behind us.
+    madvise(base, info.st_size, MADV_SEQUENTIAL);
+    madvise(base, info.st_size, MADV_WILLNEED);
+
+    map->Map = (const uint8_t *)base;
+    map->Size = info.st_size;
+    if (memcmp(map->Map, "OggS", 4)) {
+        OggMapClose(map);
+        return OGG_STRIP_BAD_MAGIC;
+    }
+    memcpy(&map->Serial, map->Map + 14, sizeof(map->Serial));
+    return OGG_STRIP_OK;
+}
+
+void OggMapClose (oggMap_t * map) {
+    if (map->Map)
+        munmap((void *)map->Map, map->Size);
+    map->Map = NULL;
+}
+
+// Offset of the next capture pattern after the bad page at pos, or Size if there isn't one.
+static size_t OggMapResync (const oggMap_t * map, size_t pos) {
+    const void * found = memmem(map->Map + pos + 1, map->Size - pos - 1, "OggS", 4);
+    return found ? (size_t)((const uint8_t *)found - map->Map) : map->Size;
+}
+
+// Step onto the next good page of our stream.  Junk, damaged pages (if checking CRCs) and
+// other streams' pages are skipped over.
+static int OggMapNextPage (oggMap_t * map) {
+    const uint8_t * page;
+    size_t pos = map->NextPage;
+    size_t headerLen, dataLen, i;
+    uint32_t serial, checksum;
+
+    while (pos + OGG_PAGE_HEADER_LEN <= map->Size) {
+        page = map->Map + pos;
+        if (memcmp(page, "OggS", 4)) {
+            map->BadPages++;
+            pos = OggMapResync(map, pos);
+            continue;
+        }
+
+        headerLen = OGG_PAGE_HEADER_LEN + page[26];
+        dataLen = 0;
+        if (pos + headerLen <= map->Size) {
+            for (i = 0; i < page[26]; i++)
+                dataLen += page[OGG_PAGE_HEADER_LEN + i];
+        }
+        if (pos + headerLen + dataLen > map->Size)
+            break; // Truncated final page.
+
+        if (map->VerifyCrc) {
+            static const uint8_t noChecksum[4] = {0, 0, 0, 0};
+            uint32_t crc = OggCrcUpdate(0, page, 22);
+            crc = OggCrcUpdate(crc, noChecksum, 4);
+            crc = OggCrcUpdate(crc, page + 26, headerLen + dataLen - 26);
+            memcpy(&checksum, page + 22, sizeof(checksum));
+            if (crc != checksum) {
+                map->BadPages++;
+                pos = OggMapResync(map, pos);
+                continue;
+            }
+        }
+
+        map->NextPage = pos + headerLen + dataLen;
+        memcpy(&serial, page + 14, sizeof(serial));
+        if (serial != map->Serial) {
+            pos = map->NextPage;
+            continue;
+        }
+
+        memcpy(&map->Granule, page + 6, sizeof(map->Granule));
+        map->Segments = page + OGG_PAGE_HEADER_LEN;
+        map->SegmentCount = page[26];
+        map->Segment = 0;
+        map->Data = page + headerLen;
+        return page[5];
+    }
+
+    map->NextPage = map->Size;
+    return OGG_STRIP_EOF;
+}
+
+// Fill in packet with the next packet in the stream (header packets included).
+// Packets that were cut off by a damaged or missing page are dropped.
+int OggMapNextPacket (oggMap_t * map, oggMapPacket_t * packet) {
+    uint8_t lacing;
+    uint32_t badPages;
+    int flags;
+
+    packet->Count = 0;
+    packet->Length = 0;
+    for (;;) {
+        if (map->Segment >= map->SegmentCount) {
+            badPages = map->BadPages;
+            flags = OggMapNextPage(map);
+            if (flags < 0)
+                return flags;
+
+            // A damaged page went by: whatever follows doesn't belong to what we hold.
+            if (!(flags & OGG_FLAG_CONTINUED) || map->BadPages != badPages) {
+                packet->Count = 0; // The rest never arrived.
+                packet->Length = 0;
+            }
+            if ((flags & OGG_FLAG_CONTINUED) && !packet->Count) {
+                // Tail of a packet whose start we never saw; skip it.
+                while (map->Segment < map->SegmentCount) {
+                    lacing = map->Segments[map->Segment++];
+                    map->Data += lacing;
+                    if (lacing < 255)
+                        break;
+                }
+            }
+            continue;
+        }
+
+        if (!packet->Count || packet->Parts[packet->Count - 1] + packet->PartLengths[packet->Count - 1] != map->Data) {
+            if (packet->Count == OGG_MAP_MAX_PARTS)
+                return OGG_STRIP_BUF_SMALL;
+            packet->Parts[packet->Count] = map->Data;
+            packet->PartLengths[packet->Count++] = 0;
+        }
+
+        lacing = map->Segments[map->Segment++];
+        packet->PartLengths[packet->Count - 1] += lacing;
+        packet->Length += lacing;
+        map->Data += lacing;
+
+        if (lacing < 255) {
+            packet->Granule = map->Granule;
+            return packet->Length;
+        }
+    }
+}
@@ -0,0 +1,41 @@
+// Memory-mapped Ogg demuxer, for batch jobs on the host.
+// The whole file is mapped read-only and walked in place: packets come back as spans
+// pointing into the mapping, so there are no copies and no syscalls per packet.
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef OGG_MMAP_H
+#define OGG_MMAP_H
+
+#define OGG_MAP_MAX_PARTS 16 // Pages a single packet may be spread over.
+
+// A packet, as the pieces of it found on each page it touches.
+// Opus pages normally end on packet boundaries, so Count is almost always 1.
+typedef struct {
+    const uint8_t * Parts[OGG_MAP_MAX_PARTS];
+    uint32_t PartLengths[OGG_MAP_MAX_PARTS];
+    uint8_t Count;
+    uint32_t Length;          // Sum of PartLengths.
+    uint64_t Granule;         // Granule position of the page the packet ends on.
+} oggMapPacket_t;
+
+typedef struct {
+    const uint8_t * Map;
+    size_t Size;
+    size_t NextPage;          // Offset of the next page header.
+    const uint8_t * Segments; // Lacing values of the current page.
+    uint8_t SegmentCount;
+    uint8_t Segment;          // Next lacing value to use.
+    const uint8_t * Data;     // Next unread data byte on the current page.
+    uint64_t Granule;         // Granule position of the current page.
+    uint32_t Serial;          // Only pages with this serial are returned.
+    bool VerifyCrc;
+    uint32_t BadPages;        // Pages skipped for a bad CRC or capture pattern.
+} oggMap_t;
+
+int OggMapOpen (oggMap_t * map, const char * path, bool verifyCrc);
+void OggMapClose (oggMap_t * map);
+int OggMapNextPacket (oggMap_t * map, oggMapPacket_t * packet);
+
+#endif
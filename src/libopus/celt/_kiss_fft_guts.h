@@ -90,13 +90,8 @@
     do {(res).r = ADD32_ovflw((res).r,(a).r);  (res).i = SUB32_ovflw((res).i,(a).i); \
     }while(0)
 
-#if defined(OPUS_ARM_INLINE_ASM)
-#include "arm/kiss_fft_armv4.h"
-#endif
-
-#if defined(OPUS_ARM_INLINE_EDSP)
-#include "arm/kiss_fft_armv5e.h"
-#endif
+/* No ARM versions of the butterflies here: S_MUL() is MULT16_32_Q15(), which
+   arm/fixed_armv5e.h already makes a single SMULL. */
 #if defined(MIPSr1_ASM)
 #include "mips/kiss_fft_mipsr1.h"
 #endif
@@ -92,6 +92,10 @@ void celt_fatal(const char *str, const char *file, int line)
 #define celt_sig_assert(cond)
 #endif
 
+/* Breaks the build unless cond, a constant expression, is true. name must be unique
+   within the file. */
+#define celt_static_assert(cond, name) typedef char celt_static_assert_##name[(cond) ? 1 : -1]
+
 #define IMUL32(a,b) ((a)*(b))
 
 #define MIN16(a,b) ((a) < (b) ? (a) : (b))   /**< Minimum 16-bit value.   */
@@ -0,0 +1,380 @@
+/* Cortex-M4 DSP extension instructions, with a portable C version of each */
+
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef CM4_DSP_H
+#define CM4_DSP_H
+
+#include <string.h>
+#include "../../opus_types.h"
+#include "../../opus_defines.h"
+
+/* Each cm4_*() is one DSP extension instruction. On a core with the extension
+   (__ARM_FEATURE_DSP: the Cortex-M4 and M7, and ARMv6/v7-A) it is that
+   instruction in inline asm. Everywhere else it is C that computes the same
+   32 bits, wrap-around and saturation included, so that the code built on
+   top of these can be checked bit-exact on the host ("testbed dsp"). */
+#if defined(__ARM_FEATURE_DSP)
+# define CM4_DSP_ASM
+#endif
+
+/* Two consecutive 16-bit values as one word, the first in the bottom half.
+   The M4 allows unaligned LDR, which is what this compiles to. */
+static OPUS_INLINE opus_int32 cm4_ld16x2(const opus_int16 *p)
+{
+  opus_int32 res;
+  memcpy(&res, p, sizeof(res));
+  return res;
+}
+
+/* (bottom a) * (bottom b) */
+static OPUS_INLINE opus_int32 cm4_smulbb(opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smulbb\n\t"
+      "smulbb %0, %1, %2\n\t"
+      : "=r"(res)
+      : "%r"(a), "r"(b)
+  );
+  return res;
+#else
+  return (opus_int32)(opus_int16)a*(opus_int16)b;
+#endif
+}
+
+/* acc + (bottom a) * (bottom b), wrapping */
+static OPUS_INLINE opus_int32 cm4_smlabb(opus_int32 acc, opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smlabb\n\t"
+      "smlabb %0, %1, %2, %3\n\t"
+      : "=r"(res)
+      : "%r"(a), "r"(b), "r"(acc)
+  );
+  return res;
+#else
+  return (opus_int32)((opus_uint32)acc + (opus_uint32)cm4_smulbb(a, b));
+#endif
+}
+
+/* (bottom a) * (top b) */
+static OPUS_INLINE opus_int32 cm4_smulbt(opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smulbt\n\t"
+      "smulbt %0, %1, %2\n\t"
+      : "=r"(res)
+      : "r"(a), "r"(b)
+  );
+  return res;
+#else
+  return (opus_int32)(opus_int16)a*(b>>16);
+#endif
+}
+
+/* acc + (bottom a) * (top b), wrapping */
+static OPUS_INLINE opus_int32 cm4_smlabt(opus_int32 acc, opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smlabt\n\t"
+      "smlabt %0, %1, %2, %3\n\t"
+      : "=r"(res)
+      : "r"(a), "r"(b), "r"(acc)
+  );
+  return res;
+#else
+  return (opus_int32)((opus_uint32)acc + (opus_uint32)cm4_smulbt(a, b));
+#endif
+}
+
+/* (top a) * (top b) */
+static OPUS_INLINE opus_int32 cm4_smultt(opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smultt\n\t"
+      "smultt %0, %1, %2\n\t"
+      : "=r"(res)
+      : "%r"(a), "r"(b)
+  );
+  return res;
+#else
+  return (a>>16)*(b>>16);
+#endif
+}
+
+/* acc + (top a) * (top b), wrapping */
+static OPUS_INLINE opus_int32 cm4_smlatt(opus_int32 acc, opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smlatt\n\t"
+      "smlatt %0, %1, %2, %3\n\t"
+      : "=r"(res)
+      : "%r"(a), "r"(b), "r"(acc)
+  );
+  return res;
+#else
+  return (opus_int32)((opus_uint32)acc + (opus_uint32)cm4_smultt(a, b));
+#endif
+}
+
+/* (a * (bottom b)) >> 16, from the full 48-bit product */
+static OPUS_INLINE opus_int32 cm4_smulwb(opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smulwb\n\t"
+      "smulwb %0, %1, %2\n\t"
+      : "=r"(res)
+      : "r"(a), "r"(b)
+  );
+  return res;
+#else
+  return (opus_int32)(((opus_int64)a*(opus_int16)b)>>16);
+#endif
+}
+
+/* acc + ((a * (bottom b)) >> 16), wrapping */
+static OPUS_INLINE opus_int32 cm4_smlawb(opus_int32 acc, opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smlawb\n\t"
+      "smlawb %0, %1, %2, %3\n\t"
+      : "=r"(res)
+      : "r"(a), "r"(b), "r"(acc)
+  );
+  return res;
+#else
+  return (opus_int32)((opus_uint32)acc + (opus_uint32)cm4_smulwb(a, b));
+#endif
+}
+
+/* (a * (top b)) >> 16, from the full 48-bit product */
+static OPUS_INLINE opus_int32 cm4_smulwt(opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smulwt\n\t"
+      "smulwt %0, %1, %2\n\t"
+      : "=r"(res)
+      : "r"(a), "r"(b)
+  );
+  return res;
+#else
+  return (opus_int32)(((opus_int64)a*(b>>16))>>16);
+#endif
+}
+
+/* acc + ((a * (top b)) >> 16), wrapping */
+static OPUS_INLINE opus_int32 cm4_smlawt(opus_int32 acc, opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smlawt\n\t"
+      "smlawt %0, %1, %2, %3\n\t"
+      : "=r"(res)
+      : "r"(a), "r"(b), "r"(acc)
+  );
+  return res;
+#else
+  return (opus_int32)((opus_uint32)acc + (opus_uint32)cm4_smulwt(a, b));
+#endif
+}
+
+/* acc + (bottom a)*(bottom b) + (top a)*(top b), wrapping (the Q flag the
+   instruction sets on overflow is never read) */
+static OPUS_INLINE opus_int32 cm4_smlad(opus_int32 a, opus_int32 b, opus_int32 acc)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smlad\n\t"
+      "smlad %0, %1, %2, %3\n\t"
+      : "=r"(res)
+      : "%r"(a), "r"(b), "r"(acc)
+  );
+  return res;
+#else
+  return (opus_int32)((opus_uint32)acc + (opus_uint32)cm4_smulbb(a, b)
+        + (opus_uint32)cm4_smultt(a, b));
+#endif
+}
+
+/* acc + (bottom a)*(top b) + (top a)*(bottom b), wrapping */
+static OPUS_INLINE opus_int32 cm4_smladx(opus_int32 a, opus_int32 b, opus_int32 acc)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smladx\n\t"
+      "smladx %0, %1, %2, %3\n\t"
+      : "=r"(res)
+      : "r"(a), "r"(b), "r"(acc)
+  );
+  return res;
+#else
+  return (opus_int32)((opus_uint32)acc + (opus_uint32)cm4_smulbt(a, b)
+        + (opus_uint32)cm4_smulbt(b, a));
+#endif
+}
+
+/* The bottom half of a with the top half of b */
+static OPUS_INLINE opus_int32 cm4_pkhbt(opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_pkhbt\n\t"
+      "pkhbt %0, %1, %2\n\t"
+      : "=r"(res)
+      : "r"(a), "r"(b)
+  );
+  return res;
+#else
+  return (opus_int32)(((opus_uint32)a & 0x0000FFFF) | ((opus_uint32)b & 0xFFFF0000));
+#endif
+}
+
+/* a + b, saturated to 32 bits */
+static OPUS_INLINE opus_int32 cm4_qadd(opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_qadd\n\t"
+      "qadd %0, %1, %2\n\t"
+      : "=r"(res)
+      : "%r"(a), "r"(b)
+  );
+  return res;
+#else
+  opus_int64 res = (opus_int64)a + b;
+  return res > 2147483647 ? 2147483647 : res < -2147483647-1 ? -2147483647-1 : (opus_int32)res;
+#endif
+}
+
+/* a - b, saturated to 32 bits */
+static OPUS_INLINE opus_int32 cm4_qsub(opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_qsub\n\t"
+      "qsub %0, %1, %2\n\t"
+      : "=r"(res)
+      : "r"(a), "r"(b)
+  );
+  return res;
+#else
+  opus_int64 res = (opus_int64)a - b;
+  return res > 2147483647 ? 2147483647 : res < -2147483647-1 ? -2147483647-1 : (opus_int32)res;
+#endif
+}
+
+/* a saturated to [-32768, 32767] */
+static OPUS_INLINE opus_int32 cm4_ssat16(opus_int32 a)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_ssat16\n\t"
+      "ssat %0, #16, %1\n\t"
+      : "=r"(res)
+      : "r"(a)
+  );
+  return res;
+#else
+  return a > 32767 ? 32767 : a < -32768 ? -32768 : a;
+#endif
+}
+
+/* The 64-bit product a*b. GCC already turns this into a single SMULL, and
+   shifting the result down into one SMULL and two or three ALU ops. */
+static OPUS_INLINE opus_int64 cm4_smull(opus_int32 a, opus_int32 b)
+{
+  return (opus_int64)a*b;
+}
+
+/* The top word of a*b */
+static OPUS_INLINE opus_int32 cm4_smmul(opus_int32 a, opus_int32 b)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_smmul\n\t"
+      "smmul %0, %1, %2\n\t"
+      : "=r"(res)
+      : "%r"(a), "r"(b)
+  );
+  return res;
+#else
+  return (opus_int32)(cm4_smull(a, b)>>32);
+#endif
+}
+
+/* Leading zeros of a, 32 for 0 */
+static OPUS_INLINE opus_int32 cm4_clz(opus_int32 a)
+{
+#if defined(CM4_DSP_ASM)
+  opus_int32 res;
+  __asm__(
+      "#cm4_clz\n\t"
+      "clz %0, %1\n\t"
+      : "=r"(res)
+      : "r"(a)
+  );
+  return res;
+#else
+  opus_uint32 x = (opus_uint32)a;
+  opus_int32 n = 0;
+  if (x == 0)
+    return 32;
+  if (!(x & 0xFFFF0000)) { n += 16; x <<= 16; }
+  if (!(x & 0xFF000000)) { n += 8; x <<= 8; }
+  if (!(x & 0xF0000000)) { n += 4; x <<= 4; }
+  if (!(x & 0xC0000000)) { n += 2; x <<= 2; }
+  if (!(x & 0x80000000)) { n += 1; }
+  return n;
+#endif
+}
+
+#endif /* CM4_DSP_H */
@@ -0,0 +1,82 @@
+/* CELT's fixed-point multiply macros on the ARMv5E DSP instructions, with
+   ARMv6 saturation where OPUS_ARM_INLINE_MEDIA allows it */
+
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef FIXED_ARMv5E_H
+#define FIXED_ARMv5E_H
+
+#include "cm4_dsp.h"
+
+/* Each of these gives the same result as fixed_generic.h's 64-bit form,
+   which is what a host build uses, so the two can be compared bit for bit.
+   Without a fast 64-bit type fixed_generic.h builds the Q15 and Q31 products
+   out of 16-bit halves instead; one SMULL does the whole product. */
+
+/** 16x32 multiplication, followed by a 16-bit shift right. Results fits in 32 bits */
+#undef MULT16_32_Q16
+#define MULT16_32_Q16(a,b) (cm4_smulwb(b, a))
+
+/** 16x32 multiply, followed by a 16-bit shift right and 32-bit add.
+    Results fits in 32 bits */
+#undef MAC16_32_Q16
+#define MAC16_32_Q16(c,a,b) (cm4_smlawb(c, b, a))
+
+/** 16x32 multiplication, followed by a 15-bit shift right. Results fits in 32 bits.
+    SMULWB and a doubling would drop the product's bit 15, so this takes SMULL. */
+#undef MULT16_32_Q15
+#define MULT16_32_Q15(a,b) ((opus_val32)(cm4_smull((opus_val16)(a), b)>>15))
+
+/** 16x32 multiply, followed by a 15-bit shift right and 32-bit add.
+    b must fit in 31 bits. Result fits in 32 bits. */
+#undef MAC16_32_Q15
+#define MAC16_32_Q15(c,a,b) ADD32((c), MULT16_32_Q15(a,b))
+
+/** 32x32 multiplication, followed by a 31-bit shift right. Results fits in 32 bits */
+#undef MULT32_32_Q31
+#define MULT32_32_Q31(a,b) ((opus_val32)(cm4_smull(a, b)>>31))
+
+/** 16x16 multiplication where the result fits in 32 bits */
+#undef MULT16_16
+#define MULT16_16(a,b) (cm4_smulbb(a, b))
+
+/** 16x16 multiply-add where the result fits in 32 bits */
+#undef MAC16_16
+#define MAC16_16(c,a,b) (cm4_smlabb(c, a, b))
+
+#if defined(OPUS_ARM_INLINE_MEDIA)
+
+/** Saturate to 16 bits */
+#undef SATURATE16
+#define SATURATE16(x) ((opus_val16)cm4_ssat16(x))
+
+/* Shadows arch.h's SAT16() function, which the output paths call per sample */
+#undef SAT16
+#define SAT16(x) ((opus_int16)cm4_ssat16(x))
+
+#endif /* OPUS_ARM_INLINE_MEDIA */
+
+#endif /* FIXED_ARMv5E_H */
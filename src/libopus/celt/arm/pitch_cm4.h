@@ -0,0 +1,89 @@
+/* Cortex-M4 version of the fixed-point correlation kernel */
+
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PITCH_CM4_H
+#define PITCH_CM4_H
+
+#include "../arch.h"
+#include "cm4_dsp.h"
+
+#if defined(FIXED_POINT) && !defined(OVERRIDE_XCORR_KERNEL)
+
+/* xcorr_kernel_c() two taps at a time. Each pair of x is one word, and so is
+   each pair of y; SMLAD takes the even lags, and SMLADX the odd ones, off
+   y[j+1..j+2] and y[j+3..j+4] put together with PKHBT. That is two word
+   loads, two PKHBTs and four SMLAD(X)s per two taps, where xcorr_kernel_c()
+   takes four halfword loads and eight MACs. The sums wrap just like
+   MAC16_16(), so the order of the adds doesn't change the result. */
+static OPUS_INLINE void xcorr_kernel_cm4(const opus_val16 *x, const opus_val16 *y,
+      opus_val32 sum[4], int len)
+{
+   int j;
+   opus_int32 sum0, sum1, sum2, sum3;
+   opus_int32 y01, y23;
+   celt_assert(len>=3);
+   sum0 = sum[0];
+   sum1 = sum[1];
+   sum2 = sum[2];
+   sum3 = sum[3];
+   y01 = cm4_ld16x2(y);
+   y23 = cm4_ld16x2(y+2);
+   /* j<len-2 keeps the loads of y[j+4..j+5] within the y[len+2] that
+      xcorr_kernel_c() reads up to */
+   for (j=0;j<len-2;j+=2)
+   {
+      opus_int32 x01, y45;
+      x01 = cm4_ld16x2(x+j);
+      y45 = cm4_ld16x2(y+j+4);
+      sum0 = cm4_smlad(x01, y01, sum0);
+      sum1 = cm4_smladx(x01, cm4_pkhbt(y23, y01), sum1);
+      sum2 = cm4_smlad(x01, y23, sum2);
+      sum3 = cm4_smladx(x01, cm4_pkhbt(y45, y23), sum3);
+      y01 = y23;
+      y23 = y45;
+   }
+   for (;j<len;j++)
+   {
+      opus_int32 xj = x[j];
+      sum0 = cm4_smlabb(sum0, xj, y[j]);
+      sum1 = cm4_smlabb(sum1, xj, y[j+1]);
+      sum2 = cm4_smlabb(sum2, xj, y[j+2]);
+      sum3 = cm4_smlabb(sum3, xj, y[j+3]);
+   }
+   sum[0] = sum0;
+   sum[1] = sum1;
+   sum[2] = sum2;
+   sum[3] = sum3;
+}
+
+#define OVERRIDE_XCORR_KERNEL
+#define xcorr_kernel(x, y, sum, len, arch) \
+    ((void)(arch), xcorr_kernel_cm4(x, y, sum, len))
+
+#endif
+
+#endif /* PITCH_CM4_H */
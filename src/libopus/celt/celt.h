@@ -42,6 +42,10 @@
 #include "entdec.h"
 #include "arch.h"
 
+#if (defined(OPUS_X86_MAY_HAVE_SSE4_1) && defined(FIXED_POINT))
+#include "x86/pitch_sse.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -131,6 +135,23 @@ typedef struct {
 #define CELT_SET_SILK_INFO_REQUEST    10028
 #define CELT_SET_SILK_INFO(x) CELT_SET_SILK_INFO_REQUEST, __celt_check_silkinfo_ptr(x)
 
+/* Decoder output gain, linear in Q16; 0 means unity. Fixed-point only. */
+#define CELT_SET_OUTPUT_GAIN_REQUEST    10030
+#define CELT_SET_OUTPUT_GAIN(x) CELT_SET_OUTPUT_GAIN_REQUEST, __opus_check_int(x)
+
+/* Mono output written as 16-bit stereo pairs; one of the OPUS_PACKING_ values.
+   Fixed-point only. */
+#define CELT_SET_OUTPUT_PACKING_REQUEST    10032
+#define CELT_SET_OUTPUT_PACKING(x) CELT_SET_OUTPUT_PACKING_REQUEST, __opus_check_int(x)
+
+/* Synthesis at the output rate instead of 48 kHz, followed by decimation.
+   Fixed-point only, and not bit-exact. */
+#define CELT_SET_DECIMATED_SYNTHESIS_REQUEST    10034
+#define CELT_SET_DECIMATED_SYNTHESIS(x) CELT_SET_DECIMATED_SYNTHESIS_REQUEST, __opus_check_int(x)
+
+#define CELT_GET_DECIMATED_SYNTHESIS_REQUEST    10035
+#define CELT_GET_DECIMATED_SYNTHESIS(x) CELT_GET_DECIMATED_SYNTHESIS_REQUEST, __opus_check_int_ptr(x)
+
 /* Encoder stuff */
 
 int celt_encoder_get_size(int channels);
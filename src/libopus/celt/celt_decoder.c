@@ -50,6 +50,7 @@
 #include <stdarg.h>
 #include "celt_lpc.h"
 #include "vq.h"
+#include "../opus.h"
 
 /* The maximum pitch lag to allow in the pitch-based PLC. It's possible to save
    CPU time in the PLC pitch search by making this smaller than MAX_PERIOD. The
@@ -59,7 +60,8 @@
    pitch of 480 Hz. */
 #define PLC_PITCH_LAG_MIN (100)
 
-#if defined(SMALL_FOOTPRINT) && defined(FIXED_POINT)
+/* Not with decimated synthesis, whose output buffer can be shorter than X. */
+#if defined(SMALL_FOOTPRINT) && defined(FIXED_POINT) && !defined(HAVE_DECIMATED_SYNTHESIS)
 #define NORM_ALIASING_HACK
 #endif
 /**********************************************************************/
@@ -67,6 +69,14 @@
 /*                             DECODER                                */
 /*                                                                    */
 /**********************************************************************/
+/* History per channel, in samples at the synthesis rate. Decimated synthesis
+   keeps it at the output rate, and its PLC, pitch search and postfilter use it
+   just as the 48 kHz path does (DECODE_BUFFER_SIZE, MAX_PERIOD, lp_pitch_buf
+   and all), so there it holds downsample times as much audio as it has to.
+   It isn't scaled down to match even with HAVE_DECIMATED_SYNTHESIS, because
+   OPUS_SET_DECIMATED_SYNTHESIS is chosen per decoder at run time, and is off
+   by default: the exact path needs all of it at 48 kHz, at any output rate,
+   and the decoder's size is fixed when it's built (OPUS_DECODER_SIZE). */
 #define DECODE_BUFFER_SIZE 2048
 
 /** Decoder state
@@ -74,6 +84,7 @@
  */
 struct OpusCustomDecoder {
    const OpusCustomMode *mode;
+   const CELTDecimation *decimate; /* Non-NULL to synthesise at the output rate */
    int overlap;
    int channels;
    int stream_channels;
@@ -83,6 +94,8 @@ struct OpusCustomDecoder {
    int signalling;
    int disable_inv;
    int arch;
+   opus_int32 output_gain;
+   int output_packing;
 
    /* Everything beyond this point gets cleared on a reset */
 #define DECODER_RESET_START rng
@@ -109,6 +122,17 @@ struct OpusCustomDecoder {
    /* opus_val16 backgroundLogE[], Size = 2*mode->nbEBands */
 };
 
+#if defined(FIXED_POINT) && !defined(CUSTOM_MODES)
+/* opus_decoder_get_size() has a compile-time twin in opus.h, OPUS_DECODER_SIZE; this is the
+   CELT part of it, as opus_custom_decoder_get_size() works it out for the 48 kHz mode
+   (overlap 120, 21 bands). */
+#define CELT_STATIC_DECODER_SIZE(c) (sizeof(struct OpusCustomDecoder) \
+   + ((c)*(DECODE_BUFFER_SIZE+120)-1)*sizeof(celt_sig) + (c)*LPC_ORDER*sizeof(opus_val16) \
+   + 4*2*21*sizeof(opus_val16))
+celt_static_assert(CELT_STATIC_DECODER_SIZE(1) == OPUS_DECODER_CELT_SIZE(1), celt_mono_size);
+celt_static_assert(CELT_STATIC_DECODER_SIZE(2) == OPUS_DECODER_CELT_SIZE(2), celt_stereo_size);
+#endif
+
 #if defined(ENABLE_HARDENING) || defined(ENABLE_ASSERTIONS)
 /* Make basic checks on the CELT state to ensure we don't end
    up writing all over memory. */
@@ -129,7 +153,8 @@ void validate_celt_decoder(CELTDecoder *st)
    celt_assert(st->arch <= OPUS_ARCHMASK);
 #endif
    celt_assert(st->last_pitch_index <= PLC_PITCH_LAG_MAX);
-   celt_assert(st->last_pitch_index >= PLC_PITCH_LAG_MIN || st->last_pitch_index == 0);
+   celt_assert(st->last_pitch_index >= PLC_PITCH_LAG_MIN/(st->decimate ? st->downsample : 1)
+         || st->last_pitch_index == 0);
    celt_assert(st->postfilter_period < MAX_PERIOD);
    celt_assert(st->postfilter_period >= COMBFILTER_MINPERIOD || st->postfilter_period == 0);
    celt_assert(st->postfilter_period_old < MAX_PERIOD);
@@ -223,7 +248,7 @@ void opus_custom_decoder_destroy(CELTDecoder *st)
 }
 #endif /* CUSTOM_MODES */
 
-#ifndef CUSTOM_MODES
+#if !defined(CUSTOM_MODES) && (!defined(FIXED_POINT) || OPUS_DECODER_MAX_CHANNELS > 1)
 /* Special case for stereo with no downsampling and no accumulation. This is
    quite common and we can make it faster by processing both channels in the
    same loop, reducing overhead due to the dependency loop in the IIR filter. */
@@ -254,11 +279,178 @@ static void deemphasis_stereo_simple(celt_sig *in[], opus_val16 *pcm, int N, con
 }
 #endif
 
+#if defined(FIXED_POINT) && !defined(CUSTOM_MODES)
+/* The output stage: deemphasis, downsampling, the output gain (Q16), the
+   saturation to 16 bits and the store into pcm, in one pass over the
+   synthesised signal, with the result going straight to where the caller
+   wants it (with packing, an I2S buffer). DEEMPHASIS_KERNEL stamps out one
+   kernel per configuration, and deemphasis_fused() picks the one for the
+   frame from deemphasis_kernels[], so nothing that's fixed for the stream
+   costs a test per sample.
+
+   CC is the channel count. PACKED is mono written as 16-bit stereo pairs:
+   the sample goes into the left half, the right or both, as packing says,
+   and the other half is zeroed; with accum, the value being added to is read
+   back from the half that holds it. GAIN applies gain, which is otherwise
+   zero; the result is the same as scaling the finished (and, with accum,
+   summed) output by it and saturating. ZERO is for decimated synthesis,
+   where coef[1] and coef[2] are the fitted deemphasis filter's zero, applied
+   to each input sample as it's read (in[c][-1] being the previous frame's
+   last sample), and coef[0] its pole; downsample is then 1. Otherwise,
+   downsampling keeps the first sample of each group, as the generic path
+   below does, without needing its scratch buffer. */
+typedef void (*deemphasis_kernel)(celt_sig *in[], opus_val16 *pcm, int N, int downsample,
+      const opus_val16 *coef, celt_sig *mem, int accum, opus_int32 gain, int packing);
+
+/* One sample of channel c, from x with filter memory m, into y. */
+#define DEEMPHASIS_SAMPLE(x, m, c, PACKED, ZERO, GAIN, ACCUM) \
+   { \
+      celt_sig tmp; \
+      opus_val32 out; \
+      if (ZERO) \
+      { \
+         tmp = SHL32(ADD32(MULT16_32_Q15(coef[1], x[j]), MULT16_32_Q15(coef[2], x[j-1])), 2); \
+         tmp = tmp + m + VERY_SMALL; \
+         m = MULT16_32_Q15(coef0, tmp); \
+      } else { \
+         tmp = x[j] + m + VERY_SMALL; \
+         m = MULT16_32_Q15(coef0, tmp); \
+         for (k=1;k<downsample;k++) \
+            m = MULT16_32_Q15(coef0, x[j+k] + m + VERY_SMALL); \
+      } \
+      out = SCALEOUT(SIG2WORD16(tmp)); \
+      if (ACCUM) \
+         out = SAT16(ADD32(PACKED ? y[held] : y[c], out)); \
+      if (GAIN) \
+      { \
+         out = MULT16_32_P16(out, gain); \
+         out = SATURATE(out, 32767); \
+      } \
+      if (PACKED) \
+      { \
+         y[0] = (opus_val16)out & left_mask; \
+         y[1] = (opus_val16)out & right_mask; \
+      } else \
+         y[c] = (opus_val16)out; \
+   }
+
+/* With stereo, both channels go through the same loop, so that the two
+   filters' dependency chains overlap. */
+#define DEEMPHASIS_LOOP(CC, PACKED, ZERO, GAIN, ACCUM) \
+   for (j=0;j<N;j+=downsample) \
+   { \
+      DEEMPHASIS_SAMPLE(x0, m0, 0, PACKED, ZERO, GAIN, ACCUM) \
+      if (CC == 2) \
+         DEEMPHASIS_SAMPLE(x1, m1, 1, PACKED, ZERO, GAIN, ACCUM) \
+      y += PACKED ? 2 : CC; \
+   }
+
+/* accum (hybrid frames only) gets a loop of its own, rather than a kernel. */
+#define DEEMPHASIS_KERNEL(name, CC, PACKED, ZERO, GAIN) \
+static void name(celt_sig *in[], opus_val16 *pcm, int N, int downsample, \
+      const opus_val16 *coef, celt_sig *mem, int accum, opus_int32 gain, int packing) \
+{ \
+   int j, k; \
+   const celt_sig * OPUS_RESTRICT x0 = in[0]; \
+   const celt_sig * OPUS_RESTRICT x1 = in[CC-1]; \
+   opus_val16 * OPUS_RESTRICT y = pcm; \
+   celt_sig m0 = mem[0]; \
+   celt_sig m1 = mem[CC-1]; \
+   opus_val16 coef0 = coef[0]; \
+   opus_val16 left_mask = packing == OPUS_PACKING_RIGHT ? 0 : -1; \
+   opus_val16 right_mask = packing == OPUS_PACKING_LEFT ? 0 : -1; \
+   int held = packing == OPUS_PACKING_RIGHT; \
+   (void)x1; \
+   (void)gain; \
+   (void)left_mask; \
+   (void)right_mask; \
+   (void)held; \
+   celt_assert(!ZERO || downsample == 1); \
+   if (accum) \
+      DEEMPHASIS_LOOP(CC, PACKED, ZERO, GAIN, 1) \
+   else \
+      DEEMPHASIS_LOOP(CC, PACKED, ZERO, GAIN, 0) \
+   mem[0] = m0; \
+   mem[CC-1] = CC == 2 ? m1 : m0; \
+}
+
+DEEMPHASIS_KERNEL(deemphasis_mono,             1, 0, 0, 0)
+DEEMPHASIS_KERNEL(deemphasis_mono_gain,        1, 0, 0, 1)
+DEEMPHASIS_KERNEL(deemphasis_packed,           1, 1, 0, 0)
+DEEMPHASIS_KERNEL(deemphasis_packed_gain,      1, 1, 0, 1)
+#if OPUS_DECODER_MAX_CHANNELS > 1
+DEEMPHASIS_KERNEL(deemphasis_stereo,           2, 0, 0, 0)
+DEEMPHASIS_KERNEL(deemphasis_stereo_gain,      2, 0, 0, 1)
+#else
+#define deemphasis_stereo NULL
+#define deemphasis_stereo_gain NULL
+#endif
+#ifdef HAVE_DECIMATED_SYNTHESIS
+DEEMPHASIS_KERNEL(deemphasis_mono_zero,        1, 0, 1, 0)
+DEEMPHASIS_KERNEL(deemphasis_mono_zero_gain,   1, 0, 1, 1)
+DEEMPHASIS_KERNEL(deemphasis_packed_zero,      1, 1, 1, 0)
+DEEMPHASIS_KERNEL(deemphasis_packed_zero_gain, 1, 1, 1, 1)
+#if OPUS_DECODER_MAX_CHANNELS > 1
+DEEMPHASIS_KERNEL(deemphasis_stereo_zero,      2, 0, 1, 0)
+DEEMPHASIS_KERNEL(deemphasis_stereo_zero_gain, 2, 0, 1, 1)
+#else
+#define deemphasis_stereo_zero NULL
+#define deemphasis_stereo_zero_gain NULL
+#endif
+#endif
+
+/* [mono, packed, stereo][zero][gain] */
+static const deemphasis_kernel deemphasis_kernels[3][2][2] = {
+   { { deemphasis_mono, deemphasis_mono_gain },
+#ifdef HAVE_DECIMATED_SYNTHESIS
+     { deemphasis_mono_zero, deemphasis_mono_zero_gain }
+#endif
+   },
+   { { deemphasis_packed, deemphasis_packed_gain },
+#ifdef HAVE_DECIMATED_SYNTHESIS
+     { deemphasis_packed_zero, deemphasis_packed_zero_gain }
+#endif
+   },
+   { { deemphasis_stereo, deemphasis_stereo_gain },
+#ifdef HAVE_DECIMATED_SYNTHESIS
+     { deemphasis_stereo_zero, deemphasis_stereo_zero_gain }
+#endif
+   }
+};
+
+static void deemphasis_fused(celt_sig *in[], opus_val16 *pcm, int N, int C, int downsample,
+      const opus_val16 *coef, int zero, celt_sig *mem, int accum, opus_int32 gain, int packing)
+{
+   deemphasis_kernel kernel;
+   celt_assert(!packing || C == 1);
+   kernel = deemphasis_kernels[packing ? 1 : C == 2 ? 2 : 0][zero][gain != 0];
+   celt_assert(kernel != NULL);
+   kernel(in, pcm, N, downsample, coef, mem, accum, gain, packing);
+}
+
 #ifndef RESYNTH
 static
 #endif
 void deemphasis(celt_sig *in[], opus_val16 *pcm, int N, int C, int downsample, const opus_val16 *coef,
-      celt_sig *mem, int accum)
+      celt_sig *mem, int accum, opus_int32 gain, int packing)
+{
+#if OPUS_DECODER_MAX_CHANNELS > 1
+   /* The plain 48 kHz stereo case still does best without the fused
+      kernel's downsampling loop, and writes the same. */
+   if (downsample == 1 && C == 2 && !accum && !gain)
+   {
+      deemphasis_stereo_simple(in, pcm, N, coef[0], mem);
+      return;
+   }
+#endif
+   deemphasis_fused(in, pcm, N, C, downsample, coef, 0, mem, accum, gain, packing);
+}
+#else
+#ifndef RESYNTH
+static
+#endif
+void deemphasis(celt_sig *in[], opus_val16 *pcm, int N, int C, int downsample, const opus_val16 *coef,
+      celt_sig *mem, int accum, opus_int32 gain, int packing)
 {
    int c;
    int Nd;
@@ -266,6 +458,8 @@ void deemphasis(celt_sig *in[], opus_val16 *pcm, int N, int C, int downsample, c
    opus_val16 coef0;
    VARDECL(celt_sig, scratch);
    SAVE_STACK;
+   (void)gain;
+   (void)packing;
 #ifndef CUSTOM_MODES
    /* Short version for common case. */
    if (downsample == 1 && C == 2 && !accum)
@@ -356,6 +550,98 @@ void deemphasis(celt_sig *in[], opus_val16 *pcm, int N, int C, int downsample, c
    } while (++c<C);
    RESTORE_STACK;
 }
+#endif
+
+#ifdef HAVE_DECIMATED_SYNTHESIS
+/* Deemphasis for a signal synthesised at the output rate: the fitted
+   filter's zero and pole, with the decimation's coefficients in place of the
+   mode's, in the same pass. in[c][-1], the previous frame's last sample, is
+   still in the decoder's history. */
+static void deemphasis_decimated(celt_sig *in[], opus_val16 *pcm, int N, int C,
+      const CELTDecimation *decimate, celt_sig *mem, int accum, opus_int32 gain, int packing)
+{
+   deemphasis_fused(in, pcm, N, C, 1, decimate->deemph, 1, mem, accum, gain, packing);
+}
+
+/* comb_filter() at the output rate. A 48 kHz lag of T is T/downsample output
+   samples and a fraction, and for each fraction and tapset there are four
+   taps, at lags T/downsample-1 to T/downsample+2, fitted to the tapset's
+   kernel delayed by that much. */
+static void comb_filter_decimated(opus_val32 *y, opus_val32 *x, int T0, int T1, int N,
+      opus_val16 g0, opus_val16 g1, int tapset0, int tapset1,
+      const CELTDecimation *decimate, int overlap)
+{
+   int i, k;
+   int D = decimate->downsample;
+   int L0, L1;
+   const opus_val16 *window = decimate->window;
+   opus_val16 g0k[4], g1k[4];
+
+   if (g0==0 && g1==0)
+   {
+      if (x!=y)
+         OPUS_MOVE(y, x, N);
+      return;
+   }
+   T0 = IMAX(T0, COMBFILTER_MINPERIOD);
+   T1 = IMAX(T1, COMBFILTER_MINPERIOD);
+   /* Lag of the first tap: at least 1, since T0, T1 >= 15 and D <= 6 */
+   L0 = T0/D-1;
+   L1 = T1/D-1;
+   for (k=0;k<4;k++)
+   {
+      g0k[k] = MULT16_16_P15(g0, decimate->comb[4*(tapset0*D+T0%D)+k]);
+      g1k[k] = MULT16_16_P15(g1, decimate->comb[4*(tapset1*D+T1%D)+k]);
+   }
+   if (g0==g1 && T0==T1 && tapset0==tapset1)
+      overlap=0;
+   for (i=0;i<overlap;i++)
+   {
+      opus_val16 f;
+      opus_val32 t = x[i];
+      f = MULT16_16_Q15(window[i],window[i]);
+      for (k=0;k<4;k++)
+         t += MULT16_32_Q15(MULT16_16_Q15((Q15ONE-f),g0k[k]),x[i-L0-k])
+            + MULT16_32_Q15(MULT16_16_Q15(f,g1k[k]),x[i-L1-k]);
+      y[i] = SATURATE(t, SIG_SAT);
+   }
+   if (g1==0)
+   {
+      if (x!=y)
+         OPUS_MOVE(y+overlap, x+overlap, N-overlap);
+      return;
+   }
+   for (;i<N;i++)
+   {
+      opus_val32 t = x[i];
+      for (k=0;k<4;k++)
+         t += MULT16_32_Q15(g1k[k],x[i-L1-k]);
+      y[i] = SATURATE(t, SIG_SAT);
+   }
+}
+#endif
+
+/* The B interleaved IMDCTs of one channel, from freq into out, saturated so
+   that we can't overflow in the pitch postfilter or in the deemphasis. Where
+   the overlap suits it, each sample is saturated as the IMDCT completes it;
+   where it doesn't (decimated synthesis at 12 kHz), splitting that back out
+   per block only adds calls, so the plain IMDCT runs and one pass over the
+   channel saturates it, as before. */
+static void celt_imdct_saturate(const mdct_lookup *mdct, celt_sig *freq, celt_sig *out,
+      const opus_val16 *window, int overlap, int shift, int B, int NB, int arch)
+{
+   int b, i;
+   if (CLT_MDCT_BACKWARD_SAT_FUSES(overlap, NB))
+   {
+      for (b=0;b<B;b++)
+         clt_mdct_backward_sat(mdct, &freq[b], out+NB*b, window, overlap, shift, B, arch);
+   } else {
+      for (b=0;b<B;b++)
+         clt_mdct_backward(mdct, &freq[b], out+NB*b, window, overlap, shift, B, arch);
+      for (i=0;i<B*NB;i++)
+         out[i] = SATURATE(out[i], SIG_SAT);
+   }
+}
 
 #ifndef RESYNTH
 static
@@ -363,33 +649,54 @@ static
 void celt_synthesis(const CELTMode *mode, celt_norm *X, celt_sig * out_syn[],
                     opus_val16 *oldBandE, int start, int effEnd, int C, int CC,
                     int isTransient, int LM, int downsample,
-                    int silence, int arch)
+                    int silence, const CELTDecimation *decimate, int arch)
 {
    int c, i;
    int M;
-   int b;
    int B;
-   int N, NB;
+   int N, NB, NS;
    int shift;
    int nbEBands;
    int overlap;
+   int shortMdctSize;
+   const mdct_lookup *mdct;
+   const opus_val16 *window;
    VARDECL(celt_sig, freq);
    SAVE_STACK;
 
    overlap = mode->overlap;
+   shortMdctSize = mode->shortMdctSize;
+   mdct = &mode->mdct;
+   window = mode->window;
+#ifdef HAVE_DECIMATED_SYNTHESIS
+   if (decimate)
+   {
+      overlap = decimate->overlap;
+      shortMdctSize = decimate->shortMdctSize;
+      mdct = &decimate->mdct;
+      window = decimate->window;
+   }
+#else
+   (void)decimate;
+#endif
    nbEBands = mode->nbEBands;
    N = mode->shortMdctSize<<LM;
-   ALLOC(freq, N, celt_sig); /**< Interleaved signal MDCTs */
+   /* Output samples, fewer than the N coefficients with decimated synthesis.
+      The bands above the output Nyquist are zero, and the IMDCT only reads the
+      NS coefficients below them. */
+   NS = shortMdctSize<<LM;
+   /* When downmixing at the output rate, freq2 won't fit in the output buffer */
+   ALLOC(freq, (NS<N && CC==1 && C==2) ? 2*N : N, celt_sig); /**< Interleaved signal MDCTs */
    M = 1<<LM;
 
    if (isTransient)
    {
       B = M;
-      NB = mode->shortMdctSize;
+      NB = shortMdctSize;
       shift = mode->maxLM;
    } else {
       B = 1;
-      NB = mode->shortMdctSize<<LM;
+      NB = shortMdctSize<<LM;
       shift = mode->maxLM-LM;
    }
 
@@ -401,16 +708,14 @@ void celt_synthesis(const CELTMode *mode, celt_norm *X, celt_sig * out_syn[],
             downsample, silence);
       /* Store a temporary copy in the output buffer because the IMDCT destroys its input. */
       freq2 = out_syn[1]+overlap/2;
-      OPUS_COPY(freq2, freq, N);
-      for (b=0;b<B;b++)
-         clt_mdct_backward(&mode->mdct, &freq2[b], out_syn[0]+NB*b, mode->window, overlap, shift, B, arch);
-      for (b=0;b<B;b++)
-         clt_mdct_backward(&mode->mdct, &freq[b], out_syn[1]+NB*b, mode->window, overlap, shift, B, arch);
+      OPUS_COPY(freq2, freq, NS);
+      celt_imdct_saturate(mdct, freq2, out_syn[0], window, overlap, shift, B, NB, arch);
+      celt_imdct_saturate(mdct, freq, out_syn[1], window, overlap, shift, B, NB, arch);
    } else if (CC==1&&C==2)
    {
       /* Downmixing a stereo stream to mono */
       celt_sig *freq2;
-      freq2 = out_syn[0]+overlap/2;
+      freq2 = NS<N ? freq+N : out_syn[0]+overlap/2;
       denormalise_bands(mode, X, freq, oldBandE, start, effEnd, M,
             downsample, silence);
       /* Use the output buffer as temp array before downmixing. */
@@ -418,23 +723,15 @@ void celt_synthesis(const CELTMode *mode, celt_norm *X, celt_sig * out_syn[],
             downsample, silence);
       for (i=0;i<N;i++)
          freq[i] = ADD32(HALF32(freq[i]), HALF32(freq2[i]));
-      for (b=0;b<B;b++)
-         clt_mdct_backward(&mode->mdct, &freq[b], out_syn[0]+NB*b, mode->window, overlap, shift, B, arch);
+      celt_imdct_saturate(mdct, freq, out_syn[0], window, overlap, shift, B, NB, arch);
    } else {
       /* Normal case (mono or stereo) */
       c=0; do {
          denormalise_bands(mode, X+c*N, freq, oldBandE+c*nbEBands, start, effEnd, M,
                downsample, silence);
-         for (b=0;b<B;b++)
-            clt_mdct_backward(&mode->mdct, &freq[b], out_syn[c]+NB*b, mode->window, overlap, shift, B, arch);
+         celt_imdct_saturate(mdct, freq, out_syn[c], window, overlap, shift, B, NB, arch);
       } while (++c<CC);
    }
-   /* Saturate IMDCT output so that we can't overflow in the pitch postfilter
-      or in the */
-   c=0; do {
-      for (i=0;i<N;i++)
-         out_syn[c][i] = SATURATE(out_syn[c][i], SIG_SAT);
-   } while (++c<CC);
    RESTORE_STACK;
 }
 
@@ -477,18 +774,22 @@ static void tf_decode(int start, int end, int isTransient, int *tf_res, int LM,
    }
 }
 
-static int celt_plc_pitch_search(celt_sig *decode_mem[2], int C, int arch)
+/* decimation is 1 when decode_mem is at 48 kHz, and otherwise the factor it
+   was synthesised at a lower rate by; the lag limits scale with it. */
+static int celt_plc_pitch_search(celt_sig *decode_mem[2], int C, int decimation, int arch)
 {
    int pitch_index;
+   int lag_max = PLC_PITCH_LAG_MAX/decimation;
+   int lag_min = PLC_PITCH_LAG_MIN/decimation;
    VARDECL( opus_val16, lp_pitch_buf );
    SAVE_STACK;
    ALLOC( lp_pitch_buf, DECODE_BUFFER_SIZE>>1, opus_val16 );
    pitch_downsample(decode_mem, lp_pitch_buf,
          DECODE_BUFFER_SIZE, C, arch);
-   pitch_search(lp_pitch_buf+(PLC_PITCH_LAG_MAX>>1), lp_pitch_buf,
-         DECODE_BUFFER_SIZE-PLC_PITCH_LAG_MAX,
-         PLC_PITCH_LAG_MAX-PLC_PITCH_LAG_MIN, &pitch_index, arch);
-   pitch_index = PLC_PITCH_LAG_MAX-pitch_index;
+   pitch_search(lp_pitch_buf+(lag_max>>1), lp_pitch_buf,
+         DECODE_BUFFER_SIZE-lag_max,
+         lag_max-lag_min, &pitch_index, arch);
+   pitch_index = lag_max-pitch_index;
    RESTORE_STACK;
    return pitch_index;
 }
@@ -500,6 +801,8 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
    const int C = st->channels;
    celt_sig *decode_mem[2];
    celt_sig *out_syn[2];
+   int NS;
+   int decimation;
    opus_val16 *lpc;
    opus_val16 *oldBandE, *oldLogE, *oldLogE2, *backgroundLogE;
    const OpusCustomMode *mode;
@@ -509,6 +812,7 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
    int loss_count;
    int noise_based;
    const opus_int16 *eBands;
+   const opus_val16 *window;
    SAVE_STACK;
 
    mode = st->mode;
@@ -518,7 +822,6 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
 
    c=0; do {
       decode_mem[c] = st->_decode_mem + c*(DECODE_BUFFER_SIZE+overlap);
-      out_syn[c] = decode_mem[c]+DECODE_BUFFER_SIZE-N;
    } while (++c<C);
    lpc = (opus_val16*)(st->_decode_mem+(DECODE_BUFFER_SIZE+overlap)*C);
    oldBandE = lpc+C*LPC_ORDER;
@@ -526,6 +829,25 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
    oldLogE2 = oldLogE + 2*nbEBands;
    backgroundLogE = oldLogE2  + 2*nbEBands;
 
+   /* The history takes NS samples per frame, and overlap and window are at its
+      rate: the output rate, with decimated synthesis. X still has N
+      coefficients per channel. */
+   NS = N;
+   window = mode->window;
+   decimation = 1;
+#ifdef HAVE_DECIMATED_SYNTHESIS
+   if (st->decimate)
+   {
+      NS = N/st->downsample;
+      overlap = st->decimate->overlap;
+      window = st->decimate->window;
+      decimation = st->downsample;
+   }
+#endif
+   c=0; do {
+      out_syn[c] = decode_mem[c]+DECODE_BUFFER_SIZE-NS;
+   } while (++c<C);
+
    loss_count = st->loss_count;
    start = st->start;
    noise_based = loss_count >= 5 || start != 0 || st->skip_plc;
@@ -580,15 +902,15 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
       st->rng = seed;
 
       c=0; do {
-         OPUS_MOVE(decode_mem[c], decode_mem[c]+N,
-               DECODE_BUFFER_SIZE-N+(overlap>>1));
+         OPUS_MOVE(decode_mem[c], decode_mem[c]+NS,
+               DECODE_BUFFER_SIZE-NS+(overlap>>1));
       } while (++c<C);
 
-      celt_synthesis(mode, X, out_syn, oldBandE, start, effEnd, C, C, 0, LM, st->downsample, 0, st->arch);
+      celt_synthesis(mode, X, out_syn, oldBandE, start, effEnd, C, C, 0, LM, st->downsample, 0,
+            st->decimate, st->arch);
    } else {
       int exc_length;
       /* Pitch-based PLC */
-      const opus_val16 *window;
       opus_val16 *exc;
       opus_val16 fade = Q15ONE;
       int pitch_index;
@@ -598,7 +920,7 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
 
       if (loss_count == 0)
       {
-         st->last_pitch_index = pitch_index = celt_plc_pitch_search(decode_mem, C, st->arch);
+         st->last_pitch_index = pitch_index = celt_plc_pitch_search(decode_mem, C, decimation, st->arch);
       } else {
          pitch_index = st->last_pitch_index;
          fade = QCONST16(.8f,15);
@@ -612,7 +934,6 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
       ALLOC(_exc, MAX_PERIOD+LPC_ORDER, opus_val16);
       ALLOC(fir_tmp, exc_length, opus_val16);
       exc = _exc+LPC_ORDER;
-      window = mode->window;
       c=0; do {
          opus_val16 decay;
          opus_val16 attenuation;
@@ -703,7 +1024,7 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
          /* Move the decoder memory one frame to the left to give us room to
             add the data for the new frame. We ignore the overlap that extends
             past the end of the buffer, because we aren't going to use it. */
-         OPUS_MOVE(buf, buf+N, DECODE_BUFFER_SIZE-N);
+         OPUS_MOVE(buf, buf+NS, DECODE_BUFFER_SIZE-NS);
 
          /* Extrapolate from the end of the excitation with a period of
             "pitch_index", scaling down each period by an additional factor of
@@ -711,7 +1032,7 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
          extrapolation_offset = MAX_PERIOD-pitch_index;
          /* We need to extrapolate enough samples to cover a complete MDCT
             window (including overlap/2 samples on both sides). */
-         extrapolation_len = N+overlap;
+         extrapolation_len = NS+overlap;
          /* We also apply fading if this is not the first loss. */
          attenuation = MULT16_16_Q15(fade, decay);
          for (i=j=0;i<extrapolation_len;i++,j++)
@@ -721,13 +1042,13 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
                j -= pitch_index;
                attenuation = MULT16_16_Q15(attenuation, decay);
             }
-            buf[DECODE_BUFFER_SIZE-N+i] =
+            buf[DECODE_BUFFER_SIZE-NS+i] =
                   SHL32(EXTEND32(MULT16_16_Q15(attenuation,
                         exc[extrapolation_offset+j])), SIG_SHIFT);
             /* Compute the energy of the previously decoded signal whose
                excitation we're copying. */
             tmp = ROUND16(
-                  buf[DECODE_BUFFER_SIZE-MAX_PERIOD-N+extrapolation_offset+j],
+                  buf[DECODE_BUFFER_SIZE-MAX_PERIOD-NS+extrapolation_offset+j],
                   SIG_SHIFT);
             S1 += SHR32(MULT16_16(tmp, tmp), 10);
          }
@@ -736,15 +1057,15 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
             /* Copy the last decoded samples (prior to the overlap region) to
                synthesis filter memory so we can have a continuous signal. */
             for (i=0;i<LPC_ORDER;i++)
-               lpc_mem[i] = ROUND16(buf[DECODE_BUFFER_SIZE-N-1-i], SIG_SHIFT);
+               lpc_mem[i] = ROUND16(buf[DECODE_BUFFER_SIZE-NS-1-i], SIG_SHIFT);
             /* Apply the synthesis filter to convert the excitation back into
                the signal domain. */
-            celt_iir(buf+DECODE_BUFFER_SIZE-N, lpc+c*LPC_ORDER,
-                  buf+DECODE_BUFFER_SIZE-N, extrapolation_len, LPC_ORDER,
+            celt_iir(buf+DECODE_BUFFER_SIZE-NS, lpc+c*LPC_ORDER,
+                  buf+DECODE_BUFFER_SIZE-NS, extrapolation_len, LPC_ORDER,
                   lpc_mem, st->arch);
 #ifdef FIXED_POINT
             for (i=0; i < extrapolation_len; i++)
-               buf[DECODE_BUFFER_SIZE-N+i] = SATURATE(buf[DECODE_BUFFER_SIZE-N+i], SIG_SAT);
+               buf[DECODE_BUFFER_SIZE-NS+i] = SATURATE(buf[DECODE_BUFFER_SIZE-NS+i], SIG_SAT);
 #endif
          }
 
@@ -755,7 +1076,7 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
             opus_val32 S2=0;
             for (i=0;i<extrapolation_len;i++)
             {
-               opus_val16 tmp = ROUND16(buf[DECODE_BUFFER_SIZE-N+i], SIG_SHIFT);
+               opus_val16 tmp = ROUND16(buf[DECODE_BUFFER_SIZE-NS+i], SIG_SHIFT);
                S2 += SHR32(MULT16_16(tmp, tmp), 10);
             }
             /* This checks for an "explosion" in the synthesis. */
@@ -768,7 +1089,7 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
 #endif
             {
                for (i=0;i<extrapolation_len;i++)
-                  buf[DECODE_BUFFER_SIZE-N+i] = 0;
+                  buf[DECODE_BUFFER_SIZE-NS+i] = 0;
             } else if (S1 < S2)
             {
                opus_val16 ratio = celt_sqrt(frac_div32(SHR32(S1,1)+1,S2+1));
@@ -776,13 +1097,13 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
                {
                   opus_val16 tmp_g = Q15ONE
                         - MULT16_16_Q15(window[i], Q15ONE-ratio);
-                  buf[DECODE_BUFFER_SIZE-N+i] =
-                        MULT16_32_Q15(tmp_g, buf[DECODE_BUFFER_SIZE-N+i]);
+                  buf[DECODE_BUFFER_SIZE-NS+i] =
+                        MULT16_32_Q15(tmp_g, buf[DECODE_BUFFER_SIZE-NS+i]);
                }
                for (i=overlap;i<extrapolation_len;i++)
                {
-                  buf[DECODE_BUFFER_SIZE-N+i] =
-                        MULT16_32_Q15(ratio, buf[DECODE_BUFFER_SIZE-N+i]);
+                  buf[DECODE_BUFFER_SIZE-NS+i] =
+                        MULT16_32_Q15(ratio, buf[DECODE_BUFFER_SIZE-NS+i]);
                }
             }
          }
@@ -790,6 +1111,14 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
          /* Apply the pre-filter to the MDCT overlap for the next frame because
             the post-filter will be re-applied in the decoder after the MDCT
             overlap. */
+#ifdef HAVE_DECIMATED_SYNTHESIS
+         if (st->decimate)
+            comb_filter_decimated(etmp, buf+DECODE_BUFFER_SIZE,
+                 st->postfilter_period, st->postfilter_period, overlap,
+                 -st->postfilter_gain, -st->postfilter_gain,
+                 st->postfilter_tapset, st->postfilter_tapset, st->decimate, 0);
+         else
+#endif
          comb_filter(etmp, buf+DECODE_BUFFER_SIZE,
               st->postfilter_period, st->postfilter_period, overlap,
               -st->postfilter_gain, -st->postfilter_gain,
@@ -814,7 +1143,7 @@ static void celt_decode_lost(CELTDecoder * OPUS_RESTRICT st, int N, int LM)
 int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *data,
       int len, opus_val16 * OPUS_RESTRICT pcm, int frame_size, ec_dec *dec, int accum)
 {
-   int c, i, N;
+   int c, i, N, NS;
    int spread_decision;
    opus_int32 bits;
    ec_dec _dec;
@@ -861,6 +1190,7 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    const OpusCustomMode *mode;
    int nbEBands;
    int overlap;
+   int shortMdctSize;
    const opus_int16 *eBands;
    ALLOC_STACK;
 
@@ -919,7 +1249,21 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    N = M*mode->shortMdctSize;
    c=0; do {
       decode_mem[c] = st->_decode_mem + c*(DECODE_BUFFER_SIZE+overlap);
-      out_syn[c] = decode_mem[c]+DECODE_BUFFER_SIZE-N;
+   } while (++c<CC);
+   /* The history takes NS samples per frame, at the output rate with
+      decimated synthesis; overlap and shortMdctSize follow it from here on. */
+   NS = N;
+   shortMdctSize = mode->shortMdctSize;
+#ifdef HAVE_DECIMATED_SYNTHESIS
+   if (st->decimate)
+   {
+      NS = N/st->downsample;
+      overlap = st->decimate->overlap;
+      shortMdctSize = st->decimate->shortMdctSize;
+   }
+#endif
+   c=0; do {
+      out_syn[c] = decode_mem[c]+DECODE_BUFFER_SIZE-NS;
    } while (++c<CC);
 
    effEnd = end;
@@ -929,7 +1273,12 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    if (data == NULL || len<=1)
    {
       celt_decode_lost(st, N, LM);
-      deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum);
+#ifdef HAVE_DECIMATED_SYNTHESIS
+      if (st->decimate)
+         deemphasis_decimated(out_syn, pcm, NS, CC, st->decimate, st->preemph_memD, accum, st->output_gain, st->output_packing);
+      else
+#endif
+      deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum, st->output_gain, st->output_packing);
       RESTORE_STACK;
       return frame_size/st->downsample;
    }
@@ -1066,7 +1415,7 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    unquant_fine_energy(mode, start, end, oldBandE, fine_quant, dec, C);
 
    c=0; do {
-      OPUS_MOVE(decode_mem[c], decode_mem[c]+N, DECODE_BUFFER_SIZE-N+overlap/2);
+      OPUS_MOVE(decode_mem[c], decode_mem[c]+NS, DECODE_BUFFER_SIZE-NS+overlap/2);
    } while (++c<CC);
 
    /* Decode fixed codebook */
@@ -1104,16 +1453,29 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    }
 
    celt_synthesis(mode, X, out_syn, oldBandE, start, effEnd,
-                  C, CC, isTransient, LM, st->downsample, silence, st->arch);
+                  C, CC, isTransient, LM, st->downsample, silence, st->decimate, st->arch);
 
    c=0; do {
       st->postfilter_period=IMAX(st->postfilter_period, COMBFILTER_MINPERIOD);
       st->postfilter_period_old=IMAX(st->postfilter_period_old, COMBFILTER_MINPERIOD);
-      comb_filter(out_syn[c], out_syn[c], st->postfilter_period_old, st->postfilter_period, mode->shortMdctSize,
+#ifdef HAVE_DECIMATED_SYNTHESIS
+      if (st->decimate)
+      {
+         comb_filter_decimated(out_syn[c], out_syn[c], st->postfilter_period_old, st->postfilter_period, shortMdctSize,
+               st->postfilter_gain_old, st->postfilter_gain, st->postfilter_tapset_old, st->postfilter_tapset,
+               st->decimate, overlap);
+         if (LM!=0)
+            comb_filter_decimated(out_syn[c]+shortMdctSize, out_syn[c]+shortMdctSize, st->postfilter_period, postfilter_pitch, NS-shortMdctSize,
+                  st->postfilter_gain, postfilter_gain, st->postfilter_tapset, postfilter_tapset,
+                  st->decimate, overlap);
+         continue;
+      }
+#endif
+      comb_filter(out_syn[c], out_syn[c], st->postfilter_period_old, st->postfilter_period, shortMdctSize,
             st->postfilter_gain_old, st->postfilter_gain, st->postfilter_tapset_old, st->postfilter_tapset,
             mode->window, overlap, st->arch);
       if (LM!=0)
-         comb_filter(out_syn[c]+mode->shortMdctSize, out_syn[c]+mode->shortMdctSize, st->postfilter_period, postfilter_pitch, N-mode->shortMdctSize,
+         comb_filter(out_syn[c]+shortMdctSize, out_syn[c]+shortMdctSize, st->postfilter_period, postfilter_pitch, N-shortMdctSize,
                st->postfilter_gain, postfilter_gain, st->postfilter_tapset, postfilter_tapset,
                mode->window, overlap, st->arch);
 
@@ -1168,7 +1530,12 @@ int celt_decode_with_ec(CELTDecoder * OPUS_RESTRICT st, const unsigned char *dat
    } while (++c<2);
    st->rng = dec->rng;
 
-   deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum);
+#ifdef HAVE_DECIMATED_SYNTHESIS
+   if (st->decimate)
+      deemphasis_decimated(out_syn, pcm, NS, CC, st->decimate, st->preemph_memD, accum, st->output_gain, st->output_packing);
+   else
+#endif
+   deemphasis(out_syn, pcm, N, CC, st->downsample, mode->preemph, st->preemph_memD, accum, st->output_gain, st->output_packing);
    st->loss_count = 0;
    RESTORE_STACK;
    if (ec_tell(dec) > 8*len)
@@ -1267,6 +1634,51 @@ int opus_custom_decoder_ctl(CELTDecoder * OPUS_RESTRICT st, int request, ...)
          st->end = value;
       }
       break;
+      case CELT_SET_OUTPUT_GAIN_REQUEST:
+      {
+         opus_int32 value = va_arg(ap, opus_int32);
+         st->output_gain = value;
+      }
+      break;
+      case CELT_SET_OUTPUT_PACKING_REQUEST:
+      {
+         opus_int32 value = va_arg(ap, opus_int32);
+         if (value<OPUS_PACKING_NONE || value>OPUS_PACKING_RIGHT || (value && st->channels!=1))
+            goto bad_arg;
+         st->output_packing = value;
+      }
+      break;
+      case CELT_SET_DECIMATED_SYNTHESIS_REQUEST:
+      {
+         const CELTDecimation *decimate;
+         opus_int32 value = va_arg(ap, opus_int32);
+         if (value<0 || value>1)
+            goto bad_arg;
+#ifdef HAVE_DECIMATED_SYNTHESIS
+         /* NULL at 48 kHz, where there is nothing to save. */
+         decimate = value ? celt_mode_decimation(st->mode, st->downsample) : NULL;
+#else
+         if (value)
+            goto bad_request;
+         decimate = NULL;
+#endif
+         /* The history is kept at the synthesis rate, so it can't be carried
+            over from one rate to the other. */
+         if (decimate != st->decimate)
+         {
+            st->decimate = decimate;
+            opus_custom_decoder_ctl(st, OPUS_RESET_STATE);
+         }
+      }
+      break;
+      case CELT_GET_DECIMATED_SYNTHESIS_REQUEST:
+      {
+         opus_int32 *value = va_arg(ap, opus_int32*);
+         if (value==NULL)
+            goto bad_arg;
+         *value = st->decimate != NULL;
+      }
+      break;
       case CELT_SET_CHANNELS_REQUEST:
       {
          opus_int32 value = va_arg(ap, opus_int32);
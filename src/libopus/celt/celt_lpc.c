@@ -126,7 +126,7 @@ void celt_fir_c(
    RESTORE_STACK;
 }
 
-void celt_iir(const opus_val32 *_x,
+void celt_iir_c(const opus_val32 *_x,
          const opus_val16 *den,
          opus_val32 *_y,
          int N,
@@ -54,7 +54,8 @@ static void kf_bfly2(
    kiss_fft_cpx * Fout2;
    int i;
    (void)m;
-#ifdef CUSTOM_MODES
+#if defined(CUSTOM_MODES) || defined(HAVE_DECIMATED_SYNTHESIS)
+   /* Decimated synthesis has FFTs of 30 and 10, which end on a radix-2 */
    if (m==1)
    {
       celt_assert(m==1);
@@ -78,6 +78,13 @@ typedef struct {
  4*4*4*2
  */
 
+/* Decimated synthesis (DECIMATED_SYNTHESIS in config.h) needs the static
+   fixed-point mode, whose tables it extends. Its FFTs of 30 and 10 end on a
+   radix-2 stage, so the FFT needs to know about it too. */
+#if defined(DECIMATED_SYNTHESIS) && defined(FIXED_POINT) && !defined(CUSTOM_MODES)
+#define HAVE_DECIMATED_SYNTHESIS
+#endif
+
 typedef struct arch_fft_state{
    int is_supported;
    void *priv;
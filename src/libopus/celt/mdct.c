@@ -341,3 +341,149 @@ void clt_mdct_backward_c(const mdct_lookup *l, kiss_fft_scalar *in, kiss_fft_sca
    }
 }
 #endif /* OVERRIDE_clt_mdct_backward */
+
+/* clt_mdct_backward() followed by saturating the samples it completes, for
+   when a kernel can't do both at once. */
+static void clt_mdct_backward_then_saturate(const mdct_lookup *l, kiss_fft_scalar *in,
+      kiss_fft_scalar * OPUS_RESTRICT out, const opus_val16 * OPUS_RESTRICT window,
+      int overlap, int shift, int stride, int arch)
+{
+   int i;
+   int N2 = l->n>>(shift+1);
+   clt_mdct_backward_c(l, in, out, window, overlap, shift, stride, arch);
+   for (i=0;i<N2;i++)
+      out[i] = SATURATE(out[i], SIG_SAT);
+}
+
+#ifndef OVERRIDE_clt_mdct_backward
+void clt_mdct_backward_sat_c(const mdct_lookup *l, kiss_fft_scalar *in, kiss_fft_scalar * OPUS_RESTRICT out,
+      const opus_val16 * OPUS_RESTRICT window, int overlap, int shift, int stride, int arch)
+{
+   int i;
+   int N, N2, N4;
+   const kiss_twiddle_scalar *trig;
+
+   N = l->n;
+   trig = l->trig;
+   for (i=0;i<shift;i++)
+   {
+      N >>= 1;
+      trig += N;
+   }
+   N2 = N>>1;
+   N4 = N>>2;
+
+   if (!CLT_MDCT_BACKWARD_SAT_FUSES(overlap, N2))
+   {
+      clt_mdct_backward_then_saturate(l, in, out, window, overlap, shift, stride, arch);
+      return;
+   }
+
+   /* Pre-rotate */
+   {
+      /* Temp pointers to make it really clear to the compiler what we're doing */
+      const kiss_fft_scalar * OPUS_RESTRICT xp1 = in;
+      const kiss_fft_scalar * OPUS_RESTRICT xp2 = in+stride*(N2-1);
+      kiss_fft_scalar * OPUS_RESTRICT yp = out+(overlap>>1);
+      const kiss_twiddle_scalar * OPUS_RESTRICT t = &trig[0];
+      const opus_int16 * OPUS_RESTRICT bitrev = l->kfft[shift]->bitrev;
+      for(i=0;i<N4;i++)
+      {
+         int rev;
+         kiss_fft_scalar yr, yi;
+         rev = *bitrev++;
+         yr = ADD32_ovflw(S_MUL(*xp2, t[i]), S_MUL(*xp1, t[N4+i]));
+         yi = SUB32_ovflw(S_MUL(*xp1, t[i]), S_MUL(*xp2, t[N4+i]));
+         /* We swap real and imag because we use an FFT instead of an IFFT. */
+         yp[2*rev+1] = yr;
+         yp[2*rev] = yi;
+         /* Storing the pre-rotation directly in the bitrev order. */
+         xp1+=2*stride;
+         xp2-=2*stride;
+      }
+   }
+
+   opus_fft_impl(l->kfft[shift], (kiss_fft_cpx*)(out+(overlap>>1)));
+
+   /* Post-rotate and de-shuffle from both ends of the buffer at once, as
+      clt_mdct_backward_c() does. For the first overlap/4 pairs, the front end
+      is the new half of the overlap, and is mirrored, windowed and added to
+      the previous frame's half as it comes out, while the back end is this
+      frame's tail, left for the next. After that, both ends are done with
+      as soon as they're rotated. Whatever is done with is saturated. */
+   {
+      kiss_fft_scalar * yp0 = out+(overlap>>1);
+      kiss_fft_scalar * yp1 = out+(overlap>>1)+N2-2;
+      kiss_fft_scalar * OPUS_RESTRICT xp = out+(overlap>>1)-1;
+      const opus_val16 * OPUS_RESTRICT wp0 = window+(overlap>>1);
+      const opus_val16 * OPUS_RESTRICT wp1 = window+(overlap>>1)-1;
+      const kiss_twiddle_scalar *t = &trig[0];
+      for(i=0;i<overlap>>2;i++)
+      {
+         kiss_fft_scalar re, im, yr0, yi0, yr1, yi1, x2;
+         kiss_twiddle_scalar t0, t1;
+         /* We swap real and imag because we're using an FFT instead of an IFFT. */
+         re = yp0[1];
+         im = yp0[0];
+         t0 = t[i];
+         t1 = t[N4+i];
+         /* We'd scale up by 2 here, but instead it's done when mixing the windows */
+         yr0 = ADD32_ovflw(S_MUL(re,t0), S_MUL(im,t1));
+         yi1 = SUB32_ovflw(S_MUL(re,t1), S_MUL(im,t0));
+         re = yp1[1];
+         im = yp1[0];
+         t0 = t[(N4-i-1)];
+         t1 = t[(N2-i-1)];
+         yr1 = ADD32_ovflw(S_MUL(re,t0), S_MUL(im,t1));
+         yi0 = SUB32_ovflw(S_MUL(re,t1), S_MUL(im,t0));
+         yp1[0] = yr1;
+         yp1[1] = yi1;
+         /* TDAC: yp0[0] mirrors xp[0], and yp0[1] mirrors xp[-1]. */
+         x2 = xp[0];
+         xp[0] = SATURATE(SUB32_ovflw(MULT16_32_Q15(wp0[0], x2), MULT16_32_Q15(wp1[0], yr0)), SIG_SAT);
+         yp0[0] = SATURATE(ADD32_ovflw(MULT16_32_Q15(wp1[0], x2), MULT16_32_Q15(wp0[0], yr0)), SIG_SAT);
+         x2 = xp[-1];
+         xp[-1] = SATURATE(SUB32_ovflw(MULT16_32_Q15(wp0[1], x2), MULT16_32_Q15(wp1[-1], yi0)), SIG_SAT);
+         yp0[1] = SATURATE(ADD32_ovflw(MULT16_32_Q15(wp1[-1], x2), MULT16_32_Q15(wp0[1], yi0)), SIG_SAT);
+         yp0 += 2;
+         yp1 -= 2;
+         xp -= 2;
+         wp0 += 2;
+         wp1 -= 2;
+      }
+      /* Loop to (N4+1)>>1 to handle odd N4. When N4 is odd, the
+         middle pair will be computed twice, from values read before either
+         write, so saturating both times is harmless. */
+      for(;i<(N4+1)>>1;i++)
+      {
+         kiss_fft_scalar re, im, yr, yi;
+         kiss_twiddle_scalar t0, t1;
+         re = yp0[1];
+         im = yp0[0];
+         t0 = t[i];
+         t1 = t[N4+i];
+         yr = ADD32_ovflw(S_MUL(re,t0), S_MUL(im,t1));
+         yi = SUB32_ovflw(S_MUL(re,t1), S_MUL(im,t0));
+         re = yp1[1];
+         im = yp1[0];
+         yp0[0] = SATURATE(yr, SIG_SAT);
+         yp1[1] = SATURATE(yi, SIG_SAT);
+
+         t0 = t[(N4-i-1)];
+         t1 = t[(N2-i-1)];
+         yr = ADD32_ovflw(S_MUL(re,t0), S_MUL(im,t1));
+         yi = SUB32_ovflw(S_MUL(re,t1), S_MUL(im,t0));
+         yp1[0] = SATURATE(yr, SIG_SAT);
+         yp0[1] = SATURATE(yi, SIG_SAT);
+         yp0 += 2;
+         yp1 -= 2;
+      }
+   }
+}
+#else
+void clt_mdct_backward_sat_c(const mdct_lookup *l, kiss_fft_scalar *in, kiss_fft_scalar * OPUS_RESTRICT out,
+      const opus_val16 * OPUS_RESTRICT window, int overlap, int shift, int stride, int arch)
+{
+   clt_mdct_backward_then_saturate(l, in, out, window, overlap, shift, stride, arch);
+}
+#endif /* OVERRIDE_clt_mdct_backward */
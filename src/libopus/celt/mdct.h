@@ -74,6 +74,21 @@ void clt_mdct_backward_c(const mdct_lookup *l, kiss_fft_scalar *in,
       const opus_val16 * OPUS_RESTRICT window,
       int overlap, int shift, int stride, int arch);
 
+/** Whether clt_mdct_backward_sat_c() can fuse the saturation into the
+    post-rotation for blocks of n2 output samples: it takes the overlap two
+    samples at a time, and needs it to end before the middle of the block. */
+#define CLT_MDCT_BACKWARD_SAT_FUSES(overlap, n2) (!((overlap)&3) && (overlap) <= (n2))
+
+/** clt_mdct_backward_c(), which also saturates to SIG_SAT each output sample
+    it completes: the first N>>(shift+1), leaving the tail that the next call
+    overlaps. The post-rotation, the windowed overlap-add and the saturation
+    are done in one pass, when CLT_MDCT_BACKWARD_SAT_FUSES() says the overlap
+    suits it; otherwise it's clt_mdct_backward_c() and a saturation loop. */
+void clt_mdct_backward_sat_c(const mdct_lookup *l, kiss_fft_scalar *in,
+      kiss_fft_scalar * OPUS_RESTRICT out,
+      const opus_val16 * OPUS_RESTRICT window,
+      int overlap, int shift, int stride, int arch);
+
 #if !defined(OVERRIDE_OPUS_MDCT)
 /* Is run-time CPU detection enabled on this platform? */
 #if defined(OPUS_HAVE_RTCD) && defined(HAVE_ARM_NE10)
@@ -98,6 +113,10 @@ extern void (*const CLT_MDCT_BACKWARD_IMPL[OPUS_ARCHMASK+1])(
                                                    _window, _overlap, _shift, \
                                                    _stride, _arch)
 
+/* The NE10 MDCTs are float only, where there's nothing to saturate. */
+#define clt_mdct_backward_sat(_l, _in, _out, _window, _overlap, _shift, _stride, _arch) \
+   clt_mdct_backward(_l, _in, _out, _window, _overlap, _shift, _stride, _arch)
+
 #else /* if defined(OPUS_HAVE_RTCD) && defined(HAVE_ARM_NE10) */
 
 #define clt_mdct_forward(_l, _in, _out, _window, _overlap, _shift, _stride, _arch) \
@@ -106,7 +125,16 @@ extern void (*const CLT_MDCT_BACKWARD_IMPL[OPUS_ARCHMASK+1])(
 #define clt_mdct_backward(_l, _in, _out, _window, _overlap, _shift, _stride, _arch) \
    clt_mdct_backward_c(_l, _in, _out, _window, _overlap, _shift, _stride, _arch)
 
+#define clt_mdct_backward_sat(_l, _in, _out, _window, _overlap, _shift, _stride, _arch) \
+   clt_mdct_backward_sat_c(_l, _in, _out, _window, _overlap, _shift, _stride, _arch)
+
 #endif /* end if defined(OPUS_HAVE_RTCD) && defined(HAVE_ARM_NE10) && !defined(FIXED_POINT) */
+#else /* if !defined(OVERRIDE_OPUS_MDCT) */
+
+/* As above: the NE10 MDCTs are float only. */
+#define clt_mdct_backward_sat(_l, _in, _out, _window, _overlap, _shift, _stride, _arch) \
+   clt_mdct_backward(_l, _in, _out, _window, _overlap, _shift, _stride, _arch)
+
 #endif /* end if !defined(OVERRIDE_OPUS_MDCT) */
 
 #endif
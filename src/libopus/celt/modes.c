@@ -70,6 +70,10 @@ static const unsigned char band_allocation[] = {
  #endif
 #endif /* CUSTOM_MODES_ONLY */
 
+#ifdef HAVE_DECIMATED_SYNTHESIS
+#include "static_decimate_fixed.h"
+#endif
+
 #ifndef M_PI
 #define M_PI 3.141592653
 #endif
@@ -232,7 +236,7 @@ CELTMode *opus_custom_mode_create(opus_int32 Fs, int frame_size, int *error)
    int LM;
    int arch = opus_select_arch();
    ALLOC_STACK;
-#if !defined(VAR_ARRAYS) && !defined(USE_ALLOCA)
+#if !defined(VAR_ARRAYS) && !defined(USE_ALLOCA) && !defined(SCRATCH_ARENA)
    if (global_stack==NULL)
       goto failure;
 #endif
@@ -440,3 +444,18 @@ void opus_custom_mode_destroy(CELTMode *mode)
    opus_free((CELTMode *)mode);
 }
 #endif
+
+#ifdef HAVE_DECIMATED_SYNTHESIS
+const CELTDecimation *celt_mode_decimation(const CELTMode *mode, int downsample)
+{
+   int i;
+   if (mode != &mode48000_960_120)
+      return NULL;
+   for (i=0;i<(int)(sizeof(decimation48000_960)/sizeof(decimation48000_960[0]));i++)
+   {
+      if (decimation48000_960[i].downsample == downsample)
+         return &decimation48000_960[i];
+   }
+   return NULL;
+}
+#endif
@@ -71,5 +71,26 @@ struct OpusCustomMode {
    PulseCache cache;
 };
 
+/** What the decoder needs to synthesise a mode's output at Fs/downsample
+    instead of at Fs: a smaller IMDCT (whose bands all fit below the output
+    Nyquist anyway) and the filters that stand in for the postfilter and
+    deemphasis at that rate.
+ @brief Decimated synthesis tables
+ */
+typedef struct {
+   int downsample;
+   int overlap;              /**< The mode's overlap, at the output rate */
+   int shortMdctSize;        /**< Likewise */
+   const opus_val16 *window; /**< The mode's window at the output rate's sampling points */
+   mdct_lookup mdct;
+   opus_val16 deemph[3];     /**< (b0 + b1 z^-1)/(1 - a z^-1): a in Q15, then b0 and b1 in Q13 */
+   const opus_val16 *comb;   /**< Postfilter taps (Q15), 4 per tapset and lag modulo downsample */
+} CELTDecimation;
+
+#ifdef HAVE_DECIMATED_SYNTHESIS
+/** The decimated synthesis tables for downsample, or NULL if there are none */
+const CELTDecimation *celt_mode_decimation(const CELTMode *mode, int downsample);
+#endif
+
 
 #endif
@@ -50,6 +50,10 @@
 # include "arm/pitch_arm.h"
 #endif
 
+#if defined(OPUS_ARM_INLINE_MEDIA)
+# include "arm/pitch_cm4.h"
+#endif
+
 void pitch_downsample(celt_sig * OPUS_RESTRICT x[], opus_val16 * OPUS_RESTRICT x_lp,
       int len, int C, int arch);
 
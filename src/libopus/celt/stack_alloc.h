@@ -35,11 +35,11 @@
 #include "../opus_types.h"
 #include "../opus_defines.h"
 
-#if (!defined (VAR_ARRAYS) && !defined (USE_ALLOCA) && !defined (NONTHREADSAFE_PSEUDOSTACK))
-#error "Opus requires one of VAR_ARRAYS, USE_ALLOCA, or NONTHREADSAFE_PSEUDOSTACK be defined to select the temporary allocation mode."
+#if (!defined (VAR_ARRAYS) && !defined (USE_ALLOCA) && !defined (NONTHREADSAFE_PSEUDOSTACK) && !defined (SCRATCH_ARENA))
+#error "Opus requires one of VAR_ARRAYS, USE_ALLOCA, NONTHREADSAFE_PSEUDOSTACK or SCRATCH_ARENA be defined to select the temporary allocation mode."
 #endif
 
-#ifdef USE_ALLOCA
+#if defined(USE_ALLOCA) || defined(SCRATCH_ARENA)
 # ifdef WIN32
 #  include <malloc.h>
 # else
@@ -88,7 +88,89 @@
  * @param type Type of element
  */
 
-#if defined(VAR_ARRAYS)
+#if defined(SCRATCH_ARENA)
+
+/* Temporaries come from the OpusScratchArena the application gave the decoder
+   (OPUS_SET_SCRATCH_ARENA), which opus_decode_native() installs in opus_scratch
+   for the length of the call. They're handed out bottom up, opus_scratch.used
+   being the stack pointer, so the arena starts each call empty and RESTORE_STACK
+   pops as usual. Outside a decoder with an arena (the encoder, or a decoder
+   without one), and for anything that doesn't fit, they go on the stack as with
+   USE_ALLOCA, so the stack still has to be big enough for all of them.
+   opus_scratch is per thread, so a decode on one thread never hands its arena to
+   the encoder or a decoder on another; where OPUS_SCRATCH_TLS is defined empty,
+   it's global, and only one thread may call into Opus at a time. */
+
+#ifndef OPUS_SCRATCH_TLS
+# if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#  define OPUS_SCRATCH_TLS _Thread_local
+# elif defined(__GNUC__)
+#  define OPUS_SCRATCH_TLS __thread
+# else
+#  error "SCRATCH_ARENA needs thread-local storage: define OPUS_SCRATCH_TLS, or define it empty if only one thread calls Opus"
+# endif
+#endif
+
+/* The arena installed for the call in progress, and how much of it is in use. */
+typedef struct {
+   OpusScratchArena *arena;
+   opus_int32 used;
+} opus_scratch_state;
+
+#ifdef CELT_C
+OPUS_SCRATCH_TLS opus_scratch_state opus_scratch={0,0};
+#else
+extern OPUS_SCRATCH_TLS opus_scratch_state opus_scratch;
+#endif /* CELT_C */
+
+#define OPUS_SCRATCH_ALIGN 8
+
+/* Returns NULL when there's no arena, or when the request doesn't fit, and then
+   ALLOC takes it from the stack instead. The decode still comes out right; the
+   arena's peak, which offsets carry on past the end to record, is then above its
+   size, and says how big it has to be. */
+static OPUS_INLINE void *opus_scratch_push(opus_int32 bytes)
+{
+   OpusScratchArena *arena = opus_scratch.arena;
+   opus_int32 start;
+   if (!arena)
+      return 0;
+   start = (opus_scratch.used + OPUS_SCRATCH_ALIGN - 1) & ~(OPUS_SCRATCH_ALIGN - 1);
+   opus_scratch.used = start + bytes;
+   if (opus_scratch.used > arena->peak)
+      arena->peak = opus_scratch.used;
+   if (opus_scratch.used > arena->size)
+      return 0;
+   return arena->base + start;
+}
+
+/* Install arena for a call, saving what it replaced in saved. Calls nest: one
+   that's already using the arena carries on from where the outer one is. */
+static OPUS_INLINE void opus_scratch_enter(OpusScratchArena *arena, opus_scratch_state *saved)
+{
+   *saved = opus_scratch;
+   if (arena != opus_scratch.arena)
+   {
+      opus_scratch.arena = arena;
+      opus_scratch.used = 0;
+   }
+}
+
+/* Put back what opus_scratch_enter() replaced. */
+static OPUS_INLINE void opus_scratch_leave(const opus_scratch_state *saved)
+{
+   opus_scratch = *saved;
+}
+
+#define VARDECL(type, var) type *var
+#define ALLOC(var, size, type) ((var) = (type*)opus_scratch_push((opus_int32)(sizeof(type)*(size))), \
+                                (var) = (var) ? (var) : (type*)alloca(sizeof(type)*(size)))
+#define SAVE_STACK opus_int32 _saved_stack = opus_scratch.used
+#define RESTORE_STACK (opus_scratch.used = _saved_stack)
+#define ALLOC_STACK SAVE_STACK
+#define ALLOC_NONE 0
+
+#elif defined(VAR_ARRAYS)
 
 #define VARDECL(type, var)
 #define ALLOC(var, size, type) type var[size]
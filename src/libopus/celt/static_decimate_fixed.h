@@ -0,0 +1,644 @@
+/* Decimated synthesis tables for the 48 kHz, 960 sample mode (CELTDecimation in
+   modes.h). Generated by "testbed dtables" in pc_testbed; don't edit. */
+
+#ifndef STATIC_DECIMATE_FIXED_H
+#define STATIC_DECIMATE_FIXED_H
+
+static const opus_val16 window60[60] = {
+9, 79, 220, 431, 711,
+1060, 1476, 1958, 2505, 3114,
+3784, 4512, 5295, 6130, 7013,
+7941, 8908, 9911, 10945, 12003,
+13081, 14173, 15272, 16373, 17471,
+18558, 19629, 20678, 21700, 22689,
+23642, 24553, 25420, 26239, 27007,
+27722, 28384, 28991, 29545, 30044,
+30491, 30886, 31233, 31534, 31791,
+32009, 32190, 32337, 32456, 32549,
+32620, 32672, 32709, 32735, 32751,
+32760, 32765, 32767, 32767, 32767,
+};
+
+static const opus_val16 window40[40] = {
+20, 178, 494, 966, 1590,
+2362, 3276, 4325, 5499, 6788,
+8179, 9657, 11207, 12810, 14447,
+16098, 17744, 19363, 20936, 22445,
+23874, 25208, 26435, 27548, 28541,
+29411, 30160, 30792, 31313, 31731,
+32057, 32303, 32481, 32604, 32683,
+32729, 32754, 32764, 32767, 32767,
+};
+
+static const opus_val16 window30[30] = {
+35, 317, 877, 1709, 2802,
+4141, 5706, 7472, 9406, 11471,
+13625, 15823, 18016, 20156, 22199,
+24103, 25835, 27371, 28695, 29801,
+30695, 31389, 31905, 32267, 32505,
+32648, 32723, 32756, 32766, 32767,
+};
+
+static const opus_val16 window20[20] = {
+79, 711, 1958, 3784, 6130,
+8908, 12003, 15272, 18558, 21700,
+24553, 27007, 28991, 30491, 31534,
+32190, 32549, 32709, 32760, 32767,
+};
+
+static const kiss_twiddle_cpx fft_twiddles160[160] = {
+{32767, 0}, {32743, -1287},
+{32667, -2570}, {32541, -3851},
+{32364, -5125}, {32138, -6393},
+{31863, -7650}, {31539, -8895},
+{31165, -10126}, {30743, -11340},
+{30274, -12540}, {29758, -13718},
+{29197, -14875}, {28590, -16010},
+{27940, -17119}, {27246, -18205},
+{26510, -19260}, {25734, -20286},
+{24918, -21281}, {24063, -22242},
+{23171, -23171}, {22244, -24063},
+{21282, -24917}, {20288, -25733},
+{19261, -26509}, {18205, -27246},
+{17122, -27940}, {16012, -28590},
+{14878, -29197}, {13720, -29757},
+{12540, -30274}, {11342, -30743},
+{10127, -31164}, {8895, -31537},
+{7650, -31862}, {6393, -32138},
+{5127, -32364}, {3852, -32541},
+{2572, -32667}, {1287, -32742},
+{0, -32767}, {-1287, -32743},
+{-2570, -32667}, {-3851, -32541},
+{-5125, -32364}, {-6393, -32138},
+{-7650, -31863}, {-8895, -31539},
+{-10126, -31165}, {-11340, -30743},
+{-12540, -30274}, {-13718, -29758},
+{-14875, -29197}, {-16010, -28590},
+{-17119, -27940}, {-18205, -27246},
+{-19260, -26510}, {-20286, -25734},
+{-21281, -24918}, {-22242, -24063},
+{-23171, -23171}, {-24063, -22244},
+{-24917, -21282}, {-25733, -20288},
+{-26509, -19261}, {-27246, -18205},
+{-27940, -17122}, {-28590, -16012},
+{-29197, -14878}, {-29757, -13720},
+{-30274, -12540}, {-30743, -11342},
+{-31164, -10127}, {-31537, -8895},
+{-31862, -7650}, {-32138, -6393},
+{-32364, -5127}, {-32541, -3852},
+{-32667, -2572}, {-32742, -1287},
+{-32767, 0}, {-32743, 1287},
+{-32667, 2570}, {-32541, 3851},
+{-32364, 5125}, {-32138, 6393},
+{-31863, 7650}, {-31539, 8895},
+{-31165, 10126}, {-30743, 11340},
+{-30274, 12540}, {-29758, 13718},
+{-29197, 14875}, {-28590, 16010},
+{-27940, 17119}, {-27246, 18205},
+{-26510, 19260}, {-25734, 20286},
+{-24918, 21281}, {-24063, 22242},
+{-23171, 23171}, {-22244, 24063},
+{-21282, 24917}, {-20288, 25733},
+{-19261, 26509}, {-18205, 27246},
+{-17122, 27940}, {-16012, 28590},
+{-14878, 29197}, {-13720, 29757},
+{-12540, 30274}, {-11342, 30743},
+{-10127, 31164}, {-8895, 31537},
+{-7650, 31862}, {-6393, 32138},
+{-5127, 32364}, {-3852, 32541},
+{-2572, 32667}, {-1287, 32742},
+{0, 32767}, {1287, 32743},
+{2570, 32667}, {3851, 32541},
+{5125, 32364}, {6393, 32138},
+{7650, 31863}, {8895, 31539},
+{10126, 31165}, {11340, 30743},
+{12540, 30274}, {13718, 29758},
+{14875, 29197}, {16010, 28590},
+{17119, 27940}, {18205, 27246},
+{19260, 26510}, {20286, 25734},
+{21281, 24918}, {22242, 24063},
+{23171, 23171}, {24063, 22244},
+{24917, 21282}, {25733, 20288},
+{26509, 19261}, {27246, 18205},
+{27940, 17122}, {28590, 16012},
+{29197, 14878}, {29757, 13720},
+{30274, 12540}, {30743, 11342},
+{31164, 10127}, {31537, 8895},
+{31862, 7650}, {32138, 6393},
+{32364, 5127}, {32541, 3852},
+{32667, 2572}, {32742, 1287},
+};
+
+static const opus_int16 fft_bitrev160[160] = {
+0, 32, 64, 96, 128, 8, 40, 72, 104, 136, 16, 48, 80, 112, 144,
+24, 56, 88, 120, 152, 4, 36, 68, 100, 132, 12, 44, 76, 108, 140,
+20, 52, 84, 116, 148, 28, 60, 92, 124, 156, 1, 33, 65, 97, 129,
+9, 41, 73, 105, 137, 17, 49, 81, 113, 145, 25, 57, 89, 121, 153,
+5, 37, 69, 101, 133, 13, 45, 77, 109, 141, 21, 53, 85, 117, 149,
+29, 61, 93, 125, 157, 2, 34, 66, 98, 130, 10, 42, 74, 106, 138,
+18, 50, 82, 114, 146, 26, 58, 90, 122, 154, 6, 38, 70, 102, 134,
+14, 46, 78, 110, 142, 22, 54, 86, 118, 150, 30, 62, 94, 126, 158,
+3, 35, 67, 99, 131, 11, 43, 75, 107, 139, 19, 51, 83, 115, 147,
+27, 59, 91, 123, 155, 7, 39, 71, 103, 135, 15, 47, 79, 111, 143,
+23, 55, 87, 119, 151, 31, 63, 95, 127, 159,
+};
+
+static const opus_int16 fft_bitrev80[80] = {
+0, 16, 32, 48, 64, 4, 20, 36, 52, 68, 8, 24, 40, 56, 72,
+12, 28, 44, 60, 76, 1, 17, 33, 49, 65, 5, 21, 37, 53, 69,
+9, 25, 41, 57, 73, 13, 29, 45, 61, 77, 2, 18, 34, 50, 66,
+6, 22, 38, 54, 70, 10, 26, 42, 58, 74, 14, 30, 46, 62, 78,
+3, 19, 35, 51, 67, 7, 23, 39, 55, 71, 11, 27, 43, 59, 75,
+15, 31, 47, 63, 79,
+};
+
+static const opus_int16 fft_bitrev40[40] = {
+0, 8, 16, 24, 32, 4, 12, 20, 28, 36, 1, 9, 17, 25, 33,
+5, 13, 21, 29, 37, 2, 10, 18, 26, 34, 6, 14, 22, 30, 38,
+3, 11, 19, 27, 35, 7, 15, 23, 31, 39,
+};
+
+static const opus_int16 fft_bitrev20[20] = {
+0, 4, 8, 12, 16, 1, 5, 9, 13, 17, 2, 6, 10, 14, 18,
+3, 7, 11, 15, 19,
+};
+
+static const opus_int16 fft_bitrev10[10] = {
+0, 2, 4, 6, 8, 1, 3, 5, 7, 9,
+};
+
+static const opus_int16 fft_bitrev30[30] = {
+0, 6, 12, 18, 24, 2, 8, 14, 20, 26, 4, 10, 16, 22, 28,
+1, 7, 13, 19, 25, 3, 9, 15, 21, 27, 5, 11, 17, 23, 29,
+};
+
+static const opus_int16 fft_bitrev15[15] = {
+0, 3, 6, 9, 12, 1, 4, 7, 10, 13, 2, 5, 8, 11, 14,
+};
+
+static const kiss_fft_state fft_state160 = {
+160,    /* nfft */
+26214,    /* scale */
+7,      /* scale_shift */
+-1,      /* shift */
+{5, 32, 4, 8, 2, 4, 4, 1, 0, 0, 0, 0, 0, 0, 0, 0, },    /* factors */
+fft_bitrev160,  /* bitrev */
+fft_twiddles160,  /* twiddles */
+NULL,
+};
+
+static const kiss_fft_state fft_state80 = {
+80,    /* nfft */
+26214,    /* scale */
+6,      /* scale_shift */
+1,      /* shift */
+{5, 16, 4, 4, 4, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, },    /* factors */
+fft_bitrev80,  /* bitrev */
+fft_twiddles160,  /* twiddles */
+NULL,
+};
+
+static const kiss_fft_state fft_state40 = {
+40,    /* nfft */
+26214,    /* scale */
+5,      /* scale_shift */
+2,      /* shift */
+{5, 8, 2, 4, 4, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, },    /* factors */
+fft_bitrev40,  /* bitrev */
+fft_twiddles160,  /* twiddles */
+NULL,
+};
+
+static const kiss_fft_state fft_state20 = {
+20,    /* nfft */
+26214,    /* scale */
+4,      /* scale_shift */
+3,      /* shift */
+{5, 4, 4, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, },    /* factors */
+fft_bitrev20,  /* bitrev */
+fft_twiddles160,  /* twiddles */
+NULL,
+};
+
+static const kiss_fft_state fft_state10 = {
+10,    /* nfft */
+26214,    /* scale */
+3,      /* scale_shift */
+4,      /* shift */
+{5, 2, 2, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, },    /* factors */
+fft_bitrev10,  /* bitrev */
+fft_twiddles160,  /* twiddles */
+NULL,
+};
+
+static const kiss_fft_state fft_state30 = {
+30,    /* nfft */
+17476,    /* scale */
+4,      /* scale_shift */
+4,      /* shift */
+{5, 6, 3, 2, 2, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, },    /* factors */
+fft_bitrev30,  /* bitrev */
+fft_twiddles48000_960,  /* twiddles */
+NULL,
+};
+
+static const kiss_fft_state fft_state15 = {
+15,    /* nfft */
+17476,    /* scale */
+3,      /* scale_shift */
+5,      /* shift */
+{5, 3, 3, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, },    /* factors */
+fft_bitrev15,  /* bitrev */
+fft_twiddles48000_960,  /* twiddles */
+NULL,
+};
+
+static const opus_val16 mdct_twiddles480[930] = {
+32767, 32767, 32765, 32761, 32756,
+32750, 32742, 32732, 32722, 32710,
+32696, 32681, 32665, 32647, 32628,
+32608, 32586, 32562, 32538, 32512,
+32484, 32455, 32425, 32393, 32360,
+32326, 32290, 32253, 32214, 32174,
+32133, 32090, 32046, 32001, 31954,
+31906, 31856, 31805, 31753, 31700,
+31645, 31588, 31530, 31471, 31411,
+31349, 31286, 31222, 31156, 31089,
+31020, 30951, 30880, 30807, 30733,
+30658, 30582, 30504, 30425, 30345,
+30263, 30181, 30096, 30011, 29924,
+29836, 29747, 29656, 29564, 29471,
+29377, 29281, 29184, 29086, 28987,
+28886, 28784, 28681, 28577, 28471,
+28365, 28257, 28147, 28037, 27925,
+27812, 27698, 27583, 27467, 27349,
+27231, 27111, 26990, 26868, 26744,
+26620, 26494, 26367, 26239, 26110,
+25980, 25849, 25717, 25583, 25449,
+25313, 25176, 25038, 24900, 24760,
+24619, 24477, 24333, 24189, 24044,
+23898, 23751, 23602, 23453, 23303,
+23152, 22999, 22846, 22692, 22537,
+22380, 22223, 22065, 21906, 21746,
+21585, 21423, 21261, 21097, 20933,
+20767, 20601, 20434, 20265, 20096,
+19927, 19756, 19584, 19412, 19239,
+19065, 18890, 18714, 18538, 18361,
+18183, 18004, 17824, 17644, 17463,
+17281, 17098, 16915, 16731, 16546,
+16361, 16175, 15988, 15800, 15612,
+15423, 15234, 15043, 14852, 14661,
+14469, 14276, 14083, 13889, 13694,
+13499, 13303, 13107, 12910, 12713,
+12515, 12317, 12118, 11918, 11718,
+11517, 11316, 11115, 10913, 10710,
+10508, 10304, 10100, 9896, 9691,
+9486, 9281, 9075, 8869, 8662,
+8455, 8248, 8040, 7832, 7623,
+7415, 7206, 6996, 6787, 6577,
+6366, 6156, 5945, 5734, 5523,
+5311, 5100, 4888, 4675, 4463,
+4251, 4038, 3825, 3612, 3399,
+3185, 2972, 2758, 2544, 2330,
+2116, 1902, 1688, 1474, 1260,
+1045, 831, 617, 402, 188,
+-27, -241, -456, -670, -885,
+-1099, -1313, -1528, -1742, -1956,
+-2170, -2384, -2598, -2811, -3025,
+-3239, -3452, -3665, -3878, -4091,
+-4304, -4516, -4728, -4941, -5153,
+-5364, -5576, -5787, -5998, -6209,
+-6419, -6629, -6839, -7049, -7258,
+-7467, -7676, -7884, -8092, -8300,
+-8507, -8714, -8920, -9127, -9332,
+-9538, -9743, -9947, -10151, -10355,
+-10558, -10761, -10963, -11165, -11367,
+-11568, -11768, -11968, -12167, -12366,
+-12565, -12762, -12960, -13156, -13352,
+-13548, -13743, -13937, -14131, -14324,
+-14517, -14709, -14900, -15091, -15281,
+-15470, -15659, -15847, -16035, -16221,
+-16407, -16593, -16777, -16961, -17144,
+-17326, -17508, -17689, -17869, -18049,
+-18227, -18405, -18582, -18758, -18934,
+-19108, -19282, -19455, -19627, -19799,
+-19969, -20139, -20308, -20475, -20642,
+-20809, -20974, -21138, -21301, -21464,
+-21626, -21786, -21946, -22105, -22263,
+-22420, -22575, -22730, -22884, -23037,
+-23189, -23340, -23490, -23640, -23788,
+-23935, -24080, -24225, -24369, -24512,
+-24654, -24795, -24934, -25073, -25211,
+-25347, -25482, -25617, -25750, -25882,
+-26013, -26143, -26272, -26399, -26526,
+-26651, -26775, -26898, -27020, -27141,
+-27260, -27379, -27496, -27612, -27727,
+-27841, -27953, -28065, -28175, -28284,
+-28391, -28498, -28603, -28707, -28810,
+-28911, -29012, -29111, -29209, -29305,
+-29401, -29495, -29587, -29679, -29769,
+-29858, -29946, -30032, -30118, -30201,
+-30284, -30365, -30445, -30524, -30601,
+-30677, -30752, -30825, -30897, -30968,
+-31038, -31106, -31172, -31238, -31302,
+-31365, -31426, -31486, -31545, -31602,
+-31658, -31713, -31766, -31818, -31869,
+-31918, -31966, -32012, -32058, -32101,
+-32144, -32185, -32224, -32262, -32299,
+-32335, -32369, -32401, -32433, -32463,
+-32491, -32518, -32544, -32568, -32591,
+-32613, -32633, -32652, -32669, -32685,
+-32700, -32713, -32724, -32735, -32744,
+-32751, -32757, -32762, -32766, -32767,
+32767, 32764, 32755, 32741, 32720,
+32694, 32663, 32626, 32583, 32535,
+32481, 32421, 32356, 32286, 32209,
+32128, 32041, 31948, 31850, 31747,
+31638, 31523, 31403, 31278, 31148,
+31012, 30871, 30724, 30572, 30415,
+30253, 30086, 29913, 29736, 29553,
+29365, 29172, 28974, 28771, 28564,
+28351, 28134, 27911, 27684, 27452,
+27216, 26975, 26729, 26478, 26223,
+25964, 25700, 25432, 25159, 24882,
+24601, 24315, 24026, 23732, 23434,
+23133, 22827, 22517, 22204, 21886,
+21565, 21240, 20912, 20580, 20244,
+19905, 19563, 19217, 18868, 18516,
+18160, 17802, 17440, 17075, 16708,
+16338, 15964, 15588, 15210, 14829,
+14445, 14059, 13670, 13279, 12886,
+12490, 12093, 11693, 11291, 10888,
+10482, 10075, 9666, 9255, 8843,
+8429, 8014, 7597, 7180, 6760,
+6340, 5919, 5496, 5073, 4649,
+4224, 3798, 3372, 2945, 2517,
+2090, 1661, 1233, 804, 375,
+-54, -483, -911, -1340, -1768,
+-2197, -2624, -3052, -3479, -3905,
+-4330, -4755, -5179, -5602, -6024,
+-6445, -6865, -7284, -7702, -8118,
+-8533, -8946, -9358, -9768, -10177,
+-10584, -10989, -11392, -11793, -12192,
+-12589, -12984, -13377, -13767, -14155,
+-14541, -14924, -15305, -15683, -16058,
+-16430, -16800, -17167, -17531, -17892,
+-18249, -18604, -18956, -19304, -19649,
+-19990, -20329, -20663, -20994, -21322,
+-21646, -21966, -22282, -22595, -22904,
+-23208, -23509, -23806, -24099, -24387,
+-24672, -24952, -25228, -25499, -25766,
+-26029, -26288, -26541, -26791, -27035,
+-27275, -27511, -27741, -27967, -28188,
+-28405, -28616, -28823, -29024, -29221,
+-29412, -29599, -29780, -29957, -30128,
+-30294, -30455, -30611, -30761, -30906,
+-31046, -31181, -31310, -31434, -31552,
+-31665, -31773, -31875, -31972, -32063,
+-32149, -32229, -32304, -32373, -32437,
+-32495, -32547, -32594, -32635, -32671,
+-32701, -32726, -32745, -32758, -32766,
+32767, 32754, 32717, 32658, 32577,
+32473, 32348, 32200, 32029, 31837,
+31624, 31388, 31131, 30853, 30553,
+30232, 29891, 29530, 29148, 28746,
+28324, 27883, 27423, 26944, 26447,
+25931, 25398, 24847, 24279, 23695,
+23095, 22478, 21846, 21199, 20538,
+19863, 19174, 18472, 17757, 17030,
+16291, 15541, 14781, 14010, 13230,
+12441, 11643, 10837, 10024, 9204,
+8377, 7545, 6708, 5866, 5020,
+4171, 3319, 2464, 1608, 751,
+-107, -965, -1822, -2678, -3532,
+-4383, -5232, -6077, -6918, -7754,
+-8585, -9409, -10228, -11039, -11843,
+-12639, -13426, -14204, -14972, -15730,
+-16477, -17213, -17937, -18648, -19347,
+-20033, -20705, -21363, -22006, -22634,
+-23246, -23843, -24423, -24986, -25533,
+-26062, -26573, -27066, -27540, -27995,
+-28431, -28848, -29245, -29622, -29979,
+-30315, -30630, -30924, -31197, -31449,
+-31679, -31887, -32074, -32239, -32381,
+-32501, -32600, -32675, -32729, -32759,
+32767, 32711, 32565, 32330, 32007,
+31595, 31097, 30514, 29847, 29099,
+28270, 27364, 26383, 25330, 24207,
+23018, 21766, 20454, 19087, 17666,
+16198, 14685, 13132, 11543, 9922,
+8274, 6603, 4914, 3212, 1501,
+-214, -1929, -3638, -5338, -7022,
+-8688, -10330, -11943, -13524, -15067,
+-16569, -18026, -19434, -20788, -22085,
+-23322, -24494, -25600, -26635, -27598,
+-28485, -29293, -30022, -30668, -31230,
+-31706, -32096, -32397, -32610, -32734,
+32765, 32541, 31960, 31029, 29758,
+28161, 26255, 24062, 21605, 18912,
+16011, 12935, 9717, 6393, 2998,
+-429, -3851, -7232, -10533, -13719,
+-16754, -19606, -22243, -24636, -26760,
+-28590, -30107, -31294, -32138, -32631,
+};
+
+static const opus_val16 mdct_twiddles320[620] = {
+32767, 32766, 32761, 32753, 32741,
+32727, 32709, 32688, 32664, 32637,
+32606, 32573, 32536, 32496, 32453,
+32407, 32358, 32306, 32251, 32192,
+32131, 32066, 31998, 31927, 31853,
+31776, 31696, 31613, 31527, 31438,
+31345, 31250, 31152, 31050, 30946,
+30839, 30729, 30616, 30499, 30380,
+30258, 30133, 30006, 29875, 29741,
+29605, 29465, 29323, 29178, 29030,
+28880, 28726, 28570, 28411, 28250,
+28085, 27918, 27749, 27576, 27401,
+27223, 27043, 26860, 26674, 26486,
+26296, 26102, 25907, 25708, 25508,
+25304, 25099, 24891, 24680, 24468,
+24252, 24035, 23815, 23593, 23369,
+23142, 22913, 22682, 22449, 22213,
+21976, 21736, 21494, 21251, 21005,
+20757, 20507, 20255, 20001, 19745,
+19488, 19228, 18967, 18703, 18438,
+18171, 17903, 17633, 17361, 17087,
+16812, 16535, 16256, 15976, 15694,
+15411, 15127, 14841, 14553, 14264,
+13974, 13682, 13389, 13095, 12799,
+12503, 12205, 11906, 11605, 11304,
+11001, 10698, 10393, 10088, 9781,
+9474, 9165, 8856, 8546, 8235,
+7923, 7610, 7297, 6983, 6669,
+6353, 6037, 5721, 5404, 5086,
+4768, 4450, 4131, 3812, 3492,
+3172, 2851, 2531, 2210, 1889,
+1568, 1246, 925, 603, 281,
+-40, -362, -684, -1005, -1327,
+-1648, -1969, -2290, -2611, -2932,
+-3252, -3572, -3891, -4211, -4529,
+-4848, -5166, -5483, -5800, -6116,
+-6432, -6747, -7062, -7376, -7689,
+-8001, -8313, -8623, -8933, -9242,
+-9551, -9858, -10164, -10469, -10774,
+-11077, -11379, -11680, -11980, -12279,
+-12577, -12873, -13169, -13463, -13755,
+-14046, -14336, -14625, -14912, -15198,
+-15482, -15765, -16046, -16326, -16604,
+-16881, -17156, -17429, -17700, -17970,
+-18238, -18505, -18769, -19032, -19293,
+-19552, -19809, -20065, -20318, -20569,
+-20819, -21066, -21312, -21555, -21796,
+-22035, -22272, -22507, -22740, -22971,
+-23199, -23425, -23649, -23870, -24090,
+-24306, -24521, -24733, -24943, -25151,
+-25355, -25558, -25758, -25956, -26151,
+-26343, -26533, -26721, -26906, -27088,
+-27268, -27445, -27619, -27791, -27960,
+-28127, -28290, -28451, -28610, -28765,
+-28918, -29068, -29215, -29359, -29500,
+-29639, -29775, -29908, -30038, -30165,
+-30289, -30410, -30529, -30644, -30757,
+-30866, -30973, -31076, -31177, -31274,
+-31369, -31460, -31549, -31634, -31716,
+-31796, -31872, -31945, -32015, -32082,
+-32146, -32207, -32265, -32319, -32371,
+-32419, -32464, -32507, -32546, -32581,
+-32614, -32644, -32670, -32693, -32714,
+-32730, -32744, -32755, -32762, -32767,
+32767, 32760, 32739, 32706, 32661,
+32602, 32531, 32448, 32352, 32243,
+32123, 31989, 31844, 31686, 31516,
+31334, 31139, 30933, 30715, 30485,
+30243, 29989, 29724, 29448, 29160,
+28861, 28551, 28229, 27897, 27554,
+27201, 26837, 26463, 26078, 25683,
+25279, 24865, 24441, 24008, 23565,
+23114, 22653, 22184, 21706, 21220,
+20726, 20223, 19713, 19195, 18670,
+18138, 17599, 17053, 16500, 15941,
+15376, 14805, 14228, 13646, 13058,
+12465, 11868, 11266, 10660, 10049,
+9435, 8817, 8196, 7571, 6944,
+6314, 5681, 5047, 4410, 3772,
+3132, 2491, 1849, 1206, 563,
+-80, -724, -1367, -2009, -2651,
+-3292, -3931, -4569, -5205, -5840,
+-6472, -7101, -7728, -8351, -8972,
+-9589, -10202, -10812, -11417, -12018,
+-12614, -13205, -13792, -14373, -14948,
+-15518, -16081, -16639, -17190, -17734,
+-18272, -18802, -19326, -19841, -20350,
+-20850, -21342, -21826, -22302, -22769,
+-23227, -23677, -24117, -24548, -24969,
+-25381, -25783, -26175, -26557, -26929,
+-27290, -27641, -27981, -28311, -28629,
+-28937, -29233, -29518, -29792, -30054,
+-30304, -30543, -30770, -30986, -31189,
+-31380, -31559, -31726, -31881, -32024,
+-32154, -32272, -32377, -32470, -32550,
+-32618, -32673, -32716, -32746, -32763,
+32767, 32736, 32654, 32522, 32339,
+32107, 31825, 31494, 31114, 30687,
+30212, 29690, 29123, 28511, 27855,
+27156, 26415, 25633, 24812, 23953,
+23056, 22125, 21159, 20160, 19130,
+18071, 16984, 15871, 14733, 13572,
+12391, 11191, 9973, 8740, 7493,
+6235, 4967, 3692, 2411, 1126,
+-161, -1447, -2731, -4011, -5285,
+-6550, -7806, -9049, -10279, -11492,
+-12688, -13865, -15019, -16151, -17258,
+-18338, -19390, -20413, -21403, -22361,
+-23284, -24171, -25021, -25833, -26604,
+-27335, -28023, -28668, -29269, -29825,
+-30335, -30798, -31214, -31581, -31900,
+-32169, -32389, -32559, -32679, -32749,
+32766, 32640, 32313, 31786, 31063,
+30149, 29049, 27770, 26320, 24707,
+22942, 21035, 18999, 16846, 14589,
+12242, 9819, 7336, 4808, 2250,
+-322, -2892, -5444, -7962, -10431,
+-12836, -15162, -17395, -19520, -21525,
+-23397, -25125, -26698, -28106, -29341,
+-30395, -31262, -31936, -32413, -32691,
+32762, 32258, 30959, 28899, 26127,
+22711, 18736, 14300, 9512, 4490,
+-643, -5760, -10736, -15447, -19777,
+-23621, -26883, -29483, -31357, -32459,
+};
+
+static const opus_val16 comb_taps2[24] = {
+7149, 19221, 7149, -488,
+1119, 15310, 15310, 1119,
+3583, 26530, 3584, -603,
+-3148, 18435, 18435, -3148,
+1338, 30439, 1338, -225,
+-5428, 19920, 19920, -5428,
+};
+
+static const opus_val16 comb_taps3[36] = {
+4131, 25474, 4132, -628,
+-1483, 21899, 13345, -2532,
+-2532, 13345, 21899, -1483,
+1734, 29811, 1734, -334,
+-4476, 24937, 13528, -4238,
+-4238, 13528, 24937, -4476,
+647, 31664, 648, -125,
+-5782, 26217, 13555, -4932,
+-4932, 13555, 26217, -5782,
+};
+
+static const opus_val16 comb_taps4[48] = {
+2546, 28374, 2546, -455,
+-2538, 25781, 10558, -3049,
+-4225, 19148, 19148, -4225,
+-3049, 10558, 25781, -2538,
+1004, 31067, 1005, -202,
+-4461, 27987, 10161, -3759,
+-5796, 20174, 20174, -5796,
+-3759, 10161, 27987, -4461,
+375, 32133, 375, -75,
+-5235, 28857, 9985, -4024,
+-6417, 20569, 20569, -6417,
+-4024, 9985, 28857, -5235,
+};
+
+static const opus_val16 comb_taps6[72] = {
+1207, 30716, 1208, -238,
+-2845, 29308, 6980, -2589,
+-5112, 25564, 13545, -4579,
+-5592, 20042, 20042, -5592,
+-4579, 13545, 25564, -5112,
+-2589, 6980, 29308, -2845,
+456, 32000, 456, -94,
+-3755, 30480, 6566, -2751,
+-6016, 26451, 13565, -5061,
+-6339, 20521, 20521, -6339,
+-5061, 13565, 26451, -6016,
+-2751, 6566, 30480, -3755,
+170, 32481, 170, -35,
+-4100, 30919, 6407, -2808,
+-6357, 26782, 13569, -5239,
+-6620, 20699, 20699, -6620,
+-5239, 13569, 26782, -6357,
+-2808, 6407, 30919, -4100,
+};
+
+static const CELTDecimation decimation48000_960[4] = {
+{2, 60, 60, window60,
+ {960, 3, {&fft_state48000_960_1, &fft_state48000_960_2, &fft_state48000_960_3, &fft_state30}, mdct_twiddles480},
+ {22872, 13619, 2098}, comb_taps2},
+{3, 40, 40, window40,
+ {640, 3, {&fft_state160, &fft_state80, &fft_state40, &fft_state20}, mdct_twiddles320},
+ {18874, 18596, 3511}, comb_taps3},
+{4, 30, 30, window30,
+ {480, 3, {&fft_state48000_960_2, &fft_state48000_960_3, &fft_state30, &fft_state15}, mdct_twiddles480+480},
+ {15434, 22915, 4747}, comb_taps4},
+{6, 20, 20, window20,
+ {320, 3, {&fft_state80, &fft_state40, &fft_state20, &fft_state10}, mdct_twiddles320+320},
+ {9994, 29842, 6812}, comb_taps6},
+};
+
+#endif
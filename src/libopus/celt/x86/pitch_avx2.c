@@ -0,0 +1,232 @@
+/* AVX2 versions of the fixed-point correlation kernels */
+
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+//#ifdef HAVE_CONFIG_H
+#include "../../config.h"
+//#endif
+
+#include "../pitch.h"
+
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_AVX2)
+
+#include <immintrin.h>
+#include "x86cpu.h"
+
+/* Same sums as the SSE4.1 kernels, sixteen products a step instead of eight;
+   what's left over goes through the 128-bit half and then C. */
+
+static OPUS_INLINE OPUS_TARGET_AVX2 __m128i fold_epi32(__m256i v)
+{
+   return _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+static OPUS_INLINE OPUS_TARGET_AVX2 opus_val32 hsum_epi32(__m128i v)
+{
+   v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+   v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+   return _mm_cvtsi128_si32(v);
+}
+
+OPUS_TARGET_AVX2
+opus_val32 celt_inner_prod_avx2(const opus_val16 *x, const opus_val16 *y, int N)
+{
+   int i;
+   opus_val32 xy;
+   __m256i sum = _mm256_setzero_si256();
+   __m128i sum128;
+
+   for (i=0;i<N-31;i+=32)
+   {
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(
+            _mm256_loadu_si256((const __m256i *)(const void *)&x[i]),
+            _mm256_loadu_si256((const __m256i *)(const void *)&y[i])));
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(
+            _mm256_loadu_si256((const __m256i *)(const void *)&x[i + 16]),
+            _mm256_loadu_si256((const __m256i *)(const void *)&y[i + 16])));
+   }
+   if (i<N-15)
+   {
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(
+            _mm256_loadu_si256((const __m256i *)(const void *)&x[i]),
+            _mm256_loadu_si256((const __m256i *)(const void *)&y[i])));
+      i += 16;
+   }
+   sum128 = fold_epi32(sum);
+   if (i<N-7)
+   {
+      sum128 = _mm_add_epi32(sum128, _mm_madd_epi16(
+            _mm_loadu_si128((const __m128i *)(const void *)&x[i]),
+            _mm_loadu_si128((const __m128i *)(const void *)&y[i])));
+      i += 8;
+   }
+   if (i<N-3)
+   {
+      sum128 = _mm_add_epi32(sum128, _mm_madd_epi16(
+            _mm_loadl_epi64((const __m128i *)(const void *)&x[i]),
+            _mm_loadl_epi64((const __m128i *)(const void *)&y[i])));
+      i += 4;
+   }
+   xy = hsum_epi32(sum128);
+   for (;i<N;i++)
+      xy = MAC16_16(xy, x[i], y[i]);
+   return xy;
+}
+
+OPUS_TARGET_AVX2
+void dual_inner_prod_avx2(const opus_val16 *x, const opus_val16 *y01, const opus_val16 *y02,
+      int N, opus_val32 *xy1, opus_val32 *xy2)
+{
+   int i;
+   opus_val32 xy01, xy02;
+   __m256i sum1 = _mm256_setzero_si256();
+   __m256i sum2 = _mm256_setzero_si256();
+   __m128i sum1_128, sum2_128;
+
+   for (i=0;i<N-15;i+=16)
+   {
+      __m256i xi = _mm256_loadu_si256((const __m256i *)(const void *)&x[i]);
+      sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(xi,
+            _mm256_loadu_si256((const __m256i *)(const void *)&y01[i])));
+      sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(xi,
+            _mm256_loadu_si256((const __m256i *)(const void *)&y02[i])));
+   }
+   sum1_128 = fold_epi32(sum1);
+   sum2_128 = fold_epi32(sum2);
+   if (i<N-7)
+   {
+      __m128i xi = _mm_loadu_si128((const __m128i *)(const void *)&x[i]);
+      sum1_128 = _mm_add_epi32(sum1_128, _mm_madd_epi16(xi,
+            _mm_loadu_si128((const __m128i *)(const void *)&y01[i])));
+      sum2_128 = _mm_add_epi32(sum2_128, _mm_madd_epi16(xi,
+            _mm_loadu_si128((const __m128i *)(const void *)&y02[i])));
+      i += 8;
+   }
+   if (i<N-3)
+   {
+      __m128i xi = _mm_loadl_epi64((const __m128i *)(const void *)&x[i]);
+      sum1_128 = _mm_add_epi32(sum1_128, _mm_madd_epi16(xi,
+            _mm_loadl_epi64((const __m128i *)(const void *)&y01[i])));
+      sum2_128 = _mm_add_epi32(sum2_128, _mm_madd_epi16(xi,
+            _mm_loadl_epi64((const __m128i *)(const void *)&y02[i])));
+      i += 4;
+   }
+   xy01 = hsum_epi32(sum1_128);
+   xy02 = hsum_epi32(sum2_128);
+   for (;i<N;i++)
+   {
+      xy01 = MAC16_16(xy01, x[i], y01[i]);
+      xy02 = MAC16_16(xy02, x[i], y02[i]);
+   }
+   *xy1 = xy01;
+   *xy2 = xy02;
+}
+
+OPUS_TARGET_AVX2
+opus_val32 celt_pitch_xcorr_avx2(const opus_val16 *_x, const opus_val16 *_y,
+      opus_val32 *xcorr, int len, int max_pitch, int arch)
+{
+   int i, j;
+   opus_val32 maxcorr;
+   __m128i vmax = _mm_set1_epi32(1);
+
+   celt_assert(max_pitch>0);
+   for (i=0;i<max_pitch-3;i+=4)
+   {
+      const opus_val16 *y = _y + i;
+      __m256i sum0 = _mm256_setzero_si256();
+      __m256i sum1 = _mm256_setzero_si256();
+      __m256i sum2 = _mm256_setzero_si256();
+      __m256i sum3 = _mm256_setzero_si256();
+      __m128i s0, s1, s2, s3, sums;
+
+      for (j=0;j<len-15;j+=16)
+      {
+         __m256i xj = _mm256_loadu_si256((const __m256i *)(const void *)&_x[j]);
+         sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(xj,
+               _mm256_loadu_si256((const __m256i *)(const void *)&y[j])));
+         sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(xj,
+               _mm256_loadu_si256((const __m256i *)(const void *)&y[j + 1])));
+         sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(xj,
+               _mm256_loadu_si256((const __m256i *)(const void *)&y[j + 2])));
+         sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(xj,
+               _mm256_loadu_si256((const __m256i *)(const void *)&y[j + 3])));
+      }
+      s0 = fold_epi32(sum0);
+      s1 = fold_epi32(sum1);
+      s2 = fold_epi32(sum2);
+      s3 = fold_epi32(sum3);
+      if (j<len-7)
+      {
+         __m128i xj = _mm_loadu_si128((const __m128i *)(const void *)&_x[j]);
+         s0 = _mm_add_epi32(s0, _mm_madd_epi16(xj,
+               _mm_loadu_si128((const __m128i *)(const void *)&y[j])));
+         s1 = _mm_add_epi32(s1, _mm_madd_epi16(xj,
+               _mm_loadu_si128((const __m128i *)(const void *)&y[j + 1])));
+         s2 = _mm_add_epi32(s2, _mm_madd_epi16(xj,
+               _mm_loadu_si128((const __m128i *)(const void *)&y[j + 2])));
+         s3 = _mm_add_epi32(s3, _mm_madd_epi16(xj,
+               _mm_loadu_si128((const __m128i *)(const void *)&y[j + 3])));
+         j += 8;
+      }
+      if (j<len-3)
+      {
+         __m128i xj = _mm_loadl_epi64((const __m128i *)(const void *)&_x[j]);
+         s0 = _mm_add_epi32(s0, _mm_madd_epi16(xj,
+               _mm_loadl_epi64((const __m128i *)(const void *)&y[j])));
+         s1 = _mm_add_epi32(s1, _mm_madd_epi16(xj,
+               _mm_loadl_epi64((const __m128i *)(const void *)&y[j + 1])));
+         s2 = _mm_add_epi32(s2, _mm_madd_epi16(xj,
+               _mm_loadl_epi64((const __m128i *)(const void *)&y[j + 2])));
+         s3 = _mm_add_epi32(s3, _mm_madd_epi16(xj,
+               _mm_loadl_epi64((const __m128i *)(const void *)&y[j + 3])));
+         j += 4;
+      }
+      sums = _mm_hadd_epi32(_mm_hadd_epi32(s0, s1), _mm_hadd_epi32(s2, s3));
+      for (;j<len;j++)
+      {
+         sums = _mm_add_epi32(sums, _mm_mullo_epi32(_mm_set1_epi32(_x[j]),
+               OP_CVTEPI16_EPI32_M64(&y[j])));
+      }
+      _mm_storeu_si128((__m128i *)(void *)&xcorr[i], sums);
+      vmax = _mm_max_epi32(vmax, sums);
+   }
+   vmax = _mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+   vmax = _mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+   maxcorr = _mm_cvtsi128_si32(vmax);
+   /* In case max_pitch isn't a multiple of 4. */
+   for (;i<max_pitch;i++)
+   {
+      opus_val32 sum;
+      sum = celt_inner_prod_avx2(_x, _y+i, len);
+      xcorr[i] = sum;
+      maxcorr = MAX32(maxcorr, sum);
+   }
+   (void)arch;
+   return maxcorr;
+}
+
+#endif
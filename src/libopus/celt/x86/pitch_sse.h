@@ -0,0 +1,118 @@
+/* SSE4.1 and AVX2 versions of the fixed-point correlation kernels */
+
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef PITCH_SSE_H
+#define PITCH_SSE_H
+
+#include "../arch.h"
+#include "../cpu_support.h"
+
+/* Only fixed point has x86 kernels here; a float build gets the C ones. */
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+opus_val32 celt_inner_prod_sse4_1(const opus_val16 *x, const opus_val16 *y, int N);
+
+void dual_inner_prod_sse4_1(const opus_val16 *x, const opus_val16 *y01, const opus_val16 *y02,
+      int N, opus_val32 *xy1, opus_val32 *xy2);
+
+opus_val32 celt_pitch_xcorr_sse4_1(const opus_val16 *_x, const opus_val16 *_y,
+      opus_val32 *xcorr, int len, int max_pitch, int arch);
+
+void comb_filter_const_sse4_1(opus_val32 *y, opus_val32 *x, int T, int N,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12);
+
+#if defined(OPUS_X86_MAY_HAVE_AVX2)
+opus_val32 celt_inner_prod_avx2(const opus_val16 *x, const opus_val16 *y, int N);
+
+void dual_inner_prod_avx2(const opus_val16 *x, const opus_val16 *y01, const opus_val16 *y02,
+      int N, opus_val32 *xy1, opus_val32 *xy2);
+
+opus_val32 celt_pitch_xcorr_avx2(const opus_val16 *_x, const opus_val16 *_y,
+      opus_val32 *xcorr, int len, int max_pitch, int arch);
+#endif
+
+#define OVERRIDE_CELT_INNER_PROD
+#define OVERRIDE_DUAL_INNER_PROD
+#define OVERRIDE_PITCH_XCORR
+#define OVERRIDE_COMB_FILTER_CONST
+
+#if defined(OPUS_X86_PRESUME_AVX2)
+
+#define celt_inner_prod(x, y, N, arch) \
+    ((void)(arch), celt_inner_prod_avx2(x, y, N))
+#define dual_inner_prod(x, y01, y02, N, xy1, xy2, arch) \
+    ((void)(arch), dual_inner_prod_avx2(x, y01, y02, N, xy1, xy2))
+#define celt_pitch_xcorr celt_pitch_xcorr_avx2
+#define comb_filter_const(y, x, T, N, g10, g11, g12, arch) \
+    ((void)(arch), comb_filter_const_sse4_1(y, x, T, N, g10, g11, g12))
+
+#elif defined(OPUS_X86_PRESUME_SSE4_1) && !defined(OPUS_X86_MAY_HAVE_AVX2)
+
+#define celt_inner_prod(x, y, N, arch) \
+    ((void)(arch), celt_inner_prod_sse4_1(x, y, N))
+#define dual_inner_prod(x, y01, y02, N, xy1, xy2, arch) \
+    ((void)(arch), dual_inner_prod_sse4_1(x, y01, y02, N, xy1, xy2))
+#define celt_pitch_xcorr celt_pitch_xcorr_sse4_1
+#define comb_filter_const(y, x, T, N, g10, g11, g12, arch) \
+    ((void)(arch), comb_filter_const_sse4_1(y, x, T, N, g10, g11, g12))
+
+#else
+
+extern opus_val32 (*const CELT_INNER_PROD_IMPL[OPUS_ARCHMASK + 1])(
+      const opus_val16 *x, const opus_val16 *y, int N);
+
+#define celt_inner_prod(x, y, N, arch) \
+    ((*CELT_INNER_PROD_IMPL[(arch) & OPUS_ARCHMASK])(x, y, N))
+
+extern void (*const DUAL_INNER_PROD_IMPL[OPUS_ARCHMASK + 1])(
+      const opus_val16 *x, const opus_val16 *y01, const opus_val16 *y02,
+      int N, opus_val32 *xy1, opus_val32 *xy2);
+
+#define dual_inner_prod(x, y01, y02, N, xy1, xy2, arch) \
+    ((*DUAL_INNER_PROD_IMPL[(arch) & OPUS_ARCHMASK])(x, y01, y02, N, xy1, xy2))
+
+extern opus_val32 (*const CELT_PITCH_XCORR_IMPL[OPUS_ARCHMASK + 1])(
+      const opus_val16 *_x, const opus_val16 *_y,
+      opus_val32 *xcorr, int len, int max_pitch, int arch);
+
+#define celt_pitch_xcorr(_x, _y, xcorr, len, max_pitch, arch) \
+    ((*CELT_PITCH_XCORR_IMPL[(arch) & OPUS_ARCHMASK])(_x, _y, xcorr, len, max_pitch, arch))
+
+/* The table needs the C version to be visible from x86_celt_map.c. */
+#define NON_STATIC_COMB_FILTER_CONST_C
+
+extern void (*const COMB_FILTER_CONST_IMPL[OPUS_ARCHMASK + 1])(
+      opus_val32 *y, opus_val32 *x, int T, int N,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12);
+
+#define comb_filter_const(y, x, T, N, g10, g11, g12, arch) \
+    ((*COMB_FILTER_CONST_IMPL[(arch) & OPUS_ARCHMASK])(y, x, T, N, g10, g11, g12))
+
+#endif
+
+#endif
+#endif
@@ -0,0 +1,243 @@
+/* SSE4.1 versions of the fixed-point correlation kernels and of the postfilter's
+   comb filter */
+
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+//#ifdef HAVE_CONFIG_H
+#include "../../config.h"
+//#endif
+
+#include "../pitch.h"
+#include "../celt.h"
+
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+#include <smmintrin.h>
+#include "x86cpu.h"
+
+/* The C versions accumulate with MAC16_16(), which wraps at 32 bits, so any
+   order of the same products gives the same sum: _mm_madd_epi16() is exact
+   as it stands. */
+
+static OPUS_INLINE OPUS_TARGET_SSE4_1 opus_val32 hsum_epi32(__m128i v)
+{
+   v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+   v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+   return _mm_cvtsi128_si32(v);
+}
+
+OPUS_TARGET_SSE4_1
+opus_val32 celt_inner_prod_sse4_1(const opus_val16 *x, const opus_val16 *y, int N)
+{
+   int i;
+   opus_val32 xy;
+   __m128i sum = _mm_setzero_si128();
+
+   for (i=0;i<N-15;i+=16)
+   {
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(
+            _mm_loadu_si128((const __m128i *)(const void *)&x[i]),
+            _mm_loadu_si128((const __m128i *)(const void *)&y[i])));
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(
+            _mm_loadu_si128((const __m128i *)(const void *)&x[i + 8]),
+            _mm_loadu_si128((const __m128i *)(const void *)&y[i + 8])));
+   }
+   if (i<N-7)
+   {
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(
+            _mm_loadu_si128((const __m128i *)(const void *)&x[i]),
+            _mm_loadu_si128((const __m128i *)(const void *)&y[i])));
+      i += 8;
+   }
+   if (i<N-3)
+   {
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(
+            _mm_loadl_epi64((const __m128i *)(const void *)&x[i]),
+            _mm_loadl_epi64((const __m128i *)(const void *)&y[i])));
+      i += 4;
+   }
+   xy = hsum_epi32(sum);
+   for (;i<N;i++)
+      xy = MAC16_16(xy, x[i], y[i]);
+   return xy;
+}
+
+OPUS_TARGET_SSE4_1
+void dual_inner_prod_sse4_1(const opus_val16 *x, const opus_val16 *y01, const opus_val16 *y02,
+      int N, opus_val32 *xy1, opus_val32 *xy2)
+{
+   int i;
+   opus_val32 xy01, xy02;
+   __m128i sum1 = _mm_setzero_si128();
+   __m128i sum2 = _mm_setzero_si128();
+
+   for (i=0;i<N-7;i+=8)
+   {
+      __m128i xi = _mm_loadu_si128((const __m128i *)(const void *)&x[i]);
+      sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(xi,
+            _mm_loadu_si128((const __m128i *)(const void *)&y01[i])));
+      sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(xi,
+            _mm_loadu_si128((const __m128i *)(const void *)&y02[i])));
+   }
+   if (i<N-3)
+   {
+      __m128i xi = _mm_loadl_epi64((const __m128i *)(const void *)&x[i]);
+      sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(xi,
+            _mm_loadl_epi64((const __m128i *)(const void *)&y01[i])));
+      sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(xi,
+            _mm_loadl_epi64((const __m128i *)(const void *)&y02[i])));
+      i += 4;
+   }
+   xy01 = hsum_epi32(sum1);
+   xy02 = hsum_epi32(sum2);
+   for (;i<N;i++)
+   {
+      xy01 = MAC16_16(xy01, x[i], y01[i]);
+      xy02 = MAC16_16(xy02, x[i], y02[i]);
+   }
+   *xy1 = xy01;
+   *xy2 = xy02;
+}
+
+/* Four lags at a time, as xcorr_kernel_c() does them, but eight products per
+   lag per step; the lags are summed across in one go at the end. */
+OPUS_TARGET_SSE4_1
+opus_val32 celt_pitch_xcorr_sse4_1(const opus_val16 *_x, const opus_val16 *_y,
+      opus_val32 *xcorr, int len, int max_pitch, int arch)
+{
+   int i, j;
+   opus_val32 maxcorr;
+   __m128i vmax = _mm_set1_epi32(1);
+
+   celt_assert(max_pitch>0);
+   for (i=0;i<max_pitch-3;i+=4)
+   {
+      const opus_val16 *y = _y + i;
+      __m128i sum0 = _mm_setzero_si128();
+      __m128i sum1 = _mm_setzero_si128();
+      __m128i sum2 = _mm_setzero_si128();
+      __m128i sum3 = _mm_setzero_si128();
+      __m128i sums;
+
+      for (j=0;j<len-7;j+=8)
+      {
+         __m128i xj = _mm_loadu_si128((const __m128i *)(const void *)&_x[j]);
+         sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(xj,
+               _mm_loadu_si128((const __m128i *)(const void *)&y[j])));
+         sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(xj,
+               _mm_loadu_si128((const __m128i *)(const void *)&y[j + 1])));
+         sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(xj,
+               _mm_loadu_si128((const __m128i *)(const void *)&y[j + 2])));
+         sum3 = _mm_add_epi32(sum3, _mm_madd_epi16(xj,
+               _mm_loadu_si128((const __m128i *)(const void *)&y[j + 3])));
+      }
+      if (j<len-3)
+      {
+         __m128i xj = _mm_loadl_epi64((const __m128i *)(const void *)&_x[j]);
+         sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(xj,
+               _mm_loadl_epi64((const __m128i *)(const void *)&y[j])));
+         sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(xj,
+               _mm_loadl_epi64((const __m128i *)(const void *)&y[j + 1])));
+         sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(xj,
+               _mm_loadl_epi64((const __m128i *)(const void *)&y[j + 2])));
+         sum3 = _mm_add_epi32(sum3, _mm_madd_epi16(xj,
+               _mm_loadl_epi64((const __m128i *)(const void *)&y[j + 3])));
+         j += 4;
+      }
+      sums = _mm_hadd_epi32(_mm_hadd_epi32(sum0, sum1), _mm_hadd_epi32(sum2, sum3));
+      for (;j<len;j++)
+      {
+         sums = _mm_add_epi32(sums, _mm_mullo_epi32(_mm_set1_epi32(_x[j]),
+               OP_CVTEPI16_EPI32_M64(&y[j])));
+      }
+      _mm_storeu_si128((__m128i *)(void *)&xcorr[i], sums);
+      vmax = _mm_max_epi32(vmax, sums);
+   }
+   vmax = _mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+   vmax = _mm_max_epi32(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+   maxcorr = _mm_cvtsi128_si32(vmax);
+   /* In case max_pitch isn't a multiple of 4. */
+   for (;i<max_pitch;i++)
+   {
+      opus_val32 sum;
+      sum = celt_inner_prod_sse4_1(_x, _y+i, len);
+      xcorr[i] = sum;
+      maxcorr = MAX32(maxcorr, sum);
+   }
+   (void)arch;
+   return maxcorr;
+}
+
+/* MULT16_32_Q15() split at bit 16 the way fixed_generic.h does it without
+   64-bit multiplies, so both halves fit a 32-bit lane. */
+static OPUS_INLINE OPUS_TARGET_SSE4_1 __m128i mult16_32_q15_epi32(__m128i a, __m128i b)
+{
+   __m128i hi, lo;
+   hi = _mm_mullo_epi32(a, _mm_srai_epi32(b, 16));
+   lo = _mm_mullo_epi32(a, _mm_and_si128(b, _mm_set1_epi32(0xFFFF)));
+   return _mm_add_epi32(_mm_slli_epi32(hi, 1), _mm_srai_epi32(lo, 15));
+}
+
+/* Works in place like the C version: T is at least COMBFILTER_MINPERIOD, so
+   every input a block of four reads from before i has already been written. */
+OPUS_TARGET_SSE4_1
+void comb_filter_const_sse4_1(opus_val32 *y, opus_val32 *x, int T, int N,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12)
+{
+   int i;
+   __m128i vg10, vg11, vg12, sat, nsat;
+
+   vg10 = _mm_set1_epi32(g10);
+   vg11 = _mm_set1_epi32(g11);
+   vg12 = _mm_set1_epi32(g12);
+   sat = _mm_set1_epi32(SIG_SAT);
+   nsat = _mm_set1_epi32(-SIG_SAT);
+   for (i=0;i<N-3;i+=4)
+   {
+      __m128i x0, x1, x2, x3, x4, t;
+      x4 = _mm_loadu_si128((const __m128i *)(const void *)&x[i-T-2]);
+      x3 = _mm_loadu_si128((const __m128i *)(const void *)&x[i-T-1]);
+      x2 = _mm_loadu_si128((const __m128i *)(const void *)&x[i-T]);
+      x1 = _mm_loadu_si128((const __m128i *)(const void *)&x[i-T+1]);
+      x0 = _mm_loadu_si128((const __m128i *)(const void *)&x[i-T+2]);
+      t = _mm_loadu_si128((const __m128i *)(const void *)&x[i]);
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(vg10, x2));
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(vg11, _mm_add_epi32(x1, x3)));
+      t = _mm_add_epi32(t, mult16_32_q15_epi32(vg12, _mm_add_epi32(x0, x4)));
+      t = _mm_min_epi32(_mm_max_epi32(t, nsat), sat);
+      _mm_storeu_si128((__m128i *)(void *)&y[i], t);
+   }
+   for (;i<N;i++)
+   {
+      y[i] = x[i]
+               + MULT16_32_Q15(g10,x[i-T])
+               + MULT16_32_Q15(g11,ADD32(x[i-T+1],x[i-T-1]))
+               + MULT16_32_Q15(g12,ADD32(x[i-T+2],x[i-T-2]));
+      y[i] = SATURATE(y[i], SIG_SAT);
+   }
+}
+
+#endif
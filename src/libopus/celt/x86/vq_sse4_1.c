@@ -0,0 +1,224 @@
+/* SSE4.1 version of the fixed-point PVQ search */
+
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+//#ifdef HAVE_CONFIG_H
+#include "../../config.h"
+//#endif
+
+#include "../mathops.h"
+#include "../vq.h"
+#include "../arch.h"
+#include "../stack_alloc.h"
+
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+#include <smmintrin.h>
+#include "x86cpu.h"
+
+#define SEXT16_EPI32(v) (_mm_srai_epi32(_mm_slli_epi32((v), 16), 16))
+
+/* Scores of positions j..j+3 for the next pulse, computed exactly as the C
+   loop does, truncations to 16 bits included. */
+static OPUS_INLINE OPUS_TARGET_SSE4_1 void pvq_scores(const celt_norm *X, const celt_norm *y,
+      int j, __m128i vxy, __m128i vyy, __m128i shift, __m128i *num, __m128i *den)
+{
+   __m128i Rxy;
+   Rxy = _mm_sra_epi32(_mm_add_epi32(vxy, OP_CVTEPI16_EPI32_M64(&X[j])), shift);
+   Rxy = SEXT16_EPI32(Rxy);
+   Rxy = _mm_srai_epi32(_mm_mullo_epi32(Rxy, Rxy), 15);
+   *num = SEXT16_EPI32(Rxy);
+   *den = SEXT16_EPI32(_mm_add_epi32(vyy, OP_CVTEPI16_EPI32_M64(&y[j])));
+}
+
+/* Where the C loop picks the first j with the best Rxy/Ryy, each lane here
+   keeps the first best of every fourth j, and the lanes are then compared
+   the same way with ties going to the lower index.  The products are exact
+   and Ryy is positive, so that's the same j. */
+static OPUS_INLINE OPUS_TARGET_SSE4_1 int pvq_best_pulse(const celt_norm *X, const celt_norm *y,
+      int N, opus_val32 xy, opus_val16 yy, int rshift)
+{
+   int j, k, best_id;
+   opus_val16 Rxy, Ryy, best_den;
+   opus_val32 best_num;
+   __m128i vxy, vyy, shift, id, best_n, best_d, best_i;
+   int nums[4], dens[4], ids[4];
+
+   vxy = _mm_set1_epi32(xy);
+   vyy = _mm_set1_epi32(yy);
+   shift = _mm_cvtsi32_si128(rshift);
+   id = _mm_setr_epi32(0, 1, 2, 3);
+   pvq_scores(X, y, 0, vxy, vyy, shift, &best_n, &best_d);
+   best_i = id;
+   for (j=4;j<N-3;j+=4)
+   {
+      __m128i n, d, better;
+      id = _mm_add_epi32(id, _mm_set1_epi32(4));
+      pvq_scores(X, y, j, vxy, vyy, shift, &n, &d);
+      better = _mm_cmpgt_epi32(_mm_mullo_epi32(best_d, n), _mm_mullo_epi32(d, best_n));
+      best_n = _mm_blendv_epi8(best_n, n, better);
+      best_d = _mm_blendv_epi8(best_d, d, better);
+      best_i = _mm_blendv_epi8(best_i, id, better);
+   }
+   _mm_storeu_si128((__m128i *)(void *)nums, best_n);
+   _mm_storeu_si128((__m128i *)(void *)dens, best_d);
+   _mm_storeu_si128((__m128i *)(void *)ids, best_i);
+   best_num = nums[0];
+   best_den = dens[0];
+   best_id = ids[0];
+   for (k=1;k<4;k++)
+   {
+      opus_val32 a = MULT16_16(best_den, nums[k]);
+      opus_val32 b = MULT16_16(dens[k], best_num);
+      if (a > b || (a == b && ids[k] < best_id))
+      {
+         best_num = nums[k];
+         best_den = dens[k];
+         best_id = ids[k];
+      }
+   }
+   for (;j<N;j++)
+   {
+      Rxy = EXTRACT16(SHR32(ADD32(xy, EXTEND32(X[j])),rshift));
+      Ryy = ADD16(yy, y[j]);
+      Rxy = MULT16_16_Q15(Rxy,Rxy);
+      if (MULT16_16(best_den, Rxy) > MULT16_16(Ryy, best_num))
+      {
+         best_den = Ryy;
+         best_num = Rxy;
+         best_id = j;
+      }
+   }
+   return best_id;
+}
+
+/* op_pvq_search_c() with the search for each pulse done four positions at a
+   time.  Short bands aren't worth it, and go through the C loop. */
+OPUS_TARGET_SSE4_1
+opus_val16 op_pvq_search_sse4_1(celt_norm *X, int *iy, int K, int N, int arch)
+{
+   VARDECL(celt_norm, y);
+   VARDECL(int, signx);
+   int i, j;
+   int pulsesLeft;
+   opus_val32 sum;
+   opus_val32 xy;
+   opus_val16 yy;
+   SAVE_STACK;
+
+   if (N < 8)
+   {
+      RESTORE_STACK;
+      return op_pvq_search_c(X, iy, K, N, arch);
+   }
+   ALLOC(y, N, celt_norm);
+   ALLOC(signx, N, int);
+
+   /* Get rid of the sign */
+   sum = 0;
+   j=0; do {
+      signx[j] = X[j]<0;
+      X[j] = ABS16(X[j]);
+      iy[j] = 0;
+      y[j] = 0;
+   } while (++j<N);
+
+   xy = yy = 0;
+
+   pulsesLeft = K;
+
+   /* Do a pre-search by projecting on the pyramid */
+   if (K > (N>>1))
+   {
+      opus_val16 rcp;
+      j=0; do {
+         sum += X[j];
+      }  while (++j<N);
+
+      /* If X is too small, just replace it with a pulse at 0 */
+      if (sum <= K)
+      {
+         X[0] = QCONST16(1.f,14);
+         j=1; do
+            X[j]=0;
+         while (++j<N);
+         sum = QCONST16(1.f,14);
+      }
+      rcp = EXTRACT16(MULT16_32_Q16(K, celt_rcp(sum)));
+      j=0; do {
+         /* It's really important to round *towards zero* here */
+         iy[j] = MULT16_16_Q15(X[j],rcp);
+         y[j] = (celt_norm)iy[j];
+         yy = MAC16_16(yy, y[j],y[j]);
+         xy = MAC16_16(xy, X[j],y[j]);
+         y[j] *= 2;
+         pulsesLeft -= iy[j];
+      }  while (++j<N);
+   }
+   celt_sig_assert(pulsesLeft>=0);
+
+   /* This should never happen, but just in case it does (e.g. on silence)
+      we fill the first bin with pulses. */
+   if (pulsesLeft > N+3)
+   {
+      opus_val16 tmp = (opus_val16)pulsesLeft;
+      yy = MAC16_16(yy, tmp, tmp);
+      yy = MAC16_16(yy, tmp, y[0]);
+      iy[0] += pulsesLeft;
+      pulsesLeft=0;
+   }
+
+   for (i=0;i<pulsesLeft;i++)
+   {
+      int best_id;
+      int rshift = 1+celt_ilog2(K-pulsesLeft+i+1);
+      /* The squared magnitude term gets added anyway, so we might as well
+         add it outside the loop */
+      yy = ADD16(yy, 1);
+
+      best_id = pvq_best_pulse(X, y, N, xy, yy, rshift);
+
+      /* Updating the sums of the new pulse(s) */
+      xy = ADD32(xy, EXTEND32(X[best_id]));
+      /* We're multiplying y[j] by two so we don't have to do it here */
+      yy = ADD16(yy, y[best_id]);
+
+      /* Only now that we've made the final choice, update y/iy */
+      /* Multiplying y[j] by 2 so we don't have to do it everywhere else */
+      y[best_id] += 2;
+      iy[best_id]++;
+   }
+
+   /* Put the original sign back */
+   j=0;
+   do {
+      iy[j] = (iy[j]^-signx[j]) + signx[j];
+   } while (++j<N);
+   RESTORE_STACK;
+   return yy;
+}
+
+#endif
@@ -0,0 +1,95 @@
+/* Run-time dispatch tables for the CELT x86 kernels, indexed by arch (see
+   cpu_support.h) */
+
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+//#ifdef HAVE_CONFIG_H
+#include "../../config.h"
+//#endif
+
+#include "x86cpu.h"
+#include "../pitch.h"
+#include "../celt.h"
+#include "../vq.h"
+
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_SSE4_1) && \
+  !(defined(OPUS_X86_PRESUME_AVX2) || \
+  (defined(OPUS_X86_PRESUME_SSE4_1) && !defined(OPUS_X86_MAY_HAVE_AVX2)))
+
+opus_val32 (*const CELT_INNER_PROD_IMPL[OPUS_ARCHMASK + 1])(
+      const opus_val16 *x, const opus_val16 *y, int N) = {
+   celt_inner_prod_c,                /* non-sse */
+   celt_inner_prod_c,
+   celt_inner_prod_c,
+   MAY_HAVE_SSE4_1(celt_inner_prod),
+   MAY_HAVE_AVX2(celt_inner_prod)    /* avx2 */
+};
+
+void (*const DUAL_INNER_PROD_IMPL[OPUS_ARCHMASK + 1])(
+      const opus_val16 *x, const opus_val16 *y01, const opus_val16 *y02,
+      int N, opus_val32 *xy1, opus_val32 *xy2) = {
+   dual_inner_prod_c,                /* non-sse */
+   dual_inner_prod_c,
+   dual_inner_prod_c,
+   MAY_HAVE_SSE4_1(dual_inner_prod),
+   MAY_HAVE_AVX2(dual_inner_prod)    /* avx2 */
+};
+
+opus_val32 (*const CELT_PITCH_XCORR_IMPL[OPUS_ARCHMASK + 1])(
+      const opus_val16 *_x, const opus_val16 *_y,
+      opus_val32 *xcorr, int len, int max_pitch, int arch) = {
+   celt_pitch_xcorr_c,               /* non-sse */
+   celt_pitch_xcorr_c,
+   celt_pitch_xcorr_c,
+   MAY_HAVE_SSE4_1(celt_pitch_xcorr),
+   MAY_HAVE_AVX2(celt_pitch_xcorr)   /* avx2 */
+};
+
+void (*const COMB_FILTER_CONST_IMPL[OPUS_ARCHMASK + 1])(
+      opus_val32 *y, opus_val32 *x, int T, int N,
+      opus_val16 g10, opus_val16 g11, opus_val16 g12) = {
+   comb_filter_const_c,                /* non-sse */
+   comb_filter_const_c,
+   comb_filter_const_c,
+   MAY_HAVE_SSE4_1(comb_filter_const),
+   MAY_HAVE_SSE4_1(comb_filter_const)  /* avx2 */
+};
+
+#endif
+
+#if defined(FIXED_POINT) && defined(OPUS_X86_MAY_HAVE_SSE4_1) && \
+  !defined(OPUS_X86_PRESUME_SSE4_1)
+
+opus_val16 (*const OP_PVQ_SEARCH_IMPL[OPUS_ARCHMASK + 1])(
+      celt_norm *_X, int *iy, int K, int N, int arch) = {
+   op_pvq_search_c,                /* non-sse */
+   op_pvq_search_c,
+   op_pvq_search_c,
+   MAY_HAVE_SSE4_1(op_pvq_search),
+   MAY_HAVE_SSE4_1(op_pvq_search)  /* avx2 */
+};
+
+#endif
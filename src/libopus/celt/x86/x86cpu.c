@@ -0,0 +1,97 @@
+/* x86 run-time CPU detection */
+
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+//#ifdef HAVE_CONFIG_H
+#include "../../config.h"
+//#endif
+
+#include "../cpu_support.h"
+
+#if (defined(OPUS_X86_MAY_HAVE_SSE) && !defined(OPUS_X86_PRESUME_SSE)) || \
+  (defined(OPUS_X86_MAY_HAVE_SSE2) && !defined(OPUS_X86_PRESUME_SSE2)) || \
+  (defined(OPUS_X86_MAY_HAVE_SSE4_1) && !defined(OPUS_X86_PRESUME_SSE4_1)) || \
+  (defined(OPUS_X86_MAY_HAVE_AVX2) && !defined(OPUS_X86_PRESUME_AVX2))
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+static void cpuid(unsigned int info[4], unsigned int leaf)
+{
+   __cpuidex((int *)info, leaf, 0);
+}
+
+static unsigned int xgetbv0(void)
+{
+   return (unsigned int)_xgetbv(0);
+}
+
+#else
+#include <cpuid.h>
+
+static void cpuid(unsigned int info[4], unsigned int leaf)
+{
+   if (leaf > __get_cpuid_max(0, 0))
+      info[0] = info[1] = info[2] = info[3] = 0;
+   else
+      __cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+}
+
+static unsigned int xgetbv0(void)
+{
+   unsigned int eax, edx;
+   __asm__ volatile ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+   return eax;
+}
+#endif
+
+/* Each level needs the ones below it; AVX2 also needs the OS to save the YMM
+   registers, which is what XGETBV says. */
+int opus_select_arch(void)
+{
+   unsigned int info[4];
+   int arch = 0;
+
+   cpuid(info, 1);
+   if (!(info[3] & (1 << 25)))
+      return arch;
+   arch++;
+   if (!(info[3] & (1 << 26)))
+      return arch;
+   arch++;
+   if (!(info[2] & (1 << 19)))
+      return arch;
+   arch++;
+   if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (xgetbv0() & 6) == 6)
+   {
+      cpuid(info, 7);
+      if (info[1] & (1 << 5))
+         arch++;
+   }
+   return arch;
+}
+
+#endif
@@ -0,0 +1,62 @@
+/* x86 run-time CPU detection, and the names of each instruction set's kernels */
+
+/*
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   - Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   - Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+   OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef X86CPU_H
+# define X86CPU_H
+
+# if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+#  define MAY_HAVE_SSE4_1(name) name ## _sse4_1
+# else
+#  define MAY_HAVE_SSE4_1(name) name ## _c
+# endif
+
+/* Kernels without an AVX2 version of their own run the SSE4.1 one there. */
+# if defined(OPUS_X86_MAY_HAVE_AVX2)
+#  define MAY_HAVE_AVX2(name) name ## _avx2
+# else
+#  define MAY_HAVE_AVX2(name) MAY_HAVE_SSE4_1(name)
+# endif
+
+/* The kernels carry their instruction set in a target attribute, so the
+   library builds with one set of flags and only they need the CPU to have it;
+   with -msse4.1 or -mavx2 the attributes change nothing. */
+# if defined(__GNUC__) || defined(__clang__)
+#  define OPUS_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+#  define OPUS_TARGET_AVX2 __attribute__((target("avx2")))
+# else
+#  define OPUS_TARGET_SSE4_1
+#  define OPUS_TARGET_AVX2
+# endif
+
+/* Loads 4 or 8 int16s into 32-bit lanes.  The 64-bit load keeps the compiler
+   from reading past the end of the array. */
+# define OP_CVTEPI16_EPI32_M64(x) \
+ (_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)(const void *)(x))))
+# define OP_CVTEPI16_EPI32_M128(x) \
+ (_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(const void *)(x))))
+
+#endif
@@ -35,7 +35,7 @@
 /* #undef FUZZING */
 
 /* Define to 1 if you have the <alloca.h> header file. */
-/* #undef HAVE_ALLOCA_H */
+#define HAVE_ALLOCA_H 1
 
 /* NE10 library is installed on host. Make sure it is on target! */
 /* #undef HAVE_ARM_NE10 */
@@ -88,10 +88,15 @@
 /* Use generic ARMv4 inline asm optimizations */
 /* #undef OPUS_ARM_INLINE_ASM */
 
-/* Use ARMv5E inline asm optimizations */
+/* Use ARMv5E and ARMv6 inline asm optimizations: the DSP extension's
+   multiplies, SMLAD, PKHBT and SSAT, on a core that has them, as the
+   Cortex-M4 does (celt/arm, silk/arm). Opt in with -DOPUS_ARM_INLINE_EDSP
+   -DOPUS_ARM_INLINE_MEDIA (see platformio.ini): nothing turns them on by
+   itself until an arm-none-eabi build has been shown warning-clean,
+   bit-exact and faster on the board. Defining both on a host builds the
+   same code with a C version of each instruction, to check it bit-exact
+   against the generic C ("testbed dsp") */
 /* #undef OPUS_ARM_INLINE_EDSP */
-
-/* Use ARMv6 inline asm optimizations */
 /* #undef OPUS_ARM_INLINE_MEDIA */
 
 /* Use ARM NEON inline asm optimizations */
@@ -133,8 +138,8 @@
 /* Use run-time CPU capabilities detection */
 /* #undef OPUS_HAVE_RTCD */
 
-/* Compiler supports X86 AVX Intrinsics */
-/* #undef OPUS_X86_MAY_HAVE_AVX */
+/* Compiler supports X86 AVX2 Intrinsics */
+/* #undef OPUS_X86_MAY_HAVE_AVX2 */
 
 /* Compiler supports X86 SSE Intrinsics */
 /* #undef OPUS_X86_MAY_HAVE_SSE */
@@ -145,8 +150,8 @@
 /* Compiler supports X86 SSE4.1 Intrinsics */
 /* #undef OPUS_X86_MAY_HAVE_SSE4_1 */
 
-/* Define if binary requires AVX intrinsics support */
-/* #undef OPUS_X86_PRESUME_AVX */
+/* Define if binary requires AVX2 intrinsics support */
+/* #undef OPUS_X86_PRESUME_AVX2 */
 
 /* Define if binary requires SSE intrinsics support */
 /* #undef OPUS_X86_PRESUME_SSE */
@@ -184,6 +189,30 @@
 /* Use C99 variable-size arrays */
 #define VAR_ARRAYS 1
 
+/* Let the decoder take its temporaries from a caller-provided arena
+   (OPUS_SET_SCRATCH_ARENA) instead of the stack; takes precedence over
+   VAR_ARRAYS. Without an arena, and for whatever doesn't fit one, they go on
+   the stack with alloca, so this needs HAVE_ALLOCA_H or an alloca in
+   <stdlib.h> */
+#define SCRATCH_ARENA 1
+
+/* Bare-metal ARM has no thread-local storage to keep the arena's state in
+   (__thread wants __aeabi_read_tp, which FreeRTOS doesn't switch per task),
+   so there it's global, and only one task may call into Opus: on the player,
+   decodeTask */
+#if defined(__arm__) && !defined(__linux__)
+#define OPUS_SCRATCH_TLS
+#endif
+
+/* Let the CELT decoder synthesise at the output rate, with an IMDCT a
+   fraction of the size, rather than at 48 kHz and then drop the samples in
+   between (OPUS_SET_DECIMATED_SYNTHESIS). Fixed point only. Neither
+   bit-exact nor conformant (pc_testbed decimate scores it well below the
+   exact path), and the player keeps the exact path, so the device is built
+   without its tables and kernels. pc_testbed builds with
+   -DDECIMATED_SYNTHESIS to check and time it (testbed decimate) */
+/* #undef DECIMATED_SYNTHESIS */
+
 /* Define to empty if `const' does not conform to ANSI C. */
 /* #undef const */
 
@@ -359,6 +359,17 @@ OPUS_EXPORT int opus_encoder_ctl(OpusEncoder *st, int request, ...) OPUS_ARG_NON
   * where opus_decoder_get_size() returns the required size for the decoder state. Note that
   * future versions of this code may change the size, so no assuptions should be made about it.
   *
+  * Where the heap is off limits, the state can be reserved at compile time instead, with
+  * #OPUS_DECODER_SIZE, and initialized in place. Nothing is then allocated at all, neither
+  * here nor while decoding:
+  * @code
+  * static union { void *align; unsigned char bytes[OPUS_DECODER_SIZE(1)]; } storage;
+  * OpusDecoder *dec = (OpusDecoder *)&storage;
+  * error = opus_decoder_init(dec, Fs, 1);
+  * @endcode
+  * The state must be aligned for a pointer, which the union takes care of. To start a new
+  * stream, call opus_decoder_init() on it again; there's nothing to free.
+  *
   * The decoder state is always continuous in memory and only a shallow copy is sufficient
   * to copy it (e.g. memcpy())
   *
@@ -405,6 +416,52 @@ typedef struct OpusDecoder OpusDecoder;
   */
 OPUS_EXPORT OPUS_WARN_UNUSED_RESULT int opus_decoder_get_size(int channels);
 
+/** @name Decoder size at compile time
+  * opus_decoder_get_size() as a constant expression, for reserving a decoder in static
+  * storage. These describe this build of the library: fixed point, the standard (not
+  * custom) CELT mode, and 32- or 64-bit pointers. Each part is checked against the real
+  * structure when the library is built, so a change to one that leaves these out of step
+  * stops the build rather than overrunning the storage.
+  */
+/**@{*/
+#ifndef OPUS_DECODER_MAX_CHANNELS
+/** Most output channels any decoder in this build has: 1 leaves out the part of the state
+  * only stereo output needs, and opus_decoder_init() then turns down 2. Mono output can
+  * still decode stereo streams. Define it (to 1 or 2) the same way for the library and
+  * the application, from the build flags. */
+#define OPUS_DECODER_MAX_CHANNELS 2
+#endif
+#define OPUS_DECODER_SILK 1 /**< The SILK core, for #OPUS_DECODER_CORES. */
+#define OPUS_DECODER_CELT 2 /**< The CELT core, for #OPUS_DECODER_CORES. */
+#ifndef OPUS_DECODER_CORES
+/** Which codecs the decoder carries: #OPUS_DECODER_SILK, #OPUS_DECODER_CELT, or both OR'd
+  * together (the default). With one, the other's code and state are left out, and packets
+  * needing it (hybrid ones need both) fail with #OPUS_UNIMPLEMENTED, or are concealed if
+  * #OPUS_SET_CONCEAL_UNSUPPORTED says so. Like #OPUS_DECODER_MAX_CHANNELS, define it the
+  * same way for the library and the application. */
+#define OPUS_DECODER_CORES (OPUS_DECODER_SILK | OPUS_DECODER_CELT)
+#endif
+#define OPUS_DECODER_POINTER_GROWTH (sizeof(void*) - 4) /**< Extra bytes per pointer over a 32-bit target. */
+/** The OpusDecoder itself, with one pointer. */
+#define OPUS_DECODER_BASE_SIZE (116 + OPUS_DECODER_POINTER_GROWTH)
+/** The SILK decoder: two channel states whichever the channel count, though with mono
+  * output only, the side channel's stops short of its synthesis state. */
+#if OPUS_DECODER_MAX_CHANNELS == 1
+#define OPUS_DECODER_SILK_SIZE (4432 + 10*OPUS_DECODER_POINTER_GROWTH)
+#else
+#define OPUS_DECODER_SILK_SIZE (8552 + 12*OPUS_DECODER_POINTER_GROWTH)
+#endif
+/** The CELT decoder: its structure, then per channel 2048+120 samples of history and
+  * 24 LPC coefficients, then 4 sets of 2x21 band energies. */
+#define OPUS_DECODER_CELT_SIZE(channels) (104 + 2*OPUS_DECODER_POINTER_GROWTH \
+   + ((channels)*(2048+120) - 1)*4 + ((channels)*24 + 4*2*21)*2)
+/** Bytes opus_decoder_get_size() returns for channels (1 or 2): the parts above, less
+  * any core #OPUS_DECODER_CORES leaves out. */
+#define OPUS_DECODER_SIZE(channels) (OPUS_DECODER_BASE_SIZE \
+   + ((OPUS_DECODER_CORES & OPUS_DECODER_SILK) ? OPUS_DECODER_SILK_SIZE : 0) \
+   + ((OPUS_DECODER_CORES & OPUS_DECODER_CELT) ? OPUS_DECODER_CELT_SIZE(channels) : 0))
+/**@}*/
+
 /** Allocates and initializes a decoder state.
   * @param [in] Fs <tt>opus_int32</tt>: Sample rate to decode at (Hz).
   *                                     This must be one of 8000, 12000, 16000,
@@ -427,8 +484,10 @@ OPUS_EXPORT OPUS_WARN_UNUSED_RESULT OpusDecoder *opus_decoder_create(
 );
 
 /** Initializes a previously allocated decoder state.
-  * The state must be at least the size returned by opus_decoder_get_size().
-  * This is intended for applications which use their own allocator instead of malloc. @see opus_decoder_create,opus_decoder_get_size
+  * The state must be at least the size returned by opus_decoder_get_size() (or
+  * #OPUS_DECODER_SIZE), and aligned for a pointer.
+  * This is intended for applications which use their own allocator instead of malloc,
+  * or static storage. @see opus_decoder_create,opus_decoder_get_size
   * To reset a previously initialized state, use the #OPUS_RESET_STATE CTL.
   * @param [in] st <tt>OpusDecoder*</tt>: Decoder state.
   * @param [in] Fs <tt>opus_int32</tt>: Sampling rate to decode to (Hz).
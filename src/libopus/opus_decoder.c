@@ -53,6 +53,14 @@
 #include "celt/mathops.h"
 #include "celt/cpu_support.h"
 
+/* The cores this build decodes with (OPUS_DECODER_CORES in opus.h). Whatever is
+   left out is never called, so the linker drops it, and has no space in the state. */
+#define HAVE_SILK_DECODER ((OPUS_DECODER_CORES & OPUS_DECODER_SILK) != 0)
+#define HAVE_CELT_DECODER ((OPUS_DECODER_CORES & OPUS_DECODER_CELT) != 0)
+#if !HAVE_SILK_DECODER && !HAVE_CELT_DECODER
+#error "OPUS_DECODER_CORES needs OPUS_DECODER_SILK, OPUS_DECODER_CELT, or both"
+#endif
+
 struct OpusDecoder {
    int          celt_dec_offset;
    int          silk_dec_offset;
@@ -60,6 +68,10 @@ struct OpusDecoder {
    opus_int32   Fs;          /** Sampling rate (at the API level) */
    silk_DecControlStruct DecControl;
    int          decode_gain;
+   int          output_packing;
+   int          conceal_unsupported; /** Conceal packets needing a core this build lacks */
+   int          gain_pass;   /** Apply the gain in a pass of its own, as libopus does */
+   OpusScratchArena *scratch; /** Where temporaries come from, with SCRATCH_ARENA */
    int          arch;
 
    /* Everything beyond this point gets cleared on a reset */
@@ -77,8 +89,16 @@ struct OpusDecoder {
 #endif
 
    opus_uint32  rangeFinal;
+   opus_int32   skip_samples;
 };
 
+#ifdef FIXED_POINT
+/* OPUS_DECODER_SIZE in opus.h has to come to what opus_decoder_get_size() does. The SILK
+   and CELT parts are checked where their structures are; this is the rest. align() rounds
+   up to the alignment of a pointer, so a multiple of that is left alone. */
+celt_static_assert(sizeof(OpusDecoder) == OPUS_DECODER_BASE_SIZE && OPUS_DECODER_BASE_SIZE % sizeof(void*) == 0, opus_decoder_base_size);
+#endif
+
 #if defined(ENABLE_HARDENING) || defined(ENABLE_ASSERTIONS)
 static void validate_opus_decoder(OpusDecoder *st)
 {
@@ -102,54 +122,61 @@ static void validate_opus_decoder(OpusDecoder *st)
 
 int opus_decoder_get_size(int channels)
 {
-   int silkDecSizeBytes, celtDecSizeBytes;
-   int ret;
-   if (channels<1 || channels > 2)
+   int silkDecSizeBytes=0, celtDecSizeBytes=0;
+   if (channels<1 || channels > OPUS_DECODER_MAX_CHANNELS)
       return 0;
-   ret = silk_Get_Decoder_Size( &silkDecSizeBytes );
-   if(ret)
+#if HAVE_SILK_DECODER
+   if (silk_Get_Decoder_Size( &silkDecSizeBytes ))
       return 0;
    silkDecSizeBytes = align(silkDecSizeBytes);
+#endif
+#if HAVE_CELT_DECODER
    celtDecSizeBytes = celt_decoder_get_size(channels);
+#endif
    return align(sizeof(OpusDecoder))+silkDecSizeBytes+celtDecSizeBytes;
 }
 
 int opus_decoder_init(OpusDecoder *st, opus_int32 Fs, int channels)
 {
-   void *silk_dec;
-   CELTDecoder *celt_dec;
-   int ret, silkDecSizeBytes;
+   int ret, silkDecSizeBytes=0;
 
    if ((Fs!=48000&&Fs!=24000&&Fs!=16000&&Fs!=12000&&Fs!=8000)
-    || (channels!=1&&channels!=2))
+    || (channels!=1&&channels!=2) || channels > OPUS_DECODER_MAX_CHANNELS)
       return OPUS_BAD_ARG;
 
    OPUS_CLEAR((char*)st, opus_decoder_get_size(channels));
    /* Initialize SILK decoder */
+#if HAVE_SILK_DECODER
    ret = silk_Get_Decoder_Size(&silkDecSizeBytes);
    if (ret)
       return OPUS_INTERNAL_ERROR;
 
    silkDecSizeBytes = align(silkDecSizeBytes);
+#endif
    st->silk_dec_offset = align(sizeof(OpusDecoder));
    st->celt_dec_offset = st->silk_dec_offset+silkDecSizeBytes;
-   silk_dec = (char*)st+st->silk_dec_offset;
-   celt_dec = (CELTDecoder*)((char*)st+st->celt_dec_offset);
    st->stream_channels = st->channels = channels;
 
    st->Fs = Fs;
    st->DecControl.API_sampleRate = st->Fs;
    st->DecControl.nChannelsAPI      = st->channels;
 
+#if HAVE_SILK_DECODER
    /* Reset decoder */
-   ret = silk_InitDecoder( silk_dec );
+   ret = silk_InitDecoder( (char*)st+st->silk_dec_offset );
    if(ret)return OPUS_INTERNAL_ERROR;
+#endif
 
-   /* Initialize CELT decoder */
-   ret = celt_decoder_init(celt_dec, Fs, channels);
-   if(ret!=OPUS_OK)return OPUS_INTERNAL_ERROR;
+#if HAVE_CELT_DECODER
+   {
+      CELTDecoder *celt_dec = (CELTDecoder*)((char*)st+st->celt_dec_offset);
+      /* Initialize CELT decoder */
+      ret = celt_decoder_init(celt_dec, Fs, channels);
+      if(ret!=OPUS_OK)return OPUS_INTERNAL_ERROR;
 
-   celt_decoder_ctl(celt_dec, CELT_SET_SIGNALLING(0));
+      celt_decoder_ctl(celt_dec, CELT_SET_SIGNALLING(0));
+   }
+#endif
 
    st->prev_mode = 0;
    st->frame_size = Fs/400;
@@ -162,7 +189,7 @@ OpusDecoder *opus_decoder_create(opus_int32 Fs, int channels, int *error)
    int ret;
    OpusDecoder *st;
    if ((Fs!=48000&&Fs!=24000&&Fs!=16000&&Fs!=12000&&Fs!=8000)
-    || (channels!=1&&channels!=2))
+    || (channels!=1&&channels!=2) || channels > OPUS_DECODER_MAX_CHANNELS)
    {
       if (error)
          *error = OPUS_BAD_ARG;
@@ -203,6 +230,17 @@ static void smooth_fade(const opus_val16 *in1, const opus_val16 *in2,
    }
 }
 
+static void apply_gain(opus_val16 *pcm, int len, opus_val32 gain)
+{
+   int i;
+   for (i=0;i<len;i++)
+   {
+      opus_val32 x;
+      x = MULT16_32_P16(pcm[i],gain);
+      pcm[i] = SATURATE(x, 32767);
+   }
+}
+
 static int opus_packet_get_mode(const unsigned char *data)
 {
    int mode;
@@ -218,14 +256,25 @@ static int opus_packet_get_mode(const unsigned char *data)
    return mode;
 }
 
+/* Whether this build has the core(s) a packet of the given mode needs */
+static int opus_decoder_has_mode(int mode)
+{
+   if (mode == MODE_HYBRID)
+      return HAVE_SILK_DECODER && HAVE_CELT_DECODER;
+   return mode == MODE_SILK_ONLY ? HAVE_SILK_DECODER : HAVE_CELT_DECODER;
+}
+
 static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       opus_int32 len, opus_val16 *pcm, int frame_size, int decode_fec)
 {
+#if HAVE_SILK_DECODER
    void *silk_dec;
+#endif
+#if HAVE_CELT_DECODER
    CELTDecoder *celt_dec;
-   int i, silk_ret=0, celt_ret=0;
+#endif
+   int i, celt_ret=0;
    ec_dec dec;
-   opus_int32 silk_frame_size;
    int pcm_silk_size;
    VARDECL(opus_int16, pcm_silk);
    int pcm_transition_silk_size;
@@ -246,17 +295,26 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    int celt_to_silk=0;
    int c;
    int F2_5, F5, F10, F20;
-   const opus_val16 *window;
+   const opus_val16 *window=NULL;
    opus_uint32 redundant_rng = 0;
    int celt_accum;
+   opus_val32 gain = 0;
+   int fuse_gain = 0;
+   int stride;
    ALLOC_STACK;
 
+#if HAVE_SILK_DECODER
    silk_dec = (char*)st+st->silk_dec_offset;
+#endif
+#if HAVE_CELT_DECODER
    celt_dec = (CELTDecoder*)((char*)st+st->celt_dec_offset);
+#endif
    F20 = st->Fs/50;
    F10 = F20>>1;
    F5 = F10>>1;
    F2_5 = F5>>1;
+   /* Values per sample in pcm: packed output is mono in stereo pairs */
+   stride = st->output_packing ? 2 : st->channels;
    if (frame_size < F2_5)
    {
       RESTORE_STACK;
@@ -285,7 +343,7 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       if (mode == 0)
       {
          /* If we haven't got any packet yet, all we can do is return zeros */
-         for (i=0;i<audiosize*st->channels;i++)
+         for (i=0;i<audiosize*stride;i++)
             pcm[i] = 0;
          RESTORE_STACK;
          return audiosize;
@@ -302,7 +360,7 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
                RESTORE_STACK;
                return ret;
             }
-            pcm += ret*st->channels;
+            pcm += ret*stride;
             audiosize -= ret;
          } while (audiosize > 0);
          RESTORE_STACK;
@@ -334,9 +392,29 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       transition = 1;
       /* Decide where to allocate the stack memory for pcm_transition */
       if (mode == MODE_CELT_ONLY)
-         pcm_transition_celt_size = F5*st->channels;
+         pcm_transition_celt_size = F5*stride;
       else
-         pcm_transition_silk_size = F5*st->channels;
+         pcm_transition_silk_size = F5*stride;
+   }
+
+   if(st->decode_gain)
+   {
+      gain = celt_exp2(MULT16_16_P15(QCONST16(6.48814081e-4f, 25), st->decode_gain));
+#ifdef FIXED_POINT
+      /* Apply the gain in whichever stage writes each output sample last
+         (CELT's deemphasis, or SILK's output for SILK-only frames) instead of
+         in a pass of its own, wherever that comes to exactly what the pass
+         would: nothing may be mixed into a sample after it's scaled.
+         Transitions, redundant frames and the CELT fade-out after hybrid
+         frames are all mixed in over the first 5 ms or the last 2.5 ms of
+         the frame. SILK leaves those unscaled for the pass to finish. CELT
+         scales a frame only if there's none of that, which for hybrid frames
+         isn't known until SILK is done. Frames short enough that SILK and
+         CELT are summed separately take the whole pass, as does a gain so
+         low it rounds to 0, which to CELT and SILK means none. */
+      fuse_gain = !st->gain_pass && gain != 0 &&
+            ((mode == MODE_CELT_ONLY && !transition) || celt_accum);
+#endif
    }
    ALLOC(pcm_transition_celt, pcm_transition_celt_size, opus_val16);
    if (transition && mode == MODE_CELT_ONLY)
@@ -354,13 +432,15 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    }
 
    /* Don't allocate any memory when in CELT-only mode */
-   pcm_silk_size = (mode != MODE_CELT_ONLY && !celt_accum) ? IMAX(F10, frame_size)*st->channels : ALLOC_NONE;
+   pcm_silk_size = (mode != MODE_CELT_ONLY && !celt_accum) ? IMAX(F10, frame_size)*stride : ALLOC_NONE;
    ALLOC(pcm_silk, pcm_silk_size, opus_int16);
 
    /* SILK processing */
+#if HAVE_SILK_DECODER
    if (mode != MODE_CELT_ONLY)
    {
-      int lost_flag, decoded_samples;
+      int lost_flag, decoded_samples, silk_ret;
+      opus_int32 silk_frame_size;
       opus_int16 *pcm_ptr;
 #ifdef FIXED_POINT
       if (celt_accum)
@@ -372,6 +452,10 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       if (st->prev_mode==MODE_CELT_ONLY)
          silk_InitDecoder( silk_dec );
 
+#ifdef FIXED_POINT
+      st->DecControl.outputGain_Q16 = fuse_gain && mode == MODE_SILK_ONLY ? gain : 0;
+#endif
+
       /* The SILK PLC cannot produce frames of less than 10 ms */
       st->DecControl.payloadSize_ms = IMAX(10, 1000 * audiosize / st->Fs);
 
@@ -400,23 +484,29 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
      do {
         /* Call SILK decoder */
         int first_frame = decoded_samples == 0;
+#ifdef FIXED_POINT
+        /* Without a packet there's nothing to mix in */
+        st->DecControl.outputGainFrom = (data != NULL ? F5 : 0) - decoded_samples;
+        st->DecControl.outputGainTo = (data != NULL ? frame_size - F2_5 : frame_size) - decoded_samples;
+#endif
         silk_ret = silk_Decode( silk_dec, &st->DecControl,
                                 lost_flag, first_frame, &dec, pcm_ptr, &silk_frame_size, st->arch );
         if( silk_ret ) {
            if (lost_flag) {
               /* PLC failure should not be fatal */
               silk_frame_size = frame_size;
-              for (i=0;i<frame_size*st->channels;i++)
+              for (i=0;i<frame_size*stride;i++)
                  pcm_ptr[i] = 0;
            } else {
              RESTORE_STACK;
              return OPUS_INTERNAL_ERROR;
            }
         }
-        pcm_ptr += silk_frame_size * st->channels;
+        pcm_ptr += silk_frame_size * stride;
         decoded_samples += silk_frame_size;
       } while( decoded_samples < frame_size );
    }
+#endif
 
    start_band = 0;
    if (!decode_fec && mode != MODE_CELT_ONLY && data != NULL
@@ -447,9 +537,19 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
          /* Shrink decoder because of raw bits */
          dec.storage -= redundancy_bytes;
       }
+#if !HAVE_CELT_DECODER
+      /* The redundant frame is CELT, and only smooths the switch to or from a
+         CELT frame, which without CELT was concealed anyway. */
+      redundancy = 0;
+      celt_to_silk = 0;
+#endif
    }
    if (mode != MODE_CELT_ONLY)
       start_band = 17;
+#ifdef FIXED_POINT
+   if (mode == MODE_HYBRID && (redundancy || transition))
+      fuse_gain = 0;
+#endif
 
    if (redundancy)
    {
@@ -466,6 +566,7 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
    }
 
 
+#if HAVE_CELT_DECODER
    if (bandwidth)
    {
       int endband=21;
@@ -492,11 +593,13 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
       MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_END_BAND(endband)));
    }
    MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_CHANNELS(st->stream_channels)));
+#endif
 
    /* Only allocation memory for redundancy if/when needed */
-   redundant_audio_size = redundancy ? F5*st->channels : ALLOC_NONE;
+   redundant_audio_size = redundancy ? F5*stride : ALLOC_NONE;
    ALLOC(redundant_audio, redundant_audio_size, opus_val16);
 
+#if HAVE_CELT_DECODER
    /* 5 ms redundant frame for CELT->SILK*/
    if (redundancy && celt_to_silk)
    {
@@ -508,43 +611,58 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
 
    /* MUST be after PLC */
    MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_START_BAND(start_band)));
+#else
+   (void)start_band;
+#endif
 
    if (mode != MODE_SILK_ONLY)
    {
+#if HAVE_CELT_DECODER
       int celt_frame_size = IMIN(F20, frame_size);
       /* Make sure to discard any previous CELT state */
       if (mode != st->prev_mode && st->prev_mode > 0 && !st->prev_redundancy)
          MUST_SUCCEED(celt_decoder_ctl(celt_dec, OPUS_RESET_STATE));
-      /* Decode CELT */
+      /* Decode CELT, scaling it on the way out if it has the last word. The
+         redundant frames and the hybrid to SILK fade-out are left unscaled. */
+#ifdef FIXED_POINT
+      MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_OUTPUT_GAIN(fuse_gain ? gain : 0)));
+#endif
       celt_ret = celt_decode_with_ec(celt_dec, decode_fec ? NULL : data,
                                      len, pcm, celt_frame_size, &dec, celt_accum);
+#ifdef FIXED_POINT
+      MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_OUTPUT_GAIN(0)));
+#endif
+#endif
    } else {
-      unsigned char silence[2] = {0xFF, 0xFF};
       if (!celt_accum)
       {
-         for (i=0;i<frame_size*st->channels;i++)
+         for (i=0;i<frame_size*stride;i++)
             pcm[i] = 0;
       }
+#if HAVE_CELT_DECODER
       /* For hybrid -> SILK transitions, we let the CELT MDCT
          do a fade-out by decoding a silence frame */
       if (st->prev_mode == MODE_HYBRID && !(redundancy && celt_to_silk && st->prev_redundancy) )
       {
+         unsigned char silence[2] = {0xFF, 0xFF};
          MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_SET_START_BAND(0)));
          celt_decode_with_ec(celt_dec, silence, 2, pcm, F2_5, NULL, celt_accum);
       }
+#endif
    }
 
    if (mode != MODE_CELT_ONLY && !celt_accum)
    {
 #ifdef FIXED_POINT
-      for (i=0;i<frame_size*st->channels;i++)
+      for (i=0;i<frame_size*stride;i++)
          pcm[i] = SAT16(ADD32(pcm[i], pcm_silk[i]));
 #else
-      for (i=0;i<frame_size*st->channels;i++)
+      for (i=0;i<frame_size*stride;i++)
          pcm[i] = pcm[i] + (opus_val16)((1.f/32768.f)*pcm_silk[i]);
 #endif
    }
 
+#if HAVE_CELT_DECODER
    {
       const CELTMode *celt_mode;
       MUST_SUCCEED(celt_decoder_ctl(celt_dec, CELT_GET_MODE(&celt_mode)));
@@ -559,28 +677,29 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
 
       celt_decode_with_ec(celt_dec, data+len, redundancy_bytes, redundant_audio, F5, NULL, 0);
       MUST_SUCCEED(celt_decoder_ctl(celt_dec, OPUS_GET_FINAL_RANGE(&redundant_rng)));
-      smooth_fade(pcm+st->channels*(frame_size-F2_5), redundant_audio+st->channels*F2_5,
-                  pcm+st->channels*(frame_size-F2_5), F2_5, st->channels, window, st->Fs);
+      smooth_fade(pcm+stride*(frame_size-F2_5), redundant_audio+stride*F2_5,
+                  pcm+stride*(frame_size-F2_5), F2_5, stride, window, st->Fs);
    }
+#endif
    if (redundancy && celt_to_silk)
    {
-      for (c=0;c<st->channels;c++)
+      for (c=0;c<stride;c++)
       {
          for (i=0;i<F2_5;i++)
-            pcm[st->channels*i+c] = redundant_audio[st->channels*i+c];
+            pcm[stride*i+c] = redundant_audio[stride*i+c];
       }
-      smooth_fade(redundant_audio+st->channels*F2_5, pcm+st->channels*F2_5,
-                  pcm+st->channels*F2_5, F2_5, st->channels, window, st->Fs);
+      smooth_fade(redundant_audio+stride*F2_5, pcm+stride*F2_5,
+                  pcm+stride*F2_5, F2_5, stride, window, st->Fs);
    }
    if (transition)
    {
       if (audiosize >= F5)
       {
-         for (i=0;i<st->channels*F2_5;i++)
+         for (i=0;i<stride*F2_5;i++)
             pcm[i] = pcm_transition[i];
-         smooth_fade(pcm_transition+st->channels*F2_5, pcm+st->channels*F2_5,
-                     pcm+st->channels*F2_5, F2_5,
-                     st->channels, window, st->Fs);
+         smooth_fade(pcm_transition+stride*F2_5, pcm+stride*F2_5,
+                     pcm+stride*F2_5, F2_5,
+                     stride, window, st->Fs);
       } else {
          /* Not enough time to do a clean transition, but we do it anyway
             This will not preserve amplitude perfectly and may introduce
@@ -589,20 +708,17 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
             transition it pretty silly in the first place */
          smooth_fade(pcm_transition, pcm,
                      pcm, F2_5,
-                     st->channels, window, st->Fs);
+                     stride, window, st->Fs);
       }
    }
 
-   if(st->decode_gain)
+   if(st->decode_gain && !fuse_gain)
+      apply_gain(pcm, frame_size*stride, gain);
+   else if (fuse_gain && mode == MODE_SILK_ONLY && data != NULL)
    {
-      opus_val32 gain;
-      gain = celt_exp2(MULT16_16_P15(QCONST16(6.48814081e-4f, 25), st->decode_gain));
-      for (i=0;i<frame_size*st->channels;i++)
-      {
-         opus_val32 x;
-         x = MULT16_32_P16(pcm[i],gain);
-         pcm[i] = SATURATE(x, 32767);
-      }
+      /* What SILK left unscaled, now that it's been mixed */
+      apply_gain(pcm, F5*stride, gain);
+      apply_gain(pcm+(frame_size-F2_5)*stride, F2_5*stride, gain);
    }
 
    if (len <= 1)
@@ -615,7 +731,7 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
 
    if (celt_ret>=0)
    {
-      if (OPUS_CHECK_ARRAY(pcm, audiosize*st->channels))
+      if (OPUS_CHECK_ARRAY(pcm, audiosize*stride))
          OPUS_PRINT_INT(audiosize);
    }
 
@@ -624,7 +740,7 @@ static int opus_decode_frame(OpusDecoder *st, const unsigned char *data,
 
 }
 
-int opus_decode_native(OpusDecoder *st, const unsigned char *data,
+static int opus_decode_packet(OpusDecoder *st, const unsigned char *data,
       opus_int32 len, opus_val16 *pcm, int frame_size, int decode_fec,
       int self_delimited, opus_int32 *packet_offset, int soft_clip)
 {
@@ -634,6 +750,7 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
    int packet_frame_size, packet_bandwidth, packet_mode, packet_stream_channels;
    /* 48 x 2.5 ms = 120 ms */
    opus_int16 size[48];
+   int stride = st->output_packing ? 2 : st->channels;
    VALIDATE_OPUS_DECODER(st);
    if (decode_fec<0 || decode_fec>1)
       return OPUS_BAD_ARG;
@@ -645,13 +762,13 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
       int pcm_count=0;
       do {
          int ret;
-         ret = opus_decode_frame(st, NULL, 0, pcm+pcm_count*st->channels, frame_size-pcm_count, 0);
+         ret = opus_decode_frame(st, NULL, 0, pcm+pcm_count*stride, frame_size-pcm_count, 0);
          if (ret<0)
             return ret;
          pcm_count += ret;
       } while (pcm_count < frame_size);
       celt_assert(pcm_count == frame_size);
-      if (OPUS_CHECK_ARRAY(pcm, pcm_count*st->channels))
+      if (OPUS_CHECK_ARRAY(pcm, pcm_count*stride))
          OPUS_PRINT_INT(pcm_count);
       st->last_packet_duration = pcm_count;
       return pcm_count;
@@ -670,6 +787,21 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
 
    data += offset;
 
+   if (!opus_decoder_has_mode(packet_mode))
+   {
+      /* A core this build lacks: give up on the packet, or conceal it (for as
+         long as it lasts, or as FEC would have) as though it was lost */
+      if (!st->conceal_unsupported)
+         return OPUS_UNIMPLEMENTED;
+      if (!decode_fec)
+      {
+         if (count*packet_frame_size > frame_size)
+            return OPUS_BUFFER_TOO_SMALL;
+         frame_size = count*packet_frame_size;
+      }
+      return opus_decode_native(st, NULL, 0, pcm, frame_size, 0, 0, NULL, soft_clip);
+   }
+
    if (decode_fec)
    {
       int duration_copy;
@@ -694,12 +826,12 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
       st->bandwidth = packet_bandwidth;
       st->frame_size = packet_frame_size;
       st->stream_channels = packet_stream_channels;
-      ret = opus_decode_frame(st, data, size[0], pcm+st->channels*(frame_size-packet_frame_size),
+      ret = opus_decode_frame(st, data, size[0], pcm+stride*(frame_size-packet_frame_size),
             packet_frame_size, 1);
       if (ret<0)
          return ret;
       else {
-         if (OPUS_CHECK_ARRAY(pcm, frame_size*st->channels))
+         if (OPUS_CHECK_ARRAY(pcm, frame_size*stride))
             OPUS_PRINT_INT(frame_size);
          st->last_packet_duration = frame_size;
          return frame_size;
@@ -719,25 +851,60 @@ int opus_decode_native(OpusDecoder *st, const unsigned char *data,
    for (i=0;i<count;i++)
    {
       int ret;
-      ret = opus_decode_frame(st, data, size[i], pcm+nb_samples*st->channels, frame_size-nb_samples, 0);
+      ret = opus_decode_frame(st, data, size[i], pcm+nb_samples*stride, frame_size-nb_samples, 0);
       if (ret<0)
          return ret;
       celt_assert(ret==packet_frame_size);
       data += size[i];
+      /* Trim OPUS_SET_SKIP_SAMPLES off the front. Frames that are dropped
+         whole are simply decoded over by the next one, so only the frame
+         the trim ends in gets moved. */
+      if (st->skip_samples >= ret)
+      {
+         st->skip_samples -= ret;
+         continue;
+      } else if (st->skip_samples > 0)
+      {
+         OPUS_MOVE(pcm+nb_samples*stride, pcm+(nb_samples+st->skip_samples)*stride,
+                   (ret-st->skip_samples)*stride);
+         ret -= st->skip_samples;
+         st->skip_samples = 0;
+      }
       nb_samples += ret;
    }
-   st->last_packet_duration = nb_samples;
-   if (OPUS_CHECK_ARRAY(pcm, nb_samples*st->channels))
+   st->last_packet_duration = count*packet_frame_size;
+   if (OPUS_CHECK_ARRAY(pcm, nb_samples*stride))
       OPUS_PRINT_INT(nb_samples);
 #ifndef FIXED_POINT
    if (soft_clip)
-      opus_pcm_soft_clip(pcm, nb_samples, st->channels, st->softclip_mem);
+      opus_pcm_soft_clip(pcm, nb_samples, stride, st->softclip_mem);
    else
       st->softclip_mem[0]=st->softclip_mem[1]=0;
 #endif
    return nb_samples;
 }
 
+int opus_decode_native(OpusDecoder *st, const unsigned char *data,
+      opus_int32 len, opus_val16 *pcm, int frame_size, int decode_fec,
+      int self_delimited, opus_int32 *packet_offset, int soft_clip)
+{
+#ifdef SCRATCH_ARENA
+   /* Everything below takes its temporaries from the decoder's arena, which
+      starts the call empty. Running out of it doesn't fail the call: what
+      doesn't fit goes on the stack, and the arena's peak records it. */
+   opus_scratch_state saved;
+   int ret;
+   opus_scratch_enter(st->scratch, &saved);
+   ret = opus_decode_packet(st, data, len, pcm, frame_size, decode_fec,
+         self_delimited, packet_offset, soft_clip);
+   opus_scratch_leave(&saved);
+   return ret;
+#else
+   return opus_decode_packet(st, data, len, pcm, frame_size, decode_fec,
+         self_delimited, packet_offset, soft_clip);
+#endif
+}
+
 #ifdef FIXED_POINT
 
 int opus_decode(OpusDecoder *st, const unsigned char *data,
@@ -755,6 +922,7 @@ int opus_decode_float(OpusDecoder *st, const unsigned char *data,
    VARDECL(opus_int16, out);
    int ret, i;
    int nb_samples;
+   int stride = st->output_packing ? 2 : st->channels;
    ALLOC_STACK;
 
    if(frame_size<=0)
@@ -771,12 +939,12 @@ int opus_decode_float(OpusDecoder *st, const unsigned char *data,
          return OPUS_INVALID_PACKET;
    }
    celt_assert(st->channels == 1 || st->channels == 2);
-   ALLOC(out, frame_size*st->channels, opus_int16);
+   ALLOC(out, frame_size*stride, opus_int16);
 
    ret = opus_decode_native(st, data, len, out, frame_size, decode_fec, 0, NULL, 0);
    if (ret > 0)
    {
-      for (i=0;i<ret*st->channels;i++)
+      for (i=0;i<ret*stride;i++)
          pcm[i] = (1.f/32768.f)*(out[i]);
    }
    RESTORE_STACK;
@@ -835,11 +1003,11 @@ int opus_decoder_ctl(OpusDecoder *st, int request, ...)
 {
    int ret = OPUS_OK;
    va_list ap;
-   void *silk_dec;
+#if HAVE_CELT_DECODER
    CELTDecoder *celt_dec;
 
-   silk_dec = (char*)st+st->silk_dec_offset;
    celt_dec = (CELTDecoder*)((char*)st+st->celt_dec_offset);
+#endif
 
 
    va_start(ap, request);
@@ -872,8 +1040,12 @@ int opus_decoder_ctl(OpusDecoder *st, int request, ...)
             sizeof(OpusDecoder)-
             ((char*)&st->OPUS_DECODER_RESET_START - (char*)st));
 
+#if HAVE_CELT_DECODER
       celt_decoder_ctl(celt_dec, OPUS_RESET_STATE);
-      silk_InitDecoder( silk_dec );
+#endif
+#if HAVE_SILK_DECODER
+      silk_InitDecoder( (char*)st+st->silk_dec_offset );
+#endif
       st->stream_channels = st->channels;
       st->frame_size = st->Fs/400;
    }
@@ -895,9 +1067,11 @@ int opus_decoder_ctl(OpusDecoder *st, int request, ...)
       {
          goto bad_arg;
       }
+#if HAVE_CELT_DECODER
       if (st->prev_mode == MODE_CELT_ONLY)
          ret = celt_decoder_ctl(celt_dec, OPUS_GET_PITCH(value));
       else
+#endif
          *value = st->DecControl.prevPitchLag;
    }
    break;
@@ -911,6 +1085,137 @@ int opus_decoder_ctl(OpusDecoder *st, int request, ...)
       *value = st->decode_gain;
    }
    break;
+   case OPUS_GET_SKIP_SAMPLES_REQUEST:
+   {
+      opus_int32 *value = va_arg(ap, opus_int32*);
+      if (!value)
+      {
+         goto bad_arg;
+      }
+      *value = st->skip_samples;
+   }
+   break;
+   case OPUS_SET_SKIP_SAMPLES_REQUEST:
+   {
+       opus_int32 value = va_arg(ap, opus_int32);
+       if (value<0)
+       {
+          goto bad_arg;
+       }
+       st->skip_samples = value;
+   }
+   break;
+   case OPUS_GET_OUTPUT_PACKING_REQUEST:
+   {
+      opus_int32 *value = va_arg(ap, opus_int32*);
+      if (!value)
+      {
+         goto bad_arg;
+      }
+      *value = st->output_packing;
+   }
+   break;
+   case OPUS_SET_OUTPUT_PACKING_REQUEST:
+   {
+       opus_int32 value = va_arg(ap, opus_int32);
+#ifdef FIXED_POINT
+       if (value<OPUS_PACKING_NONE || value>OPUS_PACKING_RIGHT || (value && st->channels!=1))
+       {
+          goto bad_arg;
+       }
+       st->output_packing = value;
+       st->DecControl.outputPacking = value;
+#if HAVE_CELT_DECODER
+       ret = celt_decoder_ctl(celt_dec, CELT_SET_OUTPUT_PACKING(value));
+#endif
+#else
+       if (value != OPUS_PACKING_NONE)
+       {
+          goto bad_arg;
+       }
+#endif
+   }
+   break;
+   case OPUS_SET_SCRATCH_ARENA_REQUEST:
+   {
+       OpusScratchArena *value = va_arg(ap, OpusScratchArena*);
+#ifdef SCRATCH_ARENA
+       st->scratch = value;
+#else
+       (void)value;
+       ret = OPUS_UNIMPLEMENTED;
+#endif
+   }
+   break;
+   case OPUS_GET_SCRATCH_PEAK_REQUEST:
+   {
+      opus_int32 *value = va_arg(ap, opus_int32*);
+      if (!value)
+      {
+         goto bad_arg;
+      }
+      *value = st->scratch ? st->scratch->peak : 0;
+   }
+   break;
+   case OPUS_SET_CONCEAL_UNSUPPORTED_REQUEST:
+   {
+       opus_int32 value = va_arg(ap, opus_int32);
+       if(value<0 || value>1)
+       {
+          goto bad_arg;
+       }
+       st->conceal_unsupported = value;
+   }
+   break;
+   case OPUS_GET_CONCEAL_UNSUPPORTED_REQUEST:
+   {
+      opus_int32 *value = va_arg(ap, opus_int32*);
+      if (!value)
+      {
+         goto bad_arg;
+      }
+      *value = st->conceal_unsupported;
+   }
+   break;
+   case OPUS_SET_DECIMATED_SYNTHESIS_REQUEST:
+   {
+       opus_int32 value = va_arg(ap, opus_int32);
+       if(value<0 || value>1)
+       {
+          goto bad_arg;
+       }
+#if HAVE_CELT_DECODER
+       ret = celt_decoder_ctl(celt_dec, CELT_SET_DECIMATED_SYNTHESIS(value));
+#else
+       if (value)
+          ret = OPUS_UNIMPLEMENTED;
+#endif
+   }
+   break;
+   case OPUS_GET_DECIMATED_SYNTHESIS_REQUEST:
+   {
+      opus_int32 *value = va_arg(ap, opus_int32*);
+      if (!value)
+      {
+         goto bad_arg;
+      }
+#if HAVE_CELT_DECODER
+      ret = celt_decoder_ctl(celt_dec, CELT_GET_DECIMATED_SYNTHESIS(value));
+#else
+      *value = 0;
+#endif
+   }
+   break;
+   case OPUS_SET_GAIN_PASS_REQUEST:
+   {
+       opus_int32 value = va_arg(ap, opus_int32);
+       if (value<0 || value>1)
+       {
+          goto bad_arg;
+       }
+       st->gain_pass = value;
+   }
+   break;
    case OPUS_SET_GAIN_REQUEST:
    {
        opus_int32 value = va_arg(ap, opus_int32);
@@ -938,7 +1243,9 @@ int opus_decoder_ctl(OpusDecoder *st, int request, ...)
        {
           goto bad_arg;
        }
+#if HAVE_CELT_DECODER
        ret = celt_decoder_ctl(celt_dec, OPUS_SET_PHASE_INVERSION_DISABLED(value));
+#endif
    }
    break;
    case OPUS_GET_PHASE_INVERSION_DISABLED_REQUEST:
@@ -948,7 +1255,12 @@ int opus_decoder_ctl(OpusDecoder *st, int request, ...)
        {
           goto bad_arg;
        }
+#if HAVE_CELT_DECODER
        ret = celt_decoder_ctl(celt_dec, OPUS_GET_PHASE_INVERSION_DISABLED(value));
+#else
+       /* Only CELT inverts the phase of anything */
+       *value = 0;
+#endif
    }
    break;
    default:
@@ -169,6 +169,16 @@ extern "C" {
 #define OPUS_SET_PHASE_INVERSION_DISABLED_REQUEST 4046
 #define OPUS_GET_PHASE_INVERSION_DISABLED_REQUEST 4047
 #define OPUS_GET_IN_DTX_REQUEST              4049
+#define OPUS_SET_SKIP_SAMPLES_REQUEST        4050
+#define OPUS_GET_SKIP_SAMPLES_REQUEST        4051
+#define OPUS_SET_OUTPUT_PACKING_REQUEST      4052
+#define OPUS_GET_OUTPUT_PACKING_REQUEST      4053
+#define OPUS_SET_SCRATCH_ARENA_REQUEST       4054
+#define OPUS_GET_SCRATCH_PEAK_REQUEST        4055
+#define OPUS_SET_CONCEAL_UNSUPPORTED_REQUEST 4056
+#define OPUS_GET_CONCEAL_UNSUPPORTED_REQUEST 4057
+#define OPUS_SET_DECIMATED_SYNTHESIS_REQUEST 4058
+#define OPUS_GET_DECIMATED_SYNTHESIS_REQUEST 4059
 
 /** Defines for the presence of extended APIs. */
 #define OPUS_HAVE_OPUS_PROJECTION_H
@@ -178,6 +188,7 @@ extern "C" {
 #define __opus_check_int_ptr(ptr) ((ptr) + ((ptr) - (opus_int32*)(ptr)))
 #define __opus_check_uint_ptr(ptr) ((ptr) + ((ptr) - (opus_uint32*)(ptr)))
 #define __opus_check_val16_ptr(ptr) ((ptr) + ((ptr) - (opus_val16*)(ptr)))
+#define __opus_check_scratch_ptr(ptr) ((ptr) + ((ptr) - (OpusScratchArena*)(ptr)))
 /** @endcond */
 
 /** @defgroup opus_ctlvalues Pre-defined values for CTL interface
@@ -217,6 +228,11 @@ extern "C" {
 #define OPUS_FRAMESIZE_100_MS                5008 /**< Use 100 ms frames */
 #define OPUS_FRAMESIZE_120_MS                5009 /**< Use 120 ms frames */
 
+#define OPUS_PACKING_NONE                    0 /**< Plain mono output @hideinitializer*/
+#define OPUS_PACKING_BOTH                    1 /**< Mono into both halves of each stereo pair @hideinitializer*/
+#define OPUS_PACKING_LEFT                    2 /**< Mono into the left half, right half zero @hideinitializer*/
+#define OPUS_PACKING_RIGHT                   3 /**< Mono into the right half, left half zero @hideinitializer*/
+
 /**@}*/
 
 
@@ -729,6 +745,15 @@ extern "C" {
 
 /**@}*/
 
+/** Memory a decoder's temporaries come from, for #OPUS_SET_SCRATCH_ARENA.
+  * Fill in base and size, zero peak, and leave the rest alone.
+  */
+typedef struct OpusScratchArena {
+   unsigned char *base;    /**< The memory, aligned to 8 bytes. */
+   opus_int32     size;    /**< Its size in bytes. */
+   opus_int32     peak;    /**< Most bytes any call has needed. Kept up to date by the decoder. */
+} OpusScratchArena;
+
 /** @defgroup opus_decoderctls Decoder related CTLs
   * @see opus_genericctls, opus_encoderctls, opus_decoder
   * @{
@@ -751,6 +776,97 @@ extern "C" {
   * @hideinitializer */
 #define OPUS_GET_GAIN(x) OPUS_GET_GAIN_REQUEST, __opus_check_int_ptr(x)
 
+/** Drops the given number of samples from the front of the decoded output.
+  * Meant for the pre-skip of an Ogg Opus stream: trimming happens as packets
+  * are decoded, so the first ones may return fewer samples than they hold,
+  * or none at all. Concealed (PLC) audio is not trimmed. Counts samples per
+  * channel at the decoder's sampling rate. Cleared by OPUS_RESET_STATE.
+  * @param[in] x <tt>opus_int32</tt>: Number of samples to drop.
+  * @hideinitializer */
+#define OPUS_SET_SKIP_SAMPLES(x) OPUS_SET_SKIP_SAMPLES_REQUEST, __opus_check_int(x)
+/** Gets how many samples are still to be dropped. @see OPUS_SET_SKIP_SAMPLES
+  * @param[out] x <tt>opus_int32 *</tt>: Number of samples still to drop.
+  * @hideinitializer */
+#define OPUS_GET_SKIP_SAMPLES(x) OPUS_GET_SKIP_SAMPLES_REQUEST, __opus_check_int_ptr(x)
+
+/** Has a mono decoder write its output as interleaved 16-bit stereo pairs,
+  * ready for an I2S peripheral, instead of plain mono. The packing is done as
+  * each sample is saturated to 16 bits, so it costs no extra pass. The pcm
+  * buffer must then hold two values per sample, although frame_size and the
+  * return value still count samples per channel. Fixed-point only, and
+  * mono decoders only; returns OPUS_BAD_ARG otherwise. Survives decoder reset.
+  * <dl>
+  * <dt>#OPUS_PACKING_NONE</dt>  <dd>Plain mono output (default).</dd>
+  * <dt>#OPUS_PACKING_BOTH</dt>  <dd>The same sample in left and right.</dd>
+  * <dt>#OPUS_PACKING_LEFT</dt>  <dd>The sample on the left, silence on the right.</dd>
+  * <dt>#OPUS_PACKING_RIGHT</dt> <dd>Silence on the left, the sample on the right.</dd>
+  * </dl>
+  * @param[in] x <tt>opus_int32</tt>: One of the values above.
+  * @hideinitializer */
+#define OPUS_SET_OUTPUT_PACKING(x) OPUS_SET_OUTPUT_PACKING_REQUEST, __opus_check_int(x)
+/** Gets the decoder's output packing. @see OPUS_SET_OUTPUT_PACKING
+  * @param[out] x <tt>opus_int32 *</tt>: One of the OPUS_PACKING_ values.
+  * @hideinitializer */
+#define OPUS_GET_OUTPUT_PACKING(x) OPUS_GET_OUTPUT_PACKING_REQUEST, __opus_check_int_ptr(x)
+
+/** Has the decoder take its temporaries from an arena instead of the stack.
+  * Only in a library built with SCRATCH_ARENA; returns OPUS_UNIMPLEMENTED
+  * otherwise. For each call to opus_decode() the arena is handed out from the
+  * bottom up, and it's all free again once the call returns, so one arena can
+  * serve any number of decoders, as long as only one of them decodes at a time.
+  * The arena's peak records the most any call has needed. If a call needs more
+  * than there is, what doesn't fit goes on the stack, and the call decodes and
+  * returns as usual; the peak, now above the size, says how big the arena has
+  * to be. The stack must still have room for that, so an arena saves stack only
+  * where it's known to be big enough for every call.
+  * Cleared by opus_decoder_init(), but survives decoder reset. Pass NULL to go
+  * back to the stack.
+  * @param[in] x <tt>OpusScratchArena *</tt>: The arena, which must outlive its use.
+  * @hideinitializer */
+#define OPUS_SET_SCRATCH_ARENA(x) OPUS_SET_SCRATCH_ARENA_REQUEST, __opus_check_scratch_ptr(x)
+/** Gets the most of its arena (in bytes) any decode call has used, with
+  * every decoder sharing it counted. 0 if the decoder has no arena.
+  * @see OPUS_SET_SCRATCH_ARENA
+  * @param[out] x <tt>opus_int32 *</tt>: Peak use in bytes.
+  * @hideinitializer */
+#define OPUS_GET_SCRATCH_PEAK(x) OPUS_GET_SCRATCH_PEAK_REQUEST, __opus_check_int_ptr(x)
+
+/** Has a decoder built with only one core (see OPUS_DECODER_CORES in opus.h)
+  * conceal packets that need the other one, as if they had been lost, instead
+  * of returning #OPUS_UNIMPLEMENTED for them. Concealing still returns the
+  * packet's duration, so the stream keeps its timing. A decoder with both cores
+  * decodes every packet and ignores this. Cleared by opus_decoder_init(), but
+  * survives decoder reset.
+  * @param[in] x <tt>opus_int32</tt>: 1 to conceal, 0 to fail (default).
+  * @hideinitializer */
+#define OPUS_SET_CONCEAL_UNSUPPORTED(x) OPUS_SET_CONCEAL_UNSUPPORTED_REQUEST, __opus_check_int(x)
+/** Gets whether packets the decoder can't decode are concealed.
+  * @see OPUS_SET_CONCEAL_UNSUPPORTED
+  * @param[out] x <tt>opus_int32 *</tt>: 1 or 0.
+  * @hideinitializer */
+#define OPUS_GET_CONCEAL_UNSUPPORTED(x) OPUS_GET_CONCEAL_UNSUPPORTED_REQUEST, __opus_check_int_ptr(x)
+
+/** Has a decoder running below 48 kHz do its CELT synthesis at its own rate:
+  * a smaller inverse MDCT over the bands it can play, with the postfilter and
+  * de-emphasis redesigned for that rate, instead of a full 48 kHz synthesis
+  * that is then decimated. This is cheaper, but it is a lower quality mode,
+  * neither bit-exact nor conformant: scored against the 48 kHz decode as
+  * opus_compare does, it gets Q 88, 75, 65 and 49 at 24, 16, 12 and 8 kHz,
+  * where the exact path gets 95, 91, 86 and 78 (pc_testbed decimate). Only
+  * in a fixed-point library built with DECIMATED_SYNTHESIS; returns
+  * #OPUS_UNIMPLEMENTED otherwise. Ignored at 48 kHz. Changing it
+  * resets the CELT history, so it's best set before the first packet.
+  * Cleared by opus_decoder_init(), but survives decoder reset.
+  * @param[in] x <tt>opus_int32</tt>: 1 to synthesize at the output rate, 0 for
+  *                                   the exact path (default).
+  * @hideinitializer */
+#define OPUS_SET_DECIMATED_SYNTHESIS(x) OPUS_SET_DECIMATED_SYNTHESIS_REQUEST, __opus_check_int(x)
+/** Gets whether CELT synthesis runs at the output rate; 0 at 48 kHz.
+  * @see OPUS_SET_DECIMATED_SYNTHESIS
+  * @param[out] x <tt>opus_int32 *</tt>: 1 or 0.
+  * @hideinitializer */
+#define OPUS_GET_DECIMATED_SYNTHESIS(x) OPUS_GET_DECIMATED_SYNTHESIS_REQUEST, __opus_check_int_ptr(x)
+
 /** Gets the duration (in samples) of the last packet successfully decoded or concealed.
   * @param[out] x <tt>opus_int32 *</tt>: Number of samples (at current sampling rate).
   * @hideinitializer */
@@ -132,6 +132,11 @@ typedef void (*opus_copy_channel_out_func)(
 #define OPUS_SET_FORCE_MODE_REQUEST    11002
 #define OPUS_SET_FORCE_MODE(x) OPUS_SET_FORCE_MODE_REQUEST, __opus_check_int(x)
 
+/* Applies OPUS_SET_GAIN in a pass over each decoded frame, as libopus does,
+   rather than as the output is written. For checking one against the other. */
+#define OPUS_SET_GAIN_PASS_REQUEST     11004
+#define OPUS_SET_GAIN_PASS(x) OPUS_SET_GAIN_PASS_REQUEST, __opus_check_int(x)
+
 typedef void (*downmix_func)(const void *, opus_val32 *, int, int, int, int, int);
 void downmix_float(const void *_x, opus_val32 *sub, int subframe, int offset, int c1, int c2, int C);
 void downmix_int(const void *_x, opus_val32 *sub, int subframe, int offset, int c1, int c2, int C);
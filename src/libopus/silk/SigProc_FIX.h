@@ -47,6 +47,10 @@ extern "C"
 #include "x86/SigProc_FIX_sse.h"
 #endif
 
+#if defined(OPUS_ARM_INLINE_MEDIA)
+#include "arm/LPC_analysis_filter_cm4.h"
+#endif
+
 #if (defined(OPUS_ARM_ASM) || defined(OPUS_ARM_MAY_HAVE_NEON_INTR))
 #include "arm/biquad_alt_arm.h"
 #include "arm/LPC_inv_pred_gain_arm.h"
@@ -76,6 +80,17 @@ opus_int silk_resampler(
     opus_int32                  inLen               /* I    Number of input samples                                     */
 );
 
+/*!
+ * Resampler, writing the output as stage says (packed, scaled); a NULL stage is silk_resampler()
+ */
+opus_int silk_resampler_out(
+    silk_resampler_state_struct *S,                 /* I/O  Resampler state                                             */
+    opus_int16                  out[],              /* O    Output signal                                               */
+    const opus_int16            in[],               /* I    Input signal                                                */
+    opus_int32                  inLen,              /* I    Number of input samples                                     */
+    const silk_resampler_output_struct *stage       /* I    Output stage, or NULL                                       */
+);
+
 /*!
 * Downsample 2x, mediocre quality
 */
@@ -120,7 +135,7 @@ void silk_biquad_alt_stride2_c(
 );
 
 /* Variable order MA prediction error filter. */
-void silk_LPC_analysis_filter(
+void silk_LPC_analysis_filter_c(
     opus_int16                  *out,               /* O    Output signal                                               */
     const opus_int16            *in,                /* I    Input signal                                                */
     const opus_int16            *B,                 /* I    MA prediction coefficients, Q12 [order]                     */
@@ -129,6 +144,11 @@ void silk_LPC_analysis_filter(
     int                         arch                /* I    Run-time architecture                                       */
 );
 
+#if !defined(OVERRIDE_silk_LPC_analysis_filter)
+#define silk_LPC_analysis_filter(out, in, B, len, d, arch) \
+    (silk_LPC_analysis_filter_c(out, in, B, len, d, arch))
+#endif
+
 /* Chirp (bandwidth expand) LP AR filter */
 void silk_bwexpander(
     opus_int16                  *ar,                /* I/O  AR filter to be expanded (without leading 1)                */
@@ -633,6 +653,15 @@ static OPUS_INLINE opus_int64 silk_max_64(opus_int64 a, opus_int64 b)
 #include "mips/sigproc_fix_mipsr1.h"
 #endif
 
+/* Decoder output gain, rounded and saturated the same way as the Opus decoder's gain stage */
+static OPUS_INLINE opus_int16 silk_output_gain(
+    opus_int16                  x,                  /* I    Sample                                                      */
+    opus_int32                  gain_Q16            /* I    Gain, Q16                                                   */
+)
+{
+    return (opus_int16)silk_LIMIT( silk_RSHIFT_ROUND64( silk_SMULL( x, gain_Q16 ), 16 ), -32767, 32767 );
+}
+
 
 #ifdef  __cplusplus
 }
@@ -0,0 +1,100 @@
+/***********************************************************************
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+- Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+- Neither the name of Internet Society, IETF or IETF Trust, nor the
+names of specific contributors, may be used to endorse or promote
+products derived from this software without specific prior written
+permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* Cortex-M4 version of the LPC analysis filter */
+
+//#ifdef HAVE_CONFIG_H
+#include "../../config.h"
+//#endif
+
+#include "../SigProc_FIX.h"
+
+#if defined(OPUS_ARM_INLINE_MEDIA)
+
+#include "../../celt/arm/cm4_dsp.h"
+
+/* The prediction error of one output: the taps' dot product, wrapping as in
+   silk_LPC_analysis_filter_c(), subtracted from the input in Q12 */
+static OPUS_INLINE opus_int16 silk_LPC_residual_cm4(
+    opus_int32                  in_Q0,
+    opus_int32                  pred_Q12
+)
+{
+    opus_int32 out32_Q12;
+
+    out32_Q12 = silk_SUB32_ovflw( silk_LSHIFT( in_Q0, 12 ), pred_Q12 );
+    return (opus_int16)cm4_ssat16( silk_RSHIFT_ROUND( out32_Q12, 12 ) );
+}
+
+/* silk_LPC_analysis_filter_c() two taps and two outputs at a time. For output
+   ix, the word at in[ ix - 2 - j ] holds the pair that B[ j ] and B[ j + 1 ]
+   weigh in reverse order, so SMLADX takes both taps at once. For output ix + 1
+   the pair is a halfword later, and PKHBT makes it from the word just loaded
+   and the one before, so each tap pair costs two loads for two outputs. */
+void silk_LPC_analysis_filter_cm4(
+    opus_int16                  *out,               /* O    Output signal                                               */
+    const opus_int16            *in,                /* I    Input signal                                                */
+    const opus_int16            *B,                 /* I    MA prediction coefficients, Q12 [order]                     */
+    const opus_int32            len,                /* I    Signal length                                               */
+    const opus_int32            d                   /* I    Filter order                                                */
+)
+{
+    opus_int   ix, j;
+    opus_int32 acc0, acc1, B01, in_hi, in_lo;
+
+    celt_assert( d >= 6 );
+    celt_assert( (d & 1) == 0 );
+    celt_assert( d <= len );
+
+    for( ix = d; ix < len - 1; ix += 2 ) {
+        acc0 = 0;
+        acc1 = 0;
+        in_hi = cm4_ld16x2( &in[ ix ] );
+        for( j = 0; j < d; j += 2 ) {
+            B01   = cm4_ld16x2( &B[ j ] );
+            in_lo = cm4_ld16x2( &in[ ix - 2 - j ] );
+            /* B[ j ] * in[ ix - 1 - j ] + B[ j + 1 ] * in[ ix - 2 - j ] */
+            acc0  = cm4_smladx( B01, in_lo, acc0 );
+            /* B[ j ] * in[ ix - j ] + B[ j + 1 ] * in[ ix - 1 - j ] */
+            acc1  = cm4_smlad( B01, cm4_pkhbt( in_hi, in_lo ), acc1 );
+            in_hi = in_lo;
+        }
+        out[ ix ]     = silk_LPC_residual_cm4( in[ ix ], acc0 );
+        out[ ix + 1 ] = silk_LPC_residual_cm4( in[ ix + 1 ], acc1 );
+    }
+    if( ix < len ) {
+        acc0 = 0;
+        for( j = 0; j < d; j += 2 ) {
+            acc0 = cm4_smladx( cm4_ld16x2( &B[ j ] ), cm4_ld16x2( &in[ ix - 2 - j ] ), acc0 );
+        }
+        out[ ix ] = silk_LPC_residual_cm4( in[ ix ], acc0 );
+    }
+
+    /* Set first d output samples to zero */
+    silk_memset( out, 0, d * sizeof( opus_int16 ) );
+}
+
+#endif
@@ -0,0 +1,55 @@
+/***********************************************************************
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+- Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+- Neither the name of Internet Society, IETF or IETF Trust, nor the
+names of specific contributors, may be used to endorse or promote
+products derived from this software without specific prior written
+permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* SigProc_FIX.h's remaining multiply and saturation macros on the ARMv5E DSP
+   and ARMv6 media instructions */
+
+#ifndef SILK_SIGPROC_FIX_ARMv5E_H
+#define SILK_SIGPROC_FIX_ARMv5E_H
+
+#include "../../celt/arm/cm4_dsp.h"
+
+/* ((a32 >> 16)  * (b32 >> 16)) output have to be 32bit int */
+#undef silk_SMULTT
+#define silk_SMULTT(a32, b32)               (cm4_smultt(a32, b32))
+
+/* a32 + ((a32 >> 16)  * (b32 >> 16)) output have to be 32bit int */
+#undef silk_SMLATT
+#define silk_SMLATT(a32, b32, c32)          (cm4_smlatt(a32, b32, c32))
+
+#if defined(OPUS_ARM_INLINE_MEDIA)
+
+/* Signed top word multiply */
+#undef silk_SMMUL
+#define silk_SMMUL(a32, b32)                (cm4_smmul(a32, b32))
+
+/* Every caller hands this a 32-bit value */
+#undef silk_SAT16
+#define silk_SAT16(a)                       (cm4_ssat16(a))
+
+#endif /* OPUS_ARM_INLINE_MEDIA */
+
+#endif /* SILK_SIGPROC_FIX_ARMv5E_H */
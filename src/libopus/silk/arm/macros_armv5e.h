@@ -0,0 +1,92 @@
+/***********************************************************************
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+- Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+- Neither the name of Internet Society, IETF or IETF Trust, nor the
+names of specific contributors, may be used to endorse or promote
+products derived from this software without specific prior written
+permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+/* SILK's multiply macros on the ARMv5E DSP instructions */
+
+#ifndef SILK_MACROS_ARMv5E_H
+#define SILK_MACROS_ARMv5E_H
+
+#include "../../celt/arm/cm4_dsp.h"
+
+/* The OPUS_FAST_INT64 forms in macros.h are the reference: those are what a
+   host build runs, and what each of these matches bit for bit. */
+
+/* (a32 * (opus_int32)((opus_int16)(b32))) >> 16 output have to be 32bit int */
+#undef silk_SMULWB
+#define silk_SMULWB(a32, b32)            (cm4_smulwb(a32, b32))
+
+/* a32 + (b32 * (opus_int32)((opus_int16)(c32))) >> 16 output have to be 32bit int */
+#undef silk_SMLAWB
+#define silk_SMLAWB(a32, b32, c32)       (cm4_smlawb(a32, b32, c32))
+
+/* (a32 * (b32 >> 16)) >> 16 */
+#undef silk_SMULWT
+#define silk_SMULWT(a32, b32)            (cm4_smulwt(a32, b32))
+
+/* a32 + (b32 * (c32 >> 16)) >> 16 */
+#undef silk_SMLAWT
+#define silk_SMLAWT(a32, b32, c32)       (cm4_smlawt(a32, b32, c32))
+
+/* (opus_int32)((opus_int16)(a3))) * (opus_int32)((opus_int16)(b32)) output have to be 32bit int */
+#undef silk_SMULBB
+#define silk_SMULBB(a32, b32)            (cm4_smulbb(a32, b32))
+
+/* a32 + (opus_int32)((opus_int16)(b32)) * (opus_int32)((opus_int16)(c32)) output have to be 32bit int */
+#undef silk_SMLABB
+#define silk_SMLABB(a32, b32, c32)       (cm4_smlabb(a32, b32, c32))
+
+/* (opus_int32)((opus_int16)(a32)) * (b32 >> 16) */
+#undef silk_SMULBT
+#define silk_SMULBT(a32, b32)            (cm4_smulbt(a32, b32))
+
+/* a32 + (opus_int32)((opus_int16)(b32)) * (c32 >> 16) */
+#undef silk_SMLABT
+#define silk_SMLABT(a32, b32, c32)       (cm4_smlabt(a32, b32, c32))
+
+/* (a32 * b32) >> 16: one SMULL, where macros.h would take an SMULWB, a
+   rounding shift and an MLA without a fast 64-bit type */
+#undef silk_SMULWW
+#define silk_SMULWW(a32, b32)            ((opus_int32)(cm4_smull(a32, b32) >> 16))
+
+/* a32 + ((b32 * c32) >> 16) */
+#undef silk_SMLAWW
+#define silk_SMLAWW(a32, b32, c32)       ((opus_int32)((a32) + (cm4_smull(b32, c32) >> 16)))
+
+/* add/subtract with output saturated */
+#undef silk_ADD_SAT32
+#define silk_ADD_SAT32(a, b)             (cm4_qadd(a, b))
+
+#undef silk_SUB_SAT32
+#define silk_SUB_SAT32(a, b)             (cm4_qsub(a, b))
+
+/* These shadow the functions macros.h has already defined */
+#undef silk_CLZ16
+#define silk_CLZ16(in16)                 (cm4_clz((opus_int32)(((opus_uint32)(in16) << 16) | 0x8000)))
+
+#undef silk_CLZ32
+#define silk_CLZ32(in32)                 (cm4_clz(in32))
+
+#endif /* SILK_MACROS_ARMv5E_H */
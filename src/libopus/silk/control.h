@@ -141,6 +141,16 @@ typedef struct {
 
     /* O:   Pitch lag of previous frame (0 if unvoiced), measured in samples at 48 kHz      */
     opus_int prevPitchLag;
+
+    /* I:   Gain applied as the output is written, Q16; 0 for none                           */
+    opus_int32 outputGain_Q16;
+
+    /* I:   Output samples the gain is applied to: [outputGainFrom, outputGainTo) of this call  */
+    opus_int outputGainFrom;
+    opus_int outputGainTo;
+
+    /* I:   Mono output written as 16-bit stereo pairs: 0 off, 1 both, 2 left, 3 right      */
+    opus_int outputPacking;
 } silk_DecControlStruct;
 
 #ifdef __cplusplus
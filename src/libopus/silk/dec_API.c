@@ -32,18 +32,33 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "main.h"
 #include "../celt/stack_alloc.h"
 #include "../celt/os_support.h"
+#include "../opus.h"
 
 /************************/
 /* Decoder Super Struct */
 /************************/
 typedef struct {
-    silk_decoder_state          channel_state[ DECODER_NUM_CHANNELS ];
     stereo_dec_state                sStereo;
     opus_int                         nChannelsAPI;
     opus_int                         nChannelsInternal;
     opus_int                         prev_decode_only_middle;
+    silk_decoder_state          channel_state[ DECODER_NUM_CHANNELS ];  /* Last: see SILK_DECODER_SIZE */
 } silk_decoder;
 
+/* Mono output is the mid channel alone, so a decoder with mono output only parses the side  */
+/* channel of a stereo stream, to get past it, and never synthesizes it. A build that only   */
+/* does mono output (OPUS_DECODER_MAX_CHANNELS 1) leaves the synthesis part of the side      */
+/* channel's state off the end of the decoder altogether.                                    */
+#if OPUS_DECODER_MAX_CHANNELS == 1
+#define SILK_DECODER_SIZE ( ( offsetof( silk_decoder, channel_state[ 1 ] ) \
+    + offsetof( silk_decoder_state, SILK_DECODER_SYNTHESIS_START ) + 7 ) & ~7 )
+#else
+#define SILK_DECODER_SIZE sizeof( silk_decoder )
+#endif
+
+/* opus.h sizes this for OPUS_DECODER_SIZE.  A multiple of 8, so it needs no padding after it. */
+celt_static_assert( SILK_DECODER_SIZE == OPUS_DECODER_SILK_SIZE && OPUS_DECODER_SILK_SIZE % 8 == 0, silk_decoder_size );
+
 /*********************/
 /* Decoder functions */
 /*********************/
@@ -54,11 +69,48 @@ opus_int silk_Get_Decoder_Size(                         /* O    Returns error co
 {
     opus_int ret = SILK_NO_ERROR;
 
-    *decSizeBytes = sizeof( silk_decoder );
+    *decSizeBytes = SILK_DECODER_SIZE;
 
     return ret;
 }
 
+/* Output gain for sample i of this call, if it's in the range the caller wants scaled */
+static OPUS_INLINE opus_int16 silk_output_gain_at(
+    opus_int16                      x,                  /* I    Sample                                          */
+    opus_int                        i,                  /* I    Index of the sample in this call's output       */
+    const silk_DecControlStruct     *decControl         /* I    Control structure                               */
+)
+{
+    if( i >= decControl->outputGainFrom && i < decControl->outputGainTo ) {
+        return silk_output_gain( x, decControl->outputGain_Q16 );
+    }
+    return x;
+}
+
+/* Get past a frame without synthesizing it: read what silk_decode_frame() would from the   */
+/* bitstream, which updates the little state the reading depends on, and drop the rest      */
+static void silk_skip_frame(
+    silk_decoder_state              *psDec,             /* I/O  Decoder state (only the parsing part is used)   */
+    ec_dec                          *psRangeDec,        /* I/O  Compressor data structure                       */
+    opus_int                        lostFlag,           /* I    0: no loss, 1 loss, 2 decode fec                */
+    opus_int                        condCoding          /* I    The type of conditional coding to use           */
+)
+{
+    VARDECL( opus_int16, pulses );
+    SAVE_STACK;
+
+    if(   lostFlag == FLAG_DECODE_NORMAL ||
+        ( lostFlag == FLAG_DECODE_LBRR && psDec->LBRR_flags[ psDec->nFramesDecoded ] == 1 ) )
+    {
+        ALLOC( pulses, (psDec->frame_length + SHELL_CODEC_FRAME_LENGTH - 1) &
+                       ~(SHELL_CODEC_FRAME_LENGTH - 1), opus_int16 );
+        silk_decode_indices( psDec, psRangeDec, psDec->nFramesDecoded, lostFlag, condCoding );
+        silk_decode_pulses( psRangeDec, pulses, psDec->indices.signalType,
+                psDec->indices.quantOffsetType, psDec->frame_length );
+    }
+    RESTORE_STACK;
+}
+
 /* Reset decoder state */
 opus_int silk_InitDecoder(                              /* O    Returns error code                              */
     void                            *decState           /* I/O  State                                           */
@@ -68,7 +120,7 @@ opus_int silk_InitDecoder(                              /* O    Returns error co
     silk_decoder_state *channel_state = ((silk_decoder *)decState)->channel_state;
 
     for( n = 0; n < DECODER_NUM_CHANNELS; n++ ) {
-        ret  = silk_init_decoder( &channel_state[ n ] );
+        ret  = silk_init_decoder( &channel_state[ n ], n == 0 || OPUS_DECODER_MAX_CHANNELS == 2 );
     }
     silk_memset(&((silk_decoder *)decState)->sStereo, 0, sizeof(((silk_decoder *)decState)->sStereo));
     /* Not strictly needed, but it's cleaner that way */
@@ -97,6 +149,7 @@ opus_int silk_Decode(                                   /* O    Returns error co
     VARDECL( opus_int16, samplesOut2_tmp );
     opus_int32 MS_pred_Q13[ 2 ] = { 0 };
     opus_int16 *resample_out_ptr;
+    silk_resampler_output_struct outputStage;
     silk_decoder *psDec = ( silk_decoder * )decState;
     silk_decoder_state *channel_state = psDec->channel_state;
     opus_int has_side;
@@ -117,7 +170,7 @@ opus_int silk_Decode(                                   /* O    Returns error co
 
     /* If Mono -> Stereo transition in bitstream: init state of second channel */
     if( decControl->nChannelsInternal > psDec->nChannelsInternal ) {
-        ret += silk_init_decoder( &channel_state[ 1 ] );
+        ret += silk_init_decoder( &channel_state[ 1 ], decControl->nChannelsAPI == 2 );
     }
 
     stereo_to_mono = decControl->nChannelsInternal == 1 && psDec->nChannelsInternal == 2 &&
@@ -153,7 +206,8 @@ opus_int silk_Decode(                                   /* O    Returns error co
                 RESTORE_STACK;
                 return SILK_DEC_INVALID_SAMPLING_FREQUENCY;
             }
-            ret += silk_decoder_set_fs( &channel_state[ n ], fs_kHz_dec, decControl->API_sampleRate );
+            ret += silk_decoder_set_fs( &channel_state[ n ], fs_kHz_dec, decControl->API_sampleRate,
+                                        n == 0 || decControl->nChannelsAPI == 2 );
         }
     }
 
@@ -246,7 +300,7 @@ opus_int silk_Decode(                                   /* O    Returns error co
     }
 
     /* Reset side channel decoder prediction memory for first frame with side coding */
-    if( decControl->nChannelsInternal == 2 && decode_only_middle == 0 && psDec->prev_decode_only_middle == 1 ) {
+    if( decControl->nChannelsAPI == 2 && decControl->nChannelsInternal == 2 && decode_only_middle == 0 && psDec->prev_decode_only_middle == 1 ) {
         silk_memset( psDec->channel_state[ 1 ].outBuf, 0, sizeof(psDec->channel_state[ 1 ].outBuf) );
         silk_memset( psDec->channel_state[ 1 ].sLPC_Q14_buf, 0, sizeof(psDec->channel_state[ 1 ].sLPC_Q14_buf) );
         psDec->channel_state[ 1 ].lagPrev        = 100;
@@ -297,7 +351,11 @@ opus_int silk_Decode(                                   /* O    Returns error co
             } else {
                 condCoding = CODE_CONDITIONALLY;
             }
-            ret += silk_decode_frame( &channel_state[ n ], psRangeDec, &samplesOut1_tmp[ n ][ 2 ], &nSamplesOutDec, lostFlag, condCoding, arch);
+            if( n == 0 || decControl->nChannelsAPI == 2 ) {
+                ret += silk_decode_frame( &channel_state[ n ], psRangeDec, &samplesOut1_tmp[ n ][ 2 ], &nSamplesOutDec, lostFlag, condCoding, arch);
+            } else {
+                silk_skip_frame( &channel_state[ n ], psRangeDec, lostFlag, condCoding );
+            }
         } else {
             silk_memset( &samplesOut1_tmp[ n ][ 2 ], 0, nSamplesOutDec * sizeof( opus_int16 ) );
         }
@@ -324,6 +382,12 @@ opus_int silk_Decode(                                   /* O    Returns error co
     } else {
         resample_out_ptr = samplesOut;
     }
+    outputStage.stride    = decControl->outputPacking ? 2 : 1;
+    outputStage.mask[ 0 ] = decControl->outputPacking == 3 ? 0 : -1;
+    outputStage.mask[ 1 ] = decControl->outputPacking == 2 ? 0 : -1;
+    outputStage.gain_Q16  = decControl->outputGain_Q16;
+    outputStage.gainFrom  = decControl->outputGainFrom;
+    outputStage.gainTo    = decControl->outputGainTo;
 
     ALLOC( samplesOut1_tmp_storage2, delay_stack_alloc
            ? decControl->nChannelsInternal*(channel_state[ 0 ].frame_length + 2 )
@@ -336,13 +400,21 @@ opus_int silk_Decode(                                   /* O    Returns error co
     }
     for( n = 0; n < silk_min( decControl->nChannelsAPI, decControl->nChannelsInternal ); n++ ) {
 
-        /* Resample decoded signal to API_sampleRate */
-        ret += silk_resampler( &channel_state[ n ].resampler_state, resample_out_ptr, &samplesOut1_tmp[ n ][ 1 ], nSamplesOutDec );
+        /* Resample decoded signal to API_sampleRate. Mono output is written by the resampler's */
+        /* output stage, packed and scaled as asked                                              */
+        ret += silk_resampler_out( &channel_state[ n ].resampler_state, resample_out_ptr, &samplesOut1_tmp[ n ][ 1 ], nSamplesOutDec,
+                                   decControl->nChannelsAPI == 1 && ( decControl->outputPacking || decControl->outputGain_Q16 ) ? &outputStage : NULL );
 
-        /* Interleave if stereo output and stereo stream */
+        /* Interleave if stereo output and stereo stream, applying any output gain on the way */
         if( decControl->nChannelsAPI == 2 ) {
-            for( i = 0; i < *nSamplesOut; i++ ) {
-                samplesOut[ n + 2 * i ] = resample_out_ptr[ i ];
+            if( decControl->outputGain_Q16 ) {
+                for( i = 0; i < *nSamplesOut; i++ ) {
+                    samplesOut[ n + 2 * i ] = silk_output_gain_at( resample_out_ptr[ i ], i, decControl );
+                }
+            } else {
+                for( i = 0; i < *nSamplesOut; i++ ) {
+                    samplesOut[ n + 2 * i ] = resample_out_ptr[ i ];
+                }
             }
         }
     }
@@ -354,8 +426,14 @@ opus_int silk_Decode(                                   /* O    Returns error co
                we weren't doing collapsing when switching to mono */
             ret += silk_resampler( &channel_state[ 1 ].resampler_state, resample_out_ptr, &samplesOut1_tmp[ 0 ][ 1 ], nSamplesOutDec );
 
-            for( i = 0; i < *nSamplesOut; i++ ) {
-                samplesOut[ 1 + 2 * i ] = resample_out_ptr[ i ];
+            if( decControl->outputGain_Q16 ) {
+                for( i = 0; i < *nSamplesOut; i++ ) {
+                    samplesOut[ 1 + 2 * i ] = silk_output_gain_at( resample_out_ptr[ i ], i, decControl );
+                }
+            } else {
+                for( i = 0; i < *nSamplesOut; i++ ) {
+                    samplesOut[ 1 + 2 * i ] = resample_out_ptr[ i ];
+                }
             }
         } else {
             for( i = 0; i < *nSamplesOut; i++ ) {
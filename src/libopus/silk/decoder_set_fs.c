@@ -35,7 +35,8 @@ POSSIBILITY OF SUCH DAMAGE.
 opus_int silk_decoder_set_fs(
     silk_decoder_state          *psDec,                         /* I/O  Decoder state pointer                       */
     opus_int                    fs_kHz,                         /* I    Sampling frequency (kHz)                    */
-    opus_int32                  fs_API_Hz                       /* I    API Sampling frequency (Hz)                 */
+    opus_int32                  fs_API_Hz,                      /* I    API Sampling frequency (Hz)                 */
+    opus_int                    synthesize                      /* I    0: the channel is only parsed               */
 )
 {
     opus_int frame_length, ret = 0;
@@ -48,7 +49,7 @@ opus_int silk_decoder_set_fs(
     frame_length = silk_SMULBB( psDec->nb_subfr, psDec->subfr_length );
 
     /* Initialize resampler when switching internal or external sampling frequency */
-    if( psDec->fs_kHz != fs_kHz || psDec->fs_API_hz != fs_API_Hz ) {
+    if( synthesize && ( psDec->fs_kHz != fs_kHz || psDec->fs_API_hz != fs_API_Hz ) ) {
         /* Initialize the resampler for dec_API.c preparing resampling from fs_kHz to API_fs_Hz */
         ret += silk_resampler_init( &psDec->resampler_state, silk_SMULBB( fs_kHz, 1000 ), fs_API_Hz, 0 );
 
@@ -92,8 +93,10 @@ opus_int silk_decoder_set_fs(
             psDec->lagPrev                 = 100;
             psDec->LastGainIndex           = 10;
             psDec->prevSignalType          = TYPE_NO_VOICE_ACTIVITY;
-            silk_memset( psDec->outBuf, 0, sizeof(psDec->outBuf));
-            silk_memset( psDec->sLPC_Q14_buf, 0, sizeof(psDec->sLPC_Q14_buf) );
+            if( synthesize ) {
+                silk_memset( psDec->outBuf, 0, sizeof(psDec->outBuf));
+                silk_memset( psDec->sLPC_Q14_buf, 0, sizeof(psDec->sLPC_Q14_buf) );
+            }
         }
 
         psDec->fs_kHz       = fs_kHz;
@@ -0,0 +1,88 @@
+/***********************************************************************
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+- Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+- Neither the name of Internet Society, IETF or IETF Trust, nor the
+names of specific contributors, may be used to endorse or promote
+products derived from this software without specific prior written
+permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+
+/* AVX2 version of silk_inner_prod16_aligned_64() */
+
+//#ifdef HAVE_CONFIG_H
+#include "../../../config.h"
+//#endif
+
+#include "../../SigProc_FIX.h"
+
+#if defined(OPUS_X86_MAY_HAVE_AVX2)
+
+#include <immintrin.h>
+#include "../../../celt/x86/x86cpu.h"
+
+/* As the SSE4.1 version, sixteen products a step. */
+OPUS_TARGET_AVX2
+opus_int64 silk_inner_prod16_aligned_64_avx2(
+    const opus_int16            *inVec1,            /*    I input vector 1                                              */
+    const opus_int16            *inVec2,            /*    I input vector 2                                              */
+    const opus_int              len                 /*    I vector lengths                                              */
+)
+{
+    opus_int   i;
+    opus_int64 sum;
+    opus_int32 wraps;
+    __m256i    acc, wrap_count, int32_min;
+    __m128i    acc128, wraps128;
+
+    acc        = _mm256_setzero_si256();
+    wrap_count = _mm256_setzero_si256();
+    int32_min  = _mm256_set1_epi32( silk_int32_MIN );
+    for( i = 0; i < len - 15; i += 16 ) {
+        __m256i p = _mm256_madd_epi16( _mm256_loadu_si256( (const __m256i *)(const void *)&inVec1[ i ] ),
+                                       _mm256_loadu_si256( (const __m256i *)(const void *)&inVec2[ i ] ) );
+        wrap_count = _mm256_sub_epi32( wrap_count, _mm256_cmpeq_epi32( p, int32_min ) );
+        acc = _mm256_add_epi64( acc, _mm256_cvtepi32_epi64( _mm256_castsi256_si128( p ) ) );
+        acc = _mm256_add_epi64( acc, _mm256_cvtepi32_epi64( _mm256_extracti128_si256( p, 1 ) ) );
+    }
+    acc128   = _mm_add_epi64( _mm256_castsi256_si128( acc ), _mm256_extracti128_si256( acc, 1 ) );
+    wraps128 = _mm_add_epi32( _mm256_castsi256_si128( wrap_count ), _mm256_extracti128_si256( wrap_count, 1 ) );
+    if( i < len - 7 ) {
+        __m128i p = _mm_madd_epi16( _mm_loadu_si128( (const __m128i *)(const void *)&inVec1[ i ] ),
+                                    _mm_loadu_si128( (const __m128i *)(const void *)&inVec2[ i ] ) );
+        wraps128 = _mm_sub_epi32( wraps128, _mm_cmpeq_epi32( p, _mm256_castsi256_si128( int32_min ) ) );
+        acc128 = _mm_add_epi64( acc128, _mm_cvtepi32_epi64( p ) );
+        acc128 = _mm_add_epi64( acc128, _mm_cvtepi32_epi64( _mm_srli_si128( p, 8 ) ) );
+        i += 8;
+    }
+    acc128 = _mm_add_epi64( acc128, _mm_unpackhi_epi64( acc128, acc128 ) );
+    wraps128 = _mm_add_epi32( wraps128, _mm_shuffle_epi32( wraps128, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    wraps128 = _mm_add_epi32( wraps128, _mm_shuffle_epi32( wraps128, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+    wraps = _mm_cvtsi128_si32( wraps128 );
+    _mm_storel_epi64( (__m128i *)(void *)&sum, acc128 );
+    sum += silk_LSHIFT64( (opus_int64)wraps, 32 );
+
+    for( ; i < len; i++ ) {
+        sum = silk_SMLALBB( sum, inVec1[ i ], inVec2[ i ] );
+    }
+    return sum;
+}
+
+#endif
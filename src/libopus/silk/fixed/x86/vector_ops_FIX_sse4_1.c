@@ -0,0 +1,80 @@
+/***********************************************************************
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+- Redistributions of source code must retain the above copyright notice,
+this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+- Neither the name of Internet Society, IETF or IETF Trust, nor the
+names of specific contributors, may be used to endorse or promote
+products derived from this software without specific prior written
+permission.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+***********************************************************************/
+
+
+/* SSE4.1 version of silk_inner_prod16_aligned_64() */
+
+//#ifdef HAVE_CONFIG_H
+#include "../../../config.h"
+//#endif
+
+#include "../../SigProc_FIX.h"
+
+#if defined(OPUS_X86_MAY_HAVE_SSE4_1)
+
+#include <smmintrin.h>
+#include "../../../celt/x86/x86cpu.h"
+
+/* _mm_madd_epi16() sums products in pairs, and the only pair a 32-bit lane can't
+   hold is two of -32768 * -32768: it wraps to silk_int32_MIN, which no other
+   pair can give.  Those are counted and their 2^32 put back at the end, which
+   keeps the sum exact like the C version's. */
+OPUS_TARGET_SSE4_1
+opus_int64 silk_inner_prod16_aligned_64_sse4_1(
+    const opus_int16            *inVec1,            /*    I input vector 1                                              */
+    const opus_int16            *inVec2,            /*    I input vector 2                                              */
+    const opus_int              len                 /*    I vector lengths                                              */
+)
+{
+    opus_int   i;
+    opus_int64 sum;
+    opus_int32 wraps;
+    __m128i    acc, wrap_count, int32_min;
+
+    acc        = _mm_setzero_si128();
+    wrap_count = _mm_setzero_si128();
+    int32_min  = _mm_set1_epi32( silk_int32_MIN );
+    for( i = 0; i < len - 7; i += 8 ) {
+        __m128i p = _mm_madd_epi16( _mm_loadu_si128( (const __m128i *)(const void *)&inVec1[ i ] ),
+                                    _mm_loadu_si128( (const __m128i *)(const void *)&inVec2[ i ] ) );
+        wrap_count = _mm_sub_epi32( wrap_count, _mm_cmpeq_epi32( p, int32_min ) );
+        acc = _mm_add_epi64( acc, _mm_cvtepi32_epi64( p ) );
+        acc = _mm_add_epi64( acc, _mm_cvtepi32_epi64( _mm_srli_si128( p, 8 ) ) );
+    }
+    acc = _mm_add_epi64( acc, _mm_unpackhi_epi64( acc, acc ) );
+    wrap_count = _mm_add_epi32( wrap_count, _mm_shuffle_epi32( wrap_count, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    wrap_count = _mm_add_epi32( wrap_count, _mm_shuffle_epi32( wrap_count, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+    wraps = _mm_cvtsi128_si32( wrap_count );
+    _mm_storel_epi64( (__m128i *)(void *)&sum, acc );
+    sum += silk_LSHIFT64( (opus_int64)wraps, 32 );
+
+    for( ; i < len; i++ ) {
+        sum = silk_SMLALBB( sum, inVec1[ i ], inVec2[ i ] );
+    }
+    return sum;
+}
+
+#endif
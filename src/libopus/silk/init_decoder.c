@@ -35,9 +35,18 @@ POSSIBILITY OF SUCH DAMAGE.
 /* Init Decoder State   */
 /************************/
 opus_int silk_init_decoder(
-    silk_decoder_state          *psDec                          /* I/O  Decoder state pointer                       */
+    silk_decoder_state          *psDec,                         /* I/O  Decoder state pointer                       */
+    opus_int                    synthesize                      /* I    0: the channel is only parsed               */
 )
 {
+    /* A channel that's only parsed has no synthesis state to clear (it may not even be there) */
+    if( !synthesize ) {
+        silk_memset( psDec, 0, offsetof( silk_decoder_state, SILK_DECODER_SYNTHESIS_START ) );
+        psDec->first_frame_after_reset = 1;
+        psDec->arch = opus_select_arch();
+        return(0);
+    }
+
     /* Clear the entire encoder state, except anything copied */
     silk_memset( psDec, 0, sizeof( silk_decoder_state ) );
 
@@ -390,14 +390,16 @@ void silk_NLSF_decode(
 /* Decoder Functions                                */
 /****************************************************/
 opus_int silk_init_decoder(
-    silk_decoder_state          *psDec                          /* I/O  Decoder state pointer                       */
+    silk_decoder_state          *psDec,                         /* I/O  Decoder state pointer                       */
+    opus_int                    synthesize                      /* I    0: the channel is only parsed               */
 );
 
 /* Set decoder sampling rate */
 opus_int silk_decoder_set_fs(
     silk_decoder_state          *psDec,                         /* I/O  Decoder state pointer                       */
     opus_int                    fs_kHz,                         /* I    Sampling frequency (kHz)                    */
-    opus_int32                  fs_API_Hz                       /* I    API Sampling frequency (Hz)                 */
+    opus_int32                  fs_API_Hz,                      /* I    API Sampling frequency (Hz)                 */
+    opus_int                    synthesize                      /* I    0: the channel is only parsed               */
 );
 
 /****************/
@@ -177,6 +177,39 @@ opus_int silk_resampler(
     const opus_int16            in[],               /* I    Input signal                                                */
     opus_int32                  inLen               /* I    Number of input samples                                     */
 )
+{
+    return silk_resampler_out( S, out, in, inLen, NULL );
+}
+
+/* Copy, through the output stage */
+static void silk_resampler_copy(
+    opus_int16                  out[],              /* O    Output signal                                               */
+    opus_int                    outIndex,           /* I    Index of the first sample                                   */
+    const opus_int16            in[],               /* I    Input signal                                                */
+    opus_int32                  len,                /* I    Number of samples                                           */
+    const silk_resampler_output_struct *stage       /* I    Output stage, or NULL                                       */
+)
+{
+    opus_int32 k;
+
+    if( stage == NULL ) {
+        silk_memcpy( &out[ outIndex ], in, len * sizeof( opus_int16 ) );
+    } else {
+        for( k = 0; k < len; k++ ) {
+            silk_resampler_put( out, outIndex + k, in[ k ], stage );
+        }
+    }
+}
+
+/* Resampler: convert from one sampling rate to another, with each output sample written  */
+/* as stage says: the decoder's output stage, packed into stereo pairs and scaled          */
+opus_int silk_resampler_out(
+    silk_resampler_state_struct *S,                 /* I/O  Resampler state                                             */
+    opus_int16                  out[],              /* O    Output signal                                               */
+    const opus_int16            in[],               /* I    Input signal                                                */
+    opus_int32                  inLen,              /* I    Number of input samples                                     */
+    const silk_resampler_output_struct *stage       /* I    Output stage, or NULL                                       */
+)
 {
     opus_int nSamples;
 
@@ -192,20 +225,20 @@ opus_int silk_resampler(
 
     switch( S->resampler_function ) {
         case USE_silk_resampler_private_up2_HQ_wrapper:
-            silk_resampler_private_up2_HQ_wrapper( S, out, S->delayBuf, S->Fs_in_kHz );
-            silk_resampler_private_up2_HQ_wrapper( S, &out[ S->Fs_out_kHz ], &in[ nSamples ], inLen - S->Fs_in_kHz );
+            silk_resampler_private_up2_HQ_wrapper( S, out, 0, S->delayBuf, S->Fs_in_kHz, stage );
+            silk_resampler_private_up2_HQ_wrapper( S, out, S->Fs_out_kHz, &in[ nSamples ], inLen - S->Fs_in_kHz, stage );
             break;
         case USE_silk_resampler_private_IIR_FIR:
-            silk_resampler_private_IIR_FIR( S, out, S->delayBuf, S->Fs_in_kHz );
-            silk_resampler_private_IIR_FIR( S, &out[ S->Fs_out_kHz ], &in[ nSamples ], inLen - S->Fs_in_kHz );
+            silk_resampler_private_IIR_FIR( S, out, 0, S->delayBuf, S->Fs_in_kHz, stage );
+            silk_resampler_private_IIR_FIR( S, out, S->Fs_out_kHz, &in[ nSamples ], inLen - S->Fs_in_kHz, stage );
             break;
         case USE_silk_resampler_private_down_FIR:
-            silk_resampler_private_down_FIR( S, out, S->delayBuf, S->Fs_in_kHz );
-            silk_resampler_private_down_FIR( S, &out[ S->Fs_out_kHz ], &in[ nSamples ], inLen - S->Fs_in_kHz );
+            silk_resampler_private_down_FIR( S, out, 0, S->delayBuf, S->Fs_in_kHz, stage );
+            silk_resampler_private_down_FIR( S, out, S->Fs_out_kHz, &in[ nSamples ], inLen - S->Fs_in_kHz, stage );
             break;
         default:
-            silk_memcpy( out, S->delayBuf, S->Fs_in_kHz * sizeof( opus_int16 ) );
-            silk_memcpy( &out[ S->Fs_out_kHz ], &in[ nSamples ], ( inLen - S->Fs_in_kHz ) * sizeof( opus_int16 ) );
+            silk_resampler_copy( out, 0, S->delayBuf, S->Fs_in_kHz, stage );
+            silk_resampler_copy( out, S->Fs_out_kHz, &in[ nSamples ], inLen - S->Fs_in_kHz, stage );
     }
 
     /* Copy to delay buffer */
@@ -41,28 +41,61 @@ extern "C" {
 #define RESAMPLER_MAX_FS_KHZ                    48
 #define RESAMPLER_MAX_BATCH_SIZE_IN             ( RESAMPLER_MAX_BATCH_SIZE_MS * RESAMPLER_MAX_FS_KHZ )
 
+/* Store output sample i, saturated to 16 bits, as the output stage says: scaled if it's in */
+/* the gain's range, and written as a stereo pair if the stage packs. A NULL stage just     */
+/* stores it at out[ i ].                                                                   */
+static OPUS_INLINE void silk_resampler_put(
+    opus_int16                          out[],      /* O    Output signal               */
+    opus_int                            i,          /* I    Index of the sample         */
+    opus_int32                          x,          /* I    Sample                      */
+    const silk_resampler_output_struct  *stage      /* I    Output stage, or NULL       */
+)
+{
+    opus_int16 y = (opus_int16)silk_SAT16( x );
+
+    if( stage == NULL ) {
+        out[ i ] = y;
+        return;
+    }
+    if( stage->gain_Q16 && i >= stage->gainFrom && i < stage->gainTo ) {
+        y = silk_output_gain( y, stage->gain_Q16 );
+    }
+    if( stage->stride == 2 ) {
+        out[ 2 * i ]     = y & stage->mask[ 0 ];
+        out[ 2 * i + 1 ] = y & stage->mask[ 1 ];
+    } else {
+        out[ i ] = y;
+    }
+}
+
 /* Description: Hybrid IIR/FIR polyphase implementation of resampling */
 void silk_resampler_private_IIR_FIR(
     void                            *SS,            /* I/O  Resampler state             */
     opus_int16                      out[],          /* O    Output signal               */
+    opus_int                        outIndex,       /* I    Index of the first sample   */
     const opus_int16                in[],           /* I    Input signal                */
-    opus_int32                      inLen           /* I    Number of input samples     */
+    opus_int32                      inLen,          /* I    Number of input samples     */
+    const silk_resampler_output_struct *stage       /* I    Output stage, or NULL       */
 );
 
 /* Description: Hybrid IIR/FIR polyphase implementation of resampling */
 void silk_resampler_private_down_FIR(
     void                            *SS,            /* I/O  Resampler state             */
     opus_int16                      out[],          /* O    Output signal               */
+    opus_int                        outIndex,       /* I    Index of the first sample   */
     const opus_int16                in[],           /* I    Input signal                */
-    opus_int32                      inLen           /* I    Number of input samples     */
+    opus_int32                      inLen,          /* I    Number of input samples     */
+    const silk_resampler_output_struct *stage       /* I    Output stage, or NULL       */
 );
 
 /* Upsample by a factor 2, high quality */
 void silk_resampler_private_up2_HQ_wrapper(
     void                            *SS,            /* I/O  Resampler state (unused)    */
-    opus_int16                      *out,           /* O    Output signal [ 2 * len ]   */
+    opus_int16                      *out,           /* O    Output signal               */
+    opus_int                        outIndex,       /* I    Index of the first sample   */
     const opus_int16                *in,            /* I    Input signal [ len ]        */
-    opus_int32                      len             /* I    Number of input samples     */
+    opus_int32                      len,            /* I    Number of input samples     */
+    const silk_resampler_output_struct *stage       /* I    Output stage, or NULL       */
 );
 
 /* Upsample by a factor 2, high quality */
@@ -33,11 +33,13 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "resampler_private.h"
 #include "../celt/stack_alloc.h"
 
-static OPUS_INLINE opus_int16 *silk_resampler_private_IIR_FIR_INTERPOL(
+static OPUS_INLINE opus_int silk_resampler_private_IIR_FIR_INTERPOL(
     opus_int16  *out,
+    opus_int    outIndex,
     opus_int16  *buf,
     opus_int32  max_index_Q16,
-    opus_int32  index_increment_Q16
+    opus_int32  index_increment_Q16,
+    const silk_resampler_output_struct *stage
 )
 {
     opus_int32 index_Q16, res_Q15;
@@ -57,16 +59,18 @@ static OPUS_INLINE opus_int16 *silk_resampler_private_IIR_FIR_INTERPOL(
         res_Q15 = silk_SMLABB( res_Q15, buf_ptr[ 5 ], silk_resampler_frac_FIR_12[ 11 - table_index ][ 2 ] );
         res_Q15 = silk_SMLABB( res_Q15, buf_ptr[ 6 ], silk_resampler_frac_FIR_12[ 11 - table_index ][ 1 ] );
         res_Q15 = silk_SMLABB( res_Q15, buf_ptr[ 7 ], silk_resampler_frac_FIR_12[ 11 - table_index ][ 0 ] );
-        *out++ = (opus_int16)silk_SAT16( silk_RSHIFT_ROUND( res_Q15, 15 ) );
+        silk_resampler_put( out, outIndex++, silk_RSHIFT_ROUND( res_Q15, 15 ), stage );
     }
-    return out;
+    return outIndex;
 }
 /* Upsample using a combination of allpass-based 2x upsampling and FIR interpolation */
 void silk_resampler_private_IIR_FIR(
     void                            *SS,            /* I/O  Resampler state             */
     opus_int16                      out[],          /* O    Output signal               */
+    opus_int                        outIndex,       /* I    Index of the first sample   */
     const opus_int16                in[],           /* I    Input signal                */
-    opus_int32                      inLen           /* I    Number of input samples     */
+    opus_int32                      inLen,          /* I    Number of input samples     */
+    const silk_resampler_output_struct *stage       /* I    Output stage, or NULL       */
 )
 {
     silk_resampler_state_struct *S = (silk_resampler_state_struct *)SS;
@@ -89,7 +93,7 @@ void silk_resampler_private_IIR_FIR(
         silk_resampler_private_up2_HQ( S->sIIR, &buf[ RESAMPLER_ORDER_FIR_12 ], in, nSamplesIn );
 
         max_index_Q16 = silk_LSHIFT32( nSamplesIn, 16 + 1 );         /* + 1 because 2x upsampling */
-        out = silk_resampler_private_IIR_FIR_INTERPOL( out, buf, max_index_Q16, index_increment_Q16 );
+        outIndex = silk_resampler_private_IIR_FIR_INTERPOL( out, outIndex, buf, max_index_Q16, index_increment_Q16, stage );
         in += nSamplesIn;
         inLen -= nSamplesIn;
 
@@ -33,14 +33,16 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "resampler_private.h"
 #include "../celt/stack_alloc.h"
 
-static OPUS_INLINE opus_int16 *silk_resampler_private_down_FIR_INTERPOL(
+static OPUS_INLINE opus_int silk_resampler_private_down_FIR_INTERPOL(
     opus_int16          *out,
+    opus_int            outIndex,
     opus_int32          *buf,
     const opus_int16    *FIR_Coefs,
     opus_int            FIR_Order,
     opus_int            FIR_Fracs,
     opus_int32          max_index_Q16,
-    opus_int32          index_increment_Q16
+    opus_int32          index_increment_Q16,
+    const silk_resampler_output_struct *stage
 )
 {
     opus_int32 index_Q16, res_Q6;
@@ -80,7 +82,7 @@ static OPUS_INLINE opus_int16 *silk_resampler_private_down_FIR_INTERPOL(
                 res_Q6 = silk_SMLAWB( res_Q6, buf_ptr[  9 ], interpol_ptr[ 8 ] );
 
                 /* Scale down, saturate and store in output array */
-                *out++ = (opus_int16)silk_SAT16( silk_RSHIFT_ROUND( res_Q6, 6 ) );
+                silk_resampler_put( out, outIndex++, silk_RSHIFT_ROUND( res_Q6, 6 ), stage );
             }
             break;
         case RESAMPLER_DOWN_ORDER_FIR1:
@@ -103,7 +105,7 @@ static OPUS_INLINE opus_int16 *silk_resampler_private_down_FIR_INTERPOL(
                 res_Q6 = silk_SMLAWB( res_Q6, silk_ADD32( buf_ptr[ 11 ], buf_ptr[ 12 ] ), FIR_Coefs[ 11 ] );
 
                 /* Scale down, saturate and store in output array */
-                *out++ = (opus_int16)silk_SAT16( silk_RSHIFT_ROUND( res_Q6, 6 ) );
+                silk_resampler_put( out, outIndex++, silk_RSHIFT_ROUND( res_Q6, 6 ), stage );
             }
             break;
         case RESAMPLER_DOWN_ORDER_FIR2:
@@ -132,21 +134,23 @@ static OPUS_INLINE opus_int16 *silk_resampler_private_down_FIR_INTERPOL(
                 res_Q6 = silk_SMLAWB( res_Q6, silk_ADD32( buf_ptr[ 17 ], buf_ptr[ 18 ] ), FIR_Coefs[ 17 ] );
 
                 /* Scale down, saturate and store in output array */
-                *out++ = (opus_int16)silk_SAT16( silk_RSHIFT_ROUND( res_Q6, 6 ) );
+                silk_resampler_put( out, outIndex++, silk_RSHIFT_ROUND( res_Q6, 6 ), stage );
             }
             break;
         default:
             celt_assert( 0 );
     }
-    return out;
+    return outIndex;
 }
 
 /* Resample with a 2nd order AR filter followed by FIR interpolation */
 void silk_resampler_private_down_FIR(
     void                            *SS,            /* I/O  Resampler state             */
     opus_int16                      out[],          /* O    Output signal               */
+    opus_int                        outIndex,       /* I    Index of the first sample   */
     const opus_int16                in[],           /* I    Input signal                */
-    opus_int32                      inLen           /* I    Number of input samples     */
+    opus_int32                      inLen,          /* I    Number of input samples     */
+    const silk_resampler_output_struct *stage       /* I    Output stage, or NULL       */
 )
 {
     silk_resampler_state_struct *S = (silk_resampler_state_struct *)SS;
@@ -174,8 +178,8 @@ void silk_resampler_private_down_FIR(
         max_index_Q16 = silk_LSHIFT32( nSamplesIn, 16 );
 
         /* Interpolate filtered signal */
-        out = silk_resampler_private_down_FIR_INTERPOL( out, buf, FIR_Coefs, S->FIR_Order,
-            S->FIR_Fracs, max_index_Q16, index_increment_Q16 );
+        outIndex = silk_resampler_private_down_FIR_INTERPOL( out, outIndex, buf, FIR_Coefs, S->FIR_Order,
+            S->FIR_Fracs, max_index_Q16, index_increment_Q16, stage );
 
         in += nSamplesIn;
         inLen -= nSamplesIn;
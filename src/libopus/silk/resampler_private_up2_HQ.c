@@ -35,11 +35,14 @@ POSSIBILITY OF SUCH DAMAGE.
 /* Upsample by a factor 2, high quality */
 /* Uses 2nd order allpass filters for the 2x upsampling, followed by a      */
 /* notch filter just above Nyquist.                                         */
-void silk_resampler_private_up2_HQ(
+/* Inlined into both callers, so the one with no output stage loses it.    */
+static OPUS_INLINE void silk_resampler_private_up2_HQ_out(
     opus_int32                      *S,             /* I/O  Resampler state [ 6 ]       */
-    opus_int16                      *out,           /* O    Output signal [ 2 * len ]   */
+    opus_int16                      *out,           /* O    Output signal               */
+    opus_int                        outIndex,       /* I    Index of the first sample   */
     const opus_int16                *in,            /* I    Input signal [ len ]        */
-    opus_int32                      len             /* I    Number of input samples     */
+    opus_int32                      len,            /* I    Number of input samples     */
+    const silk_resampler_output_struct *stage       /* I    Output stage, or NULL       */
 )
 {
     opus_int32 k;
@@ -76,7 +79,7 @@ void silk_resampler_private_up2_HQ(
         S[ 2 ]  = silk_ADD32( out32_2, X );
 
         /* Apply gain in Q15, convert back to int16 and store to output */
-        out[ 2 * k ] = (opus_int16)silk_SAT16( silk_RSHIFT_ROUND( out32_1, 10 ) );
+        silk_resampler_put( out, outIndex + 2 * k, silk_RSHIFT_ROUND( out32_1, 10 ), stage );
 
         /* First all-pass section for odd output sample */
         Y       = silk_SUB32( in32, S[ 3 ] );
@@ -97,17 +100,29 @@ void silk_resampler_private_up2_HQ(
         S[ 5 ]  = silk_ADD32( out32_2, X );
 
         /* Apply gain in Q15, convert back to int16 and store to output */
-        out[ 2 * k + 1 ] = (opus_int16)silk_SAT16( silk_RSHIFT_ROUND( out32_1, 10 ) );
+        silk_resampler_put( out, outIndex + 2 * k + 1, silk_RSHIFT_ROUND( out32_1, 10 ), stage );
     }
 }
 
-void silk_resampler_private_up2_HQ_wrapper(
-    void                            *SS,            /* I/O  Resampler state (unused)    */
+void silk_resampler_private_up2_HQ(
+    opus_int32                      *S,             /* I/O  Resampler state [ 6 ]       */
     opus_int16                      *out,           /* O    Output signal [ 2 * len ]   */
     const opus_int16                *in,            /* I    Input signal [ len ]        */
     opus_int32                      len             /* I    Number of input samples     */
 )
+{
+    silk_resampler_private_up2_HQ_out( S, out, 0, in, len, NULL );
+}
+
+void silk_resampler_private_up2_HQ_wrapper(
+    void                            *SS,            /* I/O  Resampler state (unused)    */
+    opus_int16                      *out,           /* O    Output signal               */
+    opus_int                        outIndex,       /* I    Index of the first sample   */
+    const opus_int16                *in,            /* I    Input signal [ len ]        */
+    opus_int32                      len,            /* I    Number of input samples     */
+    const silk_resampler_output_struct *stage       /* I    Output stage, or NULL       */
+)
 {
     silk_resampler_state_struct *S = (silk_resampler_state_struct *)SS;
-    silk_resampler_private_up2_HQ( S->sIIR, out, in, len );
+    silk_resampler_private_up2_HQ_out( S->sIIR, out, outIndex, in, len, stage );
 }
@@ -53,6 +53,16 @@ typedef struct _silk_resampler_state_struct{
     const opus_int16 *Coefs;
 } silk_resampler_state_struct;
 
+/* How silk_resampler_out() writes its output, so that the decoder's output needs no pass  */
+/* of its own afterwards                                                                    */
+typedef struct _silk_resampler_output_struct{
+    opus_int         stride;        /* Values per sample: 1, or 2 to write each one as a stereo pair */
+    opus_int16       mask[ 2 ];     /* With stride 2, ANDed into the left and the right value        */
+    opus_int32       gain_Q16;      /* Gain applied on the way out, Q16; 0 for none                  */
+    opus_int         gainFrom;      /* Output samples the gain is applied to: [gainFrom, gainTo)     */
+    opus_int         gainTo;
+} silk_resampler_output_struct;
+
 #ifdef __cplusplus
 }
 #endif
@@ -259,12 +259,10 @@ typedef struct {
 /* Decoder state                */
 /********************************/
 typedef struct {
-    opus_int32                  prev_gain_Q16;
-    opus_int32                  exc_Q14[ MAX_FRAME_LENGTH ];
-    opus_int32                  sLPC_Q14_buf[ MAX_LPC_ORDER ];
-    opus_int16                  outBuf[ MAX_FRAME_LENGTH + 2 * MAX_SUB_FRAME_LENGTH ];  /* Buffer for output signal                     */
-    opus_int                    lagPrev;                            /* Previous Lag                                                     */
+    /* Everything before SILK_DECODER_SYNTHESIS_START is what it takes to parse a channel;  */
+    /* the rest is only needed to synthesize it (see silk_decoder_set_fs and dec_API.c)     */
     opus_int8                   LastGainIndex;                      /* Previous gain index                                              */
+    opus_int                    lagPrev;                            /* Previous Lag                                                     */
     opus_int                    fs_kHz;                             /* Sampling frequency in kHz                                        */
     opus_int32                  fs_API_hz;                          /* API sample frequency (Hz)                                        */
     opus_int                    nb_subfr;                           /* Number of 5 ms subframes in a frame                              */
@@ -272,7 +270,6 @@ typedef struct {
     opus_int                    subfr_length;                       /* Subframe length (samples)                                        */
     opus_int                    ltp_mem_length;                     /* Length of LTP memory                                             */
     opus_int                    LPC_order;                          /* LPC order                                                        */
-    opus_int16                  prevNLSF_Q15[ MAX_LPC_ORDER ];      /* Used to interpolate LSFs                                         */
     opus_int                    first_frame_after_reset;            /* Flag for deactivating NLSF interpolation                         */
     const opus_uint8            *pitch_lag_low_bits_iCDF;           /* Pointer to iCDF table for low bits of pitch lag index            */
     const opus_uint8            *pitch_contour_iCDF;                /* Pointer to iCDF table for pitch contour index                    */
@@ -289,20 +286,28 @@ typedef struct {
     opus_int                    LBRR_flag;
     opus_int                    LBRR_flags[ MAX_FRAMES_PER_PACKET ];
 
-    silk_resampler_state_struct resampler_state;
-
     const silk_NLSF_CB_struct   *psNLSF_CB;                         /* Pointer to NLSF codebook                                         */
 
     /* Quantization indices */
     SideInfoIndices             indices;
 
+    opus_int                    prevSignalType;
+    int                         arch;
+
+#define SILK_DECODER_SYNTHESIS_START prev_gain_Q16
+    opus_int32                  prev_gain_Q16;
+    opus_int32                  exc_Q14[ MAX_FRAME_LENGTH ];
+    opus_int32                  sLPC_Q14_buf[ MAX_LPC_ORDER ];
+    opus_int16                  outBuf[ MAX_FRAME_LENGTH + 2 * MAX_SUB_FRAME_LENGTH ];  /* Buffer for output signal                     */
+    opus_int16                  prevNLSF_Q15[ MAX_LPC_ORDER ];      /* Used to interpolate LSFs                                         */
+
+    silk_resampler_state_struct resampler_state;
+
     /* CNG state */
     silk_CNG_struct             sCNG;
 
     /* Stuff used for PLC */
     opus_int                    lossCnt;
-    opus_int                    prevSignalType;
-    int                         arch;
 
     silk_PLC_struct sPLC;
 
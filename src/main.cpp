@@ -21,6 +21,9 @@
 #include <nrfx_i2s.h> // Adafruit's nRF52 core doesn't include this.
 #include "libopus/opus.h"
 #include "ogg_stripper.h"
+#include "opk_reader.h"
+#include "read_ahead.h"
+#include "pcm_fifo.h"
 
 #ifndef NRFX_I2S_DEFAULT_CONFIG_IRQ_PRIORITY
 #define NRFX_I2S_DEFAULT_CONFIG_IRQ_PRIORITY 7
@@ -30,9 +33,18 @@
 #define PIN_SCK    NRF_GPIO_PIN_MAP(0, 6) // D11
 #define PIN_MCK   NRF_GPIO_PIN_MAP(0, 7) // D12
 #define PIN_SDOUT  NRF_GPIO_PIN_MAP(0, 26) // D9
-#define BUFFER_LENGTH 1000
-
-#define OGG_BUF_LEN 0xFF
+#define BUFFER_LENGTH PCM_FIFO_FRAME_LENGTH // Samples per I2S buffer; sized in pcm_fifo.h.
+#define DECODE_RATE 16000
+#define GRANULE_SCALE (48000 / DECODE_RATE) // Granule positions and pre-skip count 48 kHz samples.
+#define OUTPUT_PACKING OPUS_PACKING_BOTH // Mono on both I2S channels; or OPUS_PACKING_LEFT / _RIGHT.
+#define I2S_CHANNELS 2 // The decoder writes each sample as a stereo pair, one 32-bit I2S word.
+
+#define OGG_BUF_LEN 0x2000 // Holds a couple of Ogg pages.
+#define READ_AHEAD_BLOCK 0x1000 // One QSPI erase sector; FatFs serves these in one go.
+#define READ_AHEAD_BLOCKS 2
+#define DECODE_SCRATCH_BYTES 9216 // opus_decode's temporaries: 8256 bytes at worst (pc_testbed scratch).
+#define DECODE_TASK_STACK 2560 // Words.  The temporaries are in the arena: 9 KB with it (pc_testbed scratch).
+#define READ_AHEAD_TASK_STACK 512 // Words.  Just FatFs and the QSPI driver under fileBlockRead.
 
 void playFile(void);
 int32_t msc_write_cb (uint32_t lba, uint8_t* buffer, uint32_t bufsize);
@@ -40,16 +52,53 @@ int32_t msc_read_cb (uint32_t lba, void* buffer, uint32_t bufsize);
 void msc_flush_cb (void);
 static void data_handler(nrfx_i2s_buffers_t const * p_released, uint32_t status);
 void loadBuffer(int16_t * dest, const int16_t * src, size_t samples);
+static int nextPacket(const uint8_t ** packet);
+static int decodeNext(void * context, int16_t * pcm, size_t maxSamples);
+static void decodeTask(void * arg);
+static void readAheadTask(void * arg);
+static void startTrack(uint16_t preSkip, int16_t outputGain);
+static int fileBlockRead(void * context, uint32_t offset, uint8_t * destination, size_t length);
 
 File dataFile;
-OpusDecoder *decoder;
+
+// The decoder lives in static RAM, sized at compile time, and is only ever initialized in
+// place: nothing on the playback path touches the heap.
+static union {
+  void * align;
+  uint8_t bytes[OPUS_DECODER_SIZE(1)];
+} decoderStorage;
+OpusDecoder * const decoder = (OpusDecoder *)&decoderStorage;
+
+// And its temporaries in this arena rather than on the decode task's stack, so what they take
+// is in the map file.  The task's stack isn't sized for them as well: a call that wants more
+// than the arena has puts the rest on the stack, and decodeNext stops playback as soon as
+// scratchArena.peak shows that happened.
+static uint64_t decoderScratch[DECODE_SCRATCH_BYTES / sizeof(uint64_t)];
+static OpusScratchArena scratchArena = { (unsigned char *)decoderScratch, sizeof(decoderScratch), 0 };
 
 uint32_t offset = 0;
 
 uint8_t oggBuf[OGG_BUF_LEN];
-
-int16_t bufA[BUFFER_LENGTH];
-int16_t bufB[BUFFER_LENGTH];
+oggStream_t oggStream;
+opkReader_t opkReader; // Shares oggBuf; only one of the two is playing at a time.
+bool playingOpk;
+
+// Gapless bookkeeping for the track playing now.
+uint64_t trackGranule; // 48 kHz samples decoded so far, pre-skip included.
+
+// A packet that didn't fit the room left in the PCM FIFO's frame; decoded on the next call.
+const uint8_t * heldPacket;
+int heldLength;
+
+// Storage reads happen in readAheadTask, into these; the decoder only copies out of them.
+uint8_t readAheadBuf[READ_AHEAD_BLOCK * READ_AHEAD_BLOCKS];
+readAhead_t readAhead;
+TaskHandle_t readAheadTaskHandle;
+SemaphoreHandle_t flashLock; // FatFs isn't reentrant: held by whoever is using it.
+
+// Decoding happens in decodeTask, straight into this; the I2S callback only swaps pointers.
+pcmFifo_t pcmFifo;
+TaskHandle_t decodeTaskHandle;
 nrfx_i2s_buffers_t firstBuf;
 nrfx_i2s_buffers_t newBuf;
 
@@ -93,6 +142,18 @@ void setup()
 
   changed = true; // to print contents initially
 
+  OggStreamInit(&oggStream, &dataFile, oggBuf, OGG_BUF_LEN);
+  ReadAheadInit(&readAhead, fileBlockRead, &dataFile, readAheadBuf, READ_AHEAD_BLOCK, READ_AHEAD_BLOCKS);
+  OggStreamSetPrefetch(&oggStream, &readAhead);
+  PcmFifoInit(&pcmFifo, decodeNext, NULL);
+
+  // Above loop(), so flash and USB housekeeping can't hold up the audio, but below every
+  // interrupt, I2S included.  The read-ahead sits level with the decoder, which wakes it, so
+  // it runs as soon as decoding has finished with the CPU.
+  flashLock = xSemaphoreCreateMutex();
+  xTaskCreate(decodeTask, "decode", DECODE_TASK_STACK, NULL, TASK_PRIO_NORMAL, &decodeTaskHandle);
+  xTaskCreate(readAheadTask, "readahead", READ_AHEAD_TASK_STACK, NULL, TASK_PRIO_NORMAL, &readAheadTaskHandle);
+
   // Configure the I2S module.
   nrfx_i2s_config_t config = NRFX_I2S_DEFAULT_CONFIG(PIN_SCK, PIN_LRCK, NRFX_I2S_PIN_NOT_USED,
                                                      PIN_SDOUT, NRFX_I2S_PIN_NOT_USED);
@@ -111,9 +172,11 @@ void loop()
   if ( changed )
   {
     changed = false;
+    xSemaphoreTake(flashLock, portMAX_DELAY);
     if ( !root.open("/") )
     {
 //      Serial.println("open root failed");
+      xSemaphoreGive(flashLock);
       return;
     }
 //    Serial.println("Flash contents:");
@@ -134,35 +197,51 @@ void loop()
       file.close();
     }
     root.close();
+    xSemaphoreGive(flashLock);
  //   Serial.println();
     delay(1000);
   }
 
   if (n++ == 5)
     playFile();
-
 }
 
 void playFile(void) {
-  static int decoderError;
-  int bytesPulled;
-  decoder = opus_decoder_create(16000, 1, &decoderError);
+  if (opus_decoder_init(decoder, DECODE_RATE, 1) != OPUS_OK) {
+    Serial.print("ERROR: Decoder Failed to Initialize.");
+    return;
+  }
   //opus_decoder_ctl(decoder, OPUS_SET_LSB_DEPTH(16));
   
-  dataFile = fatfs.open("sample.ogg", FILE_READ);
+  // Prefer the pre-packed copy (see pc_testbed), it's cheaper to walk than the Ogg.
+  xSemaphoreTake(flashLock, portMAX_DELAY);
+  dataFile = fatfs.open("sample.opk", FILE_READ);
+  playingOpk = dataFile && OpkOpen(&opkReader, &dataFile, oggBuf, OGG_BUF_LEN, &readAhead) == OPK_OK;
+  if (!playingOpk) {
+    if (dataFile)
+      dataFile.close();
+    dataFile = fatfs.open("sample.ogg", FILE_READ);
+  }
 
   // Read the header data from the file.
+  PcmFifoReset(&pcmFifo);
+  heldLength = 0;
   if ( dataFile.available() ) {
-    if ( OggPrepareFile(&dataFile) ) {
-      bytesPulled = OggGetNextPacket(&dataFile, oggBuf, OGG_BUF_LEN);
-      if (bytesPulled > 0)
-        decoderError = opus_decode(decoder, oggBuf, bytesPulled, bufA, BUFFER_LENGTH, 0);
+    if ( playingOpk || OggStreamPrepare(&oggStream) ) {
+      ReadAheadService(&readAhead); // Prime it before the audio starts pulling.
+      if (playingOpk)
+        startTrack(opkReader.Header.PreSkip, opkReader.Header.OutputGain);
+      else
+        startTrack(oggStream.IDHeader.PreSkip, (int16_t)oggStream.IDHeader.OutputGain);
+      PcmFifoService(&pcmFifo); // Likewise the FIFO; the decode task keeps it topped up from here.
     }
   }
+  xSemaphoreGive(flashLock);
+  xTaskNotifyGive(readAheadTaskHandle); // Refill what that first decode took.
 
   // Send off the first transaction.
   firstBuf.p_rx_buffer = NULL;
-  firstBuf.p_tx_buffer = (uint32_t *)bufA;
+  firstBuf.p_tx_buffer = (uint32_t *)PcmFifoNext(&pcmFifo, NULL);
   if ( nrfx_i2s_start(&firstBuf, BUFFER_LENGTH/2, 0) != NRFX_SUCCESS)
     Serial.print("ERROR: I2S Failed to Start.");
 }
@@ -194,37 +273,162 @@ int32_t msc_write_cb (uint32_t lba, uint8_t* buffer, uint32_t bufsize)
 void msc_flush_cb (void)
 {
   // sync with flash
+  xSemaphoreTake(flashLock, portMAX_DELAY);
   flash.syncBlocks();
   // clear file system's cache to force refresh
   fatfs.cacheClear();
+  xSemaphoreGive(flashLock);
   changed = true;
   digitalWrite(LED_BUILTIN, LOW);
 }
 
-// Callback invoked when we need more data in the I2S module.
-static void data_handler(nrfx_i2s_buffers_t const * p_released, uint32_t status)
+// Fetch the next Opus packet from whichever kind of file is playing.
+// Either way, OGG_STRIP_NOT_READY means the read-ahead hasn't caught up yet.
+static int nextPacket(const uint8_t ** packet)
 {
-  static int decoderError;
   int bytesPulled;
-  newBuf.p_rx_buffer = NULL;
+  if (playingOpk) {
+    bytesPulled = OpkGetNextPacket(&opkReader, packet);
+    return bytesPulled == OPK_NOT_READY ? OGG_STRIP_NOT_READY : bytesPulled;
+  } else {
+    return OggStreamGetNextPacketView(&oggStream, packet);
+  }
+}
 
-  if (status == NRFX_I2S_STATUS_NEXT_BUFFERS_NEEDED) {
-    if (p_released->p_tx_buffer)
-      newBuf.p_tx_buffer = p_released->p_tx_buffer;
-    else
-      newBuf.p_tx_buffer = (uint32_t *)bufB; // On the first run, bufA will be consumed and nothing will be freed, so queue B.
+// Get ready for a new track: the first preSkip (48 kHz) samples it decodes are encoder delay,
+// and its header asks for outputGain (Q8 dB) on everything.  The decoder drops the one and
+// applies the other as it writes its output, so neither costs an extra pass over the PCM.
+static void startTrack(uint16_t preSkip, int16_t outputGain)
+{
+  trackGranule = preSkip / GRANULE_SCALE * GRANULE_SCALE;
+  opus_decoder_ctl(decoder, OPUS_SET_SKIP_SAMPLES(preSkip / GRANULE_SCALE));
+  opus_decoder_ctl(decoder, OPUS_SET_GAIN(outputGain));
+  opus_decoder_ctl(decoder, OPUS_SET_OUTPUT_PACKING(OUTPUT_PACKING));
+  opus_decoder_ctl(decoder, OPUS_SET_SCRATCH_ARENA(&scratchArena));
+}
+
+// Decoding runs here, at task level, whenever the I2S callback has taken a frame.
+// Whatever it pulled out of the read-ahead is then refilled by readAheadTask.
+static void decodeTask(void * arg)
+{
+  (void)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    PcmFifoService(&pcmFifo);
+    xTaskNotifyGive(readAheadTaskHandle);
   }
+}
 
-  // Load up the recently freed buffer with new PCM data.
-  if ( dataFile.available() ) {
-      bytesPulled = OggGetNextPacket(&dataFile, oggBuf, OGG_BUF_LEN);
-      if (bytesPulled > 0)
-        decoderError = opus_decode(decoder, oggBuf, bytesPulled, (int16_t *)newBuf.p_tx_buffer, BUFFER_LENGTH, 0);
-      else
-        nrfx_i2s_stop(); // Probably done.
+// The flash reads playback needs, done here rather than in loop(), which can spend a second
+// or more on a directory walk and its delay after a USB write.
+static void readAheadTask(void * arg)
+{
+  (void)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    xSemaphoreTake(flashLock, portMAX_DELAY);
+    ReadAheadService(&readAhead);
+    xSemaphoreGive(flashLock);
+  }
+}
+
+// PCM FIFO fill: decode the next packet into pcm, ready for the I2S, and return how many
+// values (I2S_CHANNELS to a sample) of it to play.
+// Where a chained Ogg moves on to its next track, the decoder is reset in place for the new
+// header (no free and malloc), and the first packet of the new track decoded straight after.
+// Each track's pre-skip is dropped from its front (see startTrack), and any padding past the
+// end granule from its back, so tracks run into each other without a gap.
+// If the read-ahead hasn't caught up, the gap is concealed instead.
+// A packet that doesn't fit is held back, and the FIFO asked for more room.
+static int decodeNext(void * context, int16_t * pcm, size_t maxSamples)
+{
+  const uint8_t *packet;
+  oggPageHeader_t *page;
+  uint64_t endGranule = 0;
+  int room = maxSamples / I2S_CHANNELS;
+  int bytesPulled, samples, excess;
+
+  // The last call outgrew the arena, and the stack had to make up the difference.
+  if (scratchArena.peak > scratchArena.size)
+    return OPUS_ALLOC_FAIL;
+
+  if (heldLength) {
+    packet = heldPacket;
+    bytesPulled = heldLength;
+    heldLength = 0;
   } else {
-    nrfx_i2s_stop(); // Probably done.
+    bytesPulled = nextPacket(&packet);
+    if (bytesPulled == OGG_STRIP_NEW_STREAM) {
+      samples = opus_decoder_init(decoder, DECODE_RATE, 1);
+      if (samples != OPUS_OK)
+        return samples;
+      startTrack(oggStream.IDHeader.PreSkip, (int16_t)oggStream.IDHeader.OutputGain);
+      bytesPulled = nextPacket(&packet);
+    }
   }
 
-  //nrfx_i2s_next_buffers_set(&newBuf);
+  if (bytesPulled == OGG_STRIP_NOT_READY) {
+    // Storage fell behind; conceal it, 20 ms at a time.
+    if (room < DECODE_RATE / 50)
+      return PCM_FIFO_NO_ROOM;
+    samples = opus_decode(decoder, NULL, 0, pcm, DECODE_RATE / 50, 0);
+    return samples < 0 ? samples : samples * I2S_CHANNELS;
+  }
+  if (bytesPulled < 0)
+    return bytesPulled;
+  if (opus_decoder_get_nb_samples(decoder, packet, bytesPulled) > room) {
+    heldPacket = packet;
+    heldLength = bytesPulled;
+    return PCM_FIFO_NO_ROOM;
+  }
+  samples = opus_decode(decoder, packet, bytesPulled, pcm, room, 0);
+  if (samples < 0)
+    return samples;
+
+  trackGranule += samples * GRANULE_SCALE;
+  if (playingOpk) {
+    endGranule = opkReader.Header.SampleCount;
+  } else {
+    page = OggStreamGetLastPageHeader(&oggStream);
+    if (page->Flags & OGG_FLAG_EOS)
+      endGranule = page->GranulePosition;
+  }
+  if (endGranule && trackGranule > endGranule) {
+    excess = (trackGranule - endGranule) / GRANULE_SCALE;
+    samples = excess < samples ? samples - excess : 0;
+  }
+  return samples * I2S_CHANNELS;
+}
+
+// Block source for the read-ahead: straight off the file on the flash.
+static int fileBlockRead(void * context, uint32_t offset, uint8_t * destination, size_t length)
+{
+  File * file = (File *)context;
+  if (file->position() != offset)
+    file->seek(offset);
+  return file->read(destination, length);
+}
+
+// Callback invoked when we need more data in the I2S module.
+// Everything here is a pointer swap; the decode task does the work, and is woken to refill
+// the frame the I2S just released.
+// p_released is NULL if the last swap was missed and the playing buffer went round again,
+// in which case nothing has come back.
+static void data_handler(nrfx_i2s_buffers_t const * p_released, uint32_t status)
+{
+  BaseType_t woken = pdFALSE;
+  const int16_t * released = p_released ? (const int16_t *)p_released->p_tx_buffer : NULL;
+
+  if (status != NRFX_I2S_STATUS_NEXT_BUFFERS_NEEDED)
+    return;
+
+  newBuf.p_rx_buffer = NULL;
+  newBuf.p_tx_buffer = (uint32_t *)PcmFifoNext(&pcmFifo, released);
+  if (newBuf.p_tx_buffer)
+    nrfx_i2s_next_buffers_set(&newBuf);
+  else
+    nrfx_i2s_stop(); // Done, and the last frame has played out.
+
+  vTaskNotifyGiveFromISR(decodeTaskHandle, &woken);
+  portYIELD_FROM_ISR(woken);
 }
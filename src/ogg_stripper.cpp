@@ -4,10 +4,46 @@
 #include <string.h>
 #include <Adafruit_SPIFlash.h>
 #include "ogg_stripper.h"
+#include "ogg_crc_table.h"
 
-static oggPageHeader_t currentPageHeader;
-static oggIDHeader_t currentIDHeader;
-static oggCommentHeader_t currentCommentHeader;
+// Backs the original single-stream API below.  Everything else takes its own oggStream_t.
+static oggStream_t defaultStream;
+
+// Run length bytes of data through the Ogg CRC, starting from crc.
+// Slice-by-8: each step folds the running CRC into the first four bytes of an eight byte
+// block, and the eight table lookups give the whole block's contribution at once.
+// Bytes are loaded one at a time, so this doesn't care about alignment or endianness.
+uint32_t OggCrcUpdate (uint32_t crc, const uint8_t * data, size_t length) {
+    uint32_t word;
+
+    while (length >= 8) {
+        word = crc ^ ((uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 |
+                      (uint32_t)data[2] << 8 | (uint32_t)data[3]);
+        crc = OggCrcTable[7][word >> 24] ^ OggCrcTable[6][(word >> 16) & 0xFF] ^
+              OggCrcTable[5][(word >> 8) & 0xFF] ^ OggCrcTable[4][word & 0xFF] ^
+              OggCrcTable[3][data[4]] ^ OggCrcTable[2][data[5]] ^
+              OggCrcTable[1][data[6]] ^ OggCrcTable[0][data[7]];
+        data += 8;
+        length -= 8;
+    }
+
+    while (length--)
+        crc = (crc << 8) ^ OggCrcTable[0][(crc >> 24) ^ *data++];
+
+    return crc;
+}
+
+// CRC of a page header as it sits on disk, with the checksum field counted as zero.
+// The struct is packed, so its first 27 + Segments bytes are exactly the header.
+static uint32_t OggHeaderCrc (const oggPageHeader_t * header) {
+    static const uint8_t noChecksum[4] = {0, 0, 0, 0};
+    const uint8_t * raw = (const uint8_t *)header;
+    uint32_t crc;
+
+    crc = OggCrcUpdate(0, raw, 22);
+    crc = OggCrcUpdate(crc, noChecksum, 4);
+    return OggCrcUpdate(crc, raw + 26, 1 + header->Segments);
+}
 
 // Parse the page header into a struct.
 // Expect to be at the beginning of the page.
@@ -36,20 +72,41 @@ int OggReadPageHeader (File * oggFile, oggPageHeader_t * header) {
     }
 }
 
+// OggReadPageHeader into stream->PageHeader, for this stream's pages only.
+// Pages of any other logical stream multiplexed into the file are seeked over.
+static int OggStreamReadPageHeader (oggStream_t * stream) {
+    int dataLen;
+
+    for (;;) {
+        dataLen = OggReadPageHeader(stream->Source, &stream->PageHeader);
+        if ( (dataLen < 0 && dataLen != OGG_STRIP_NO_SEGS) ||
+             stream->PageHeader.SerialNumber == stream->SerialNumber )
+            return dataLen;
+        if (dataLen > 0)
+            stream->Source->seekCur(dataLen);
+    }
+}
+
 // Grab the next page's content into destination.
 // This will pull the ENTIRE page, which is probably not as useful as the packet implementation below.
+// With CRC checking on, a damaged page is still consumed, but BAD_CRC is returned instead of its length.
 // We assume we're at the beginning of the page (i.e. on OggS).
 // So, we need to get the page header first to figure out how much data is actually
 // available in this page.
-int OggGetNextDataPage (File * oggFile, uint8_t * destination, size_t maxLength) {
-    int dataLen = OggReadPageHeader(oggFile, &currentPageHeader);
+int OggStreamGetNextDataPage (oggStream_t * stream, uint8_t * destination, size_t maxLength) {
+    int dataLen = OggStreamReadPageHeader(stream);
     if (dataLen > 0) {
         // The page header is good and dataLen is the number of available bytes in the page.
         // Note: Since we made sure dataLen > 0, casting to unsigned is safe.
         if ((unsigned)dataLen > maxLength)
             dataLen = maxLength;
 
-        if ( oggFile->readBytes(destination, dataLen) == (unsigned)dataLen ) {
+        if ( stream->Source->readBytes(destination, dataLen) == (unsigned)dataLen ) {
+            stream->Segment = stream->PageHeader.Segments;
+            // We can only check the page if all of it landed in destination.
+            if (stream->VerifyCrc && (unsigned)dataLen == stream->PageHeader.DataLength &&
+                OggCrcUpdate(OggHeaderCrc(&stream->PageHeader), destination, dataLen) != stream->PageHeader.Checksum)
+                return OGG_STRIP_BAD_CRC;
             return dataLen;
         } else {
             return OGG_STRIP_EOF;
@@ -61,37 +118,90 @@ int OggGetNextDataPage (File * oggFile, uint8_t * destination, size_t maxLength)
 
 // Grab the next packet's content into destination.
 // This is probably audio data.
-// We assume we're at the beginning of a packet if currentPacket is nonzero.
-// If it's zero, we're probably at the beginning of a page, so we should grab the page
-// header and fast forward to the start of the content before pulling anything.
-int OggGetNextPacket (File * oggFile, uint8_t * destination, size_t maxLength) {
-    static size_t currentPacket = 0;
+// A packet is a run of lacing values ending in one under 255, and that run may carry on
+// into the next page, so keep pulling page headers until the packet is terminated.
+// stream->Segment is the next lacing value to use in stream->PageHeader; once it runs off
+// the end of the table we're sitting on the next page header.
+// If the packet doesn't fit in maxLength, the rest of it is skipped and LEN_SHORT returned.
+// This and the data page call stay on the stream OggStreamPrepare picked, so they stop at
+// the end of the first track of a chained file; use the packet view call to play through.
+int OggStreamGetNextPacket (oggStream_t * stream, uint8_t * destination, size_t maxLength) {
+    oggPageHeader_t * header = &stream->PageHeader;
+    size_t packetLen = 0;
+    bool truncated = false;
+    uint8_t lacing;
     int dataLen;
-    int packetLen;
 
-    // If we're done with the previous page and need a new one.
-    if (currentPacket >= currentPageHeader.Segments)
-        currentPacket = 0;
+    do {
+        // If we're done with the previous page and need a new one.
+        if (stream->Segment >= header->Segments) {
+            dataLen = OggStreamReadPageHeader(stream);
+            if (dataLen < 0)
+                return dataLen; // This contains the error code from OggReadPageHeader.
+            stream->Segment = 0;
+        }
 
-    if (!currentPacket++)
-        dataLen = OggReadPageHeader(oggFile, &currentPageHeader);
-   
-    if (dataLen > 0) {
-        // The page header was pulled successfully, and we're cue'd up.
-        // Note: Since we made sure dataLen > 0, casting to unsigned is safe.
-        packetLen = oggFile->readBytes(destination, currentPageHeader.SegmentTable[currentPacket]);
+        lacing = header->SegmentTable[stream->Segment++];
+        if (truncated || packetLen + lacing > maxLength) {
+            truncated = true;
+            stream->Source->seekCur(lacing);
+        } else {
+            if ( stream->Source->readBytes(destination + packetLen, lacing) != lacing )
+                return OGG_STRIP_EOF;
+            packetLen += lacing;
+        }
+    } while (lacing == 255);
 
-        if ( packetLen == currentPageHeader.SegmentTable[currentPacket] )
-            return packetLen;
-        else
-            return OGG_STRIP_EOF;
-    } else {
-        return dataLen; // This contains the error code from OggReadPageHeader.
+    if (truncated)
+        return OGG_STRIP_LEN_SHORT;
+    else
+        return packetLen;
+}
+
+// Buffered version of the above: point packet at the next packet in the stream's read
+// buffer instead of copying it out.  See OggReaderGetNextPacket.
+// In a chained file, OGG_STRIP_NEW_STREAM is returned where one track hands over to the
+// next, with IDHeader and SerialNumber updated for the new track and packet pointing at
+// its OpusHead.  Reinitialize the decoder for the new header and carry on; its pre-skip
+// applies from the next packet.  Seeking after that is within the new track only, until
+// OggStreamPrepare is called again.
+int OggStreamGetNextPacketView (oggStream_t * stream, const uint8_t ** packet) {
+    int bytesPulled = OggReaderGetNextPacket(stream->Source, &stream->Reader, packet);
+
+    if (bytesPulled >= 0 && stream->Reader.NewStream) {
+        if (bytesPulled < 19)
+            return OGG_STRIP_LEN_SHORT;
+        memcpy(&stream->IDHeader, *packet, 19);
+        stream->SerialNumber = stream->Reader.SerialNumber;
+        return OGG_STRIP_NEW_STREAM;
     }
+    return bytesPulled;
 }
 
-oggPageHeader_t* OggGetLastPageHeader(void) {
-    return &currentPageHeader;
+// Turn page CRC checking on or off.  It's off by default.
+// The buffered reader skips damaged pages and resyncs by itself; the unbuffered data page
+// call reports them with OGG_STRIP_BAD_CRC.  Packet copies (OggStreamGetNextPacket) read
+// pages piecemeal and so can't be checked.
+void OggStreamSetCrcCheck (oggStream_t * stream, bool enable) {
+    stream->VerifyCrc = enable;
+    stream->Reader.VerifyCrc = enable;
+}
+
+// Feed the packet view call from a read-ahead rather than the file, so it only ever copies
+// out of RAM.  If nothing is prefetched yet it returns OGG_STRIP_NOT_READY, and the call
+// can simply be repeated later.  The read-ahead should be reading the same file; it's
+// repositioned whenever the stream is prepared or seeks, so do those from the same
+// context that services it.  Pass NULL to go back to reading the file directly.
+void OggStreamSetPrefetch (oggStream_t * stream, readAhead_t * prefetch) {
+    stream->Reader.Prefetch = prefetch;
+}
+
+oggPageHeader_t* OggStreamGetLastPageHeader (oggStream_t * stream) {
+    // The buffered reader keeps its own copy of whatever page it's working through.
+    if (stream->Reader.Buffer)
+        return &stream->Reader.Page;
+    else
+        return &stream->PageHeader;
 }
 
 // We should be at the start of the ID header data section.  Read it in.
@@ -150,28 +260,595 @@ int OggGetCommentHeader (File * oggFile, oggCommentHeader_t * destination, int d
     }
 }
 
+// Set up a stream over oggFile.  All parse state lives in the stream, so any number of
+// them can be open at once.
+// buffer is optional storage for the packet view API (see oggReader_t); pass NULL and 0
+// if only the copying calls will be used.
+void OggStreamInit (oggStream_t * stream, File * oggFile, uint8_t * buffer, size_t size) {
+    memset(stream, 0, sizeof(*stream));
+    stream->Source = oggFile;
+    OggReaderInit(&stream->Reader, buffer, size);
+}
+
 // Start the file at the beginning.  If it's valid, read the info.
 // Finally, seek to the beginning of the first data page.
 // This function should be called first, before GetNextDataPage.
+// Calling it again rewinds the stream and throws away anything it had buffered.
 // Return the data length pulled from the page header.
-bool OggPrepareFile (File * oggFile) {
+bool OggStreamPrepare (oggStream_t * stream) {
+    File * oggFile = stream->Source;
+    uint64_t magic;
     int dataLen;
     oggFile->seek(0); // Seek to the beginning.
 
+    // Find the ID header.  A multiplexed file opens with the BOS page of every stream in
+    // it, so look through those for the first one carrying Opus.
+    for (;;) {
+        dataLen = OggReadPageHeader(oggFile, &stream->PageHeader);
+        if ( dataLen < (int)sizeof(magic) || !(stream->PageHeader.Flags & OGG_FLAG_BOS) ||
+             oggFile->readBytes((char *)&magic, sizeof(magic)) != sizeof(magic) )
+            break;
+        oggFile->seekCur(-(int32_t)sizeof(magic));
+        if (magic == OPUSHEAD_MAGIC)
+            break;
+        oggFile->seekCur(dataLen);
+    }
+
     // Read in the ID header.
-    dataLen = OggReadPageHeader(oggFile, &currentPageHeader);
-    if ( OggGetIDHeader(oggFile, &currentIDHeader, dataLen) == OGG_STRIP_OK ) {
+    stream->SerialNumber = stream->PageHeader.SerialNumber;
+    if ( OggGetIDHeader(oggFile, &stream->IDHeader, dataLen) == OGG_STRIP_OK ) {
         printf("Got ID Header!\r\n");
     }
 
     // Read in the comment header.
-    dataLen = OggReadPageHeader(oggFile, &currentPageHeader);
-    if ( OggGetCommentHeader(oggFile, &currentCommentHeader, dataLen) == OGG_STRIP_OK ) {
+    dataLen = OggStreamReadPageHeader(stream);
+    if ( OggGetCommentHeader(oggFile, &stream->CommentHeader, dataLen) == OGG_STRIP_OK ) {
         printf("Got Comment Header!\r\n");
     }
+    stream->Segment = stream->PageHeader.Segments; // Packet reads start on the next page.
+    stream->DataStart = oggFile->position();
+    stream->Reader.SerialNumber = stream->SerialNumber;
+    OggReaderReset(&stream->Reader, stream->DataStart);
 
     if (dataLen > 0)
         return true;
     else
         return false;
 }
+
+// Point both packet paths at the page starting at offset.
+static void OggStreamJump (oggStream_t * stream, uint32_t offset) {
+    stream->Source->seek(offset);
+    stream->Segment = stream->PageHeader.Segments = 0;
+    OggReaderReset(&stream->Reader, offset);
+}
+
+// Set up an empty seek index over the caller's array.
+// spacing is the minimum distance between points in 48 kHz samples; 0 keeps every page
+// until the array fills.
+void OggSeekIndexInit (oggSeekIndex_t * index, oggSeekPoint_t * points, uint16_t capacity, uint32_t spacing) {
+    index->Points = points;
+    index->Capacity = capacity;
+    index->Count = 0;
+    index->Spacing = spacing;
+    index->FileSize = 0;
+}
+
+// Walk every page header from the first audio page to the end of the file, seeking over
+// the page data, and note where the usable seek points are.
+// A page is only usable if it doesn't open with the tail of a packet from the page
+// before; then decoding from it starts exactly at the previous page's granule position.
+// Pages that finish no packet (granule -1) can't tell us where they are, so they're skipped.
+// So are pages of other logical streams, which covers other tracks of a chained file too.
+// The stream is rewound to the first audio page afterwards.  Call after OggStreamPrepare.
+int OggSeekIndexBuild (oggStream_t * stream, oggSeekIndex_t * index) {
+    oggPageHeader_t header;
+    uint64_t lastGranule = 0;
+    uint32_t offset = stream->DataStart;
+    uint16_t i;
+    int dataLen;
+
+    // Thinning keeps Points[0], the granule 0 page OggSeekToSample falls back on, so it
+    // needs room for at least one more.
+    if (index->Capacity < 2)
+        return OGG_STRIP_NO_INDEX;
+
+    index->Count = 0;
+    index->FileSize = stream->Source->size();
+    stream->Source->seek(offset);
+    for (;;) {
+        dataLen = OggReadPageHeader(stream->Source, &header);
+        if (dataLen == OGG_STRIP_NO_SEGS)
+            dataLen = 0; // Legal, just empty.
+        else if (dataLen < 0)
+            break; // End of the file, or junk after it.
+
+        if (header.SerialNumber != stream->SerialNumber) {
+            offset += OGG_PAGE_HEADER_LEN + header.Segments + dataLen;
+            stream->Source->seekCur(dataLen);
+            continue;
+        }
+
+        if ( !(header.Flags & OGG_FLAG_CONTINUED) &&
+             (!index->Count || lastGranule - index->Points[index->Count - 1].Granule >= index->Spacing) ) {
+            if (index->Count == index->Capacity) {
+                // Out of room: thin out to every other point, starting with point 0, and
+                // space them further apart.
+                for (i = 0; i < (index->Count + 1) / 2; i++)
+                    index->Points[i] = index->Points[i * 2];
+                index->Count = (index->Count + 1) / 2;
+                index->Spacing = index->Spacing ? index->Spacing * 2 : lastGranule / index->Capacity + 1;
+            }
+            if (!index->Count || lastGranule - index->Points[index->Count - 1].Granule >= index->Spacing) {
+                index->Points[index->Count].Granule = lastGranule;
+                index->Points[index->Count].Offset = offset;
+                index->Count++;
+            }
+        }
+
+        if (header.GranulePosition != (uint64_t)-1)
+            lastGranule = header.GranulePosition;
+        offset += OGG_PAGE_HEADER_LEN + header.Segments + dataLen;
+        stream->Source->seekCur(dataLen);
+    }
+
+    OggStreamJump(stream, stream->DataStart);
+    return index->Count ? OGG_STRIP_OK : OGG_STRIP_NO_INDEX;
+}
+
+// Write the index out as a sidecar file so it doesn't have to be rebuilt next time.
+// Layout: magic, point count, spacing and indexed file size (all 32 bit), then the points,
+// 12 bytes each (granule, then offset).  "OSIX" sidecars had ABI-dependent padding in each
+// point, so they fail the magic check and are rebuilt.
+int OggSeekIndexSave (File * indexFile, const oggSeekIndex_t * index) {
+    uint32_t header[4] = { OGG_SEEK_INDEX_MAGIC, index->Count, index->Spacing, index->FileSize };
+    size_t pointsLen = index->Count * sizeof(oggSeekPoint_t);
+
+    if ( indexFile->write((const uint8_t *)header, sizeof(header)) != sizeof(header) ||
+         indexFile->write((const uint8_t *)index->Points, pointsLen) != pointsLen )
+        return OGG_STRIP_EOF;
+    return OGG_STRIP_OK;
+}
+
+// Read a sidecar written by OggSeekIndexSave.  oggFileSize is the current size of the Ogg
+// file; if it doesn't match what was indexed, the sidecar is stale and NO_INDEX returned.
+// So is one that doesn't start at granule 0, which OggSeekToSample can't do without.
+int OggSeekIndexLoad (File * indexFile, oggSeekIndex_t * index, uint32_t oggFileSize) {
+    uint32_t header[4];
+    size_t pointsLen;
+
+    if ( indexFile->readBytes((char *)header, sizeof(header)) != sizeof(header) )
+        return OGG_STRIP_EOF;
+    if (header[0] != OGG_SEEK_INDEX_MAGIC)
+        return OGG_STRIP_BAD_MAGIC;
+    if (!header[1] || header[1] > index->Capacity || header[3] != oggFileSize)
+        return OGG_STRIP_NO_INDEX;
+
+    pointsLen = header[1] * sizeof(oggSeekPoint_t);
+    if ( indexFile->readBytes((char *)index->Points, pointsLen) != pointsLen )
+        return OGG_STRIP_EOF;
+    if (index->Points[0].Granule != 0)
+        return OGG_STRIP_NO_INDEX;
+    index->Count = header[1];
+    index->Spacing = header[2];
+    index->FileSize = header[3];
+    return OGG_STRIP_OK;
+}
+
+// Get ready to play from sample, counted in 48 kHz samples from the start of the audio
+// (i.e. after pre-skip).
+// The decoder needs OGG_OPUS_PREROLL of run-in to converge, so we binary search for the
+// last point at least that far ahead of the target and jump straight to it.
+// Returns how many 48 kHz samples to decode and throw away before the target (scale by
+// Fs/48000 for other decoder rates), or an error code.  Reset the decoder (OPUS_RESET_STATE)
+// before feeding it again.
+int32_t OggSeekToSample (oggStream_t * stream, const oggSeekIndex_t * index, uint64_t sample) {
+    uint64_t target = sample + stream->IDHeader.PreSkip;
+    uint64_t start = target > OGG_OPUS_PREROLL ? target - OGG_OPUS_PREROLL : 0;
+    uint16_t low = 0, high, mid;
+
+    if (!index->Count)
+        return OGG_STRIP_NO_INDEX;
+
+    // Find the last point with Granule <= start.  The first point is always the first
+    // audio page at granule 0, so low is a safe answer.
+    high = index->Count;
+    while (high - low > 1) {
+        mid = (low + high) / 2;
+        if (index->Points[mid].Granule <= start)
+            low = mid;
+        else
+            high = mid;
+    }
+
+    OggStreamJump(stream, index->Points[low].Offset);
+    return (int32_t)(target - index->Points[low].Granule);
+}
+
+// Find the first page of this stream that starts in [offset, limit), using the reader's
+// buffer as scratch.  Usually that's one OGG_BISECT_WINDOW read; a second is needed if
+// the header straddles the end of the window, and more if there's no page in the window.
+// A capture pattern can turn up inside packet data by chance, so candidates also have
+// to look like a page header of ours (and pass the CRC, if that's on and the page fits).
+// Returns the page's offset with its header in *header, or an error code.
+static int32_t OggFindPage (oggStream_t * stream, uint32_t offset, uint32_t limit, oggPageHeader_t * header) {
+    oggReader_t * scratch = &stream->Reader;
+    size_t window = scratch->Size < OGG_BISECT_WINDOW ? scratch->Size : OGG_BISECT_WINDOW;
+    size_t got, pos, pageLen, i;
+    int bytesRead;
+
+    if (window < OGG_PAGE_HEADER_LEN + 255)
+        return OGG_STRIP_BUF_SMALL;
+
+    while (offset < limit) {
+        stream->Source->seek(offset);
+        bytesRead = stream->Source->read(scratch->Buffer, window);
+        if (bytesRead < OGG_PAGE_HEADER_LEN)
+            return OGG_STRIP_EOF;
+        got = bytesRead;
+
+        for (pos = 0; pos + OGG_PAGE_HEADER_LEN <= got && offset + pos < limit; pos++) {
+            if (memcmp(scratch->Buffer + pos, "OggS", 4))
+                continue;
+
+            memcpy(header, scratch->Buffer + pos, OGG_PAGE_HEADER_LEN);
+            if (header->Version != 0 || header->SerialNumber != stream->SerialNumber)
+                continue;
+            if (pos + OGG_PAGE_HEADER_LEN + header->Segments > got)
+                break; // Segment table runs off the window; re-read from here.
+
+            memcpy(header->SegmentTable, scratch->Buffer + pos + OGG_PAGE_HEADER_LEN, header->Segments);
+            header->DataLength = 0;
+            for (i = 0; i < header->Segments; i++)
+                header->DataLength += header->SegmentTable[i];
+            pageLen = OGG_PAGE_HEADER_LEN + header->Segments + header->DataLength;
+            if (stream->VerifyCrc && pos + pageLen <= got &&
+                OggCrcUpdate(OggHeaderCrc(header), scratch->Buffer + pos + pageLen - header->DataLength,
+                             header->DataLength) != header->Checksum)
+                continue;
+
+            return offset + pos;
+        }
+
+        if (pos == 0)
+            return OGG_STRIP_EOF;
+        offset += pos;
+    }
+    return OGG_STRIP_EOF;
+}
+
+// Same job as OggSeekToSample, for when there's no index: bisect the file on page
+// granule positions instead.  Each probe reads one window at the midpoint of the range
+// still in play and looks at the first page in it, so a seek costs O(log file size) reads
+// rather than a walk through every page header.
+// We're after the last page whose granule is at or before the start point, since decoding
+// from the page after it starts exactly at that granule.  If that next page opens with
+// the tail of a packet, we can't start there, so back off and look for an earlier page.
+// Needs the stream to have a read buffer (see OggStreamInit), which is used as scratch.
+// Returns samples to discard, as OggSeekToSample does.
+int32_t OggBisectToSample (oggStream_t * stream, uint64_t sample) {
+    oggPageHeader_t header;
+    uint64_t target = sample + stream->IDHeader.PreSkip;
+    uint64_t start = target > OGG_OPUS_PREROLL ? target - OGG_OPUS_PREROLL : 0;
+    uint64_t bestGranule;
+    uint32_t fileSize = stream->Source->size();
+    uint32_t low, high, mid, best;
+    int32_t page;
+
+    if (!stream->Reader.Buffer)
+        return OGG_STRIP_BUF_SMALL;
+
+    for (;;) {
+        // The first audio page follows the headers at granule 0, so it's the fallback.
+        low = best = stream->DataStart;
+        bestGranule = 0;
+        high = fileSize;
+
+        while (low < high) {
+            mid = low + (high - low) / 2;
+            if (high - low <= OGG_BISECT_WINDOW)
+                mid = low; // Close enough; finish off with a short walk.
+
+            page = OggFindPage(stream, mid, high, &header);
+            while (page >= 0 && header.GranulePosition == (uint64_t)-1) // Finishes no packet, tells us nothing.
+                page = OggFindPage(stream, page + 1, high, &header);
+
+            if (page < 0 || header.GranulePosition > start) {
+                if (mid == low)
+                    break; // No usable page left between low and high.
+                high = mid;
+            } else {
+                best = low = page + OGG_PAGE_HEADER_LEN + header.Segments + header.DataLength;
+                bestGranule = header.GranulePosition;
+            }
+        }
+
+        if (best == stream->DataStart)
+            break;
+        page = OggFindPage(stream, best, best + 1, &header);
+        if (page < 0 || !(header.Flags & OGG_FLAG_CONTINUED))
+            break;
+        if (!bestGranule) {
+            best = stream->DataStart;
+            break;
+        }
+        start = bestGranule - 1;
+    }
+
+    OggStreamJump(stream, best);
+    return (int32_t)(target - bestGranule);
+}
+
+// The original single-stream API.  These all share one file-static stream, so only one
+// file can be played through them at a time.
+int OggGetNextDataPage (File * oggFile, uint8_t * destination, size_t maxLength) {
+    defaultStream.Source = oggFile;
+    return OggStreamGetNextDataPage(&defaultStream, destination, maxLength);
+}
+
+int OggGetNextPacket (File * oggFile, uint8_t * destination, size_t maxLength) {
+    defaultStream.Source = oggFile;
+    return OggStreamGetNextPacket(&defaultStream, destination, maxLength);
+}
+
+oggPageHeader_t* OggGetLastPageHeader(void) {
+    return OggStreamGetLastPageHeader(&defaultStream);
+}
+
+bool OggPrepareFile (File * oggFile) {
+    OggStreamInit(&defaultStream, oggFile, NULL, 0);
+    return OggStreamPrepare(&defaultStream);
+}
+
+// Hand the reader its storage.  The buffer belongs to the caller and must outlive the reader.
+// Set SerialNumber to the stream to follow (OggStreamPrepare does this).  Started at the
+// top of a file instead, the reader picks up the first Opus stream by itself.
+void OggReaderInit (oggReader_t * reader, uint8_t * buffer, size_t size) {
+    reader->Buffer = buffer;
+    reader->Size = size;
+    reader->VerifyCrc = false;
+    reader->Prefetch = NULL;
+    reader->BadPages = 0;
+    reader->SerialNumber = 0;
+    OggReaderReset(reader, 0);
+}
+
+// Drop anything buffered and start parsing again at fileOffset, which must be the start
+// of a page.  The file itself must already be positioned there (OggPrepareFile leaves it
+// on the first audio page, so pass oggFile->position() after that).
+// With a Prefetch attached, it is repositioned here instead.
+void OggReaderReset (oggReader_t * reader, uint32_t fileOffset) {
+    reader->Head = 0;
+    reader->Tail = 0;
+    reader->PacketStart = 0;
+    reader->PacketLength = 0;
+    reader->FileOffset = fileOffset;
+    reader->Segment = 0;
+    reader->Page.Segments = 0;
+    reader->Headers = 0;
+    reader->NewStream = false;
+    if (reader->Prefetch)
+        ReadAheadReset(reader->Prefetch, fileOffset);
+}
+
+// Make sure at least `needed` bytes are buffered past Tail.
+// Anything before the packet in progress (or before Tail if there is none) has already
+// been handed out, so when we run low on room the live bytes get slid to the front.
+// That's at most a page, and only happens once per trip through the buffer.
+// Reads are as large as the free space allows and end on an OGG_READ_BLOCK boundary in
+// the file, so the filesystem can serve them as whole sectors.
+static int OggReaderFill (File * oggFile, oggReader_t * reader, size_t needed) {
+    size_t keep, freeLen, readLen, misalign;
+    int bytesRead;
+
+    while (reader->Head - reader->Tail < needed) {
+        keep = reader->PacketLength ? reader->PacketStart : reader->Tail;
+        freeLen = reader->Size - reader->Head;
+        if (freeLen < OGG_READ_BLOCK && keep > 0) {
+            memmove(reader->Buffer, reader->Buffer + keep, reader->Head - keep);
+            reader->Head -= keep;
+            reader->Tail -= keep;
+            reader->PacketStart -= keep;
+            freeLen += keep;
+        }
+
+        misalign = reader->FileOffset % OGG_READ_BLOCK;
+        readLen = (freeLen + misalign) - (freeLen + misalign) % OGG_READ_BLOCK;
+        if (readLen > misalign)
+            readLen -= misalign;
+        else
+            readLen = freeLen; // Less than a block of room left, take what fits.
+
+        if (!readLen)
+            return OGG_STRIP_BUF_SMALL;
+
+        if (reader->Prefetch) {
+            bytesRead = ReadAheadRead(reader->Prefetch, reader->Buffer + reader->Head, readLen);
+            if (!bytesRead)
+                return OGG_STRIP_NOT_READY;
+        } else {
+            bytesRead = oggFile->read(reader->Buffer + reader->Head, readLen);
+        }
+        if (bytesRead <= 0)
+            return OGG_STRIP_EOF;
+        reader->Head += bytesRead;
+        reader->FileOffset += bytesRead;
+    }
+    return OGG_STRIP_OK;
+}
+
+// We've lost our place: Tail is on something that isn't a good page.
+// Any packet in progress is gone, so drop it and scan ahead for the next capture pattern.
+// If the page we land on continues a packet, OggReaderNextPage skips the leftover.
+static int OggReaderResync (File * oggFile, oggReader_t * reader) {
+    const uint8_t * found;
+    size_t scanLen;
+    int err;
+
+    reader->PacketLength = 0;
+    reader->Tail++;
+    for (;;) {
+        err = OggReaderFill(oggFile, reader, 4);
+        if (err != OGG_STRIP_OK)
+            return err;
+
+        // Look for an 'O' with "ggS" after it.  Stop 3 short of the end so the match
+        // fits, and carry those last 3 bytes over into the next fill.
+        scanLen = reader->Head - reader->Tail - 3;
+        found = (const uint8_t *)memchr(reader->Buffer + reader->Tail, 'O', scanLen);
+        while (found && memcmp(found, "OggS", 4)) {
+            found++;
+            found = (const uint8_t *)memchr(found, 'O', reader->Buffer + reader->Tail + scanLen - found);
+        }
+
+        if (found) {
+            reader->Tail = found - reader->Buffer;
+            return OGG_STRIP_OK;
+        }
+        reader->Tail += scanLen;
+    }
+}
+
+// Buffer the whole page sitting at Tail, parse its header and leave Tail on its data.
+// If the page is bad (no capture pattern, or a CRC mismatch when checking is on), it's
+// counted in BadPages and we resync to the next page.
+// Pages of other logical streams are stepped over.  A BOS page starting with OpusHead is a
+// new Opus stream though, and as a multiplexed file's BOS pages all come before any audio,
+// it can only be the next track of a chained file: switch to it.
+// If a packet is carried over from the previous page, its bytes sit in front of this page's
+// header (and of any other streams' pages skipped since), so shuffle them up to join them
+// to the rest.
+static int OggReaderNextPage (File * oggFile, oggReader_t * reader) {
+    oggPageHeader_t * header = &reader->Page;
+    size_t headerLen, i;
+    int err;
+
+    for (;;) {
+        err = OggReaderFill(oggFile, reader, OGG_PAGE_HEADER_LEN);
+        if (err != OGG_STRIP_OK)
+            return err;
+
+        memcpy(header, reader->Buffer + reader->Tail, OGG_PAGE_HEADER_LEN);
+        if (header->Signature != OGGS_MAGIC) {
+            reader->BadPages++;
+            err = OggReaderResync(oggFile, reader);
+            if (err != OGG_STRIP_OK)
+                return err;
+            continue;
+        }
+
+        headerLen = OGG_PAGE_HEADER_LEN + header->Segments;
+        err = OggReaderFill(oggFile, reader, headerLen);
+        if (err != OGG_STRIP_OK)
+            return err;
+
+        memcpy(header->SegmentTable, reader->Buffer + reader->Tail + OGG_PAGE_HEADER_LEN, header->Segments);
+        header->DataLength = 0;
+        for (i = 0; i < header->Segments; i++)
+            header->DataLength += header->SegmentTable[i];
+
+        err = OggReaderFill(oggFile, reader, headerLen + header->DataLength);
+        if (err == OGG_STRIP_BUF_SMALL && reader->VerifyCrc) {
+            // Most likely a damaged segment table; either way we couldn't check it.
+            reader->BadPages++;
+            err = OggReaderResync(oggFile, reader);
+            if (err != OGG_STRIP_OK)
+                return err;
+            continue;
+        }
+        if (err != OGG_STRIP_OK)
+            return err;
+
+        if (reader->VerifyCrc &&
+            OggCrcUpdate(OggHeaderCrc(header), reader->Buffer + reader->Tail + headerLen,
+                         header->DataLength) != header->Checksum) {
+            reader->BadPages++;
+            err = OggReaderResync(oggFile, reader);
+            if (err != OGG_STRIP_OK)
+                return err;
+            continue;
+        }
+
+        if (header->SerialNumber != reader->SerialNumber) {
+            if ( !(header->Flags & OGG_FLAG_BOS) || header->DataLength < 8 ||
+                 memcmp(reader->Buffer + reader->Tail + headerLen, "OpusHead", 8) ) {
+                reader->Tail += headerLen + header->DataLength;
+                continue;
+            }
+            reader->SerialNumber = header->SerialNumber;
+            reader->PacketLength = 0; // Anything unfinished from the last track is dropped.
+            reader->Headers = 2;
+        }
+        break;
+    }
+
+    reader->Segment = 0;
+    if (reader->PacketLength) {
+        if (header->Flags & OGG_FLAG_CONTINUED) {
+            memmove(reader->Buffer + reader->Tail + headerLen - reader->PacketLength,
+                    reader->Buffer + reader->PacketStart, reader->PacketLength);
+            reader->PacketStart = reader->Tail + headerLen - reader->PacketLength;
+        } else {
+            reader->PacketLength = 0; // The rest of that packet never showed up, drop it.
+        }
+    } else if ((header->Flags & OGG_FLAG_CONTINUED) && reader->Headers != 1) {
+        // We came in partway through a packet (fresh start or a seek), so skip its tail.
+        while (reader->Segment < header->Segments) {
+            reader->Tail += header->SegmentTable[reader->Segment];
+            if (header->SegmentTable[reader->Segment++] < 255)
+                break;
+        }
+    }
+    reader->Tail += headerLen;
+    return OGG_STRIP_OK;
+}
+
+// Point packet at the next complete packet in the stream and return its length.
+// Nothing is copied; the view points into the reader's buffer and stays valid until the
+// next call.  Returns an OGG_STRIP_ error code (and leaves packet alone) on failure.
+// NewStream is set if the packet is the OpusHead of a new stream the reader has switched to.
+int OggReaderGetNextPacket (File * oggFile, oggReader_t * reader, const uint8_t ** packet) {
+    uint8_t lacing;
+    int err;
+
+    reader->NewStream = false;
+    for (;;) {
+        // If we're done with the previous page and need a new one.
+        if (reader->Segment >= reader->Page.Segments) {
+            err = OggReaderNextPage(oggFile, reader);
+            if (err != OGG_STRIP_OK) {
+                // Page may be half parsed; make sure a retry starts it over.
+                reader->Segment = reader->Page.Segments = 0;
+                return err;
+            }
+            continue; // The page may have been all continuation, or have no segments at all.
+        }
+
+        lacing = reader->Page.SegmentTable[reader->Segment++];
+        if (reader->Headers == 1) {
+            // Skipping the new stream's OpusTags.  None of it is kept, so it can be any size.
+            reader->Tail += lacing;
+            if (lacing < 255)
+                reader->Headers = 0;
+            continue;
+        }
+
+        if (!reader->PacketLength)
+            reader->PacketStart = reader->Tail;
+        reader->Tail += lacing;
+        reader->PacketLength += lacing;
+
+        if (lacing < 255) {
+            // That's the end of the packet.  Zero length packets are legal (the decoder
+            // treats them as lost), so they're passed along too.
+            *packet = reader->Buffer + reader->PacketStart;
+            if (reader->Headers == 2) {
+                reader->Headers = 1;
+                reader->NewStream = true;
+            }
+            err = reader->PacketLength;
+            reader->PacketLength = 0;
+            return err;
+        }
+    }
+}
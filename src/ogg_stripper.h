@@ -2,13 +2,24 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "read_ahead.h"
 
 #ifndef OGG_STRIPPER_H
+#define OGG_STRIPPER_H
 
 #define OGGS_MAGIC     0x5367674F // "OggS" NOTE: Might change due to endianness?
 #define OPUSHEAD_MAGIC 0x646165487375704F // "OpusHead"
 #define OPUSTAGS_MAGIC 0x736761547375704F // "OpusTags"
 
+#define OGG_PAGE_HEADER_LEN 27  // Fixed part of the page header, up to and including Segments.
+#define OGG_FLAG_CONTINUED  0x01 // First packet on the page continues from the previous page.
+#define OGG_FLAG_BOS        0x02 // First page of a logical stream.
+#define OGG_FLAG_EOS        0x04 // Last page of a logical stream.
+#define OGG_READ_BLOCK      512 // Storage block size.  Buffered reads are issued in whole, aligned blocks.
+#define OGG_OPUS_PREROLL    3840 // 80 ms at 48 kHz.  Decode this much ahead of a seek target before using the output.
+#define OGG_BISECT_WINDOW   4096 // Bytes read at each bisection probe.  Should cover a page or two.
+#define OGG_SEEK_INDEX_MAGIC 0x3249534F // "OSI2", sidecar seek index file signature.
+
 typedef struct __attribute((packed)) {
     uint32_t Signature;
     uint8_t Version;
@@ -37,13 +48,80 @@ typedef struct __attribute((packed)) {
     uint32_t VendorStringLength;
 } oggCommentHeader_t;
 
+// Buffered packet reader.
+// Pages are pulled into a caller-owned buffer in large block-aligned reads, and packets
+// are handed out as pointer/length views into that buffer.  Packets that span lacing runs
+// or pages are stitched together in place, so a view is always contiguous.
+// The buffer needs to hold at least one full page plus a packet in progress.  Encoders
+// usually cap pages around 4 KB, so 8 KB is a comfortable size.
+// A returned view stays valid until the next call into the reader.
+// Only pages of one logical stream (SerialNumber) are used; pages of any other stream
+// multiplexed into the file are stepped over.  When a new Opus stream starts (a BOS page
+// opening with OpusHead, as at each track change in a chained file) the reader follows
+// it: the OpusHead packet is handed out with NewStream set, and the OpusTags dropped.
+typedef struct {
+    uint8_t * Buffer;      // Caller-owned storage.
+    size_t Size;           // Length of Buffer.
+    size_t Head;           // One past the last valid byte in Buffer.
+    size_t Tail;           // Next byte to be parsed.
+    size_t PacketStart;    // Start of the packet being assembled.
+    size_t PacketLength;   // Bytes of that packet seen so far.
+    uint32_t FileOffset;   // File offset of Buffer[Head], i.e. where the next read lands.
+    uint8_t Segment;       // Next lacing value to consume from Page.
+    bool VerifyCrc;        // Check each page's CRC before using it.
+    readAhead_t * Prefetch; // If set, pull data from here instead of the file.
+    uint32_t BadPages;     // Pages skipped for a bad capture pattern or CRC.
+    uint32_t SerialNumber; // Logical stream being followed.
+    uint8_t Headers;       // Header packets of a new stream still to come: 2 = OpusHead, 1 = OpusTags.
+    bool NewStream;        // The packet just returned is a new stream's OpusHead.
+    oggPageHeader_t Page;  // Header of the page currently being unpacked.
+} oggReader_t;
+
+// Everything needed to demux one Ogg Opus file.
+typedef struct {
+    File * Source;
+    oggPageHeader_t PageHeader;      // Last page header read by the unbuffered calls.
+    oggIDHeader_t IDHeader;
+    oggCommentHeader_t CommentHeader;
+    uint8_t Segment;                 // Next lacing value to consume from PageHeader.
+    uint32_t DataStart;              // File offset of the first audio page.
+    uint32_t SerialNumber;           // Logical stream serial, from the ID header page (or the current link).
+    bool VerifyCrc;                  // Check page CRCs in the unbuffered data page call.
+    oggReader_t Reader;              // Buffered packet reader, for the packet view call.
+} oggStream_t;
+
+// One entry in a seek index: a page that starts with a fresh packet, and the granule
+// position (48 kHz samples, pre-skip included) of that packet's first sample.
+// Packed, because the sidecar holds these as they are: 12 bytes each, whatever the ABI.
+typedef struct __attribute((packed)) {
+    uint64_t Granule;
+    uint32_t Offset;
+} oggSeekPoint_t;
+
+// Sparse granule -> file offset map, built once per file by OggSeekIndexBuild.
+// Points are kept at least Spacing samples apart.  If the caller's array fills up,
+// every other point is dropped and Spacing doubled, so any file fits in any capacity of
+// two or more.  Points[0] is always the first audio page, at granule 0.
+typedef struct {
+    oggSeekPoint_t * Points;  // Caller-owned, Capacity (at least 2) entries.
+    uint16_t Capacity;
+    uint16_t Count;
+    uint32_t Spacing;
+    uint32_t FileSize;        // Size of the indexed file, to spot stale sidecars.
+} oggSeekIndex_t;
+
 enum {
     OGG_STRIP_OK = 0,
     OGG_STRIP_ERR_UNKNOWN = -1,
     OGG_STRIP_EOF = -2,
     OGG_STRIP_BAD_MAGIC = -3,
     OGG_STRIP_NO_SEGS = -4,
-    OGG_STRIP_LEN_SHORT = -5
+    OGG_STRIP_LEN_SHORT = -5,
+    OGG_STRIP_BUF_SMALL = -6,
+    OGG_STRIP_BAD_CRC = -7,
+    OGG_STRIP_NO_INDEX = -8,
+    OGG_STRIP_NOT_READY = -9,
+    OGG_STRIP_NEW_STREAM = -10
 };
 
 int OggReadPageHeader (File * oggFile, oggPageHeader_t * header);
@@ -53,6 +131,24 @@ oggPageHeader_t* OggGetLastPageHeader(void);
 int OggGetIDHeader (File * oggFile, oggIDHeader_t * destination, int dataLen);
 int OggGetCommentHeader (File * oggFile, oggCommentHeader_t * destination, int dataLen);
 bool OggPrepareFile (File * oggFile);
+void OggStreamInit (oggStream_t * stream, File * oggFile, uint8_t * buffer, size_t size);
+bool OggStreamPrepare (oggStream_t * stream);
+int OggStreamGetNextDataPage (oggStream_t * stream, uint8_t * destination, size_t maxLength);
+int OggStreamGetNextPacket (oggStream_t * stream, uint8_t * destination, size_t maxLength);
+int OggStreamGetNextPacketView (oggStream_t * stream, const uint8_t ** packet);
+oggPageHeader_t* OggStreamGetLastPageHeader (oggStream_t * stream);
+void OggStreamSetCrcCheck (oggStream_t * stream, bool enable);
+void OggStreamSetPrefetch (oggStream_t * stream, readAhead_t * prefetch);
+uint32_t OggCrcUpdate (uint32_t crc, const uint8_t * data, size_t length);
+void OggSeekIndexInit (oggSeekIndex_t * index, oggSeekPoint_t * points, uint16_t capacity, uint32_t spacing);
+int OggSeekIndexBuild (oggStream_t * stream, oggSeekIndex_t * index);
+int OggSeekIndexSave (File * indexFile, const oggSeekIndex_t * index);
+int OggSeekIndexLoad (File * indexFile, oggSeekIndex_t * index, uint32_t oggFileSize);
+int32_t OggSeekToSample (oggStream_t * stream, const oggSeekIndex_t * index, uint64_t sample);
+int32_t OggBisectToSample (oggStream_t * stream, uint64_t sample);
+void OggReaderInit (oggReader_t * reader, uint8_t * buffer, size_t size);
+void OggReaderReset (oggReader_t * reader, uint32_t fileOffset);
+int OggReaderGetNextPacket (File * oggFile, oggReader_t * reader, const uint8_t ** packet);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <Adafruit_SPIFlash.h>
+#include "opk_reader.h"
+
+// Encode value as an .opk varint.  destination needs room for OPK_MAX_VARINT_LEN bytes.
+// Returns the number of bytes written.  Used by the host-side packer.
+size_t OpkWriteVarint (uint8_t * destination, uint32_t value) {
+    size_t len = 0;
+    while (value >= 0x80) {
+        destination[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    destination[len++] = (uint8_t)value;
+    return len;
+}
+
+// Number of entries in the offset table.
+static uint32_t OpkIndexEntries (const opkHeader_t * header) {
+    return (header->PacketCount + header->IndexStride - 1) / header->IndexStride;
+}
+
+// Make sure at least `needed` bytes are buffered past Tail, sliding what's left to the
+// front when we run out of room.  See OggReaderFill; it's the same idea.
+static int OpkFill (opkReader_t * reader, size_t needed) {
+    size_t freeLen, readLen, misalign;
+    int bytesRead;
+
+    while (reader->Head - reader->Tail < needed) {
+        freeLen = reader->Size - reader->Head;
+        if (freeLen < OPK_READ_BLOCK && reader->Tail > 0) {
+            memmove(reader->Buffer, reader->Buffer + reader->Tail, reader->Head - reader->Tail);
+            reader->Head -= reader->Tail;
+            freeLen += reader->Tail;
+            reader->Tail = 0;
+        }
+
+        misalign = reader->FileOffset % OPK_READ_BLOCK;
+        readLen = (freeLen + misalign) - (freeLen + misalign) % OPK_READ_BLOCK;
+        if (readLen > misalign)
+            readLen -= misalign;
+        else
+            readLen = freeLen; // Less than a block of room left, take what fits.
+
+        if (!readLen)
+            return OPK_BUF_SMALL;
+
+        if (reader->Prefetch) {
+            bytesRead = ReadAheadRead(reader->Prefetch, reader->Buffer + reader->Head, readLen);
+            if (!bytesRead)
+                return OPK_NOT_READY;
+        } else {
+            bytesRead = reader->Source->read(reader->Buffer + reader->Head, readLen);
+        }
+        if (bytesRead <= 0)
+            return OPK_EOF;
+        reader->Head += bytesRead;
+        reader->FileOffset += bytesRead;
+    }
+    return OPK_OK;
+}
+
+// Read and check the header, then leave the reader on the first packet.
+// buffer is the caller's read buffer; it must outlive the reader.
+// prefetch is optional: if given, packet data is pulled from it rather than the file (see
+// OggStreamSetPrefetch), and OPK_NOT_READY returned when it has nothing ready yet.
+int OpkOpen (opkReader_t * reader, File * opkFile, uint8_t * buffer, size_t size, readAhead_t * prefetch) {
+    memset(reader, 0, sizeof(*reader));
+    reader->Source = opkFile;
+    reader->Prefetch = prefetch;
+    reader->Buffer = buffer;
+    reader->Size = size;
+
+    opkFile->seek(0);
+    if ( opkFile->readBytes((char *)&reader->Header, sizeof(opkHeader_t)) != sizeof(opkHeader_t) )
+        return OPK_EOF;
+    if (reader->Header.Signature != OPK_MAGIC)
+        return OPK_BAD_MAGIC;
+    if (reader->Header.Version != OPK_VERSION)
+        return OPK_BAD_VERSION;
+    if (!reader->Header.IndexStride)
+        return OPK_BAD_LENGTH;
+
+    reader->DataStart = sizeof(opkHeader_t) + OpkIndexEntries(&reader->Header) * sizeof(uint32_t);
+    return OpkSeekToPacket(reader, 0);
+}
+
+// Point packet at the next packet and return its length, or OPK_EOF after the last one.
+// Nothing is copied, and there's no framing to parse beyond the length prefix.
+int OpkGetNextPacket (opkReader_t * reader, const uint8_t ** packet) {
+    uint32_t length = 0;
+    size_t prefixLen = 0;
+    uint8_t byte;
+    int err;
+
+    if (reader->Packet >= reader->Header.PacketCount)
+        return OPK_EOF;
+
+    // The prefix may be cut short by the end of the file only if the file is broken,
+    // so ask for one byte at a time rather than OPK_MAX_VARINT_LEN up front.
+    do {
+        err = OpkFill(reader, prefixLen + 1);
+        if (err != OPK_OK)
+            return err;
+        byte = reader->Buffer[reader->Tail + prefixLen];
+        length |= (uint32_t)(byte & 0x7F) << (7 * prefixLen);
+        prefixLen++;
+    } while ((byte & 0x80) && prefixLen < OPK_MAX_VARINT_LEN);
+    if (byte & 0x80)
+        return OPK_BAD_LENGTH;
+
+    err = OpkFill(reader, prefixLen + length);
+    if (err != OPK_OK)
+        return err;
+
+    *packet = reader->Buffer + reader->Tail + prefixLen;
+    reader->Tail += prefixLen + length;
+    reader->Packet++;
+    return length;
+}
+
+// Jump to any packet with one table lookup, one seek, and a walk over the length prefixes
+// of at most IndexStride - 1 packets before it.
+// The caller works out which packet it wants; with fixed frame sizes that's just
+// sample / samples-per-packet.  Remember the decoder needs some run-in (80 ms) after a jump.
+int OpkSeekToPacket (opkReader_t * reader, uint32_t packet) {
+    readAhead_t * prefetch = reader->Prefetch;
+    const uint8_t * skipped;
+    uint32_t offset;
+    int err = OPK_OK;
+
+    if (packet >= reader->Header.PacketCount)
+        return OPK_EOF;
+
+    reader->Source->seek(sizeof(opkHeader_t) + packet / reader->Header.IndexStride * sizeof(uint32_t));
+    if ( reader->Source->readBytes((char *)&offset, sizeof(offset)) != sizeof(offset) )
+        return OPK_EOF;
+
+    reader->FileOffset = reader->DataStart + offset;
+    reader->Source->seek(reader->FileOffset);
+    reader->Head = reader->Tail = 0;
+    reader->Packet = packet - packet % reader->Header.IndexStride;
+
+    // Step over the packets in between straight from the file; whatever that leaves in
+    // Buffer is still good, and the read-ahead picks up from the end of it.
+    reader->Prefetch = NULL;
+    while (reader->Packet < packet && err >= 0)
+        err = OpkGetNextPacket(reader, &skipped);
+    reader->Prefetch = prefetch;
+    if (err < 0)
+        return err;
+
+    if (prefetch)
+        ReadAheadReset(prefetch, reader->FileOffset);
+    return OPK_OK;
+}
@@ -0,0 +1,69 @@
+// Opus packet container (.opk) reader header file
+// An .opk is Ogg Opus with the Ogg framing already stripped off on the host, so the
+// device never parses a page.  Layout, all little-endian:
+//   opkHeader_t
+//   ceil(PacketCount / IndexStride) x uint32_t
+//                            Offset of every IndexStride'th packet's length prefix, from the
+//                            start of the data.
+//   data                     Each packet is a varint length (7 bits per byte, low bits first,
+//                            top bit set on all but the last byte) followed by the packet.
+// A sparse table keeps the container smaller than the Ogg it came from; seeking pays for it
+// by stepping over at most IndexStride - 1 length prefixes.
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "read_ahead.h"
+
+#ifndef OPK_READER_H
+#define OPK_READER_H
+
+#define OPK_MAGIC   0x314B504F // "OPK1"
+#define OPK_VERSION 2
+#define OPK_INDEX_STRIDE 32 // Packets per offset table entry, as written by the packer.
+#define OPK_READ_BLOCK 512 // Storage block size.  Reads are issued in whole, aligned blocks.
+#define OPK_MAX_VARINT_LEN 3 // Enough for any packet under 2 MB, and Opus packets are far smaller.
+
+typedef struct __attribute((packed)) {
+    uint32_t Signature;
+    uint8_t Version;
+    uint8_t ChannelCount;
+    uint16_t PreSkip;          // Straight from OpusHead.
+    int16_t OutputGain;        // Q7.8 dB, straight from OpusHead.
+    uint16_t IndexStride;      // Packets per offset table entry.
+    uint32_t InputSampleRate;  // Informational, straight from OpusHead.
+    uint32_t PacketCount;
+    uint64_t SampleCount;      // Final granule position (48 kHz, pre-skip included).
+} opkHeader_t;
+
+// Same buffering scheme as oggReader_t: large block-aligned reads into a caller-owned
+// buffer, packets handed out as pointer/length views that stay valid until the next call.
+typedef struct {
+    File * Source;
+    opkHeader_t Header;
+    uint8_t * Buffer;      // Caller-owned storage.  Must hold the largest packet plus its prefix.
+    size_t Size;
+    size_t Head;           // One past the last valid byte in Buffer.
+    size_t Tail;           // Next byte to be parsed.
+    uint32_t FileOffset;   // File offset of Buffer[Head].
+    uint32_t DataStart;    // File offset of the first packet's length prefix.
+    uint32_t Packet;       // Index of the next packet to be returned.
+    readAhead_t * Prefetch; // If set, packet data comes from here instead of the file.
+} opkReader_t;
+
+enum {
+    OPK_OK = 0,
+    OPK_ERR_UNKNOWN = -1,
+    OPK_EOF = -2,
+    OPK_BAD_MAGIC = -3,
+    OPK_BAD_VERSION = -4,
+    OPK_BAD_LENGTH = -5,
+    OPK_BUF_SMALL = -6,
+    OPK_NOT_READY = -7
+};
+
+int OpkOpen (opkReader_t * reader, File * opkFile, uint8_t * buffer, size_t size, readAhead_t * prefetch);
+int OpkGetNextPacket (opkReader_t * reader, const uint8_t ** packet);
+int OpkSeekToPacket (opkReader_t * reader, uint32_t packet);
+size_t OpkWriteVarint (uint8_t * destination, uint32_t value);
+
+#endif
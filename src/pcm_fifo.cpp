@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "pcm_fifo.h"
+
+// Head, Tail and EndOfStream are all the two sides share; see read_ahead.cpp.
+#define PCM_FIFO_LOAD(x)      __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define PCM_FIFO_STORE(x, v)  __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define PCM_FIFO_SLOT(fifo, n) ((fifo)->Frames[(n) & (PCM_FIFO_FRAMES - 1)])
+
+// Set up an empty FIFO.  fill may be NULL if the caller only uses WriteSlot and Commit.
+void PcmFifoInit (pcmFifo_t * fifo, pcmFill_t fill, void * context) {
+    memset(fifo, 0, sizeof(*fifo));
+    fifo->Fill = fill;
+    fifo->Context = context;
+}
+
+// Empty the FIFO, ready for a new stream.  The I2S must be stopped.
+void PcmFifoReset (pcmFifo_t * fifo) {
+    fifo->Head = 0;
+    fifo->Tail = 0;
+    fifo->Queued = 0;
+    fifo->EndOfStream = false;
+    fifo->Offset = 0;
+    fifo->SpillLength = 0;
+}
+
+// The slot to decode the next frame into, or NULL if every slot is still with the I2S.
+// A slot only comes free once the I2S has released it, so nothing here is ever being read
+// by the DMA.  Fill the whole frame, then commit it.
+int16_t * PcmFifoWriteSlot (pcmFifo_t * fifo) {
+    uint32_t head = fifo->Head;
+
+    if (head - PCM_FIFO_LOAD(fifo->Tail) >= PCM_FIFO_FRAMES)
+        return NULL;
+    return PCM_FIFO_SLOT(fifo, head);
+}
+
+// Hand the slot from PcmFifoWriteSlot over to the I2S.
+void PcmFifoCommit (pcmFifo_t * fifo) {
+    PCM_FIFO_STORE(fifo->Head, fifo->Head + 1);
+}
+
+// Mark the end of the stream, after the last commit.
+void PcmFifoEnd (pcmFifo_t * fifo) {
+    PCM_FIFO_STORE(fifo->EndOfStream, true);
+}
+
+// Decode into every free slot with the Fill callback.  Call this from the decode task
+// whenever the I2S handler has taken a frame, and once before starting the I2S to prime
+// the FIFO.
+// Fill writes straight into the slot wherever what it produces fits the room left; only a
+// packet that straddles two frames goes through Spill, and only that packet is copied.
+// A frame is committed once it's full, or at the end, padded with silence.
+// Returns true if anything was committed.
+bool PcmFifoService (pcmFifo_t * fifo) {
+    int16_t * frame;
+    size_t room;
+    bool busy = false;
+    int samples;
+
+    while (!fifo->EndOfStream && (frame = PcmFifoWriteSlot(fifo)) != NULL) {
+        frame += fifo->Offset;
+        room = PCM_FIFO_FRAME_LENGTH - fifo->Offset;
+
+        if (fifo->SpillLength) {
+            // Finish off the packet that overflowed the last frame.
+            samples = fifo->SpillLength < room ? fifo->SpillLength : room;
+            memcpy(frame, fifo->Spill + fifo->SpillStart, samples * sizeof(int16_t));
+            fifo->SpillStart += samples;
+            fifo->SpillLength -= samples;
+        } else {
+            samples = fifo->Fill(fifo->Context, frame, room);
+            if (samples == PCM_FIFO_NO_ROOM) {
+                samples = fifo->Fill(fifo->Context, fifo->Spill, PCM_FIFO_SPILL_LENGTH);
+                if (samples >= 0) {
+                    fifo->SpillStart = 0;
+                    fifo->SpillLength = samples;
+                    continue; // Copied in next time round.
+                }
+            }
+            if (samples < 0) {
+                // Pad out and send whatever's left, then stop.
+                if (fifo->Offset) {
+                    memset(frame, 0, room * sizeof(int16_t));
+                    fifo->Offset = 0;
+                    PcmFifoCommit(fifo);
+                    busy = true;
+                }
+                PcmFifoEnd(fifo);
+                break;
+            }
+        }
+
+        fifo->Offset += samples;
+        if (fifo->Offset == PCM_FIFO_FRAME_LENGTH) {
+            fifo->Offset = 0;
+            PcmFifoCommit(fifo);
+            busy = true;
+        }
+    }
+    return busy;
+}
+
+// Called from the I2S handler with the buffer the peripheral just finished with (NULL if
+// none), and returns the buffer to queue next.  Never decodes, never blocks, never copies.
+// If the decoder hasn't got a frame ready, that's an underrun, and silence is queued
+// instead.  Returns NULL once the stream has ended and the last frame has played out,
+// at which point the I2S can be stopped.
+int16_t * PcmFifoNext (pcmFifo_t * fifo, const int16_t * released) {
+    uint32_t queued = fifo->Queued;
+    bool ended;
+
+    if (released && released != fifo->Silence)
+        PCM_FIFO_STORE(fifo->Tail, fifo->Tail + 1); // Frames come back in order.
+
+    // EndOfStream goes up after the last frame, so check it first: if it's set, Head
+    // is already final.
+    ended = PCM_FIFO_LOAD(fifo->EndOfStream);
+    if (queued != PCM_FIFO_LOAD(fifo->Head)) {
+        fifo->Queued = queued + 1;
+        return PCM_FIFO_SLOT(fifo, queued);
+    }
+
+    if (ended) {
+        if (fifo->Tail == queued)
+            return NULL;
+    } else {
+        fifo->Underruns++;
+    }
+    return fifo->Silence;
+}
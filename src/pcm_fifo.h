@@ -0,0 +1,79 @@
+// PCM FIFO header file
+// Decoded audio waiting for the I2S peripheral, so decoding can happen outside the I2S
+// interrupt.  A single-producer, single-consumer ring of fixed-size frames: the decode
+// task (anything running below the I2S interrupt's priority) decodes straight into a free
+// slot and commits it, and the I2S handler calls PcmFifoNext for the slot to give
+// nrfx_i2s_next_buffers_set, which is only a pointer swap.  Nothing is ever copied.
+// The two sides share nothing but the Head and Tail counters (and the end flag), each
+// written by one side only, so there's no locking and no masking of interrupts, and
+// neither side ever waits on the other.
+// PcmFifoService also reframes: the decoder hands over however many samples a packet
+// holds (2.5 to 120 ms of them), and they're packed end to end into fixed-size frames.
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef PCM_FIFO_H
+#define PCM_FIFO_H
+
+// Sized at compile time; override from build_flags.
+#ifndef PCM_FIFO_FRAMES
+#define PCM_FIFO_FRAMES 4 // Two in the I2S, two decoded ahead.  A power of two, at least 4.
+#endif
+#ifndef PCM_FIFO_FRAME_LENGTH
+// Samples per frame, i.e. per I2S buffer, counting each half of a stereo pair.  Shorter
+// frames mean less latency but more interrupts.  Any even length works, but a multiple of
+// the packet length lets packets decode straight into the frame; 1280 is 40 ms of stereo
+// pairs at 16 kHz, which every Opus frame size up to 40 ms divides.
+#define PCM_FIFO_FRAME_LENGTH 1280
+#endif
+#ifndef PCM_FIFO_SPILL_LENGTH
+#define PCM_FIFO_SPILL_LENGTH 3840 // Most samples one Fill can produce: 120 ms of pairs at 16 kHz.
+#endif
+
+#if (PCM_FIFO_FRAMES & (PCM_FIFO_FRAMES - 1)) || PCM_FIFO_FRAMES < 4
+#error "PCM_FIFO_FRAMES must be a power of two, and at least 4."
+#endif
+#if PCM_FIFO_FRAME_LENGTH & 1
+#error "PCM_FIFO_FRAME_LENGTH must be even: the I2S moves 32-bit words."
+#endif
+
+// Where audio comes from, for PcmFifoService.  Write up to samples samples into
+// destination and return how many were written, or a negative number once there's no
+// more.  If the next lot won't fit, return PCM_FIFO_NO_ROOM and hold on to it: it's asked
+// for again with PCM_FIFO_SPILL_LENGTH samples of room.
+// Called only from PcmFifoService, so it can take as long as it likes (within reason).
+typedef int (*pcmFill_t)(void * context, int16_t * destination, size_t samples);
+
+#define PCM_FIFO_NO_ROOM (-0x10000)
+
+typedef struct {
+    // EasyDMA reads whole words, so the frames must be word aligned.
+    int16_t Frames[PCM_FIFO_FRAMES][PCM_FIFO_FRAME_LENGTH] __attribute__((aligned(4)));
+    int16_t Silence[PCM_FIFO_FRAME_LENGTH] __attribute__((aligned(4))); // Played when the decoder falls behind.
+    pcmFill_t Fill;
+    void * Context;               // Handed back to Fill.
+    uint32_t Head;                // Frames committed.  Written by the decode side only.
+    uint32_t Tail;                // Frames the I2S has finished with.  Written by the I2S side only.
+    uint32_t Queued;              // Frames handed to the I2S.  I2S side only.
+    bool EndOfStream;             // No more frames coming.  Published after the last one.
+    uint32_t Underruns;           // Times the I2S wanted a frame and got silence.
+    // Reframing.  Decode side only.
+    size_t Offset;                // Samples already in the slot being filled.
+    int16_t Spill[PCM_FIFO_SPILL_LENGTH]; // A packet that didn't fit the room left in the slot.
+    size_t SpillStart, SpillLength;
+} pcmFifo_t;
+
+void PcmFifoInit (pcmFifo_t * fifo, pcmFill_t fill, void * context);
+void PcmFifoReset (pcmFifo_t * fifo);
+
+// Decode side.
+int16_t * PcmFifoWriteSlot (pcmFifo_t * fifo);
+void PcmFifoCommit (pcmFifo_t * fifo);
+void PcmFifoEnd (pcmFifo_t * fifo);
+bool PcmFifoService (pcmFifo_t * fifo);
+
+// I2S side.
+int16_t * PcmFifoNext (pcmFifo_t * fifo, const int16_t * released);
+
+#endif
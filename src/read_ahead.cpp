@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "read_ahead.h"
+
+// Produced and Consumed are the only things both sides touch.  Each is written by one side
+// and read by the other, so all that's needed is to publish them after the block data
+// (release) and pick them up before looking at the data (acquire).  On a single core M4
+// that's just a compiler barrier; on the host it keeps threads honest.
+#define READ_AHEAD_LOAD(x)      __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define READ_AHEAD_STORE(x, v)  __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+// Set up a read-ahead over the caller's block storage.
+void ReadAheadInit (readAhead_t * readAhead, blockRead_t read, void * context,
+                    uint8_t * blocks, size_t blockSize, uint32_t count) {
+    memset(readAhead, 0, sizeof(*readAhead));
+    readAhead->Read = read;
+    readAhead->Context = context;
+    readAhead->Blocks = blocks;
+    readAhead->BlockSize = blockSize;
+    readAhead->Count = count > READ_AHEAD_MAX_BLOCKS ? READ_AHEAD_MAX_BLOCKS : count;
+    ReadAheadReset(readAhead, 0);
+}
+
+// Throw away anything fetched and carry on from offset.
+// Blocks are always read on BlockSize boundaries, so the first one may start a little
+// before offset; ReadAheadRead skips that part.
+// Both sides have to be idle while this runs (e.g. call it from the same context as
+// ReadAheadService, with the audio stopped).
+void ReadAheadReset (readAhead_t * readAhead, uint32_t offset) {
+    readAhead->NextOffset = offset - offset % readAhead->BlockSize;
+    readAhead->ReadPos = offset % readAhead->BlockSize;
+    readAhead->Produced = 0;
+    readAhead->Consumed = 0;
+    readAhead->EndOfData = false;
+}
+
+// Fill any free blocks from the source.  Call this often from outside the audio path.
+// Returns true if anything was read.
+bool ReadAheadService (readAhead_t * readAhead) {
+    uint32_t produced = readAhead->Produced;
+    uint8_t * block;
+    bool busy = false;
+    int bytesRead;
+
+    while (!readAhead->EndOfData && produced - READ_AHEAD_LOAD(readAhead->Consumed) < readAhead->Count) {
+        block = readAhead->Blocks + (produced % readAhead->Count) * readAhead->BlockSize;
+        bytesRead = readAhead->Read(readAhead->Context, readAhead->NextOffset, block, readAhead->BlockSize);
+        if (bytesRead < 0)
+            bytesRead = 0;
+
+        readAhead->Lengths[produced % readAhead->Count] = bytesRead;
+        readAhead->NextOffset += bytesRead;
+        if ((size_t)bytesRead < readAhead->BlockSize)
+            readAhead->EndOfData = true; // Published by the store below.
+        produced++;
+        READ_AHEAD_STORE(readAhead->Produced, produced);
+        busy = true;
+    }
+    return busy;
+}
+
+// Copy up to length bytes of whatever is already fetched into destination.
+// Never touches storage.  Returns the number of bytes copied, 0 if nothing is ready yet
+// (counted as an underrun), or READ_AHEAD_EOF once everything has been handed out.
+int ReadAheadRead (readAhead_t * readAhead, uint8_t * destination, size_t length) {
+    uint32_t consumed = readAhead->Consumed;
+    uint32_t produced = READ_AHEAD_LOAD(readAhead->Produced);
+    size_t copied = 0, filled, available, chunk;
+    const uint8_t * block;
+
+    while (copied < length && consumed != produced) {
+        block = readAhead->Blocks + (consumed % readAhead->Count) * readAhead->BlockSize;
+        filled = readAhead->Lengths[consumed % readAhead->Count];
+        available = filled > readAhead->ReadPos ? filled - readAhead->ReadPos : 0;
+        chunk = length - copied < available ? length - copied : available;
+        memcpy(destination + copied, block + readAhead->ReadPos, chunk);
+        copied += chunk;
+        readAhead->ReadPos += chunk;
+
+        if (readAhead->ReadPos >= filled) {
+            // Done with this block; hand it back to be refilled.
+            readAhead->ReadPos = 0;
+            consumed++;
+            READ_AHEAD_STORE(readAhead->Consumed, consumed);
+        }
+    }
+
+    if (!copied && length) {
+        if (READ_AHEAD_LOAD(readAhead->EndOfData) && consumed == READ_AHEAD_LOAD(readAhead->Produced))
+            return READ_AHEAD_EOF;
+        readAhead->Underruns++;
+    }
+    return copied;
+}
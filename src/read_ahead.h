@@ -0,0 +1,45 @@
+// Read-ahead header file
+// Keeps a few large storage blocks fetched ahead of the parser, so the audio path only
+// ever copies out of RAM.  One side (a task of its own) calls ReadAheadService to do the
+// slow storage reads; the other (the decoder) calls ReadAheadRead, which never touches
+// storage and never blocks.  Exactly one of each, and no locking needed.
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef READ_AHEAD_H
+#define READ_AHEAD_H
+
+#define READ_AHEAD_MAX_BLOCKS 8
+
+// Where blocks come from.  Read length bytes at offset into destination and return how
+// many were read; fewer than length means the end of the data.  Called only from
+// ReadAheadService, so it's allowed to be slow.
+typedef int (*blockRead_t)(void * context, uint32_t offset, uint8_t * destination, size_t length);
+
+typedef struct {
+    blockRead_t Read;
+    void * Context;               // Handed back to Read.
+    uint8_t * Blocks;             // Caller-owned, Count * BlockSize bytes.
+    size_t BlockSize;             // Ideally a multiple of the storage sector size.
+    uint32_t Count;               // 2 to READ_AHEAD_MAX_BLOCKS.
+    uint32_t Lengths[READ_AHEAD_MAX_BLOCKS]; // Valid bytes in each block.
+    uint32_t NextOffset;          // Service side: where the next block is read from.
+    uint32_t Produced;            // Blocks filled so far.  Written by the service side only.
+    uint32_t Consumed;            // Blocks used up so far.  Written by the read side only.
+    bool EndOfData;               // Service side hit the end.  Published along with the last block.
+    size_t ReadPos;               // Read side: next byte in the oldest filled block.
+    uint32_t Underruns;           // Reads that wanted data and found none ready.
+} readAhead_t;
+
+enum {
+    READ_AHEAD_EOF = -2
+};
+
+void ReadAheadInit (readAhead_t * readAhead, blockRead_t read, void * context,
+                    uint8_t * blocks, size_t blockSize, uint32_t count);
+void ReadAheadReset (readAhead_t * readAhead, uint32_t offset);
+bool ReadAheadService (readAhead_t * readAhead);
+int ReadAheadRead (readAhead_t * readAhead, uint8_t * destination, size_t length);
+
+#endif